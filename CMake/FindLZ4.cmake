@@ -0,0 +1,21 @@
+# Copyright (c) 2015-2017, EPFL/Blue Brain Project
+# Responsible Author: Cyrille Favreau <cyrille.favreau@epfl.ch>
+#
+# This file is part of Brayns <https://github.com/BlueBrain/Brayns>
+
+# Locate the LZ4 compression library
+#
+# Defines LZ4_FOUND, LZ4_INCLUDE_DIRS and LZ4_LIBRARIES
+
+find_path(LZ4_INCLUDE_DIR NAMES lz4.h)
+find_library(LZ4_LIBRARY NAMES lz4)
+
+include(FindPackageHandleStandardArgs)
+find_package_handle_standard_args(LZ4 DEFAULT_MSG LZ4_LIBRARY LZ4_INCLUDE_DIR)
+
+if(LZ4_FOUND)
+  set(LZ4_INCLUDE_DIRS ${LZ4_INCLUDE_DIR})
+  set(LZ4_LIBRARIES ${LZ4_LIBRARY})
+endif()
+
+mark_as_advanced(LZ4_INCLUDE_DIR LZ4_LIBRARY)
@@ -59,6 +59,7 @@
 #endif
 
 #include <future>
+#include <mutex>
 #ifdef BRAYNS_USE_LUNCHBOX
 #include <lunchbox/threadPool.h>
 #endif
@@ -107,6 +108,8 @@ struct Brayns::Impl
 
     void createEngine()
     {
+        // The cache file writer reports progress to the current engine
+        _waitForCacheFile();
         _engine.reset(); // Free resources before creating a new engine
 
         const auto& engineName =
@@ -251,6 +254,10 @@ private:
         scene.resetMaterials();
         _loadData(loadingProgress);
 
+        // Geometry batches rendered so far are replaced by the whole scene
+        std::lock_guard<std::mutex> lock(scene.getLoadingMutex());
+        _renderingBatches = false;
+
         if (scene.empty() && !scene.getVolumeHandler())
         {
             BRAYNS_INFO << "Building default scene" << std::endl;
@@ -265,8 +272,9 @@ private:
             loadingProgress.setMessage("Building geometry ...");
             scene.buildGeometry();
 
+            // Written in the background, rendering starts in the meantime
             if (!geomParams.getSaveCacheFile().empty())
-                scene.saveToCacheFile();
+                _saveCacheFile(scene.createCacheFileWriter());
         }
         else
             scene.buildGeometry();
@@ -288,6 +296,47 @@ private:
         BRAYNS_INFO << "Now rendering ..." << std::endl;
     }
 
+    /**
+     * Commits the geometry published by the loaders so far. The camera is
+     * placed according to the first batches, and placed again once the scene
+     * is fully loaded.
+     * @return true if there is geometry to render
+     */
+    bool _commitGeometryBatches()
+    {
+        Scene& scene = _engine->getScene();
+        if (scene.commitGeometryBatches())
+        {
+            scene.commit();
+            if (!_renderingBatches)
+                _engine->setDefaultCamera();
+            _renderingBatches = true;
+        }
+        return _renderingBatches;
+    }
+
+    void _saveCacheFile(const Scene::CacheFileWriter& writer)
+    {
+        _waitForCacheFile();
+        _cacheFileFuture = std::async(std::launch::async, [this, writer] {
+            const auto progressUpdate = [this](const std::string& msg,
+                                               const float progress) {
+                _engine->setLastOperation(msg);
+                _engine->setLastProgress(progress);
+            };
+            if (writer(progressUpdate))
+                progressUpdate("Cache file saved", 1.f);
+            else
+                progressUpdate("Failed to save cache file", 1.f);
+        });
+    }
+
+    void _waitForCacheFile()
+    {
+        if (_cacheFileFuture.valid())
+            _cacheFileFuture.wait();
+    }
+
 #if (BRAYNS_USE_DEFLECT || BRAYNS_USE_NETWORKING)
     void _executePlugins(const Vector2ui& size)
     {
@@ -318,16 +367,25 @@ private:
         _executePlugins(windowSize);
 #endif
 
+        // Held while rendering the geometry batches of a scene that is still
+        // loading
+        std::unique_lock<std::mutex> loadingLock;
         if (!isLoadingFinished())
         {
 #ifdef BRAYNS_USE_LUNCHBOX
             if (isAsyncMode())
             {
-                _engine->resetModified();
-                return false;
+                loadingLock = std::unique_lock<std::mutex>(
+                    _engine->getScene().getLoadingMutex(), std::try_to_lock);
+                if (!loadingLock.owns_lock() || !_commitGeometryBatches())
+                {
+                    _engine->resetModified();
+                    return false;
+                }
             }
+            else
 #endif
-            _dataLoadingFuture.get();
+                _dataLoadingFuture.get();
         }
 
         _engine->commit();
@@ -337,6 +395,7 @@ private:
             camera.commit();
 
         Scene& scene = _engine->getScene();
+        scene.setLevelOfDetail(_getLevelOfDetail());
 
         if (_parametersManager.getRenderingParameters().getHeadLight())
         {
@@ -378,6 +437,18 @@ private:
         return true;
     }
 
+    /**
+     * Level of detail requested by the rendering parameters, lowered when the
+     * camera is further from the scene than the level of detail distances
+     */
+    LevelOfDetail _getLevelOfDetail()
+    {
+        const auto& renderParams = _parametersManager.getRenderingParameters();
+        return renderParams.getLevelOfDetail(
+            _engine->getScene().getWorldBounds(),
+            _engine->getCamera().getPosition());
+    }
+
     void _loadData(Progress& loadingProgress)
     {
         auto& geometryParameters = _parametersManager.getGeometryParameters();
@@ -421,7 +492,7 @@ private:
 
         if (!geometryParameters.getLoadCacheFile().empty())
         {
-            scene.loadFromCacheFile();
+            scene.loadFromCacheFile(updateProgress);
             loadingProgress += tic;
         }
 
@@ -909,6 +980,9 @@ private:
         _keyboardHandler.registerKeyboardShortcut(
             'm', "Toggle synchronous/asynchronous mode",
             std::bind(&Brayns::Impl::_toggleSynchronousMode, this));
+        _keyboardHandler.registerKeyboardShortcut(
+            'L', "Cycle through levels of detail",
+            std::bind(&Brayns::Impl::_cycleLevelOfDetail, this));
     }
 
     void _blackBackground()
@@ -1049,6 +1123,19 @@ private:
         sceneParams.setAnimationFrame(std::numeric_limits<uint32_t>::max());
     }
 
+    void _cycleLevelOfDetail()
+    {
+        RenderingParameters& renderParams =
+            _parametersManager.getRenderingParameters();
+        const size_t level = size_t(renderParams.getLevelOfDetail());
+        renderParams.setLevelOfDetail(LevelOfDetail(
+            (level + 1) % (NB_COARSE_LEVELS_OF_DETAIL + 1)));
+        BRAYNS_INFO << "Level of detail: "
+                    << renderParams.getLevelOfDetailAsString(
+                           renderParams.getLevelOfDetail())
+                    << std::endl;
+    }
+
     void _toggleShadows()
     {
         RenderingParameters& renderParams =
@@ -1202,6 +1289,12 @@ private:
     float _eyeSeparation{0.0635f};
 
     std::future<void> _dataLoadingFuture;
+    // true once geometry batches of a loading scene are rendered, guarded by
+    // the loading mutex of the scene
+    bool _renderingBatches{false};
+    // declared after the engine, so that the destruction waits for the cache
+    // file to be written before the engine goes away
+    std::future<void> _cacheFileFuture;
 #ifdef BRAYNS_USE_LUNCHBOX
     // it is important to perform loading and unloading in the same thread,
     // otherwise we leak memory from within ospray/embree. So we don't use
@@ -64,6 +64,27 @@ void Engine::reshape(const Vector2ui& frameSize)
 void Engine::commit()
 {
     auto& sceneParams = _parametersManager.getSceneParameters();
+    const auto simulationHandler = getScene().getSimulationHandler();
+    const float playbackRate = _parametersManager.getGeometryParameters()
+                                   .getCircuitSimulationPlaybackRate();
+    if (simulationHandler && playbackRate > 0.f &&
+        sceneParams.getAnimationDelta() != 0)
+    {
+        // Frames follow the playback clock rather than the rendering loop
+        const int64_t nbFrames =
+            _playbackScheduler.advance(playbackRate,
+                                       sceneParams.getAnimationDelta(),
+                                       simulationHandler->isReady());
+        if (nbFrames != 0)
+        {
+            sceneParams.setAnimationFrame(sceneParams.getAnimationFrame() +
+                                          nbFrames);
+            _frameBuffer->clear();
+        }
+        return;
+    }
+    _playbackScheduler.stop();
+
     if ((sceneParams.getModified() || sceneParams.getAnimationDelta() != 0) &&
         getScene().getSimulationHandler() &&
         getScene().getSimulationHandler()->isReady())
@@ -21,6 +21,7 @@
 #ifndef ENGINE_H
 #define ENGINE_H
 
+#include <brayns/common/simulation/PlaybackScheduler.h>
 #include <brayns/common/types.h>
 
 namespace brayns
@@ -75,6 +76,11 @@ public:
     Camera& getCamera() { return *_camera; }
     /** Gets the renderer */
     Renderer& getRenderer();
+    /** Gets the scheduler pacing the playback of simulations */
+    const PlaybackScheduler& getPlaybackScheduler() const
+    {
+        return _playbackScheduler;
+    }
     /** Active renderer */
     void setActiveRenderer(const RendererType renderer);
     RendererType getActiveRenderer() { return _activeRenderer; }
@@ -196,6 +202,7 @@ protected:
     RendererMap _renderers;
     Vector2i _frameSize;
     FrameBufferPtr _frameBuffer;
+    PlaybackScheduler _playbackScheduler;
 
     size_t _frameNumber;
     float _lastProgress;
@@ -0,0 +1,156 @@
+/* Copyright (c) 2015-2017, EPFL/Blue Brain Project
+ * All rights reserved. Do not distribute without permission.
+ * Responsible Author: Cyrille Favreau <cyrille.favreau@epfl.ch>
+ *
+ * This file is part of Brayns <https://github.com/BlueBrain/Brayns>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <utility>
+#include <vector>
+
+namespace brayns
+{
+/**
+ * Geometry of a scene, stored per material in slots that are densely indexed
+ * by material ID. Elements of a material are contiguous, so that they can be
+ * handed over to the engines as a single buffer, and the index of an element
+ * remains valid until its material is cleared.
+ *
+ * Slots are only ever added at the end, so references to the containers of
+ * existing materials are not invalidated when a new material is used.
+ *
+ * @tparam T Container of the elements of a material, either a vector of
+ *         primitives or a TrianglesMesh
+ */
+template <typename T>
+class GeometryArena
+{
+public:
+    typedef typename std::deque<T>::iterator iterator;
+    typedef typename std::deque<T>::const_iterator const_iterator;
+
+    /** @return the container of a material, created if it does not exist */
+    T& operator[](const size_t materialId)
+    {
+        if (materialId >= _slots.size())
+            _slots.resize(materialId + 1);
+        return _slots[materialId];
+    }
+
+    /** @return the container of a material, nullptr if it does not exist */
+    T* find(const size_t materialId)
+    {
+        return materialId < _slots.size() ? &_slots[materialId] : nullptr;
+    }
+    const T* find(const size_t materialId) const
+    {
+        return materialId < _slots.size() ? &_slots[materialId] : nullptr;
+    }
+
+    /** @return the number of material slots, some of which may be empty */
+    size_t size() const { return _slots.size(); }
+    /** @return true if no material holds any element */
+    bool empty() const
+    {
+        for (const auto& slot : _slots)
+            if (!slot.empty())
+                return false;
+        return true;
+    }
+
+    /** Removes all elements and materials */
+    void clear() { _slots.clear(); }
+    /**
+     * Reserves memory for nbElements additional elements of a material, so
+     * that they can be appended without reallocation. The capacity grows at
+     * least geometrically, so that reserving before each of many small
+     * appends does not reallocate the material every time.
+     */
+    void reserve(const size_t materialId, const size_t nbElements)
+    {
+        auto& slot = (*this)[materialId];
+        const size_t required = slot.size() + nbElements;
+        if (required > slot.capacity())
+            slot.reserve(std::max(required, 2 * slot.capacity()));
+    }
+
+    /**
+     * Appends elements to a material
+     * @return the index of the first appended element in the material
+     */
+    template <typename U>
+    uint64_t append(const size_t materialId, const U* elements,
+                    const size_t nbElements)
+    {
+        auto& slot = (*this)[materialId];
+        const uint64_t offset = slot.size();
+        slot.insert(slot.end(), elements, elements + nbElements);
+        return offset;
+    }
+
+    uint64_t append(const size_t materialId, const T& elements)
+    {
+        return append(materialId, elements.data(), elements.size());
+    }
+
+    /**
+     * Appends elements to a material, taking over their memory if the
+     * material is empty so that they are not copied
+     * @return the index of the first appended element in the material
+     */
+    uint64_t append(const size_t materialId, T&& elements)
+    {
+        auto& slot = (*this)[materialId];
+        if (!slot.empty())
+            return append(materialId, elements.data(), elements.size());
+        slot = std::move(elements);
+        return 0;
+    }
+
+    /** Appends all elements of another arena, material by material */
+    void append(const GeometryArena& other)
+    {
+        for (size_t materialId = 0; materialId < other.size(); ++materialId)
+        {
+            const auto& elements = other._slots[materialId];
+            if (!elements.empty())
+                append(materialId, elements);
+        }
+    }
+
+    /** @return the number of elements over all materials */
+    uint64_t getNbElements() const
+    {
+        uint64_t nbElements = 0;
+        for (const auto& slot : _slots)
+            nbElements += slot.size();
+        return nbElements;
+    }
+
+    iterator begin() { return _slots.begin(); }
+    iterator end() { return _slots.end(); }
+    const_iterator begin() const { return _slots.begin(); }
+    const_iterator end() const { return _slots.end(); }
+private:
+    std::deque<T> _slots;
+};
+}
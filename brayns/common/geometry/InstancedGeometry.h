@@ -0,0 +1,54 @@
+/* Copyright (c) 2015-2017, EPFL/Blue Brain Project
+ * All rights reserved. Do not distribute without permission.
+ * Responsible Author: Cyrille Favreau <cyrille.favreau@epfl.ch>
+ *
+ * This file is part of Brayns <https://github.com/BlueBrain/Brayns>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#pragma once
+
+#include <brayns/common/geometry/Cone.h>
+#include <brayns/common/geometry/Cylinder.h>
+#include <brayns/common/geometry/Sphere.h>
+#include <brayns/common/geometry/TrianglesMesh.h>
+#include <brayns/common/types.h>
+
+namespace brayns
+{
+/**
+ * Geometry loaded once in its own coordinates, and placed several times in the
+ * scene, one instance per transformation. Materials are the ones of the scene.
+ */
+struct InstancedGeometry
+{
+    SpheresMap spheres;
+    CylindersMap cylinders;
+    ConesMap cones;
+    TrianglesMeshMap trianglesMeshes;
+
+    /** Bounds of the geometry in its own coordinates */
+    Boxf bounds;
+
+    Matrix4fs transformations;
+
+    /**
+     * Offsets added to the simulation offsets held by the values of the
+     * primitives, one per transformation. Empty if the geometry is not mapped
+     * to simulation data.
+     */
+    uint64_ts simulationOffsets;
+};
+}
@@ -32,6 +32,8 @@ struct TrianglesMesh
     Vector4fs colors;
     Vector3uis indices;
     Vector2fs textureCoordinates;
+
+    bool empty() const { return vertices.empty() && indices.empty(); }
 };
 }
 
@@ -22,17 +22,200 @@
 
 #include <brayns/common/log.h>
 #include <brayns/common/material/Material.h>
+#include <brayns/common/utils/Utils.h>
 #include <brayns/common/volume/VolumeHandler.h>
 #include <brayns/io/NESTLoader.h>
 #include <brayns/io/TransferFunctionLoader.h>
 #include <brayns/parameters/ParametersManager.h>
 
 #include <boost/filesystem.hpp>
+#include <atomic>
+#include <fcntl.h>
 #include <fstream>
+#include <sstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef BRAYNS_USE_LZ4
+#include <lz4.h>
+#endif
+
+#ifdef BRAYNS_USE_OPENMP
+#include <omp.h>
+#endif
 
 namespace
 {
-const size_t CACHE_VERSION = 8;
+const size_t CACHE_VERSION = 9;
+const size_t COMPRESSED_CACHE_VERSION = 10;
+const size_t LEGACY_CACHE_VERSION = 8;
+
+// Blocks are aligned on page boundaries so that they can be used straight
+// from the memory-mapped file
+const uint64_t CACHE_BLOCK_ALIGNMENT = 4096;
+
+// In compressed cache files, blocks are split into chunks of this size that
+// are compressed independently, so that they can be decompressed in parallel
+const uint64_t CACHE_CHUNK_SIZE = 4 * 1024 * 1024;
+
+// LZ4 cannot compress data more than this, which bounds the size of the
+// decompressed blocks by the size of the file
+const uint64_t LZ4_MAX_COMPRESSION_RATIO = 255;
+
+enum class CacheBlockType : uint64_t
+{
+    spheres = 0,
+    cylinders = 1,
+    cones = 2,
+    vertices = 3,
+    indices = 4,
+    normals = 5,
+    textureCoordinates = 6
+};
+
+const char* CACHE_BLOCK_NAMES[] = {"spheres", "cylinders", "cones", "vertices",
+                                   "indices", "normals",
+                                   "texture coordinates"};
+
+struct CacheHeader
+{
+    uint64_t version;
+    uint64_t nbMaterials;
+    uint64_t materialsOffset;
+    uint64_t nbBlocks;
+    uint64_t blocksOffset;
+    float bounds[6];
+};
+
+struct CacheMaterial
+{
+    float color[3];
+    float specularColor[3];
+    float specularExponent;
+    float reflectionIndex;
+    float opacity;
+    float refractionIndex;
+    float emission;
+    float glossiness;
+    uint32_t castSimulationData;
+};
+
+struct CacheBlock
+{
+    uint64_t materialId;
+    CacheBlockType type;
+    uint64_t elementSize;
+    uint64_t nbElements;
+    uint64_t offset;
+};
+
+// In compressed cache files, a block starts with the number of chunks,
+// followed by their descriptions and then by the compressed chunks
+struct CacheChunk
+{
+    uint64_t offset;
+    uint64_t compressedSize;
+    uint64_t size;
+};
+
+uint64_t getCacheElementSize(const CacheBlockType type)
+{
+    switch (type)
+    {
+    case CacheBlockType::spheres:
+        return sizeof(brayns::Sphere);
+    case CacheBlockType::cylinders:
+        return sizeof(brayns::Cylinder);
+    case CacheBlockType::cones:
+        return sizeof(brayns::Cone);
+    case CacheBlockType::vertices:
+    case CacheBlockType::normals:
+        return sizeof(brayns::Vector3f);
+    case CacheBlockType::indices:
+        return sizeof(brayns::Vector3ui);
+    case CacheBlockType::textureCoordinates:
+        return sizeof(brayns::Vector2f);
+    }
+    return 0;
+}
+
+uint64_t alignCacheOffset(const uint64_t offset)
+{
+    return (offset + CACHE_BLOCK_ALIGNMENT - 1) / CACHE_BLOCK_ALIGNMENT *
+           CACHE_BLOCK_ALIGNMENT;
+}
+
+template <typename T>
+void assignCacheBlock(std::vector<T>& container, const char* data,
+                      const uint64_t nbElements)
+{
+    const T* begin = reinterpret_cast<const T*>(data);
+    container.assign(begin, begin + nbElements);
+}
+
+template <typename T>
+char* resizeCacheBlock(std::vector<T>& container, const uint64_t nbElements)
+{
+    container.resize(nbElements);
+    return reinterpret_cast<char*>(container.data());
+}
+
+#ifdef BRAYNS_USE_LZ4
+/**
+ * Writes a compressed block at the current position of the file, which is
+ * offset, and sets blockSize to the number of written bytes. Returns false if
+ * one of the chunks could not be compressed.
+ */
+bool writeCompressedCacheBlock(std::ofstream& file, const uint64_t offset,
+                               const char* data, const uint64_t size,
+                               uint64_t& blockSize)
+{
+    const uint64_t nbChunks = (size + CACHE_CHUNK_SIZE - 1) / CACHE_CHUNK_SIZE;
+    std::vector<std::vector<char>> compressedChunks(nbChunks);
+    bool compressed = true;
+#pragma omp parallel for schedule(dynamic)
+    for (uint64_t i = 0; i < nbChunks; ++i)
+    {
+        const uint64_t chunkSize =
+            std::min(CACHE_CHUNK_SIZE, size - i * CACHE_CHUNK_SIZE);
+        auto& compressedChunk = compressedChunks[i];
+        compressedChunk.resize(LZ4_compressBound(chunkSize));
+        const int compressedSize =
+            LZ4_compress_default(data + i * CACHE_CHUNK_SIZE,
+                                 compressedChunk.data(), chunkSize,
+                                 compressedChunk.size());
+        if (compressedSize <= 0)
+        {
+#pragma omp atomic write
+            compressed = false;
+            continue;
+        }
+        compressedChunk.resize(compressedSize);
+    }
+    if (!compressed)
+        return false;
+
+    std::vector<CacheChunk> chunks(nbChunks);
+    uint64_t chunkOffset =
+        offset + sizeof(uint64_t) + nbChunks * sizeof(CacheChunk);
+    for (uint64_t i = 0; i < nbChunks; ++i)
+    {
+        chunks[i].offset = chunkOffset;
+        chunks[i].compressedSize = compressedChunks[i].size();
+        chunks[i].size =
+            std::min(CACHE_CHUNK_SIZE, size - i * CACHE_CHUNK_SIZE);
+        chunkOffset += chunks[i].compressedSize;
+    }
+
+    file.write((char*)&nbChunks, sizeof(uint64_t));
+    file.write((char*)chunks.data(), nbChunks * sizeof(CacheChunk));
+    for (const auto& compressedChunk : compressedChunks)
+        file.write(compressedChunk.data(), compressedChunk.size());
+    blockSize = chunkOffset - offset;
+    return true;
+}
+#endif
 }
 
 namespace brayns
@@ -47,11 +230,15 @@ Scene::Scene(Renderers renderers, ParametersManager& parametersManager)
     , _volumeHandler(nullptr)
     , _simulationHandler(nullptr)
     , _caDiffusionSimulationHandler(nullptr)
+    , _cacheMemoryMapPtr(nullptr)
+    , _cacheMemoryMapSize(0)
+    , _cacheFileDescriptor(-1)
 {
 }
 
 Scene::~Scene()
 {
+    _unmapCacheFile();
 }
 
 void Scene::reset()
@@ -73,10 +260,19 @@ void Scene::resetModified()
 void Scene::unload()
 {
     _markGeometryDirty();
+    _dirtySpheres.clear();
+    _dirtyCylinders.clear();
+    _dirtyCones.clear();
     _spheres.clear();
     _cylinders.clear();
     _cones.clear();
     _trianglesMeshes.clear();
+    _mappedGeometry.clear();
+    _instancedGeometries.clear();
+    for (auto& coarseGeometry : _coarseGeometry)
+        coarseGeometry = InstancedGeometry();
+    _clearGeometryBatches();
+    _unmapCacheFile();
     _bounds.reset();
     _caDiffusionSimulationHandler.reset();
     _simulationHandler.reset();
@@ -597,7 +793,8 @@ VolumeHandlerPtr Scene::getVolumeHandler()
 bool Scene::empty() const
 {
     return _spheres.empty() && _cylinders.empty() && _cones.empty() &&
-           _trianglesMeshes.empty();
+           _trianglesMeshes.empty() && _mappedGeometry.empty() &&
+           _instancedGeometries.empty();
 }
 
 void Scene::_buildMissingMaterials(const size_t materialId)
@@ -606,41 +803,424 @@ void Scene::_buildMissingMaterials(const size_t materialId)
         _materials.resize(materialId + 1);
 }
 
+uint64_t Scene::_getSpheresData(const size_t materialId,
+                                const Sphere*& spheres) const
+{
+    const auto mapped = _mappedGeometry.find(materialId);
+    if (mapped != _mappedGeometry.end() && mapped->second.nbSpheres != 0)
+    {
+        spheres = mapped->second.spheres;
+        return mapped->second.nbSpheres;
+    }
+    const auto elements = _spheres.find(materialId);
+    if (!elements)
+        return 0;
+    spheres = elements->data();
+    return elements->size();
+}
+
+uint64_t Scene::_getCylindersData(const size_t materialId,
+                                  const Cylinder*& cylinders) const
+{
+    const auto mapped = _mappedGeometry.find(materialId);
+    if (mapped != _mappedGeometry.end() && mapped->second.nbCylinders != 0)
+    {
+        cylinders = mapped->second.cylinders;
+        return mapped->second.nbCylinders;
+    }
+    const auto elements = _cylinders.find(materialId);
+    if (!elements)
+        return 0;
+    cylinders = elements->data();
+    return elements->size();
+}
+
+uint64_t Scene::_getConesData(const size_t materialId,
+                              const Cone*& cones) const
+{
+    const auto mapped = _mappedGeometry.find(materialId);
+    if (mapped != _mappedGeometry.end() && mapped->second.nbCones != 0)
+    {
+        cones = mapped->second.cones;
+        return mapped->second.nbCones;
+    }
+    const auto elements = _cones.find(materialId);
+    if (!elements)
+        return 0;
+    cones = elements->data();
+    return elements->size();
+}
+
+void Scene::_detachMappedGeometry(const size_t materialId)
+{
+    if (_mappedGeometry.empty())
+        return;
+
+    const auto it = _mappedGeometry.find(materialId);
+    if (it == _mappedGeometry.end())
+        return;
+
+    // Mapped blocks are always loaded first, hence they go in front of any
+    // primitive that might have been added to the containers in the meantime
+    const auto& mapped = it->second;
+    if (mapped.nbSpheres != 0)
+    {
+        auto& spheres = _spheres[materialId];
+        spheres.insert(spheres.begin(), mapped.spheres,
+                       mapped.spheres + mapped.nbSpheres);
+    }
+    if (mapped.nbCylinders != 0)
+    {
+        auto& cylinders = _cylinders[materialId];
+        cylinders.insert(cylinders.begin(), mapped.cylinders,
+                         mapped.cylinders + mapped.nbCylinders);
+    }
+    if (mapped.nbCones != 0)
+    {
+        auto& cones = _cones[materialId];
+        cones.insert(cones.begin(), mapped.cones, mapped.cones + mapped.nbCones);
+    }
+    _mappedGeometry.erase(it);
+
+    // The engine may still reference the memory-mapped primitives
+    _dirtySpheres[materialId].moved = true;
+    _dirtyCylinders[materialId].moved = true;
+    _dirtyCones[materialId].moved = true;
+}
+
+void Scene::_markDirty(DirtyRanges& ranges, const size_t materialId,
+                       const uint64_t begin, const uint64_t end)
+{
+    if (begin >= end)
+        return;
+
+    auto& range = ranges[materialId];
+    if (range.begin == range.end)
+    {
+        range.begin = begin;
+        range.end = end;
+    }
+    else
+    {
+        range.begin = std::min(range.begin, begin);
+        range.end = std::max(range.end, end);
+    }
+    _modified = true;
+}
+
+void Scene::_detachAllMappedGeometry()
+{
+    while (!_mappedGeometry.empty())
+        _detachMappedGeometry(_mappedGeometry.begin()->first);
+}
+
 uint64_t Scene::addSphere(const size_t materialId, const Sphere& sphere)
 {
+    _detachMappedGeometry(materialId);
     _buildMissingMaterials(materialId);
-    _spheres[materialId].push_back(sphere);
+    auto& spheres = _spheres[materialId];
+    spheres.push_back(sphere);
     _bounds.merge(sphere.center);
-    return _spheres[materialId].size() - 1;
+    return spheres.size() - 1;
 }
 
 uint64_t Scene::addCylinder(const size_t materialId, const Cylinder& cylinder)
 {
+    _detachMappedGeometry(materialId);
     _buildMissingMaterials(materialId);
-    _cylinders[materialId].push_back(cylinder);
+    auto& cylinders = _cylinders[materialId];
+    cylinders.push_back(cylinder);
     _bounds.merge(cylinder.center);
     _bounds.merge(cylinder.up);
-    return _cylinders[materialId].size() - 1;
+    return cylinders.size() - 1;
 }
 
 uint64_t Scene::addCone(const size_t materialId, const Cone& cone)
 {
+    _detachMappedGeometry(materialId);
     _buildMissingMaterials(materialId);
-    _cones[materialId].push_back(cone);
+    auto& cones = _cones[materialId];
+    cones.push_back(cone);
     _bounds.merge(cone.center);
     _bounds.merge(cone.up);
-    return _cones[materialId].size() - 1;
+    return cones.size() - 1;
+}
+
+uint64_t Scene::addSpheres(const size_t materialId, const Spheres& spheres)
+{
+    _detachMappedGeometry(materialId);
+    _buildMissingMaterials(materialId);
+    for (const auto& sphere : spheres)
+        _bounds.merge(sphere.center);
+    return _spheres.append(materialId, spheres);
+}
+
+uint64_t Scene::addSpheres(const size_t materialId, Spheres&& spheres)
+{
+    _detachMappedGeometry(materialId);
+    _buildMissingMaterials(materialId);
+    for (const auto& sphere : spheres)
+        _bounds.merge(sphere.center);
+    return _spheres.append(materialId, std::move(spheres));
+}
+
+uint64_t Scene::addCylinders(const size_t materialId,
+                             const Cylinders& cylinders)
+{
+    _detachMappedGeometry(materialId);
+    _buildMissingMaterials(materialId);
+    for (const auto& cylinder : cylinders)
+    {
+        _bounds.merge(cylinder.center);
+        _bounds.merge(cylinder.up);
+    }
+    return _cylinders.append(materialId, cylinders);
+}
+
+uint64_t Scene::addCylinders(const size_t materialId, Cylinders&& cylinders)
+{
+    _detachMappedGeometry(materialId);
+    _buildMissingMaterials(materialId);
+    for (const auto& cylinder : cylinders)
+    {
+        _bounds.merge(cylinder.center);
+        _bounds.merge(cylinder.up);
+    }
+    return _cylinders.append(materialId, std::move(cylinders));
+}
+
+uint64_t Scene::addCones(const size_t materialId, const Cones& cones)
+{
+    _detachMappedGeometry(materialId);
+    _buildMissingMaterials(materialId);
+    for (const auto& cone : cones)
+    {
+        _bounds.merge(cone.center);
+        _bounds.merge(cone.up);
+    }
+    return _cones.append(materialId, cones);
+}
+
+uint64_t Scene::addCones(const size_t materialId, Cones&& cones)
+{
+    _detachMappedGeometry(materialId);
+    _buildMissingMaterials(materialId);
+    for (const auto& cone : cones)
+    {
+        _bounds.merge(cone.center);
+        _bounds.merge(cone.up);
+    }
+    return _cones.append(materialId, std::move(cones));
+}
+
+void Scene::reserveGeometry(const size_t materialId, const size_t nbSpheres,
+                            const size_t nbCylinders, const size_t nbCones)
+{
+    _detachMappedGeometry(materialId);
+    if (nbSpheres != 0)
+        _spheres.reserve(materialId, nbSpheres);
+    if (nbCylinders != 0)
+        _cylinders.reserve(materialId, nbCylinders);
+    if (nbCones != 0)
+        _cones.reserve(materialId, nbCones);
+}
+
+void Scene::addInstancedGeometry(InstancedGeometryPtr geometry)
+{
+    // Cache files only hold the scene containers
+    const auto& geometryParameters = _parametersManager.getGeometryParameters();
+    if (!supportsInstancing() || !geometryParameters.getSaveCacheFile().empty())
+    {
+        _addInstancedGeometryCopies(*geometry);
+        return;
+    }
+
+    const size_t nbMaterials =
+        std::max(std::max(geometry->spheres.size(), geometry->cylinders.size()),
+                 std::max(geometry->cones.size(),
+                          geometry->trianglesMeshes.size()));
+    if (nbMaterials != 0)
+        _buildMissingMaterials(nbMaterials - 1);
+
+    const auto& bounds = geometry->bounds;
+    for (const auto& transformation : geometry->transformations)
+        for (size_t i = 0; i < 8; ++i)
+        {
+            const Vector3f corner(
+                i & 1 ? bounds.getMax().x() : bounds.getMin().x(),
+                i & 2 ? bounds.getMax().y() : bounds.getMin().y(),
+                i & 4 ? bounds.getMax().z() : bounds.getMin().z());
+            _bounds.merge(transformation * corner);
+        }
+
+    _instancedGeometries.push_back(geometry);
+    _markGeometryDirty();
+}
+
+void Scene::setLevelOfDetail(const LevelOfDetail level)
+{
+    if (level == _levelOfDetail)
+        return;
+    _levelOfDetail = level;
+    _modified = true;
+}
+
+void Scene::addGeometryBatch(InstancedGeometryPtr batch)
+{
+    std::lock_guard<std::mutex> lock(_geometryBatchesMutex);
+    _geometryBatches.push_back(batch);
+}
+
+bool Scene::hasGeometryBatches() const
+{
+    std::lock_guard<std::mutex> lock(_geometryBatchesMutex);
+    return !_geometryBatches.empty();
+}
+
+InstancedGeometries Scene::_takeGeometryBatches()
+{
+    std::lock_guard<std::mutex> lock(_geometryBatchesMutex);
+    const auto begin = _geometryBatches.begin() + _nbCommittedGeometryBatches;
+    InstancedGeometries batches(begin, _geometryBatches.end());
+    _nbCommittedGeometryBatches = _geometryBatches.size();
+    return batches;
+}
+
+void Scene::_clearGeometryBatches()
+{
+    std::lock_guard<std::mutex> lock(_geometryBatchesMutex);
+    _geometryBatches.clear();
+    _nbCommittedGeometryBatches = 0;
+}
+
+void Scene::_addInstancedGeometryCopies(const InstancedGeometry& geometry)
+{
+    for (size_t i = 0; i < geometry.transformations.size(); ++i)
+    {
+        const auto& transformation = geometry.transformations[i];
+        const auto& simulationOffsets = geometry.simulationOffsets;
+        const uint64_t simulationOffset =
+            i < simulationOffsets.size() ? simulationOffsets[i] : 0;
+        const auto moveValues = [simulationOffset](Vector2f& values) {
+            if (simulationOffset != 0)
+                values = encodeSimulationOffset(
+                    decodeSimulationOffset(values) + simulationOffset);
+        };
+
+        for (size_t materialId = 0; materialId < geometry.spheres.size();
+             ++materialId)
+        {
+            Spheres spheres = *geometry.spheres.find(materialId);
+            if (spheres.empty())
+                continue;
+            for (auto& sphere : spheres)
+            {
+                sphere.center = transformation * sphere.center;
+                moveValues(sphere.values);
+            }
+            addSpheres(materialId, std::move(spheres));
+        }
+
+        for (size_t materialId = 0; materialId < geometry.cylinders.size();
+             ++materialId)
+        {
+            Cylinders cylinders = *geometry.cylinders.find(materialId);
+            if (cylinders.empty())
+                continue;
+            for (auto& cylinder : cylinders)
+            {
+                cylinder.center = transformation * cylinder.center;
+                cylinder.up = transformation * cylinder.up;
+                moveValues(cylinder.values);
+            }
+            addCylinders(materialId, std::move(cylinders));
+        }
+
+        for (size_t materialId = 0; materialId < geometry.cones.size();
+             ++materialId)
+        {
+            Cones cones = *geometry.cones.find(materialId);
+            if (cones.empty())
+                continue;
+            for (auto& cone : cones)
+            {
+                cone.center = transformation * cone.center;
+                cone.up = transformation * cone.up;
+                moveValues(cone.values);
+            }
+            addCones(materialId, std::move(cones));
+        }
+
+        for (size_t materialId = 0;
+             materialId < geometry.trianglesMeshes.size(); ++materialId)
+        {
+            const auto& mesh = *geometry.trianglesMeshes.find(materialId);
+            if (mesh.empty())
+                continue;
+
+            _buildMissingMaterials(materialId);
+            auto& trianglesMesh = _trianglesMeshes[materialId];
+            const uint32_t offset = trianglesMesh.vertices.size();
+            for (const auto& vertex : mesh.vertices)
+            {
+                const Vector3f transformedVertex = transformation * vertex;
+                trianglesMesh.vertices.push_back(transformedVertex);
+                _bounds.merge(transformedVertex);
+            }
+            for (const auto& normal : mesh.normals)
+            {
+                const Vector4f transformedNormal =
+                    transformation *
+                    Vector4f(normal.x(), normal.y(), normal.z(), 0.f);
+                trianglesMesh.normals.push_back(
+                    Vector3f(transformedNormal.x(), transformedNormal.y(),
+                             transformedNormal.z()));
+            }
+            for (const auto& index : mesh.indices)
+                trianglesMesh.indices.push_back(
+                    Vector3ui(index.x() + offset, index.y() + offset,
+                              index.z() + offset));
+            trianglesMesh.colors.insert(trianglesMesh.colors.end(),
+                                        mesh.colors.begin(),
+                                        mesh.colors.end());
+            trianglesMesh.textureCoordinates.insert(
+                trianglesMesh.textureCoordinates.end(),
+                mesh.textureCoordinates.begin(),
+                mesh.textureCoordinates.end());
+        }
+    }
+    _markGeometryDirty();
+}
+
+Spheres& Scene::getMaterialSpheres(const size_t materialId)
+{
+    _detachMappedGeometry(materialId);
+    _buildMissingMaterials(materialId);
+    return _spheres[materialId];
+}
+
+void Scene::commitSpheres(const size_t)
+{
+    _spheresDirty = true;
+}
+
+void Scene::setSpheresDirty(const size_t materialId, const uint64_t begin,
+                            const uint64_t end)
+{
+    _markDirty(_dirtySpheres, materialId, begin, end);
 }
 
 void Scene::setSphere(const size_t materialId, const uint64_t index,
                       const Sphere& sphere)
 {
+    _detachMappedGeometry(materialId);
     auto& spheres = _spheres[materialId];
     if (index < spheres.size())
     {
         _buildMissingMaterials(materialId);
         spheres[index] = sphere;
         _bounds.merge(sphere.center);
+        _markDirty(_dirtySpheres, materialId, index, index + 1);
     }
     else
         BRAYNS_ERROR << "Invalid index " << index << std::endl;
@@ -649,6 +1229,7 @@ void Scene::setSphere(const size_t materialId, const uint64_t index,
 void Scene::setCone(const size_t materialId, const uint64_t index,
                     const Cone& cone)
 {
+    _detachMappedGeometry(materialId);
     auto& cones = _cones[materialId];
     if (index < cones.size())
     {
@@ -656,6 +1237,7 @@ void Scene::setCone(const size_t materialId, const uint64_t index,
         cones[index] = cone;
         _bounds.merge(cone.center);
         _bounds.merge(cone.up);
+        _markDirty(_dirtyCones, materialId, index, index + 1);
     }
     else
         BRAYNS_ERROR << "Invalid index " << index << std::endl;
@@ -664,6 +1246,7 @@ void Scene::setCone(const size_t materialId, const uint64_t index,
 void Scene::setCylinder(const size_t materialId, const uint64_t index,
                         const Cylinder& cylinder)
 {
+    _detachMappedGeometry(materialId);
     auto& cylinders = _cylinders[materialId];
     if (index < cylinders.size())
     {
@@ -671,172 +1254,254 @@ void Scene::setCylinder(const size_t materialId, const uint64_t index,
         cylinders[index] = cylinder;
         _bounds.merge(cylinder.center);
         _bounds.merge(cylinder.up);
+        _markDirty(_dirtyCylinders, materialId, index, index + 1);
     }
     else
         BRAYNS_ERROR << "Invalid index " << index << std::endl;
 }
 
-void Scene::saveToCacheFile()
+/**
+ * Materials and geometry blocks of a scene, ready to be written to a cache
+ * file. Blocks either point to the scene containers, or to copies owned by the
+ * snapshot when the file is written while the scene keeps changing.
+ */
+struct Scene::CacheSnapshot
 {
-    const auto& filename =
+    bool write(const Progress::UpdateCallback& progressUpdate);
+
+    std::string filename;
+    bool compress{false};
+    CacheHeader header;
+    std::vector<CacheMaterial> materials;
+    std::vector<CacheBlock> blocks;
+    std::vector<const void*> blocksData;
+    std::vector<std::vector<char>> copies;
+};
+
+std::shared_ptr<Scene::CacheSnapshot> Scene::_createCacheSnapshot(
+    const bool copyGeometry)
+{
+    auto snapshot = std::make_shared<CacheSnapshot>();
+    snapshot->filename =
         _parametersManager.getGeometryParameters().getSaveCacheFile();
+
+#ifdef BRAYNS_USE_LZ4
+    snapshot->compress =
+        _parametersManager.getGeometryParameters().getCompressCacheFile();
+#else
+    if (_parametersManager.getGeometryParameters().getCompressCacheFile())
+        BRAYNS_WARN << "Brayns was built without LZ4, cache file will not be "
+                    << "compressed" << std::endl;
+#endif
+
+    const size_t nbMaterials = _materials.size();
+    for (auto& material : _materials)
+    {
+        CacheMaterial cacheMaterial;
+        const auto& color = material.getColor();
+        const auto& specularColor = material.getSpecularColor();
+        for (size_t i = 0; i < 3; ++i)
+        {
+            cacheMaterial.color[i] = color[i];
+            cacheMaterial.specularColor[i] = specularColor[i];
+        }
+        cacheMaterial.specularExponent = material.getSpecularExponent();
+        cacheMaterial.reflectionIndex = material.getReflectionIndex();
+        cacheMaterial.opacity = material.getOpacity();
+        cacheMaterial.refractionIndex = material.getRefractionIndex();
+        cacheMaterial.emission = material.getEmission();
+        cacheMaterial.glossiness = material.getGlossiness();
+        cacheMaterial.castSimulationData = material.getCastSimulationData();
+        snapshot->materials.push_back(cacheMaterial);
+        // TODO: Textures
+    }
+
+    // Table of contents
+    auto& blocks = snapshot->blocks;
+    auto& blocksData = snapshot->blocksData;
+    auto& copies = snapshot->copies;
+    const auto addBlock = [&blocks, &blocksData, &copies, copyGeometry](
+        const size_t materialId, const CacheBlockType type,
+        const uint64_t nbElements, const void* data) {
+        if (nbElements == 0)
+            return;
+        const uint64_t elementSize = getCacheElementSize(type);
+        blocks.push_back({materialId, type, elementSize, nbElements, 0});
+        if (copyGeometry)
+        {
+            const char* begin = static_cast<const char*>(data);
+            copies.emplace_back(begin, begin + nbElements * elementSize);
+            data = copies.back().data();
+        }
+        blocksData.push_back(data);
+    };
+
+    for (size_t materialId = 0; materialId < nbMaterials; ++materialId)
+    {
+        // Pointers are only set once the sizes are queried, which must happen
+        // before they are passed on
+        const Sphere* spheres = nullptr;
+        const auto nbSpheres = _getSpheresData(materialId, spheres);
+        addBlock(materialId, CacheBlockType::spheres, nbSpheres, spheres);
+        const Cylinder* cylinders = nullptr;
+        const auto nbCylinders = _getCylindersData(materialId, cylinders);
+        addBlock(materialId, CacheBlockType::cylinders, nbCylinders,
+                 cylinders);
+        const Cone* cones = nullptr;
+        const auto nbCones = _getConesData(materialId, cones);
+        addBlock(materialId, CacheBlockType::cones, nbCones, cones);
+
+        const auto mesh = _trianglesMeshes.find(materialId);
+        if (!mesh)
+            continue;
+        const auto& trianglesMesh = *mesh;
+        addBlock(materialId, CacheBlockType::vertices,
+                 trianglesMesh.vertices.size(), trianglesMesh.vertices.data());
+        addBlock(materialId, CacheBlockType::indices,
+                 trianglesMesh.indices.size(), trianglesMesh.indices.data());
+        addBlock(materialId, CacheBlockType::normals,
+                 trianglesMesh.normals.size(), trianglesMesh.normals.data());
+        addBlock(materialId, CacheBlockType::textureCoordinates,
+                 trianglesMesh.textureCoordinates.size(),
+                 trianglesMesh.textureCoordinates.data());
+    }
+
+    auto& header = snapshot->header;
+    header.version =
+        snapshot->compress ? COMPRESSED_CACHE_VERSION : CACHE_VERSION;
+    header.nbMaterials = nbMaterials;
+    header.materialsOffset = sizeof(CacheHeader);
+    header.nbBlocks = blocks.size();
+    const uint64_t materialsEnd =
+        header.materialsOffset + nbMaterials * sizeof(CacheMaterial);
+    header.blocksOffset = (materialsEnd + sizeof(uint64_t) - 1) /
+                          sizeof(uint64_t) * sizeof(uint64_t);
+    for (size_t i = 0; i < 3; ++i)
+    {
+        header.bounds[i] = _bounds.getMin()[i];
+        header.bounds[i + 3] = _bounds.getMax()[i];
+    }
+    return snapshot;
+}
+
+bool Scene::CacheSnapshot::write(
+    const Progress::UpdateCallback& progressUpdate)
+{
     BRAYNS_INFO << "Saving scene to binary file: " << filename << std::endl;
     std::ofstream file(filename, std::ios::out | std::ios::binary);
     if (!file.good())
     {
         BRAYNS_ERROR << "Could not open cache file " << filename << std::endl;
-        return;
+        return false;
     }
 
-    const size_t version = CACHE_VERSION;
-    file.write((char*)&version, sizeof(size_t));
-    BRAYNS_INFO << "Version: " << version << std::endl;
-
-    const size_t nbMaterials = _materials.size();
-    file.write((char*)&nbMaterials, sizeof(size_t));
-    BRAYNS_INFO << nbMaterials << " materials" << std::endl;
+    uint64_t totalSize = 0;
+    for (const auto& block : blocks)
+        totalSize += block.nbElements * block.elementSize;
 
-    // Save materials
-    for (auto& material : _materials)
+    // Offsets of compressed blocks are only known once they are written
+    const uint64_t materialsEnd =
+        header.materialsOffset + materials.size() * sizeof(CacheMaterial);
+    uint64_t position = header.blocksOffset + blocks.size() * sizeof(CacheBlock);
+    uint64_t offset = alignCacheOffset(position);
+    for (auto& block : blocks)
     {
-        Vector3f value3f;
-        value3f = material.getColor();
-        file.write((char*)&value3f, sizeof(Vector3f));
-        value3f = material.getSpecularColor();
-        file.write((char*)&value3f, sizeof(Vector3f));
-        float value = material.getSpecularExponent();
-        file.write((char*)&value, sizeof(float));
-        value = material.getReflectionIndex();
-        file.write((char*)&value, sizeof(float));
-        value = material.getOpacity();
-        file.write((char*)&value, sizeof(float));
-        value = material.getRefractionIndex();
-        file.write((char*)&value, sizeof(float));
-        value = material.getEmission();
-        file.write((char*)&value, sizeof(float));
-        value = material.getGlossiness();
-        file.write((char*)&value, sizeof(float));
-        const bool boolean = material.getCastSimulationData();
-        file.write((char*)&boolean, sizeof(bool));
-        // TODO: Textures
+        block.offset = compress ? 0 : offset;
+        offset = alignCacheOffset(offset + block.nbElements * block.elementSize);
     }
 
-    // Save geometry
-    for (size_t materialId = 0; materialId < nbMaterials; ++materialId)
-    {
-        size_t nbElements{0};
-        uint64_t bufferSize{0};
+    BRAYNS_INFO << "Version: " << header.version << std::endl;
+    file.write((char*)&header, sizeof(CacheHeader));
 
-        // Spheres
-        if (_spheres.find(materialId) != _spheres.end())
+    // Save materials
+    BRAYNS_INFO << materials.size() << " materials" << std::endl;
+    file.write((char*)materials.data(),
+               materials.size() * sizeof(CacheMaterial));
+
+    // Save table of contents and geometry
+    const std::vector<char> padding(CACHE_BLOCK_ALIGNMENT, 0);
+    file.write(padding.data(), header.blocksOffset - materialsEnd);
+    file.write((char*)blocks.data(), blocks.size() * sizeof(CacheBlock));
+    uint64_t compressedSize = 0;
+    uint64_t writtenSize = 0;
+    for (size_t i = 0; i < blocks.size() && file.good(); ++i)
+    {
+        auto& block = blocks[i];
+        const uint64_t bufferSize = block.nbElements * block.elementSize;
+        if (compress)
         {
-            const auto& spheres = _spheres[materialId];
-            nbElements = spheres.size();
-            file.write((char*)&nbElements, sizeof(size_t));
-            bufferSize = nbElements * sizeof(Sphere);
-            file.write((char*)spheres.data(), bufferSize);
-            BRAYNS_DEBUG << "[" << materialId << "] " << nbElements
-                         << " spheres" << std::endl;
+#ifdef BRAYNS_USE_LZ4
+            block.offset = (position + sizeof(uint64_t) - 1) /
+                           sizeof(uint64_t) * sizeof(uint64_t);
+            file.write(padding.data(), block.offset - position);
+            uint64_t blockSize = 0;
+            if (!writeCompressedCacheBlock(file, block.offset,
+                                           (const char*)blocksData[i],
+                                           bufferSize, blockSize))
+            {
+                BRAYNS_ERROR << "Failed to compress "
+                             << CACHE_BLOCK_NAMES[size_t(block.type)]
+                             << " of material " << block.materialId
+                             << " in cache file " << filename << std::endl;
+                return false;
+            }
+            position = block.offset + blockSize;
+            compressedSize += blockSize;
+#endif
         }
         else
         {
-            nbElements = 0;
-            file.write((char*)&nbElements, sizeof(size_t));
+            file.write(padding.data(), block.offset - position);
+            file.write((const char*)blocksData[i], bufferSize);
+            position = block.offset + bufferSize;
         }
+        BRAYNS_DEBUG << "[" << block.materialId << "] " << block.nbElements
+                     << " " << CACHE_BLOCK_NAMES[size_t(block.type)]
+                     << std::endl;
 
-        // Cylinders
-        if (_cylinders.find(materialId) != _cylinders.end())
-        {
-            const auto& cylinders = _cylinders[materialId];
-            nbElements = cylinders.size();
-            file.write((char*)&nbElements, sizeof(size_t));
-            bufferSize = nbElements * sizeof(Cylinder);
-            file.write((char*)cylinders.data(), bufferSize);
-            BRAYNS_DEBUG << "[" << materialId << "] " << nbElements
-                         << " cylinders" << std::endl;
-        }
-        else
-        {
-            nbElements = 0;
-            file.write((char*)&nbElements, sizeof(size_t));
-        }
+        writtenSize += bufferSize;
+        if (progressUpdate)
+            progressUpdate("Saving cache file ...",
+                           float(writtenSize) / float(totalSize));
+    }
 
-        // Cones
-        if (_cones.find(materialId) != _cones.end())
-        {
-            const auto& cones = _cones[materialId];
-            nbElements = cones.size();
-            file.write((char*)&nbElements, sizeof(size_t));
-            bufferSize = nbElements * sizeof(Cone);
-            file.write((char*)cones.data(), bufferSize);
-            BRAYNS_DEBUG << "[" << materialId << "] " << nbElements << " cones"
-                         << std::endl;
-        }
-        else
-        {
-            nbElements = 0;
-            file.write((char*)&nbElements, sizeof(size_t));
-        }
+    if (compress)
+    {
+        // Now that offsets are known, update the table of contents
+        file.seekp(header.blocksOffset);
+        file.write((char*)blocks.data(), blocks.size() * sizeof(CacheBlock));
 
-        if (_trianglesMeshes.find(materialId) != _trianglesMeshes.end())
-        {
-            const auto& triangesMesh = _trianglesMeshes[materialId];
-            // Vertices
-            nbElements = triangesMesh.vertices.size();
-            file.write((char*)&nbElements, sizeof(size_t));
-            bufferSize = nbElements * sizeof(Vector3f);
-            file.write((char*)triangesMesh.vertices.data(), bufferSize);
-            if (nbElements != 0)
-                BRAYNS_DEBUG << "[" << materialId << "] " << nbElements
-                             << " vertices" << std::endl;
-
-            // Indices
-            nbElements = triangesMesh.indices.size();
-            file.write((char*)&nbElements, sizeof(size_t));
-            bufferSize = nbElements * sizeof(Vector3ui);
-            file.write((char*)triangesMesh.indices.data(), bufferSize);
-            if (nbElements != 0)
-                BRAYNS_DEBUG << "[" << materialId << "] " << nbElements
-                             << " indices" << std::endl;
-
-            // Normals
-            nbElements = triangesMesh.normals.size();
-            file.write((char*)&nbElements, sizeof(size_t));
-            bufferSize = nbElements * sizeof(Vector3f);
-            file.write((char*)triangesMesh.normals.data(), bufferSize);
-            if (nbElements != 0)
-                BRAYNS_DEBUG << "[" << materialId << "] " << nbElements
-                             << " normals" << std::endl;
-
-            // Texture coordinates
-            nbElements = triangesMesh.textureCoordinates.size();
-            file.write((char*)&nbElements, sizeof(size_t));
-            bufferSize = nbElements * sizeof(Vector2f);
-            file.write((char*)triangesMesh.textureCoordinates.data(),
-                       bufferSize);
-            if (nbElements != 0)
-                BRAYNS_DEBUG << "[" << materialId << "] " << nbElements
-                             << " texture coordinates" << std::endl;
-        }
-        else
-        {
-            nbElements = 0;
-            file.write((char*)&nbElements, sizeof(size_t)); // No vertices
-            file.write((char*)&nbElements, sizeof(size_t)); // No indices
-            file.write((char*)&nbElements, sizeof(size_t)); // No normals
-            file.write((char*)&nbElements,
-                       sizeof(size_t)); // No Texture coordinates
-        }
+        BRAYNS_INFO << "Geometry compressed from " << totalSize / 1048576
+                    << " MB to " << compressedSize / 1048576 << " MB"
+                    << std::endl;
     }
 
-    // Scene bounds
-    file.write((char*)&_bounds, sizeof(Boxf));
+    if (!file.good())
+    {
+        BRAYNS_ERROR << "Failed to write cache file " << filename << std::endl;
+        return false;
+    }
     file.close();
 
     BRAYNS_INFO << "Scene successfully saved" << std::endl;
+    return true;
+}
+
+bool Scene::saveToCacheFile()
+{
+    // The scene cannot change while writing, no need to copy the geometry
+    return _createCacheSnapshot(false)->write(Progress::UpdateCallback());
 }
 
-void Scene::loadFromCacheFile()
+Scene::CacheFileWriter Scene::createCacheFileWriter()
+{
+    const auto snapshot = _createCacheSnapshot(true);
+    return [snapshot](const Progress::UpdateCallback& progressUpdate) {
+        return snapshot->write(progressUpdate);
+    };
+}
+
+void Scene::loadFromCacheFile(const Progress::UpdateCallback& progressUpdate)
 {
     const auto& geomParams = _parametersManager.getGeometryParameters();
     const auto& filename = geomParams.getLoadCacheFile();
@@ -853,24 +1518,285 @@ void Scene::loadFromCacheFile()
     file.read((char*)&version, sizeof(size_t));
     BRAYNS_INFO << "Version: " << version << std::endl;
 
-    if (version != CACHE_VERSION)
+    bool loaded = false;
+    if (version == LEGACY_CACHE_VERSION)
+        loaded = _loadFromLegacyCacheFile(file);
+    else if (version == CACHE_VERSION || version == COMPRESSED_CACHE_VERSION)
     {
-        BRAYNS_ERROR << "Only version " << CACHE_VERSION << " is supported"
+        file.close();
+        loaded = _loadFromMappedCacheFile(filename, progressUpdate);
+    }
+    else
+        BRAYNS_ERROR << "Only versions " << LEGACY_CACHE_VERSION << " to "
+                     << COMPRESSED_CACHE_VERSION << " are supported"
                      << std::endl;
-        return;
+
+    if (loaded)
+        BRAYNS_INFO << "Scene successfully loaded" << std::endl;
+}
+
+bool Scene::_mapCacheFile(const std::string& filename)
+{
+    _cacheFileDescriptor = ::open(filename.c_str(), O_RDONLY);
+    if (_cacheFileDescriptor == -1)
+    {
+        BRAYNS_ERROR << "Failed to open " << filename << std::endl;
+        return false;
+    }
+
+    struct stat sb;
+    if (::fstat(_cacheFileDescriptor, &sb) == -1)
+    {
+        BRAYNS_ERROR << "Failed to get stats from " << filename << std::endl;
+        _unmapCacheFile();
+        return false;
+    }
+
+    _cacheMemoryMapSize = sb.st_size;
+    _cacheMemoryMapPtr = ::mmap(0, _cacheMemoryMapSize, PROT_READ, MAP_PRIVATE,
+                                _cacheFileDescriptor, 0);
+    if (_cacheMemoryMapPtr == MAP_FAILED)
+    {
+        _cacheMemoryMapPtr = nullptr;
+        BRAYNS_ERROR << "Failed to map " << filename << std::endl;
+        _unmapCacheFile();
+        return false;
+    }
+    return true;
+}
+
+void Scene::_unmapCacheFile()
+{
+    if (_cacheMemoryMapPtr)
+        ::munmap(_cacheMemoryMapPtr, _cacheMemoryMapSize);
+    _cacheMemoryMapPtr = nullptr;
+    _cacheMemoryMapSize = 0;
+
+    if (_cacheFileDescriptor != -1)
+        ::close(_cacheFileDescriptor);
+    _cacheFileDescriptor = -1;
+}
+
+bool Scene::_loadFromMappedCacheFile(
+    const std::string& filename, const Progress::UpdateCallback& progressUpdate)
+{
+    _mappedGeometry.clear();
+    _unmapCacheFile();
+    if (!_mapCacheFile(filename))
+        return false;
+
+    if (_cacheMemoryMapSize < sizeof(CacheHeader))
+    {
+        BRAYNS_ERROR << "Invalid or corrupted cache file " << filename
+                     << std::endl;
+        _unmapCacheFile();
+        return false;
+    }
+
+    const char* data = static_cast<const char*>(_cacheMemoryMapPtr);
+    const auto& header = *reinterpret_cast<const CacheHeader*>(data);
+    const CacheMaterial* materials =
+        reinterpret_cast<const CacheMaterial*>(data + header.materialsOffset);
+    const CacheBlock* blocks =
+        reinterpret_cast<const CacheBlock*>(data + header.blocksOffset);
+
+    // Make sure the table of contents is consistent with the file before
+    // touching the scene
+    bool valid = header.materialsOffset <= _cacheMemoryMapSize &&
+                 header.nbMaterials <=
+                     (_cacheMemoryMapSize - header.materialsOffset) /
+                         sizeof(CacheMaterial) &&
+                 header.blocksOffset <= _cacheMemoryMapSize &&
+                 header.nbBlocks <=
+                     (_cacheMemoryMapSize - header.blocksOffset) /
+                         sizeof(CacheBlock);
+    const bool compressed = header.version == COMPRESSED_CACHE_VERSION;
+    for (uint64_t i = 0; valid && i < header.nbBlocks; ++i)
+    {
+        const auto& block = blocks[i];
+        valid = block.materialId < header.nbMaterials &&
+                block.elementSize != 0 &&
+                block.elementSize == getCacheElementSize(block.type);
+        if (valid && !compressed)
+            valid = block.offset % CACHE_BLOCK_ALIGNMENT == 0 &&
+                    block.offset <= _cacheMemoryMapSize &&
+                    block.nbElements <=
+                        (_cacheMemoryMapSize - block.offset) /
+                            block.elementSize;
+    }
+    if (!valid)
+    {
+        BRAYNS_ERROR << "Invalid or corrupted cache file " << filename
+                     << std::endl;
+        _unmapCacheFile();
+        return false;
+    }
+
+    // Materials
+    BRAYNS_INFO << header.nbMaterials << " materials" << std::endl;
+    resetMaterials();
+    if (header.nbMaterials != 0)
+        _buildMissingMaterials(header.nbMaterials - 1);
+    for (size_t i = 0; i < header.nbMaterials; ++i)
+    {
+        const auto& cacheMaterial = materials[i];
+        auto& material = _materials[i];
+        material.setColor(Vector3f(cacheMaterial.color[0],
+                                   cacheMaterial.color[1],
+                                   cacheMaterial.color[2]));
+        material.setSpecularColor(Vector3f(cacheMaterial.specularColor[0],
+                                           cacheMaterial.specularColor[1],
+                                           cacheMaterial.specularColor[2]));
+        material.setSpecularExponent(cacheMaterial.specularExponent);
+        material.setReflectionIndex(cacheMaterial.reflectionIndex);
+        material.setOpacity(cacheMaterial.opacity);
+        material.setRefractionIndex(cacheMaterial.refractionIndex);
+        material.setEmission(cacheMaterial.emission);
+        material.setGlossiness(cacheMaterial.glossiness);
+        material.setCastSimulationData(cacheMaterial.castSimulationData != 0);
+        // TODO: Textures
+    }
+    commitMaterials();
+
+    if (compressed)
+    {
+        const bool decompressed = _decompressCacheBlocks(progressUpdate);
+        _unmapCacheFile();
+        if (!decompressed)
+        {
+            BRAYNS_ERROR << "Invalid or corrupted cache file " << filename
+                         << std::endl;
+            _spheres.clear();
+            _cylinders.clear();
+            _cones.clear();
+            _trianglesMeshes.clear();
+            return false;
+        }
+        _bounds = Boxf(Vector3f(header.bounds[0], header.bounds[1],
+                                header.bounds[2]),
+                       Vector3f(header.bounds[3], header.bounds[4],
+                                header.bounds[5]));
+        return true;
+    }
+
+    // Geometry. Spheres, cylinders and cones remain in the mapped file if the
+    // engine is able to use them from there, meshes are always copied since
+    // the scene environment may need to extend them
+    const bool useMappedGeometry = supportsMappedGeometry();
+    for (uint64_t i = 0; i < header.nbBlocks; ++i)
+    {
+        const auto& block = blocks[i];
+        const auto materialId = block.materialId;
+        const char* blockData = data + block.offset;
+        BRAYNS_DEBUG << "[" << materialId << "] " << block.nbElements << " "
+                     << CACHE_BLOCK_NAMES[size_t(block.type)] << std::endl;
+
+        switch (block.type)
+        {
+        case CacheBlockType::spheres:
+            if (useMappedGeometry)
+            {
+                auto& mapped = _mappedGeometry[materialId];
+                mapped.spheres = reinterpret_cast<const Sphere*>(blockData);
+                mapped.nbSpheres = block.nbElements;
+            }
+            else
+                assignCacheBlock(_spheres[materialId], blockData,
+                                 block.nbElements);
+            break;
+        case CacheBlockType::cylinders:
+            if (useMappedGeometry)
+            {
+                auto& mapped = _mappedGeometry[materialId];
+                mapped.cylinders = reinterpret_cast<const Cylinder*>(blockData);
+                mapped.nbCylinders = block.nbElements;
+            }
+            else
+                assignCacheBlock(_cylinders[materialId], blockData,
+                                 block.nbElements);
+            break;
+        case CacheBlockType::cones:
+            if (useMappedGeometry)
+            {
+                auto& mapped = _mappedGeometry[materialId];
+                mapped.cones = reinterpret_cast<const Cone*>(blockData);
+                mapped.nbCones = block.nbElements;
+            }
+            else
+                assignCacheBlock(_cones[materialId], blockData,
+                                 block.nbElements);
+            break;
+        case CacheBlockType::vertices:
+            assignCacheBlock(_trianglesMeshes[materialId].vertices, blockData,
+                             block.nbElements);
+            break;
+        case CacheBlockType::indices:
+            assignCacheBlock(_trianglesMeshes[materialId].indices, blockData,
+                             block.nbElements);
+            break;
+        case CacheBlockType::normals:
+            assignCacheBlock(_trianglesMeshes[materialId].normals, blockData,
+                             block.nbElements);
+            break;
+        case CacheBlockType::textureCoordinates:
+            assignCacheBlock(_trianglesMeshes[materialId].textureCoordinates,
+                             blockData, block.nbElements);
+            break;
+        }
     }
 
+    // Scene bounds
+    _bounds = Boxf(Vector3f(header.bounds[0], header.bounds[1],
+                            header.bounds[2]),
+                   Vector3f(header.bounds[3], header.bounds[4],
+                            header.bounds[5]));
+
+    // Nothing references the mapping anymore if everything was copied
+    if (_mappedGeometry.empty())
+        _unmapCacheFile();
+    return true;
+}
+
+bool Scene::_loadFromLegacyCacheFile(std::ifstream& file)
+{
+    // Counts are checked against the size of the file, so that a corrupted
+    // file is rejected instead of triggering huge allocations
+    const auto position = file.tellg();
+    file.seekg(0, std::ios::end);
+    const uint64_t fileSize = file.tellg();
+    file.seekg(position);
+    const auto readCount = [&file, fileSize](const uint64_t elementSize,
+                                             size_t& nbElements) {
+        file.read((char*)&nbElements, sizeof(size_t));
+        if (!file.good())
+            return false;
+        const uint64_t offset = file.tellg();
+        return offset <= fileSize &&
+               nbElements <= (fileSize - offset) / elementSize;
+    };
+    const auto reject = [this]() {
+        BRAYNS_ERROR << "Invalid or corrupted cache file" << std::endl;
+        _spheres.clear();
+        _cylinders.clear();
+        _cones.clear();
+        _trianglesMeshes.clear();
+        return false;
+    };
+
+    // Colors, 6 floats and a boolean per material
     size_t nbMaterials;
-    file.read((char*)&nbMaterials, sizeof(size_t));
+    if (!readCount(2 * sizeof(Vector3f) + 6 * sizeof(float) + sizeof(bool),
+                   nbMaterials))
+        return reject();
     BRAYNS_INFO << nbMaterials << " materials" << std::endl;
 
     // Materials
     resetMaterials();
+    if (nbMaterials != 0)
+        _buildMissingMaterials(nbMaterials - 1);
     for (size_t i = 0; i < nbMaterials; ++i)
     {
-        size_t id;
-        file.read((char*)&id, sizeof(size_t));
-        auto& material = _materials[id];
+        auto& material = _materials[i];
         Vector3f value3f;
         file.read((char*)&value3f, sizeof(Vector3f));
         material.setColor(value3f);
@@ -904,7 +1830,8 @@ void Scene::loadFromCacheFile()
         uint64_t bufferSize{0};
 
         // Spheres
-        file.read((char*)&nbElements, sizeof(size_t));
+        if (!readCount(sizeof(Sphere), nbElements))
+            return reject();
         if (nbElements != 0)
         {
             bufferSize = nbElements * sizeof(Sphere);
@@ -915,7 +1842,8 @@ void Scene::loadFromCacheFile()
         }
 
         // Cylinders
-        file.read((char*)&nbElements, sizeof(size_t));
+        if (!readCount(sizeof(Cylinder), nbElements))
+            return reject();
         if (nbElements != 0)
         {
             bufferSize = nbElements * sizeof(Cylinder);
@@ -926,7 +1854,8 @@ void Scene::loadFromCacheFile()
         }
 
         // Cones
-        file.read((char*)&nbElements, sizeof(size_t));
+        if (!readCount(sizeof(Cone), nbElements))
+            return reject();
         if (nbElements != 0)
         {
             bufferSize = nbElements * sizeof(Cone);
@@ -937,7 +1866,8 @@ void Scene::loadFromCacheFile()
         }
 
         // Vertices
-        file.read((char*)&nbElements, sizeof(size_t));
+        if (!readCount(sizeof(Vector3f), nbElements))
+            return reject();
         if (nbElements != 0)
         {
             BRAYNS_DEBUG << "[" << materialId << "] " << nbElements
@@ -949,7 +1879,8 @@ void Scene::loadFromCacheFile()
         }
 
         // Indices
-        file.read((char*)&nbElements, sizeof(size_t));
+        if (!readCount(sizeof(Vector3ui), nbElements))
+            return reject();
         if (nbElements != 0)
         {
             BRAYNS_DEBUG << "[" << materialId << "] " << nbElements
@@ -961,7 +1892,8 @@ void Scene::loadFromCacheFile()
         }
 
         // Normals
-        file.read((char*)&nbElements, sizeof(size_t));
+        if (!readCount(sizeof(Vector3f), nbElements))
+            return reject();
         if (nbElements != 0)
         {
             BRAYNS_DEBUG << "[" << materialId << "] " << nbElements
@@ -973,7 +1905,8 @@ void Scene::loadFromCacheFile()
         }
 
         // Texture coordinates
-        file.read((char*)&nbElements, sizeof(size_t));
+        if (!readCount(sizeof(Vector2f), nbElements))
+            return reject();
         if (nbElements != 0)
         {
             BRAYNS_DEBUG << "[" << materialId << "] " << nbElements
@@ -988,9 +1921,169 @@ void Scene::loadFromCacheFile()
 
     // Scene bounds
     file.read((char*)&_bounds, sizeof(Boxf));
+    if (!file.good())
+        return reject();
     file.close();
+    return true;
+}
+
+bool Scene::_decompressCacheBlocks(
+    const Progress::UpdateCallback& progressUpdate)
+{
+#ifdef BRAYNS_USE_LZ4
+    struct DecompressionJob
+    {
+        const char* source;
+        char* destination;
+        uint64_t compressedSize;
+        uint64_t size;
+    };
+
+    const char* data = static_cast<const char*>(_cacheMemoryMapPtr);
+    const auto& header = *reinterpret_cast<const CacheHeader*>(data);
+    const CacheBlock* blocks =
+        reinterpret_cast<const CacheBlock*>(data + header.blocksOffset);
+
+    // Allocate the scene containers and list the chunks to decompress
+    std::vector<DecompressionJob> jobs;
+    uint64_t totalSize = 0;
+    uint64_t totalCompressedSize = 0;
+    for (uint64_t i = 0; i < header.nbBlocks; ++i)
+    {
+        const auto& block = blocks[i];
+        if (block.offset > _cacheMemoryMapSize - sizeof(uint64_t))
+            return false;
+        const uint64_t nbChunks =
+            *reinterpret_cast<const uint64_t*>(data + block.offset);
+        const uint64_t chunksOffset = block.offset + sizeof(uint64_t);
+        if (nbChunks >
+            (_cacheMemoryMapSize - chunksOffset) / sizeof(CacheChunk))
+            return false;
+        const CacheChunk* chunks =
+            reinterpret_cast<const CacheChunk*>(data + chunksOffset);
+
+        // Chunk sizes are checked before anything is allocated: they are
+        // bounded by the size written by the compressor and by the best LZ4
+        // ratio, and the compressed chunks of all blocks must fit in the file
+        uint64_t blockSize = 0;
+        for (uint64_t j = 0; j < nbChunks; ++j)
+        {
+            const auto& chunk = chunks[j];
+            if (chunk.size == 0 || chunk.size > CACHE_CHUNK_SIZE ||
+                chunk.compressedSize == 0 ||
+                chunk.size > chunk.compressedSize * LZ4_MAX_COMPRESSION_RATIO ||
+                chunk.offset > _cacheMemoryMapSize ||
+                chunk.compressedSize > _cacheMemoryMapSize - chunk.offset ||
+                chunk.compressedSize >
+                    _cacheMemoryMapSize - totalCompressedSize)
+            {
+                return false;
+            }
+            totalCompressedSize += chunk.compressedSize;
+            blockSize += chunk.size;
+        }
+        if (block.nbElements > blockSize / block.elementSize ||
+            block.nbElements * block.elementSize != blockSize)
+            return false;
+
+        const auto materialId = block.materialId;
+        char* destination = nullptr;
+        switch (block.type)
+        {
+        case CacheBlockType::spheres:
+            destination =
+                resizeCacheBlock(_spheres[materialId], block.nbElements);
+            break;
+        case CacheBlockType::cylinders:
+            destination =
+                resizeCacheBlock(_cylinders[materialId], block.nbElements);
+            break;
+        case CacheBlockType::cones:
+            destination = resizeCacheBlock(_cones[materialId], block.nbElements);
+            break;
+        case CacheBlockType::vertices:
+            destination = resizeCacheBlock(_trianglesMeshes[materialId].vertices,
+                                           block.nbElements);
+            break;
+        case CacheBlockType::indices:
+            destination = resizeCacheBlock(_trianglesMeshes[materialId].indices,
+                                           block.nbElements);
+            break;
+        case CacheBlockType::normals:
+            destination = resizeCacheBlock(_trianglesMeshes[materialId].normals,
+                                           block.nbElements);
+            break;
+        case CacheBlockType::textureCoordinates:
+            destination = resizeCacheBlock(
+                _trianglesMeshes[materialId].textureCoordinates,
+                block.nbElements);
+            break;
+        }
+        BRAYNS_DEBUG << "[" << materialId << "] " << block.nbElements << " "
+                     << CACHE_BLOCK_NAMES[size_t(block.type)] << std::endl;
+
+        uint64_t position = 0;
+        for (uint64_t j = 0; j < nbChunks; ++j)
+        {
+            const auto& chunk = chunks[j];
+            jobs.push_back({data + chunk.offset, destination + position,
+                            chunk.compressedSize, chunk.size});
+            position += chunk.size;
+        }
+        totalSize += blockSize;
+    }
+
+    // Decompress all chunks in parallel
+    const auto startTime = std::chrono::high_resolution_clock::now();
+    std::atomic_size_t decompressedSize{0};
+    std::atomic_size_t failures{0};
+#pragma omp parallel for schedule(dynamic)
+    for (size_t i = 0; i < jobs.size(); ++i)
+    {
+        const auto& job = jobs[i];
+        const int size =
+            LZ4_decompress_safe(job.source, job.destination,
+                                job.compressedSize, job.size);
+        if (size < 0 || uint64_t(size) != job.size)
+        {
+            ++failures;
+            continue;
+        }
+        decompressedSize += job.size;
+
+        if (!progressUpdate)
+            continue;
+#ifdef BRAYNS_USE_OPENMP
+        if (omp_get_thread_num() != 0)
+            continue;
+#endif
+        const float elapsed =
+            std::chrono::duration<float>(
+                std::chrono::high_resolution_clock::now() - startTime)
+                .count();
+        std::stringstream message;
+        message << "Decompressing cache file ("
+                << size_t(decompressedSize / 1048576.f /
+                          std::max(elapsed, 1e-3f))
+                << " MB/s) ...";
+        progressUpdate(message.str(), float(decompressedSize) / totalSize);
+    }
 
-    BRAYNS_INFO << "Scene successfully loaded" << std::endl;
+    const float elapsed = std::chrono::duration<float>(
+                              std::chrono::high_resolution_clock::now() -
+                              startTime)
+                              .count();
+    BRAYNS_INFO << "Decompressed " << totalSize / 1048576 << " MB in "
+                << elapsed << " seconds ("
+                << size_t(totalSize / 1048576.f / std::max(elapsed, 1e-3f))
+                << " MB/s)" << std::endl;
+    return failures == 0;
+#else
+    (void)progressUpdate;
+    BRAYNS_ERROR << "Brayns was built without LZ4, compressed cache files "
+                 << "are not supported" << std::endl;
+    return false;
+#endif
 }
 
 size_t Scene::addMaterial(const Material& material)
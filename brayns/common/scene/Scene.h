@@ -22,8 +22,10 @@
 #define SCENE_H
 
 #include <brayns/api.h>
+#include <brayns/common/Progress.h>
 #include <brayns/common/geometry/Cone.h>
 #include <brayns/common/geometry/Cylinder.h>
+#include <brayns/common/geometry/InstancedGeometry.h>
 #include <brayns/common/geometry/Sphere.h>
 #include <brayns/common/geometry/TrianglesMesh.h>
 #include <brayns/common/material/Material.h>
@@ -32,6 +34,8 @@
 #include <brayns/common/transferFunction/TransferFunction.h>
 #include <brayns/common/types.h>
 
+#include <mutex>
+
 namespace brayns
 {
 /**
@@ -147,17 +151,30 @@ public:
     }
 
     /**
-        Returns spheres handled by the scene
+        Returns spheres handled by the scene. Primitives that still live in a
+        memory-mapped cache file are copied into the returned container first
     */
-    BRAYNS_API SpheresMap& getSpheres() { return _spheres; }
+    BRAYNS_API SpheresMap& getSpheres()
+    {
+        _detachAllMappedGeometry();
+        return _spheres;
+    }
     /**
-        Returns cylinders handled by the scene
+        Returns cylinders handled by the scene. See getSpheres()
     */
-    BRAYNS_API CylindersMap& getCylinders() { return _cylinders; }
+    BRAYNS_API CylindersMap& getCylinders()
+    {
+        _detachAllMappedGeometry();
+        return _cylinders;
+    }
     /**
-        Returns cones handled by the scene
+        Returns cones handled by the scene. See getSpheres()
     */
-    BRAYNS_API ConesMap& getCones() { return _cones; }
+    BRAYNS_API ConesMap& getCones()
+    {
+        _detachAllMappedGeometry();
+        return _cones;
+    }
     /**
         Returns textures handled by the scene
     */
@@ -211,33 +228,52 @@ public:
     /** Loads geometry a binary cache file defined by the --load-cache-file
        command line parameter. The cache file is a binary representation of the
        following structure:
-       - Version
-       - Number of materials
+       - Header (version, number of materials, number of sections, offsets of
+         the materials and of the table of contents, scene bounds)
        - Materials
-       - For each material:
-         - Number of spheres
-         - Spheres
-         - Number of cylinders
-         - Cylinders
-         - Number of cones
-         - Cones
-         - Number of vertices
-         - Vertices
-         - Number of indices
-         - Indices
-         - Number of normals
-         - Normals
-         - Number of texture coordinates
-         - Texture coordinates
-       - Scene bounds
-    */
-    BRAYNS_API void loadFromCacheFile();
+       - Table of contents: for each non-empty block of a given material, its
+         type (spheres, cylinders, cones, vertices, indices, normals or texture
+         coordinates), element size, number of elements and offset in the file
+       - Blocks, each one starting on a page boundary
+
+       The file is memory-mapped. If the engine supports it (see
+       supportsMappedGeometry()), sphere, cylinder and cone blocks are handed
+       over to the engine directly from the mapping, without being copied
+       into the scene containers. Files written with the previous version of
+       the format (sequential stream of blocks) can still be loaded.
+
+       If the cache file was saved with --compress-cache-file, every block is
+       made of LZ4 chunks that are decompressed in parallel into the scene
+       containers.
+       @param progressUpdate Callback reporting decompression progress and
+              throughput
+    */
+    BRAYNS_API void loadFromCacheFile(
+        const Progress::UpdateCallback& progressUpdate =
+            Progress::UpdateCallback());
 
     /**
         Saves geometry a binary cache file defined by the --save-cache-file
        command line parameter. See loadFromCacheFile for file structure
+       @return true if the file was successfully written
     */
-    BRAYNS_API void saveToCacheFile();
+    BRAYNS_API bool saveToCacheFile();
+
+    /**
+        Writes a cache file and reports progress in the 0..1 range. Returns
+        true if the file was successfully written.
+    */
+    using CacheFileWriter =
+        std::function<bool(const Progress::UpdateCallback& progressUpdate)>;
+
+    /**
+        Takes a snapshot of the materials and geometry buffers of the scene,
+       and returns a writer that saves this snapshot to the file defined by
+       the --save-cache-file command line parameter. The writer does not access
+       the scene and can be run in a background thread while the scene is
+       committed, rendered and modified.
+    */
+    BRAYNS_API CacheFileWriter createCacheFileWriter();
 
     /**
      * @return true if the given volume file is supported by the engines' scene.
@@ -251,12 +287,60 @@ public:
      *        and sent to the rendering engine
      */
     BRAYNS_API void setSpheresDirty(const bool value) { _spheresDirty = value; }
+    /**
+     * @brief Sets a range of spheres of a material as dirty, after they were
+     *        modified in place through getMaterialSpheres(). Only that range
+     *        is sent to the rendering engine by the next serializeGeometry(),
+     *        as for setSphere(). The number of spheres must not have changed
+     *        since they were last committed, see commitSpheres() otherwise.
+     * @param materialId Material of the spheres
+     * @param begin Index of the first modified sphere
+     * @param end Index following the last modified sphere
+     */
+    BRAYNS_API void setSpheresDirty(size_t materialId, uint64_t begin,
+                                    uint64_t end);
+    /**
+     * @return true if spheres need to be serialized, either all of them or the
+     *         modified ranges of some materials. See serializeGeometry()
+     */
+    BRAYNS_API bool isSpheresDirty() const
+    {
+        return _spheresDirty || !_dirtySpheres.empty();
+    }
+
+    /**
+      Returns the spheres of a material, to be modified in place. Only the
+      given material is copied out of a memory-mapped cache file. Call
+      commitSpheres() once done so that the new values are sent to the
+      rendering engine. The world bounds are not updated.
+      @param materialId Material of the spheres
+      */
+    BRAYNS_API Spheres& getMaterialSpheres(const size_t materialId);
+
+    /**
+      Sends the spheres of a material to the rendering engine, leaving the
+      geometry of the other materials untouched. The default implementation
+      marks all spheres as dirty, serializeGeometry() then has to be called.
+      @param materialId Material of the spheres
+      */
+    BRAYNS_API virtual void commitSpheres(const size_t materialId);
     /**
      * @return true if unload() can be performed. Some implementations might not
      *         support it, hence deletion of the scene or the entire engine is
      * required.
      */
     virtual bool supportsUnloading() const { return true; }
+    /**
+     * @return true if the engine can render spheres, cylinders and cones
+     *         straight from a memory-mapped cache file. If false, primitives
+     *         are copied into the scene containers when the cache is loaded.
+     */
+    virtual bool supportsMappedGeometry() const { return false; }
+    /**
+     * @return true if the engine can render several instances of the same
+     *         geometry without copying it. See addInstancedGeometry().
+     */
+    virtual bool supportsInstancing() const { return false; }
     /**
      * @internal needed to ensure deletion wrt cyclic dependency
      *           scene<->renderer
@@ -298,7 +382,141 @@ public:
                                     const Cylinder& cylinder);
 
     /**
-      Replaces a sphere in the scene
+      Adds spheres to the scene in a single operation
+      @param materialId Material of the spheres
+      @param spheres Spheres to add
+      @return Index of the first sphere for the specified material
+      */
+    BRAYNS_API uint64_t addSpheres(const size_t materialId,
+                                   const Spheres& spheres);
+
+    /**
+      Adds spheres to the scene without copying them if the material does not
+      have any sphere yet
+      @param materialId Material of the spheres
+      @param spheres Spheres to add, left in a valid but unspecified state
+      @return Index of the first sphere for the specified material
+      */
+    BRAYNS_API uint64_t addSpheres(const size_t materialId, Spheres&& spheres);
+
+    /**
+      Adds cones to the scene in a single operation
+      @param materialId Material of the cones
+      @param cones Cones to add
+      @return Index of the first cone for the specified material
+      */
+    BRAYNS_API uint64_t addCones(const size_t materialId, const Cones& cones);
+
+    /**
+      Adds cones to the scene without copying them if the material does not
+      have any cone yet
+      @param materialId Material of the cones
+      @param cones Cones to add, left in a valid but unspecified state
+      @return Index of the first cone for the specified material
+      */
+    BRAYNS_API uint64_t addCones(const size_t materialId, Cones&& cones);
+
+    /**
+      Adds cylinders to the scene in a single operation
+      @param materialId Material of the cylinders
+      @param cylinders Cylinders to add
+      @return Index of the first cylinder for the specified material
+      */
+    BRAYNS_API uint64_t addCylinders(const size_t materialId,
+                                     const Cylinders& cylinders);
+
+    /**
+      Adds cylinders to the scene without copying them if the material does
+      not have any cylinder yet
+      @param materialId Material of the cylinders
+      @param cylinders Cylinders to add, left in a valid but unspecified state
+      @return Index of the first cylinder for the specified material
+      */
+    BRAYNS_API uint64_t addCylinders(const size_t materialId,
+                                     Cylinders&& cylinders);
+
+    /**
+      Reserves memory for primitives that are about to be added to a material,
+      so that adding them one by one does not reallocate the containers
+      @param materialId Material of the primitives
+      @param nbSpheres Number of spheres to reserve
+      @param nbCylinders Number of cylinders to reserve
+      @param nbCones Number of cones to reserve
+      */
+    BRAYNS_API void reserveGeometry(const size_t materialId,
+                                    const size_t nbSpheres,
+                                    const size_t nbCylinders = 0,
+                                    const size_t nbCones = 0);
+
+    /**
+      Adds geometry that is placed several times in the scene. If the engine
+      supports it (see supportsInstancing()), the geometry is built once and
+      referenced by every instance. Otherwise, and when the scene is saved to a
+      cache file, one copy per transformation is added to the scene containers.
+      @param geometry Geometry and transformations of its instances
+      */
+    BRAYNS_API void addInstancedGeometry(InstancedGeometryPtr geometry);
+
+    /** @return the geometries added with addInstancedGeometry() */
+    const InstancedGeometries& getInstancedGeometries() const
+    {
+        return _instancedGeometries;
+    }
+
+    /**
+      Returns a coarse level of detail of the geometry, rendered instead of the
+      spheres, cylinders and cones of the scene when selected with
+      setLevelOfDetail(). Coarse levels are only generated by the loaders when
+      requested (see --circuit-levels-of-detail), and are not saved to cache
+      files. They are built along with the rest of the geometry in
+      buildGeometry(): spheres, cylinders and cones modified afterwards, with
+      commitSpheres() for instance, are only updated at the full level.
+      @param level Level of detail, coarser than LevelOfDetail::full
+      */
+    BRAYNS_API InstancedGeometry& getCoarseGeometry(const LevelOfDetail level)
+    {
+        return _coarseGeometry[size_t(level)];
+    }
+
+    /**
+      Selects the level of detail at which the geometry is rendered. The full
+      geometry is rendered if the given level was not generated.
+      */
+    BRAYNS_API void setLevelOfDetail(const LevelOfDetail level);
+    LevelOfDetail getLevelOfDetail() const { return _levelOfDetail; }
+
+    /**
+      Publishes geometry while the scene is still loading, so that it can be
+      rendered before the scene is complete. Batches are in world coordinates,
+      and are not part of the scene containers: the loader still adds the
+      geometry to the scene, which replaces the batches once buildGeometry()
+      is called. Can be called from any thread.
+      @param batch Geometry to render, with a single identity transformation
+      */
+    BRAYNS_API void addGeometryBatch(InstancedGeometryPtr batch);
+
+    /** @return true if geometry batches are currently published */
+    BRAYNS_API bool hasGeometryBatches() const;
+
+    /**
+      Converts the batches published since the last call into rendering engine
+      specific data structures, and adds them to the rendered geometry. Called
+      by the rendering thread, with the loading mutex locked.
+      @return true if new batches were committed
+      */
+    BRAYNS_API virtual bool commitGeometryBatches() { return false; }
+
+    /**
+      Mutex serializing modifications of the scene by the loading thread, and
+      rendering of the batches of a scene that is still loading
+      */
+    std::mutex& getLoadingMutex() { return _loadingMutex; }
+
+    /**
+      Replaces a sphere in the scene. Only the range of modified primitives of
+      the material is sent to the rendering engine by the next
+      serializeGeometry(), unless the geometry of the scene is serialized again
+      as a whole.
       @param materialId Material of the sphere
       @param index Index of the sphere in the scene, for the given material
       @param sphere New sphere
@@ -308,7 +526,7 @@ public:
                               const Sphere& sphere);
 
     /**
-      Replaces a cone in the scene
+      Replaces a cone in the scene. See setSphere()
       @param materialId Material of the cone
       @param index Index of the cone in the scene, for the given material
       @param cone New sphere
@@ -318,7 +536,7 @@ public:
                             const Cone& cone);
 
     /**
-      Replaces a cylinder in the scene
+      Replaces a cylinder in the scene. See setSphere()
       @param materialId Material of the cylinder
       @param index Index of the cylinder in the scene, for the given material
       @param cylinder New cylinder
@@ -376,6 +594,47 @@ public:
 protected:
     void _buildMissingMaterials(const size_t materialId);
 
+    /** Range of primitives of a material modified since the last update */
+    struct DirtyRange
+    {
+        uint64_t begin{0};
+        uint64_t end{0};
+        /** True if the primitives moved in memory since they were serialized */
+        bool moved{false};
+    };
+    typedef std::map<size_t, DirtyRange> DirtyRanges;
+
+    /** Adds modified primitives to the dirty range of their material */
+    void _markDirty(DirtyRanges& ranges, size_t materialId, uint64_t begin,
+                    uint64_t end);
+
+    /**
+        Returns the batches published since the last call. They are kept by the
+        scene until the next unload, since the engine may share their memory
+    */
+    InstancedGeometries _takeGeometryBatches();
+
+    /** Releases the batches, once the engine no longer references them */
+    void _clearGeometryBatches();
+
+    /**
+        Returns the number of spheres for a given material, and sets spheres
+        to their location, which is either the scene container or the
+        memory-mapped cache file
+    */
+    uint64_t _getSpheresData(const size_t materialId,
+                             const Sphere*& spheres) const;
+    uint64_t _getCylindersData(const size_t materialId,
+                               const Cylinder*& cylinders) const;
+    uint64_t _getConesData(const size_t materialId, const Cone*& cones) const;
+
+    /**
+        Copies the primitives of a material that live in the memory-mapped
+        cache file into the scene containers, so that they can be modified
+    */
+    void _detachMappedGeometry(const size_t materialId);
+    void _detachAllMappedGeometry();
+
     // Parameters
     ParametersManager& _parametersManager;
     Renderers _renderers;
@@ -387,6 +646,9 @@ protected:
     bool _cylindersDirty;
     ConesMap _cones;
     bool _conesDirty;
+    DirtyRanges _dirtySpheres;
+    DirtyRanges _dirtyCylinders;
+    DirtyRanges _dirtyCones;
     TrianglesMeshMap _trianglesMeshes;
     bool _trianglesMeshesDirty;
     Materials _materials;
@@ -401,13 +663,53 @@ protected:
     TransferFunction _transferFunction;
     CADiffusionSimulationHandlerPtr _caDiffusionSimulationHandler;
 
+    // Geometry living in a memory-mapped cache file
+    struct MappedGeometry
+    {
+        const Sphere* spheres{nullptr};
+        uint64_t nbSpheres{0};
+        const Cylinder* cylinders{nullptr};
+        uint64_t nbCylinders{0};
+        const Cone* cones{nullptr};
+        uint64_t nbCones{0};
+    };
+    std::map<size_t, MappedGeometry> _mappedGeometry;
+
+    InstancedGeometries _instancedGeometries;
+
+    // Levels of detail
+    InstancedGeometry _coarseGeometry[NB_COARSE_LEVELS_OF_DETAIL];
+    LevelOfDetail _levelOfDetail{LevelOfDetail::full};
+
+    // Geometry rendered while the scene is loading
+    mutable std::mutex _geometryBatchesMutex;
+    InstancedGeometries _geometryBatches;
+    size_t _nbCommittedGeometryBatches{0};
+
     // Scene
     Boxf _bounds;
 
     bool _modified = false;
 
 private:
+    struct CacheSnapshot;
+    std::shared_ptr<CacheSnapshot> _createCacheSnapshot(
+        const bool copyGeometry);
     void _markGeometryDirty();
+    void _addInstancedGeometryCopies(const InstancedGeometry& geometry);
+    bool _loadFromLegacyCacheFile(std::ifstream& file);
+    bool _loadFromMappedCacheFile(
+        const std::string& filename,
+        const Progress::UpdateCallback& progressUpdate);
+    bool _decompressCacheBlocks(const Progress::UpdateCallback& progressUpdate);
+    bool _mapCacheFile(const std::string& filename);
+    void _unmapCacheFile();
+
+    void* _cacheMemoryMapPtr;
+    uint64_t _cacheMemoryMapSize;
+    int _cacheFileDescriptor;
+
+    std::mutex _loadingMutex;
 };
 }
 #endif // SCENE_H
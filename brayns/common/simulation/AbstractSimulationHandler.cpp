@@ -23,10 +23,123 @@
 #include <brayns/common/log.h>
 #include <brayns/parameters/GeometryParameters.h>
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 #include <fcntl.h>
 #include <fstream>
 #include <sys/mman.h>
 #include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef BRAYNS_USE_OPENMP
+#include <omp.h>
+#endif
+
+namespace
+{
+/**
+ * Builds the histogram of the given frames in a single parallel region. Every
+ * thread handles a contiguous part of every frame: it first computes the range
+ * of its part, and once the ranges of all threads are reduced, bins the same
+ * part, which is still in its cache, with that fixed range. Non-finite values
+ * are ignored.
+ */
+brayns::Histogram computeHistogram(
+    const std::vector<std::shared_ptr<const float>>& frames,
+    const uint64_t frameSize, const size_t histogramSize,
+    const uint32_t frame)
+{
+    brayns::Histogram histogram;
+    histogram.frame = frame;
+    histogram.values.resize(histogramSize, 0);
+
+#ifdef BRAYNS_USE_OPENMP
+    const size_t nbThreads = omp_get_max_threads();
+#else
+    const size_t nbThreads = 1;
+#endif
+    floats minValues(nbThreads, std::numeric_limits<float>::max());
+    floats maxValues(nbThreads, -std::numeric_limits<float>::max());
+    std::vector<uint64_ts> bins(nbThreads);
+    float minValue = std::numeric_limits<float>::max();
+    float maxValue = -std::numeric_limits<float>::max();
+    float scale = 0.f;
+
+#pragma omp parallel num_threads(nbThreads)
+    {
+#ifdef BRAYNS_USE_OPENMP
+        const size_t thread = omp_get_thread_num();
+        const size_t nbActiveThreads = omp_get_num_threads();
+#else
+        const size_t thread = 0;
+        const size_t nbActiveThreads = 1;
+#endif
+        const uint64_t begin = frameSize * thread / nbActiveThreads;
+        const uint64_t end = frameSize * (thread + 1) / nbActiveThreads;
+
+        float localMin = minValues[thread];
+        float localMax = maxValues[thread];
+        for (const auto& values : frames)
+        {
+            const float* data = values.get();
+            for (uint64_t i = begin; i < end; ++i)
+            {
+                const float value = data[i];
+                if (!std::isfinite(value))
+                    continue;
+                localMin = std::min(localMin, value);
+                localMax = std::max(localMax, value);
+            }
+        }
+        minValues[thread] = localMin;
+        maxValues[thread] = localMax;
+
+#pragma omp barrier
+#pragma omp single
+        {
+            for (size_t i = 0; i < nbThreads; ++i)
+            {
+                minValue = std::min(minValue, minValues[i]);
+                maxValue = std::max(maxValue, maxValues[i]);
+            }
+            // Computed in double precision, since the range of finite values
+            // may not be. Values are all in the first bin if it is empty.
+            const double range = double(maxValue) - double(minValue);
+            if (range > 0.0)
+                scale = float(double(histogramSize - 1) / range);
+        }
+
+        // The index is clamped before the conversion, which would otherwise
+        // be undefined for positions out of the range of size_t
+        const float lastBin = float(histogramSize - 1);
+        auto& localBins = bins[thread];
+        localBins.resize(histogramSize, 0);
+        if (minValue <= maxValue)
+            for (const auto& values : frames)
+            {
+                const float* data = values.get();
+                for (uint64_t i = begin; i < end; ++i)
+                {
+                    const float value = data[i];
+                    if (!std::isfinite(value))
+                        continue;
+                    const float position = (value - minValue) * scale;
+                    ++localBins[size_t(std::min(position, lastBin))];
+                }
+            }
+    }
+
+    for (const auto& localBins : bins)
+        for (size_t i = 0; i < localBins.size(); ++i)
+            histogram.values[i] += localBins[i];
+    if (minValue <= maxValue)
+        histogram.range = brayns::Vector2f(minValue, maxValue);
+    else
+        histogram.range = brayns::Vector2f(0.f, 0.f);
+    return histogram;
+}
+}
 
 namespace brayns
 {
@@ -39,24 +152,20 @@ AbstractSimulationHandler::AbstractSimulationHandler(
     , _headerSize(0)
     , _memoryMapPtr(0)
     , _cacheFileDescriptor(-1)
-    , _frameData(nullptr)
 {
     _histogram.frame = _currentFrame;
 }
 
 AbstractSimulationHandler::~AbstractSimulationHandler()
 {
+    // The histogram may be reading frames of the memory mapped cache file
+    if (_histogramFuture.valid())
+        _histogramFuture.wait();
+
     if (_memoryMapPtr)
-    {
-        const uint64_t size =
-            _headerSize + _frameSize * _nbFrames * sizeof(float);
-        ::munmap((void*)_memoryMapPtr, size);
-    }
+        ::munmap((void*)_memoryMapPtr, _memoryMapSize);
     if (_cacheFileDescriptor != -1)
         ::close(_cacheFileDescriptor);
-
-    if (_frameData)
-        delete[] _frameData;
 }
 
 bool AbstractSimulationHandler::attachSimulationToCacheFile(
@@ -95,11 +204,17 @@ bool AbstractSimulationHandler::attachSimulationToCacheFile(
         return false;
     }
 
-    _headerSize = 2 * sizeof(uint64_t);
+    _memoryMapSize = sb.st_size;
 
-    strncpy((char*)&_nbFrames, (char*)_memoryMapPtr, sizeof(_nbFrames));
-    strncpy((char*)&_frameSize, ((char*)_memoryMapPtr + sizeof(_nbFrames)),
-            sizeof(_frameSize));
+    if (!_readCacheHeader())
+    {
+        BRAYNS_ERROR << "Invalid cache file " << cacheFile << std::endl;
+        ::munmap((void*)_memoryMapPtr, _memoryMapSize);
+        _memoryMapPtr = 0;
+        ::close(_cacheFileDescriptor);
+        _cacheFileDescriptor = -1;
+        return false;
+    }
 
     BRAYNS_INFO << "Nb Frames: " << _nbFrames << std::endl;
     BRAYNS_INFO << "Frame size: " << _frameSize << std::endl;
@@ -108,6 +223,22 @@ bool AbstractSimulationHandler::attachSimulationToCacheFile(
     return true;
 }
 
+bool AbstractSimulationHandler::_readCacheHeader()
+{
+    // Same layout as written by writeHeader()
+    _headerSize = sizeof(_nbFrames) + sizeof(_frameSize);
+    if (_memoryMapSize < _headerSize)
+        return false;
+
+    memcpy(&_nbFrames, (char*)_memoryMapPtr, sizeof(_nbFrames));
+    memcpy(&_frameSize, ((char*)_memoryMapPtr + sizeof(_nbFrames)),
+           sizeof(_frameSize));
+
+    // Frames are played in place, they must all be in the file
+    const uint64_t available = (_memoryMapSize - _headerSize) / sizeof(float);
+    return _frameSize == 0 || _nbFrames <= available / _frameSize;
+}
+
 void AbstractSimulationHandler::writeHeader(std::ofstream& stream)
 {
     stream.write((char*)&_nbFrames, sizeof(_nbFrames));
@@ -122,43 +253,69 @@ void AbstractSimulationHandler::writeFrame(std::ofstream& stream,
 
 const Histogram& AbstractSimulationHandler::getHistogram()
 {
+    if (_histogramFuture.valid())
+    {
+        if (_histogramFuture.wait_for(std::chrono::seconds(0)) !=
+            std::future_status::ready)
+        {
+            return _histogram;
+        }
+        _histogram = _histogramFuture.get();
+    }
+
     if (!histogramChanged())
         return _histogram;
 
-    float* data = (float*)getFrameData(_currentFrame);
-    if (!data)
+    const float* data = (const float*)getFrameData(_currentFrame);
+    if (!data || _frameSize == 0)
         return _histogram;
 
-    // Determine range
-    Vector2f range(std::numeric_limits<float>::max(),
-                   -std::numeric_limits<float>::max());
-    for (uint64_t i = 0; i < _frameSize; ++i)
-    {
-        float value = data[i];
-        range.x() = std::min(range.x(), value);
-        range.y() = std::max(range.y(), value);
-    }
+    // Keep the frames of the window, so that they can be read by the
+    // background computation
+    const size_t window =
+        _geometryParameters.getCircuitSimulationHistogramWindow();
+    const uint32_t currentFrame = _currentFrame;
+    const uint32_t nbFrames = std::max(_nbFrames, currentFrame + 1);
+    _histogramFrames.erase(
+        std::remove_if(_histogramFrames.begin(), _histogramFrames.end(),
+                       [&](const HistogramFrame& histogramFrame) {
+                           const uint32_t distance =
+                               (currentFrame + nbFrames -
+                                histogramFrame.frame) %
+                               nbFrames;
+                           return distance == 0 || distance >= window;
+                       }),
+        _histogramFrames.end());
+    _histogramFrames.push_back({currentFrame, _shareFrameData(data)});
 
-    // Normalize values
-    const auto histogramSize =
-        _geometryParameters.getCircuitSimulationHistogramSize();
-    _histogram.values.clear();
-    _histogram.values.resize(histogramSize, 0);
-    const float normalizationValue =
-        (range.y() - range.x()) / float(histogramSize - 1);
-    for (uint64_t i = 0; i < _frameSize; ++i)
-    {
-        const size_t idx = (data[i] - range.x()) / normalizationValue;
-        assert(idx < histogramSize);
-        ++_histogram.values[idx];
-    }
+    std::vector<std::shared_ptr<const float>> frames;
+    for (const auto& histogramFrame : _histogramFrames)
+        frames.push_back(histogramFrame.values);
 
-    // Build histogram
-    _histogram.range = range;
-    _histogram.frame = _currentFrame;
+    const uint64_t frameSize = _frameSize;
+    const size_t histogramSize = std::max<size_t>(
+        1, _geometryParameters.getCircuitSimulationHistogramSize());
+    _histogramFuture = std::async(std::launch::async, [frames, frameSize,
+                                                       histogramSize,
+                                                       currentFrame] {
+        return computeHistogram(frames, frameSize, histogramSize,
+                                currentFrame);
+    });
     return _histogram;
 }
 
+std::shared_ptr<const float> AbstractSimulationHandler::_shareFrameData(
+    const float* data)
+{
+    // Frames of the cache file outlive the computation, which the destructor
+    // waits for
+    if (hasPersistentFrameData())
+        return std::shared_ptr<const float>(data, [](const float*) {});
+
+    auto values = std::make_shared<floats>(data, data + _frameSize);
+    return std::shared_ptr<const float>(values, values->data());
+}
+
 bool AbstractSimulationHandler::histogramChanged() const
 {
     return _currentFrame != _histogram.frame;
@@ -168,4 +325,35 @@ uint32_t AbstractSimulationHandler::_getBoundedFrame(const uint32_t frame) const
 {
     return _nbFrames == 0 ? frame : frame % _nbFrames;
 }
+
+void* AbstractSimulationHandler::_getCacheFrame(const uint32_t frame) const
+{
+    const uint64_t frameSize = _frameSize * sizeof(float);
+    return (unsigned char*)_memoryMapPtr + _headerSize + frame * frameSize;
+}
+
+void AbstractSimulationHandler::_adviseCacheFrames(const uint32_t firstFrame,
+                                                   uint32_t nbFrames) const
+{
+    if (!_memoryMapPtr || _nbFrames == 0)
+        return;
+
+    nbFrames = std::min(nbFrames, _nbFrames);
+    const uint64_t frameSize = _frameSize * sizeof(float);
+    const uint64_t pageSize = ::sysconf(_SC_PAGESIZE);
+    const auto advise = [&](const uint32_t begin, const uint32_t end) {
+        const uint64_t offset = _headerSize + begin * frameSize;
+        const uint64_t alignedOffset = offset - offset % pageSize;
+        ::madvise((unsigned char*)_memoryMapPtr + alignedOffset,
+                  _headerSize + end * frameSize - alignedOffset,
+                  MADV_WILLNEED);
+    };
+
+    // Frames wrap around the end of the simulation
+    const uint32_t begin = _getBoundedFrame(firstFrame);
+    const uint32_t end = std::min(begin + nbFrames, _nbFrames);
+    advise(begin, end);
+    if (end - begin < nbFrames)
+        advise(0, nbFrames - (end - begin));
+}
 }
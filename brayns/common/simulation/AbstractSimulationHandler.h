@@ -24,6 +24,9 @@
 #include <brayns/api.h>
 #include <brayns/common/types.h>
 
+#include <future>
+#include <memory>
+
 namespace brayns
 {
 /**
@@ -74,10 +77,19 @@ public:
     uint32_t getCurrentFrame() const { return _currentFrame; }
     /**
      * @brief returns a void pointer to the simulation data for the given frame
-     * or nullptr if the frame is not loaded yet.
+     * or nullptr if the frame is not loaded yet. The data is read-only, and
+     * remains valid until the next call, or as long as the handler exists if
+     * hasPersistentFrameData() returns true.
      */
     virtual void* getFrameData(uint32_t frame) = 0;
 
+    /**
+     * @return true if the frames returned by getFrameData() remain valid and
+     * unchanged as long as the handler exists, like frames of a memory mapped
+     * cache file, false if the handler reuses or frees its buffers
+     */
+    virtual bool hasPersistentFrameData() const { return false; }
+
     /**
      * @brief getFrameSize return the size of the current simulation frame
      */
@@ -96,20 +108,19 @@ public:
     void setNbFrames(const uint32_t nbFrames) { _nbFrames = nbFrames; }
     /**
      * @brief getHistogram returns the Histogram of the values in the current
-     * simulation frame. The
-     *        size of the histogram is defined by the
-     * --simulation-histogram-size command line
-     *        parameter (128 by default). To build the histogram, occurrences of
-     * the same value are
-     *        counted and spread along the histogram according to the calculated
-     * range. The
-     *        range is defined by the minimum and maximum value of the current
-     * frame. The Histogram
-     *        is specific to the current frame, not to the whole simulation.
+     * simulation frame. The size of the histogram is defined by the
+     * --circuit-simulation-histogram-size command line parameter (128 by
+     * default). The range is defined by the minimum and maximum value of the
+     * frames covered by the histogram, that is the current frame, and the
+     * previous frames for which a histogram was requested within the window
+     * defined by the --circuit-simulation-histogram-window command line
+     * parameter. Non-finite values are ignored. The histogram is computed on
+     * a background thread, and the previous histogram is returned until the
+     * new one is ready.
      */
     const Histogram& getHistogram();
 
-    /** @return true if the histogram has changed since the last update. */
+    /** @return true if the histogram does not match the current frame yet */
     bool histogramChanged() const;
 
     /** @return true if the requested frame from getFrameData() is ready to
@@ -118,6 +129,29 @@ public:
 protected:
     uint32_t _getBoundedFrame(const uint32_t frame) const;
 
+    /**
+     * Reads the header of the memory mapped cache file, frames being stored
+     * one after the other after the number of frames and the frame size
+     * @return false if the cache file is not valid
+     */
+    virtual bool _readCacheHeader();
+
+    /**
+     * @return the values of the current frame, as returned by getFrameData(),
+     * for the histogram computed in the background. Persistent frames are
+     * shared as is, others are copied unless overridden.
+     */
+    virtual std::shared_ptr<const float> _shareFrameData(const float* data);
+
+    /** @return the address of a frame in the memory mapped cache file */
+    void* _getCacheFrame(uint32_t frame) const;
+
+    /**
+     * Advises the kernel that frames of the memory mapped cache file are about
+     * to be read, so that their pages are read ahead
+     */
+    void _adviseCacheFrames(uint32_t firstFrame, uint32_t nbFrames) const;
+
     const GeometryParameters& _geometryParameters;
     uint32_t _currentFrame;
     uint32_t _nbFrames;
@@ -125,9 +159,18 @@ protected:
 
     uint64_t _headerSize;
     void* _memoryMapPtr;
+    uint64_t _memoryMapSize{0};
     int _cacheFileDescriptor;
     Histogram _histogram;
-    float* _frameData;
+
+private:
+    struct HistogramFrame
+    {
+        uint32_t frame;
+        std::shared_ptr<const float> values;
+    };
+    std::vector<HistogramFrame> _histogramFrames;
+    std::future<Histogram> _histogramFuture;
 };
 }
 #endif // ABSTRACTSIMULATIONHANDLER_H
@@ -0,0 +1,93 @@
+/* Copyright (c) 2015-2017, EPFL/Blue Brain Project
+ * All rights reserved. Do not distribute without permission.
+ * Responsible Author: Cyrille Favreau <cyrille.favreau@epfl.ch>
+ *
+ * This file is part of Brayns <https://github.com/BlueBrain/Brayns>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#include "PlaybackScheduler.h"
+
+#include <brayns/common/log.h>
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace brayns
+{
+int64_t PlaybackScheduler::advance(const float framesPerSecond,
+                                   const int32_t delta, const bool ready)
+{
+    return advance(framesPerSecond, delta, ready, Clock::now());
+}
+
+int64_t PlaybackScheduler::advance(const float framesPerSecond,
+                                   const int32_t delta, const bool ready,
+                                   const Clock::time_point now)
+{
+    if (!_playing)
+    {
+        *this = PlaybackScheduler();
+        _playing = true;
+        _lastTime = now;
+        return ready ? delta : 0;
+    }
+
+    const double elapsed =
+        std::chrono::duration<double>(now - _lastTime).count();
+    _lastTime = now;
+    _playbackTime += elapsed;
+
+    // The clock keeps running while the current frame is loading, so that the
+    // next frame is the one matching the elapsed time
+    _position += elapsed * framesPerSecond * delta;
+    if (!ready)
+    {
+        _stallTime += elapsed;
+        return 0;
+    }
+
+    // Playback moves by whole steps of delta frames, the remainder is kept
+    // for the next call
+    const int64_t stepSize = std::max(1, std::abs(delta));
+    const int64_t nbFrames = int64_t(_position / stepSize) * stepSize;
+    if (nbFrames == 0)
+        return 0;
+
+    _position -= nbFrames;
+    const uint64_t nbSteps = std::abs(nbFrames);
+    ++_nbPlayedFrames;
+    _nbDroppedFrames += nbSteps / stepSize - 1;
+    return nbFrames;
+}
+
+void PlaybackScheduler::stop()
+{
+    if (!_playing)
+        return;
+
+    _playing = false;
+    BRAYNS_INFO << "Playback: " << _nbPlayedFrames << " frames in "
+                << _playbackTime << " s (" << getEffectiveRate()
+                << " fps), " << _nbDroppedFrames << " frames dropped, "
+                << _stallTime << " s waiting for data" << std::endl;
+}
+
+float PlaybackScheduler::getEffectiveRate() const
+{
+    return _playbackTime > 0.0 ? _nbPlayedFrames / _playbackTime : 0.f;
+}
+}
@@ -0,0 +1,87 @@
+/* Copyright (c) 2015-2017, EPFL/Blue Brain Project
+ * All rights reserved. Do not distribute without permission.
+ * Responsible Author: Cyrille Favreau <cyrille.favreau@epfl.ch>
+ *
+ * This file is part of Brayns <https://github.com/BlueBrain/Brayns>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#pragma once
+
+#include <brayns/api.h>
+
+#include <chrono>
+#include <cstdint>
+
+namespace brayns
+{
+/**
+ * Paces the playback of a simulation at a target rate, independently of the
+ * rendering rate. Frames are skipped when loading or rendering falls behind,
+ * and the same frame is rendered again when rendering is faster than the
+ * target rate.
+ */
+class PlaybackScheduler
+{
+public:
+    typedef std::chrono::high_resolution_clock Clock;
+
+    /**
+     * Advances the playback clock
+     * @param framesPerSecond Target playback rate
+     * @param delta Number of frames played per step, negative to play backward
+     * @param ready True if the current frame is loaded, in which case the
+     *        playback can move to another frame
+     * @return the number of frames to add to the current frame, a multiple of
+     *         delta
+     */
+    BRAYNS_API int64_t advance(float framesPerSecond, int32_t delta,
+                               bool ready);
+
+    /**
+     * Advances the playback clock to the given time
+     * @param now Current time, which must not go backward
+     * @see advance(float, int32_t, bool)
+     */
+    BRAYNS_API int64_t advance(float framesPerSecond, int32_t delta,
+                               bool ready, Clock::time_point now);
+
+    /** Stops the playback clock, and logs the statistics of the playback */
+    BRAYNS_API void stop();
+
+    /** @return the number of frames rendered per second of playback */
+    BRAYNS_API float getEffectiveRate() const;
+
+    /** @return true if the playback clock is running */
+    bool isPlaying() const { return _playing; }
+    /** @return the number of frames rendered since the playback started */
+    uint64_t getNbPlayedFrames() const { return _nbPlayedFrames; }
+    /** @return the time elapsed since the playback started, in seconds */
+    double getPlaybackTime() const { return _playbackTime; }
+    /** @return the number of frames skipped to keep up with the target rate */
+    uint64_t getNbDroppedFrames() const { return _nbDroppedFrames; }
+    /** @return the time spent waiting for frames to be loaded, in seconds */
+    double getStallTime() const { return _stallTime; }
+private:
+    bool _playing{false};
+    Clock::time_point _lastTime;
+    double _position{0.0};
+    double _playbackTime{0.0};
+    double _stallTime{0.0};
+    uint64_t _nbPlayedFrames{0};
+    uint64_t _nbDroppedFrames{0};
+};
+}
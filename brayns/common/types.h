@@ -21,6 +21,7 @@
 #ifndef TYPES_H
 #define TYPES_H
 
+#include <brayns/common/geometry/GeometryArena.h>
 #include <brayns/common/mathTypes.h>
 
 #include <boost/program_options.hpp>
@@ -114,18 +115,22 @@ typedef std::shared_ptr<ExtensionController> ExtensionControllerPtr;
 
 struct Sphere;
 typedef std::vector<Sphere> Spheres;
-typedef std::map<size_t, Spheres> SpheresMap;
+typedef GeometryArena<Spheres> SpheresMap;
 
 struct Cylinder;
 typedef std::vector<Cylinder> Cylinders;
-typedef std::map<size_t, Cylinders> CylindersMap;
+typedef GeometryArena<Cylinders> CylindersMap;
 
 struct Cone;
 typedef std::vector<Cone> Cones;
-typedef std::map<size_t, Cones> ConesMap;
+typedef GeometryArena<Cones> ConesMap;
 
 struct TrianglesMesh;
-typedef std::map<size_t, TrianglesMesh> TrianglesMeshMap;
+typedef GeometryArena<TrianglesMesh> TrianglesMeshMap;
+
+struct InstancedGeometry;
+typedef std::shared_ptr<InstancedGeometry> InstancedGeometryPtr;
+typedef std::vector<InstancedGeometryPtr> InstancedGeometries;
 
 class Material;
 typedef std::vector<Material> Materials;
@@ -252,6 +257,17 @@ enum class GeometryQuality
     high
 };
 
+/** Levels of detail of circuit geometry, from the coarsest to the finest */
+enum class LevelOfDetail
+{
+    somas,    // One sphere per cell
+    skeleton, // Somas, and one cone per section
+    full      // Every sample of every section
+};
+
+/** Number of levels of detail stored in addition to the full geometry */
+const size_t NB_COARSE_LEVELS_OF_DETAIL = size_t(LevelOfDetail::full);
+
 /** Morphology element types */
 enum class MorphologySectionType
 {
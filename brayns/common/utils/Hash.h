@@ -0,0 +1,60 @@
+/* Copyright (c) 2015-2017, EPFL/Blue Brain Project
+ * All rights reserved. Do not distribute without permission.
+ * Responsible Author: Cyrille Favreau <cyrille.favreau@epfl.ch>
+ *
+ * This file is part of Brayns <https://github.com/BlueBrain/Brayns>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef HASH_H
+#define HASH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace brayns
+{
+/**
+ * FNV-1a hash, stable across platforms and runs unlike std::hash, used to name
+ * cache files
+ */
+class Hash
+{
+public:
+    template <typename T>
+    void add(const T& value)
+    {
+        add(&value, sizeof(T));
+    }
+
+    void add(const std::string& value) { add(value.data(), value.size()); }
+    void add(const void* data, const size_t size)
+    {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        for (size_t i = 0; i < size; ++i)
+        {
+            _value ^= bytes[i];
+            _value *= 1099511628211ull;
+        }
+    }
+
+    uint64_t get() const { return _value; }
+private:
+    uint64_t _value{14695981039346656037ull};
+};
+}
+
+#endif // HASH_H
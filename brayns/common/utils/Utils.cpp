@@ -24,6 +24,12 @@
 
 #include <boost/filesystem.hpp>
 
+namespace
+{
+// needs to be the same in SimulationRenderer.ispc
+const float OFFSET_MAGIC = 1e6;
+}
+
 namespace brayns
 {
 strings parseFolder(const std::string& folder, const strings& filters)
@@ -54,4 +60,18 @@ strings parseFolder(const std::string& folder, const strings& filters)
     std::sort(files.begin(), files.end());
     return files;
 }
+
+Vector2f encodeSimulationOffset(const uint64_t offset)
+{
+    // https://stackoverflow.com/questions/2810280
+    return Vector2f(((offset & 0xFFFFFFFF00000000LL) >> 32) / OFFSET_MAGIC,
+                    (offset & 0xFFFFFFFFLL) / OFFSET_MAGIC);
+}
+
+uint64_t decodeSimulationOffset(const Vector2f& values)
+{
+    // Rounded, since offset / OFFSET_MAGIC is not exact in single precision
+    return uint64_t(values.x() * OFFSET_MAGIC + 0.5f) << 32 |
+           uint32_t(values.y() * OFFSET_MAGIC + 0.5f);
+}
 }
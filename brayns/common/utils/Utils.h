@@ -26,6 +26,15 @@
 namespace brayns
 {
 strings parseFolder(const std::string& folder, const strings& filters);
+
+/**
+ * Encodes an offset in the simulation data into the values of a primitive. The
+ * offset is decoded by the simulation renderer.
+ */
+Vector2f encodeSimulationOffset(uint64_t offset);
+
+/** Decodes the simulation offset held by the values of a primitive */
+uint64_t decodeSimulationOffset(const Vector2f& values);
 }
 
 #endif // UTILS_H
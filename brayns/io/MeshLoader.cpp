@@ -49,6 +49,16 @@ void MeshLoader::clear()
 bool MeshLoader::importMeshFromFile(const std::string& filename, Scene& scene,
                                     const Matrix4f& transformation,
                                     const size_t defaultMaterial)
+{
+    return importMeshFromFile(filename, scene, scene.getTriangleMeshes(),
+                              scene.getWorldBounds(), transformation,
+                              defaultMaterial);
+}
+
+bool MeshLoader::importMeshFromFile(const std::string& filename, Scene& scene,
+                                    TrianglesMeshMap& meshes, Boxf& bounds,
+                                    const Matrix4f& transformation,
+                                    const size_t defaultMaterial)
 {
     _materialOffset = scene.getMaterials().size();
     const boost::filesystem::path file = filename;
@@ -103,14 +113,13 @@ bool MeshLoader::importMeshFromFile(const std::string& filename, Scene& scene,
 
     size_t nbVertices = 0;
     size_t nbFaces = 0;
-    auto& triangleMeshes = scene.getTriangleMeshes();
     for (size_t m = 0; m < aiScene->mNumMeshes; ++m)
     {
         aiMesh* mesh = aiScene->mMeshes[m];
         const size_t materialId =
             _getMaterialId(mesh->mMaterialIndex, defaultMaterial);
 
-        auto& triangleMesh = triangleMeshes[materialId];
+        auto& triangleMesh = meshes[materialId];
 
         nbVertices += mesh->mNumVertices;
         triangleMesh.vertices.reserve(nbVertices);
@@ -126,7 +135,7 @@ bool MeshLoader::importMeshFromFile(const std::string& filename, Scene& scene,
             const Vector3f transformedVertex = {vertex.x(), vertex.y(),
                                                 vertex.z()};
             triangleMesh.vertices.push_back(transformedVertex);
-            scene.getWorldBounds().merge(transformedVertex);
+            bounds.merge(transformedVertex);
             if (mesh->HasNormals())
             {
                 const auto& n = mesh->mNormals[i];
@@ -366,6 +375,14 @@ bool MeshLoader::importMeshFromFile(const std::string&, Scene&, const Matrix4f&,
     return false;
 }
 
+bool MeshLoader::importMeshFromFile(const std::string&, Scene&,
+                                    TrianglesMeshMap&, Boxf&, const Matrix4f&,
+                                    const size_t)
+{
+    BRAYNS_ERROR << NO_ASSIMP_MESSAGE << std::endl;
+    return false;
+}
+
 bool MeshLoader::exportMeshToFile(const std::string&, Scene&) const
 {
     BRAYNS_ERROR << NO_ASSIMP_MESSAGE << std::endl;
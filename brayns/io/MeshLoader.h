@@ -56,6 +56,22 @@ public:
                             const Matrix4f& transformation,
                             const size_t defaultMaterial);
 
+    /** Imports meshes from a given file into the given triangle meshes
+     *
+     * @param filename name of the file containing the meshes
+     * @param Scene holding the materials of the meshes
+     * @param meshes Triangle meshes receiving the meshes, per material
+     * @param bounds Bounds extended with the imported vertices
+     * @param transformation Position, orientation and scale to apply to the
+     *        mesh
+     * @param defaultMaterial Default material for the whole mesh. See above.
+     * @return true if the file was successfully imported. False otherwise.
+     */
+    bool importMeshFromFile(const std::string& filename, Scene& scene,
+                            TrianglesMeshMap& meshes, Boxf& bounds,
+                            const Matrix4f& transformation,
+                            const size_t defaultMaterial);
+
     /** Exports meshes to a given file
      *
      * @param filename destination file name
@@ -20,6 +20,7 @@
 
 #include "MolecularSystemReader.h"
 
+#include <brayns/common/geometry/InstancedGeometry.h>
 #include <brayns/common/log.h>
 #include <brayns/common/scene/Scene.h>
 #include <brayns/io/MeshLoader.h>
@@ -52,7 +53,9 @@ bool MolecularSystemReader::import(Scene& scene, MeshLoader& meshLoader)
     if (!_calciumSimulationFolder.empty())
     {
         CADiffusionSimulationHandlerPtr handler(
-            new CADiffusionSimulationHandler(_calciumSimulationFolder));
+            new CADiffusionSimulationHandler(
+                _calciumSimulationFolder,
+                _geometryParameters.getCalciumCacheFolder()));
         handler->setFrame(scene, 0);
         scene.setCADiffusionSimulationHandler(handler);
     }
@@ -66,10 +69,24 @@ bool MolecularSystemReader::import(Scene& scene, MeshLoader& meshLoader)
 
 bool MolecularSystemReader::_createScene(Scene& scene, MeshLoader& meshLoader)
 {
+    // Proteins colored by ID have one material per instance, and cannot share
+    // their geometry
+    const bool instancing =
+        _geometryParameters.getColorScheme() != ColorScheme::protein_by_id;
+
     uint64_t proteinCount = 0;
     for (const auto& proteinPosition : _proteinPositions)
     {
         const auto& protein = _proteins.find(proteinPosition.first);
+        if (instancing)
+        {
+            _createProteinInstances(scene, protein->second,
+                                    proteinPosition.second);
+            proteinCount += proteinPosition.second.size();
+            updateProgress("Loading proteins...", proteinCount, _nbProteins);
+            continue;
+        }
+
         if (!_proteinFolder.empty())
             // Load PDB files
             for (const auto& position : proteinPosition.second)
@@ -124,6 +141,45 @@ bool MolecularSystemReader::_createScene(Scene& scene, MeshLoader& meshLoader)
     return true;
 }
 
+void MolecularSystemReader::_createProteinInstances(
+    Scene& scene, const std::string& protein, const Vector3fs& positions)
+{
+    // The protein is loaded once, at the origin
+    auto geometry = std::make_shared<InstancedGeometry>();
+    if (!_proteinFolder.empty())
+    {
+        const auto pdbFilename = _proteinFolder + '/' + protein + ".pdb";
+        ProteinLoader loader(_geometryParameters);
+        loader.importPDBFile(pdbFilename, Vector3f(0.f, 0.f, 0.f), 0,
+                             scene.getMaterials().size(), geometry->spheres);
+        for (const auto& spheres : geometry->spheres)
+            for (const auto& sphere : spheres)
+            {
+                const Vector3f radius(sphere.radius, sphere.radius,
+                                      sphere.radius);
+                geometry->bounds.merge(sphere.center - radius);
+                geometry->bounds.merge(sphere.center + radius);
+            }
+    }
+
+    if (!_meshFolder.empty())
+    {
+        // Vertex indices are relative to the meshes of the loader, which
+        // therefore cannot be shared with the scene
+        const auto objFilename = _meshFolder + '/' + protein + ".obj";
+        MeshLoader loader(_geometryParameters);
+        loader.importMeshFromFile(objFilename, scene, geometry->trianglesMeshes,
+                                  geometry->bounds, Matrix4f(), NO_MATERIAL);
+    }
+
+    const Vector3f scale = {1.f, 1.f, 1.f};
+    geometry->transformations.reserve(positions.size());
+    for (const auto& position : positions)
+        geometry->transformations.push_back(Matrix4f(position, scale));
+
+    scene.addInstancedGeometry(geometry);
+}
+
 bool MolecularSystemReader::_loadConfiguration()
 {
     // Load molecular system configuration
@@ -68,6 +68,8 @@ public:
 
 private:
     bool _createScene(Scene& scene, MeshLoader& meshLoader);
+    void _createProteinInstances(Scene& scene, const std::string& protein,
+                                 const Vector3fs& positions);
     bool _loadConfiguration();
     bool _loadProteins();
     bool _loadPositions();
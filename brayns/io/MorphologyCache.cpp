@@ -0,0 +1,207 @@
+/* Copyright (c) 2015-2017, EPFL/Blue Brain Project
+ * All rights reserved. Do not distribute without permission.
+ * Responsible Author: Cyrille Favreau <cyrille.favreau@epfl.ch>
+ *
+ * This file is part of Brayns <https://github.com/BlueBrain/Brayns>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "MorphologyCache.h"
+
+#include <brayns/common/log.h>
+#include <brayns/common/utils/Hash.h>
+
+#include <boost/filesystem.hpp>
+
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+namespace
+{
+// Increase whenever the tessellation or the file format changes
+const uint64_t MORPHOLOGY_CACHE_VERSION = 1;
+
+struct MorphologyCacheHeader
+{
+    uint64_t version;
+    uint64_t hasSoma;
+    float somaCenter[3];
+    float somaRadius;
+    uint64_t nbSomaChildren;
+    uint64_t nbAxonSections;
+    uint64_t nbSamples;
+};
+}
+
+namespace brayns
+{
+MorphologyCache::MorphologyCache(const GeometryParameters& geometryParameters)
+    : _geometryParameters(geometryParameters)
+{
+}
+
+bool MorphologyCache::isEnabled() const
+{
+    return !_geometryParameters.getMorphologyCacheFolder().empty();
+}
+
+std::string MorphologyCache::_getFilename(
+    const std::string& morphologyFile) const
+{
+    Hash hash;
+    hash.add(MORPHOLOGY_CACHE_VERSION);
+    hash.add(morphologyFile);
+
+    // Modified morphologies must not hit stale entries
+    boost::system::error_code error;
+    const uint64_t fileSize =
+        boost::filesystem::file_size(morphologyFile, error);
+    if (!error)
+        hash.add(fileSize);
+    const int64_t lastWriteTime =
+        boost::filesystem::last_write_time(morphologyFile, error);
+    if (!error)
+        hash.add(lastWriteTime);
+
+    hash.add(_geometryParameters.getRadiusMultiplier());
+    hash.add(_geometryParameters.getRadiusCorrection());
+    hash.add(_geometryParameters.getMorphologySectionTypes());
+    hash.add(_geometryParameters.getGeometryQuality());
+
+    std::stringstream filename;
+    filename << _geometryParameters.getMorphologyCacheFolder() << "/"
+             << std::hex << std::setw(16) << std::setfill('0') << hash.get()
+             << ".morphology";
+    return filename.str();
+}
+
+bool MorphologyCache::load(const std::string& morphologyFile,
+                           MorphologyTessellation& tessellation) const
+{
+    if (!isEnabled())
+        return false;
+
+    std::ifstream file(_getFilename(morphologyFile),
+                       std::ios::in | std::ios::binary | std::ios::ate);
+    if (!file.good())
+        return false;
+    const uint64_t fileSize = file.tellg();
+    file.seekg(0);
+
+    MorphologyCacheHeader header;
+    file.read((char*)&header, sizeof(MorphologyCacheHeader));
+    if (!file.good() || header.version != MORPHOLOGY_CACHE_VERSION)
+        return false;
+
+    // Check the element counts against the file size before allocating
+    // anything, a corrupted header must not trigger huge allocations
+    uint64_t remaining = fileSize - sizeof(MorphologyCacheHeader);
+    const auto consume = [&remaining](const uint64_t nbElements,
+                                      const uint64_t elementSize) {
+        if (nbElements > remaining / elementSize)
+            return false;
+        remaining -= nbElements * elementSize;
+        return true;
+    };
+    if (!consume(header.nbSomaChildren, sizeof(Vector4f)) ||
+        !consume(header.nbAxonSections, sizeof(uint32_t)) ||
+        !consume(header.nbSamples, sizeof(MorphologySample)) || remaining != 0)
+    {
+        BRAYNS_WARN << "Ignoring corrupted morphology cache entry for "
+                    << morphologyFile << std::endl;
+        return false;
+    }
+
+    tessellation.hasSoma = header.hasSoma != 0;
+    tessellation.somaCenter = Vector3f(header.somaCenter[0],
+                                       header.somaCenter[1],
+                                       header.somaCenter[2]);
+    tessellation.somaRadius = header.somaRadius;
+    tessellation.somaChildren.resize(header.nbSomaChildren);
+    file.read((char*)tessellation.somaChildren.data(),
+              header.nbSomaChildren * sizeof(Vector4f));
+    tessellation.axonSections.resize(header.nbAxonSections);
+    file.read((char*)tessellation.axonSections.data(),
+              header.nbAxonSections * sizeof(uint32_t));
+    tessellation.samples.resize(header.nbSamples);
+    file.read((char*)tessellation.samples.data(),
+              header.nbSamples * sizeof(MorphologySample));
+    if (!file.good())
+    {
+        BRAYNS_WARN << "Ignoring corrupted morphology cache entry for "
+                    << morphologyFile << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void MorphologyCache::save(const std::string& morphologyFile,
+                           const MorphologyTessellation& tessellation) const
+{
+    const auto filename = _getFilename(morphologyFile);
+
+    // Several cells share the same morphology and may be saved concurrently,
+    // so write to a unique file that is then renamed
+    boost::system::error_code error;
+    boost::filesystem::create_directories(
+        _geometryParameters.getMorphologyCacheFolder(), error);
+    const auto tmpFilename =
+        boost::filesystem::unique_path(filename + ".%%%%-%%%%-%%%%").string();
+
+    std::ofstream file(tmpFilename, std::ios::out | std::ios::binary);
+    if (!file.good())
+    {
+        BRAYNS_WARN << "Could not create morphology cache file " << tmpFilename
+                    << std::endl;
+        return;
+    }
+
+    MorphologyCacheHeader header;
+    header.version = MORPHOLOGY_CACHE_VERSION;
+    header.hasSoma = tessellation.hasSoma ? 1 : 0;
+    for (size_t i = 0; i < 3; ++i)
+        header.somaCenter[i] = tessellation.somaCenter[i];
+    header.somaRadius = tessellation.somaRadius;
+    header.nbSomaChildren = tessellation.somaChildren.size();
+    header.nbAxonSections = tessellation.axonSections.size();
+    header.nbSamples = tessellation.samples.size();
+
+    file.write((char*)&header, sizeof(MorphologyCacheHeader));
+    file.write((char*)tessellation.somaChildren.data(),
+               header.nbSomaChildren * sizeof(Vector4f));
+    file.write((char*)tessellation.axonSections.data(),
+               header.nbAxonSections * sizeof(uint32_t));
+    file.write((char*)tessellation.samples.data(),
+               header.nbSamples * sizeof(MorphologySample));
+    file.close();
+
+    if (file.fail())
+    {
+        BRAYNS_WARN << "Failed to write morphology cache file " << tmpFilename
+                    << std::endl;
+        boost::filesystem::remove(tmpFilename, error);
+        return;
+    }
+
+    boost::filesystem::rename(tmpFilename, filename, error);
+    if (error)
+    {
+        BRAYNS_WARN << "Failed to write morphology cache file " << filename
+                    << ": " << error.message() << std::endl;
+        boost::filesystem::remove(tmpFilename, error);
+    }
+}
+}
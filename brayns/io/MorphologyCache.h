@@ -0,0 +1,107 @@
+/* Copyright (c) 2015-2017, EPFL/Blue Brain Project
+ * All rights reserved. Do not distribute without permission.
+ * Responsible Author: Cyrille Favreau <cyrille.favreau@epfl.ch>
+ *
+ * This file is part of Brayns <https://github.com/BlueBrain/Brayns>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#pragma once
+
+#include <brayns/common/types.h>
+#include <brayns/parameters/GeometryParameters.h>
+
+#include <string>
+#include <vector>
+
+namespace brayns
+{
+/**
+ * One step of the tessellation of a morphology section, in the local
+ * coordinates of the morphology. It produces a sphere at position if radius
+ * is positive, and a cylinder or a cone to the target if previousRadius is
+ * also positive.
+ */
+struct MorphologySample
+{
+    Vector3f position;
+    Vector3f target;
+    float radius;
+    float previousRadius;
+    float distanceToSoma;
+    uint32_t sectionID;
+    uint32_t sectionType;
+    // Index of the sample the segment starts from, used to interpolate the
+    // compartment report offsets
+    uint32_t segment;
+    uint32_t nbSectionSamples;
+};
+typedef std::vector<MorphologySample> MorphologySamples;
+
+/**
+ * Tessellation of a morphology in local coordinates, independent of the
+ * position of the cell, its color scheme and simulation report. Radii are
+ * already corrected according to the geometry parameters.
+ */
+struct MorphologyTessellation
+{
+    bool hasSoma{false};
+    Vector3f somaCenter;
+    float somaRadius{0.f};
+    // First sample of every section attached to the soma, with its corrected
+    // radius in w
+    Vector4fs somaChildren;
+    // Axon section IDs in morphology order
+    std::vector<uint32_t> axonSections;
+    MorphologySamples samples;
+};
+
+/**
+ * On-disk cache of morphology tessellations, enabled by the
+ * --morphology-cache-folder command line parameter. Entries are keyed by the
+ * morphology file (path, size and modification time) and the geometry
+ * parameters that affect the tessellation: radius multiplier and correction,
+ * section types and geometry quality. Cached morphologies are then only
+ * transformed, which makes loading other targets of the same circuit much
+ * faster.
+ */
+class MorphologyCache
+{
+public:
+    MorphologyCache(const GeometryParameters& geometryParameters);
+
+    /** @return true if --morphology-cache-folder was specified */
+    bool isEnabled() const;
+
+    /**
+     * Loads the tessellation of the given morphology file
+     * @return true if the morphology was found in the cache, false otherwise
+     */
+    bool load(const std::string& morphologyFile,
+              MorphologyTessellation& tessellation) const;
+
+    /**
+     * Saves the tessellation of the given morphology file. Thread-safe,
+     * failures are reported but not fatal.
+     */
+    void save(const std::string& morphologyFile,
+              const MorphologyTessellation& tessellation) const;
+
+private:
+    std::string _getFilename(const std::string& morphologyFile) const;
+
+    const GeometryParameters& _geometryParameters;
+};
+}
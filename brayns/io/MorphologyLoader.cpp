@@ -25,7 +25,12 @@
 #include <brayns/common/geometry/Sphere.h>
 #include <brayns/common/log.h>
 #include <brayns/common/scene/Scene.h>
+#include <brayns/common/utils/Utils.h>
+#include <brayns/io/MorphologyCache.h>
+#include <brayns/io/MorphologyPrefetcher.h>
+#include <brayns/io/algorithms/GeometryConcatenation.h>
 #include <brayns/io/algorithms/MetaballsGenerator.h>
+#include <brayns/io/algorithms/RegionOfInterest.h>
 #include <brayns/io/simulation/CircuitSimulationHandler.h>
 
 #include <brain/brain.h>
@@ -37,15 +42,16 @@
 #endif
 
 #include <algorithm>
+#include <chrono>
 #include <fstream>
+#include <map>
+#include <tuple>
 
 #include <boost/filesystem.hpp>
 
-namespace
-{
-// needs to be the same in SimulationRenderer.ispc
-const float INDEX_MAGIC = 1e6;
-}
+#ifdef BRAYNS_USE_OPENMP
+#include <omp.h>
+#endif
 
 namespace brayns
 {
@@ -100,7 +106,68 @@ public:
     TrianglesMeshMap& trianglesMeshes;
     Materials& materials;
     Boxf& worldBounds;
+
+    /**
+     * Subtracted from the simulation offsets of the primitives, when the
+     * geometry is shared by several neurons
+     */
+    uint64_t simulationOffsetBase{0};
+
+    /**
+     * Containers of the coarse levels of detail, see
+     * Scene::getCoarseGeometry(). Null if they are not generated.
+     */
+    ParallelSceneContainer* coarseLevels[NB_COARSE_LEVELS_OF_DETAIL]{};
+};
+
+/**
+ * Geometry accumulated by a thread while importing morphologies, merged into
+ * the scene once all morphologies are loaded
+ */
+struct ThreadSceneGeometry
+{
+    SpheresMap spheres;
+    CylindersMap cylinders;
+    ConesMap cones;
+    TrianglesMeshMap trianglesMeshes;
+    Materials materials;
+    Boxf bounds;
+
+    /** Geometry already taken from the containers above, see takeBatch() */
+    InstancedGeometries batches;
+
+    /** Coarse levels of detail, null if they are not generated */
+    InstancedGeometryPtr coarseGeometry[NB_COARSE_LEVELS_OF_DETAIL];
+
+    /** Time spent by the thread importing morphologies, in seconds */
+    double loadingTime{0.0};
+
+    /** Time spent generating geometry, excluding waits for prefetched reads */
+    double geometryTime{0.0};
 };
+typedef std::vector<ThreadSceneGeometry> ThreadSceneGeometries;
+
+/**
+ * Moves the geometry accumulated by a thread into a batch, in world
+ * coordinates, that can be rendered while the rest of the circuit is loading
+ * @return the batch, nullptr if the thread holds no geometry
+ */
+InstancedGeometryPtr takeBatch(ThreadSceneGeometry& threadGeometry)
+{
+    if (threadGeometry.spheres.empty() && threadGeometry.cylinders.empty() &&
+        threadGeometry.cones.empty() && threadGeometry.trianglesMeshes.empty())
+        return nullptr;
+
+    InstancedGeometryPtr batch(new InstancedGeometry);
+    std::swap(batch->spheres, threadGeometry.spheres);
+    std::swap(batch->cylinders, threadGeometry.cylinders);
+    std::swap(batch->cones, threadGeometry.cones);
+    std::swap(batch->trianglesMeshes, threadGeometry.trianglesMeshes);
+    batch->bounds = threadGeometry.bounds;
+    batch->transformations.push_back(Matrix4f());
+    threadGeometry.batches.push_back(batch);
+    return batch;
+}
 
 class MorphologyLoader::Impl
 {
@@ -113,6 +180,7 @@ public:
         , _geometryParameters(geometryParameters)
         , _scene(scene)
         , _materialsOffset(scene.getMaterials().size())
+        , _morphologyCache(geometryParameters)
     {
     }
 
@@ -167,6 +235,16 @@ public:
             GIDOffsets targetGIDOffsets;
             targetGIDOffsets.push_back(0);
 
+            // Geometry is clipped while morphologies are tessellated
+            _regionOfInterest = RegionOfInterest();
+            const auto& roi = _geometryParameters.getCircuitRegionOfInterest();
+            if (roi.getSize() != Vector3f(0.f))
+                _regionOfInterest.addBox(roi);
+            _regionOfInterest.addPlanes(
+                _geometryParameters.getCircuitRegionOfInterestPlanes());
+            const auto roiMargin =
+                _geometryParameters.getCircuitRegionOfInterestMargin();
+
             strings localTargets;
             if (targets.empty())
                 localTargets.push_back("");
@@ -184,14 +262,21 @@ public:
 
                 brain::GIDSet gids;
                 const auto& aabb = _geometryParameters.getCircuitBoundingBox();
-                if (aabb.getSize() == Vector3f(0.f))
+                const bool selectBySoma =
+                    _regionOfInterest.isDefined() && roiMargin > 0.f;
+                if (aabb.getSize() == Vector3f(0.f) && !selectBySoma)
                     gids = targetGids;
                 else
                 {
                     auto gidIterator = targetGids.begin();
                     for (size_t i = 0; i < allTransformations.size(); ++i)
                     {
-                        if (aabb.isIn(allTransformations[i].getTranslation()))
+                        const auto soma =
+                            allTransformations[i].getTranslation();
+                        if ((aabb.getSize() == Vector3f(0.f) ||
+                             aabb.isIn(soma)) &&
+                            (!selectBySoma ||
+                             _regionOfInterest.contains(soma, roiMargin)))
                             gids.insert(*gidIterator);
                         ++gidIterator;
                     }
@@ -420,15 +505,7 @@ private:
      */
     Vector2f _getIndexAsTextureCoordinates(const uint64_t index) const
     {
-        Vector2f textureCoordinates;
-
-        // https://stackoverflow.com/questions/2810280
-        float x = ((index & 0xFFFFFFFF00000000LL) >> 32) / INDEX_MAGIC;
-        float y = (index & 0xFFFFFFFFLL) / INDEX_MAGIC;
-
-        textureCoordinates.x() = x;
-        textureCoordinates.y() = y;
-        return textureCoordinates;
+        return encodeSimulationOffset(index);
     }
 
     /**
@@ -467,6 +544,8 @@ private:
         const auto radius = _geometryParameters.getRadiusMultiplier();
         const auto textureCoordinates = _getIndexAsTextureCoordinates(offset);
         const auto somaPosition = transformation.getTranslation();
+        if (!_regionOfInterest.contains(somaPosition, radius))
+            return true;
         const auto materialId =
             _getMaterialFromGeometryParameters(index, material,
                                                brain::neuron::SectionType::soma,
@@ -547,6 +626,21 @@ private:
                 }
             }
 
+            // Only metaballs that touch the region of interest are meshed
+            if (_regionOfInterest.isDefined())
+            {
+                const auto outside = [this](const Vector4f& metaball) {
+                    return !_regionOfInterest.contains(
+                        Vector3f(metaball.x(), metaball.y(), metaball.z()),
+                        metaball.w());
+                };
+                metaballs.erase(std::remove_if(metaballs.begin(),
+                                               metaballs.end(), outside),
+                                metaballs.end());
+                if (metaballs.empty())
+                    return true;
+            }
+
             // Generate mesh from metaballs
             const auto gridSize = _geometryParameters.getMetaballsGridSize();
             const auto threshold = _geometryParameters.getMetaballsThreshold();
@@ -555,8 +649,7 @@ private:
                 index, material, brain::neuron::SectionType::soma,
                 targetGIDOffsets);
             metaballsGenerator.generateMesh(metaballs, gridSize, threshold,
-                                            scene.materials, materialId,
-                                            scene.trianglesMeshes);
+                                            materialId, scene.trianglesMeshes);
         }
         catch (const std::runtime_error& e)
         {
@@ -566,6 +659,147 @@ private:
         return true;
     }
 
+    /**
+     * @brief _tessellateMorphology converts the sections of a morphology into
+     * samples in local coordinates, according to the section types, geometry
+     * quality and radius geometry parameters
+     * @param uri URI of the morphology
+     * @param tessellation Resulting tessellation
+     */
+    void _tessellateMorphology(const servus::URI& uri,
+                               MorphologyTessellation& tessellation) const
+    {
+        const size_t morphologySectionTypes =
+            _geometryParameters.getMorphologySectionTypes();
+
+        const brain::neuron::Morphology morphology(uri);
+
+        // Soma
+        if (morphologySectionTypes &
+            static_cast<size_t>(MorphologySectionType::soma))
+        {
+            const auto& soma = morphology.getSoma();
+            tessellation.hasSoma = true;
+            tessellation.somaCenter = soma.getCentroid();
+            tessellation.somaRadius = _getCorrectedRadius(soma.getMeanRadius());
+            for (const auto& child : soma.getChildren())
+            {
+                const auto& samples = child.getSamples();
+                if (samples.empty())
+                    continue;
+                tessellation.somaChildren.push_back(
+                    Vector4f(samples[0].x(), samples[0].y(), samples[0].z(),
+                             _getCorrectedRadius(samples[0].w() * 0.5f)));
+            }
+        }
+
+        if (morphologySectionTypes &
+            static_cast<size_t>(MorphologySectionType::axon))
+            for (const auto& section :
+                 morphology.getSections(brain::neuron::SectionType::axon))
+                tessellation.axonSections.push_back(section.getID());
+
+        // Dendrites and axon
+        const auto sectionTypes = _getSectionTypes(morphologySectionTypes);
+        for (const auto& section : morphology.getSections(sectionTypes))
+        {
+            if (section.getType() == brain::neuron::SectionType::soma)
+                continue;
+
+            const auto& samples = section.getSamples();
+            if (samples.size() < 2)
+                continue;
+
+            auto previousSample = samples[0];
+            size_t step = 1;
+            switch (_geometryParameters.getGeometryQuality())
+            {
+            case GeometryQuality::low:
+                step = samples.size() - 1;
+                break;
+            case GeometryQuality::medium:
+                step = samples.size() / 2;
+                step = (step == 0) ? 1 : step;
+                break;
+            default:
+                step = 1;
+            }
+
+            const float distanceToSoma = section.getDistanceToSoma();
+            const floats& distancesToSoma = section.getSampleDistancesToSoma();
+
+            bool done = false;
+            for (size_t i = step; !done && i < samples.size() + step;
+                 i += step)
+            {
+                if (i >= samples.size())
+                {
+                    i = samples.size() - 1;
+                    done = true;
+                }
+
+                const auto& sample = samples[i];
+                MorphologySample morphologySample;
+                morphologySample.position =
+                    Vector3f(sample.x(), sample.y(), sample.z());
+                morphologySample.target =
+                    Vector3f(previousSample.x(), previousSample.y(),
+                             previousSample.z());
+                morphologySample.radius = _getCorrectedRadius(sample.w() * 0.5f);
+                morphologySample.previousRadius =
+                    _getCorrectedRadius(samples[i - step].w() * 0.5f);
+                morphologySample.distanceToSoma =
+                    distanceToSoma + distancesToSoma[i];
+                morphologySample.sectionID = section.getID();
+                morphologySample.sectionType = uint32_t(section.getType());
+                morphologySample.segment = i - step;
+                morphologySample.nbSectionSamples = samples.size();
+                tessellation.samples.push_back(morphologySample);
+
+                previousSample = sample;
+            }
+        }
+    }
+
+    /**
+     * @brief _getMorphologyTessellation gets the tessellation of a morphology
+     * from the morphology cache, or tessellates the morphology and adds it to
+     * the cache
+     * @param uri URI of the morphology
+     * @param tessellation Resulting tessellation
+     */
+    void _getMorphologyTessellation(const servus::URI& uri,
+                                    MorphologyTessellation& tessellation) const
+    {
+        const auto& morphologyFile = uri.getPath();
+        if (_morphologyCache.load(morphologyFile, tessellation))
+            return;
+
+        _tessellateMorphology(uri, tessellation);
+        if (_morphologyCache.isEnabled())
+            _morphologyCache.save(morphologyFile, tessellation);
+    }
+
+    /**
+     * Adds the part of a cylinder that lies in the region of interest, if any
+     */
+    void _addClippedCylinder(ParallelSceneContainer& scene,
+                             const size_t materialId, Cylinder cylinder) const
+    {
+        if (_regionOfInterest.clipCylinder(cylinder))
+            scene.addCylinder(materialId, cylinder);
+    }
+
+    /**
+     * Adds the part of a cone that lies in the region of interest, if any
+     */
+    void _addClippedCone(ParallelSceneContainer& scene, const size_t materialId,
+                         Cone cone) const
+    {
+        if (_regionOfInterest.clipCone(cone))
+            scene.addCone(materialId, cone);
+    }
+
     /**
      * @brief _importMorphologyFromURI imports a morphology from the specified
      * URI
@@ -576,31 +810,40 @@ private:
      * do not apply
      * @param compartmentReport Compartment report to map to the morphology
      * @param scene Scene to which the morphology should be loaded into
+     * @param prefetchedTessellation Tessellation of the morphology if it was
+     * already read, null if it has to be read from the URI
      * @return True if the loading was successfull, false otherwise
      */
-    bool _importMorphologyFromURI(const servus::URI& uri, const uint64_t index,
-                                  const size_t material,
-                                  const Matrix4f& transformation,
-                                  CompartmentReportPtr compartmentReport,
-                                  const GIDOffsets& targetGIDOffsets,
-                                  ParallelSceneContainer& scene) const
+    bool _importMorphologyFromURI(
+        const servus::URI& uri, const uint64_t index, const size_t material,
+        const Matrix4f& transformation, CompartmentReportPtr compartmentReport,
+        const GIDOffsets& targetGIDOffsets, ParallelSceneContainer& scene,
+        const MorphologyTessellation* prefetchedTessellation = nullptr) const
     {
         try
         {
+            MorphologyTessellation readTessellation;
+            if (!prefetchedTessellation)
+                _getMorphologyTessellation(uri, readTessellation);
+            const auto& tessellation = prefetchedTessellation
+                                           ? *prefetchedTessellation
+                                           : readTessellation;
+
             Vector3f translation;
 
             const size_t morphologySectionTypes =
                 _geometryParameters.getMorphologySectionTypes();
 
-            brain::neuron::Morphology morphology(uri, transformation);
-            brain::neuron::SectionTypes sectionTypes;
-
             const MorphologyLayout& layout =
                 _geometryParameters.getMorphologyLayout();
 
             if (layout.nbColumns != 0)
             {
+                // The layout depends on the transformed morphology, which is
+                // not cached
                 Boxf morphologyAABB;
+                const brain::neuron::Morphology morphology(uri,
+                                                           transformation);
                 const auto& points = morphology.getPoints();
                 for (const auto& point : points)
                     morphologyAABB.merge({point.x(), point.y(), point.z()});
@@ -614,8 +857,6 @@ private:
                 translation = positionInGrid - morphologyAABB.getCenter();
             }
 
-            sectionTypes = _getSectionTypes(morphologySectionTypes);
-
             uint64_t offset = 0;
 
             if (compartmentReport)
@@ -623,19 +864,21 @@ private:
 
             // Soma
             if (!_geometryParameters.useRealisticSomas() &&
+                tessellation.hasSoma &&
                 morphologySectionTypes &
                     static_cast<size_t>(MorphologySectionType::soma))
             {
-                const auto& soma = morphology.getSoma();
                 const size_t materialId = _getMaterialFromGeometryParameters(
                     index, material, brain::neuron::SectionType::soma,
                     targetGIDOffsets);
-                const auto somaPosition = soma.getCentroid() + translation;
-                const auto radius = _getCorrectedRadius(soma.getMeanRadius());
-                const auto textureCoordinates =
-                    _getIndexAsTextureCoordinates(offset);
-                scene.addSphere(materialId, {somaPosition, radius, 0.f,
-                                             textureCoordinates});
+                const Vector3f somaPosition =
+                    transformation * tessellation.somaCenter + translation;
+                const auto radius = tessellation.somaRadius;
+                const auto textureCoordinates = _getIndexAsTextureCoordinates(
+                    offset - scene.simulationOffsetBase);
+                if (_regionOfInterest.contains(somaPosition, radius))
+                    scene.addSphere(materialId, {somaPosition, radius, 0.f,
+                                                 textureCoordinates});
 
                 if (_geometryParameters.getCircuitUseSimulationModel())
                 {
@@ -643,36 +886,53 @@ private:
                     // occupy as much space as possible in the mesh. This code
                     // inserts a Cone between the soma and the beginning of each
                     // branch.
-                    const auto& children = soma.getChildren();
-                    for (const auto& child : children)
+                    for (const auto& child : tessellation.somaChildren)
                     {
-                        const auto& samples = child.getSamples();
-                        const Vector3f sample{samples[0].x(), samples[0].y(),
-                                              samples[0].z()};
-                        scene.addCone(materialId, {somaPosition, sample, radius,
-                                                   _getCorrectedRadius(
-                                                       samples[0].w() * 0.5f),
-                                                   0.f, textureCoordinates});
+                        const Vector3f sample =
+                            transformation *
+                            Vector3f(child.x(), child.y(), child.z());
+                        _addClippedCone(scene, materialId,
+                                        {somaPosition, sample, radius,
+                                         child.w(), 0.f, textureCoordinates});
                     }
                 }
             }
 
+            // Coarse levels of detail always represent the soma as a sphere
+            auto skeleton =
+                scene.coarseLevels[size_t(LevelOfDetail::skeleton)];
+            if (tessellation.hasSoma && skeleton)
+            {
+                const size_t materialId = _getMaterialFromGeometryParameters(
+                    index, material, brain::neuron::SectionType::soma,
+                    targetGIDOffsets);
+                const Vector3f somaPosition =
+                    transformation * tessellation.somaCenter + translation;
+                const auto radius = tessellation.somaRadius;
+                if (_regionOfInterest.contains(somaPosition, radius))
+                {
+                    const auto textureCoordinates =
+                        _getIndexAsTextureCoordinates(
+                            offset - scene.simulationOffsetBase);
+                    for (auto coarseLevel : scene.coarseLevels)
+                        coarseLevel->addSphere(materialId,
+                                               {somaPosition, radius, 0.f,
+                                                textureCoordinates});
+                }
+            }
+
             // Only the first one or two axon sections are reported, so find the
             // last one and use its offset for all the other axon sections
-            uint16_t lastAxon = 0;
-            if (compartmentReport &&
-                (morphologySectionTypes &
-                 static_cast<size_t>(MorphologySectionType::axon)))
+            uint32_t lastAxon = 0;
+            if (compartmentReport)
             {
                 const auto& counts =
                     compartmentReport->getCompartmentCounts()[index];
-                const auto& axon =
-                    morphology.getSections(brain::neuron::SectionType::axon);
-                for (const auto& section : axon)
+                for (const auto sectionID : tessellation.axonSections)
                 {
-                    if (counts[section.getID()] > 0)
+                    if (counts[sectionID] > 0)
                     {
-                        lastAxon = section.getID();
+                        lastAxon = sectionID;
                         continue;
                     }
                     break;
@@ -680,128 +940,112 @@ private:
             }
 
             // Dendrites and axon
-            for (const auto& section : morphology.getSections(sectionTypes))
+            const auto& samples = tessellation.samples;
+            Vector3f sectionStart;
+            float sectionStartRadius = 0.f;
+            for (size_t i = 0; i < samples.size(); ++i)
             {
-                if (section.getType() == brain::neuron::SectionType::soma)
-                    continue;
-
+                const auto& sample = samples[i];
+                const auto sectionType =
+                    static_cast<brain::neuron::SectionType>(sample.sectionType);
                 const auto materialId =
                     _getMaterialFromGeometryParameters(index, material,
-                                                       section.getType(),
+                                                       sectionType,
                                                        targetGIDOffsets);
-                const auto& samples = section.getSamples();
-                if (samples.empty())
-                    continue;
 
-                auto previousSample = samples[0];
-                size_t step = 1;
-                switch (_geometryParameters.getGeometryQuality())
-                {
-                case GeometryQuality::low:
-                    step = samples.size() - 1;
-                    break;
-                case GeometryQuality::medium:
-                    step = samples.size() / 2;
-                    step = (step == 0) ? 1 : step;
-                    break;
-                default:
-                    step = 1;
-                }
-
-                const float distanceToSoma = section.getDistanceToSoma();
-                const floats& distancesToSoma =
-                    section.getSampleDistancesToSoma();
-
-                float segmentStep = 0.f;
                 if (compartmentReport)
                 {
+                    const auto& offsets =
+                        compartmentReport->getOffsets()[index];
                     const auto& counts =
                         compartmentReport->getCompartmentCounts()[index];
-                    // Number of compartments usually differs from number of
-                    // samples
-                    segmentStep =
-                        counts[section.getID()] / float(samples.size());
-                }
-
-                bool done = false;
-                for (size_t i = step; !done && i < samples.size() + step;
-                     i += step)
-                {
-                    if (i >= samples.size())
-                    {
-                        i = samples.size() - 1;
-                        done = true;
-                    }
 
-                    const auto distance = distanceToSoma + distancesToSoma[i];
-
-                    if (compartmentReport)
+                    // update the offset if we have enough compartments aka
+                    // a full compartment report. Otherwise we keep the soma
+                    // offset which happens for soma reports and use this
+                    // for all the sections
+                    if (sample.sectionID < counts.size())
                     {
-                        const auto& offsets =
-                            compartmentReport->getOffsets()[index];
-                        const auto& counts =
-                            compartmentReport->getCompartmentCounts()[index];
-
-                        // update the offset if we have enough compartments aka
-                        // a full compartment report. Otherwise we keep the soma
-                        // offset which happens for soma reports and use this
-                        // for all the sections
-                        if (section.getID() < counts.size())
+                        if (counts[sample.sectionID] > 0)
+                        {
+                            // Number of compartments usually differs from
+                            // number of samples
+                            const float segmentStep =
+                                counts[sample.sectionID] /
+                                float(sample.nbSectionSamples);
+                            offset = offsets[sample.sectionID] +
+                                     float(sample.segment) * segmentStep;
+                        }
+                        else
                         {
-                            if (counts[section.getID()] > 0)
-                                offset = offsets[section.getID()] +
-                                         float(i - step) * segmentStep;
+                            if (sectionType == brain::neuron::SectionType::axon)
+                                offset = offsets[lastAxon];
                             else
-                            {
-                                if (section.getType() ==
-                                    brain::neuron::SectionType::axon)
-                                {
-                                    offset = offsets[lastAxon];
-                                }
-                                else
-                                    // This should never happen, but just in
-                                    // case use an invalid value to show an
-                                    // error color
-                                    offset =
-                                        std::numeric_limits<uint64_t>::max();
-                            }
+                                // This should never happen, but just in
+                                // case use an invalid value to show an
+                                // error color
+                                offset = std::numeric_limits<uint64_t>::max();
                         }
                     }
+                }
 
-                    const auto sample = samples[i];
-                    const auto previousRadius =
-                        _getCorrectedRadius(samples[i - step].w() * 0.5f);
-
-                    Vector3f position(sample.x(), sample.y(), sample.z());
-                    position += translation;
-                    Vector3f target(previousSample.x(), previousSample.y(),
-                                    previousSample.z());
-                    target += translation;
-                    const auto textureCoordinates =
-                        _getIndexAsTextureCoordinates(offset);
-                    const auto radius =
-                        _getCorrectedRadius(samples[i].w() * 0.5f);
+                const Vector3f position =
+                    transformation * sample.position + translation;
+                const Vector3f target =
+                    transformation * sample.target + translation;
+                const auto textureCoordinates = _getIndexAsTextureCoordinates(
+                    offset - scene.simulationOffsetBase);
 
-                    if (radius > 0.f)
+                // The skeleton joins the first and last samples of every
+                // section
+                if (skeleton)
+                {
+                    if (i == 0 || samples[i - 1].sectionID != sample.sectionID)
                     {
-                        scene.addSphere(materialId, {position, radius, distance,
-                                                     textureCoordinates});
-
-                        if (position != target && previousRadius > 0.f)
-                        {
-                            if (radius == previousRadius)
-                                scene.addCylinder(materialId,
-                                                  {position, target, radius,
-                                                   distance,
-                                                   textureCoordinates});
-                            else
-                                scene.addCone(materialId,
-                                              {position, target, radius,
-                                               previousRadius, distance,
-                                               textureCoordinates});
-                        }
+                        sectionStart = target;
+                        sectionStartRadius = sample.previousRadius;
+                    }
+                    if ((i + 1 == samples.size() ||
+                         samples[i + 1].sectionID != sample.sectionID) &&
+                        sample.radius > 0.f && sectionStartRadius > 0.f)
+                    {
+                        if (_regionOfInterest.contains(position,
+                                                       sample.radius))
+                            skeleton->addSphere(materialId,
+                                                {position, sample.radius,
+                                                 sample.distanceToSoma,
+                                                 textureCoordinates});
+                        if (position != sectionStart)
+                            _addClippedCone(*skeleton, materialId,
+                                            {position, sectionStart,
+                                             sample.radius, sectionStartRadius,
+                                             sample.distanceToSoma,
+                                             textureCoordinates});
                     }
-                    previousSample = sample;
+                }
+
+                if (sample.radius <= 0.f)
+                    continue;
+
+                if (_regionOfInterest.contains(position, sample.radius))
+                    scene.addSphere(materialId, {position, sample.radius,
+                                                 sample.distanceToSoma,
+                                                 textureCoordinates});
+
+                if (sample.position != sample.target &&
+                    sample.previousRadius > 0.f)
+                {
+                    if (sample.radius == sample.previousRadius)
+                        _addClippedCylinder(scene, materialId,
+                                            {position, target, sample.radius,
+                                             sample.distanceToSoma,
+                                             textureCoordinates});
+                    else
+                        _addClippedCone(scene, materialId,
+                                        {position, target, sample.radius,
+                                         sample.previousRadius,
+                                         sample.distanceToSoma,
+                                         textureCoordinates});
                 }
             }
         }
@@ -862,12 +1106,11 @@ private:
     }
 #endif
 
-    bool _importMorphology(const servus::URI& source, const uint64_t index,
-                           const size_t material,
-                           const Matrix4f& transformation,
-                           CompartmentReportPtr compartmentReport,
-                           const GIDOffsets& targetGIDOffsets,
-                           ParallelSceneContainer& scene)
+    bool _importMorphology(
+        const servus::URI& source, const uint64_t index, const size_t material,
+        const Matrix4f& transformation, CompartmentReportPtr compartmentReport,
+        const GIDOffsets& targetGIDOffsets, ParallelSceneContainer& scene,
+        const MorphologyTessellation* prefetchedTessellation = nullptr)
     {
         bool returnValue = true;
         const size_t morphologySectionTypes =
@@ -885,89 +1128,426 @@ private:
             returnValue &&
             _importMorphologyFromURI(source, index, material, transformation,
                                      compartmentReport, targetGIDOffsets,
-                                     scene);
+                                     scene, prefetchedTessellation);
         return returnValue;
     }
 
+    /** Neurons with the same key are instances of the same geometry */
+    struct InstanceKey
+    {
+        std::string morphology;
+        size_ts materials;
+        uint16_ts compartmentCounts;
+        uint64_ts relativeOffsets;
+
+        bool operator<(const InstanceKey& other) const
+        {
+            return std::tie(morphology, materials, compartmentCounts,
+                            relativeOffsets) <
+                   std::tie(other.morphology, other.materials,
+                            other.compartmentCounts, other.relativeOffsets);
+        }
+    };
+
+    /**
+     * @brief _canUseInstances checks if the neurons of a circuit can be loaded
+     * as instances of their morphologies
+     * @return True if instances are enabled and the geometry of a neuron does
+     * not depend on anything else than its morphology and its transformation
+     */
+    bool _canUseInstances() const
+    {
+        return _geometryParameters.getCircuitUseInstances() &&
+               !_geometryParameters.getCircuitUseSimulationModel() &&
+               _geometryParameters.getMorphologyLayout().nbColumns == 0 &&
+               !_regionOfInterest.isDefined() &&
+               _geometryParameters.getMorphologySectionTypes() !=
+                   static_cast<size_t>(MorphologySectionType::soma);
+    }
+
+    /**
+     * @brief _getSimulationOffsetBase gets the smallest simulation offset of a
+     * neuron, to which the offsets of its instanced geometry are relative
+     * @param compartmentReport Compartment report mapped to the morphologies
+     * @param index Index of the neuron
+     * @return The simulation offset of the neuron, 0 if there is no report
+     */
+    uint64_t _getSimulationOffsetBase(CompartmentReportPtr compartmentReport,
+                                      const uint64_t index) const
+    {
+        if (!compartmentReport)
+            return 0;
+        const auto& offsets = compartmentReport->getOffsets()[index];
+        if (offsets.empty())
+            return 0;
+        return *std::min_element(offsets.begin(), offsets.end());
+    }
+
+    /**
+     * @brief _getInstanceKey gets what determines the geometry of a neuron,
+     * besides its transformation
+     * @param uri URI of the morphology
+     * @param index Index of the neuron
+     * @return Key of the neuron
+     */
+    InstanceKey _getInstanceKey(const servus::URI& uri, const uint64_t index,
+                                const GIDOffsets& targetGIDOffsets,
+                                CompartmentReportPtr compartmentReport) const
+    {
+        InstanceKey key;
+        key.morphology = uri.getPath();
+        for (const auto sectionType :
+             {brain::neuron::SectionType::undefined,
+              brain::neuron::SectionType::soma,
+              brain::neuron::SectionType::axon,
+              brain::neuron::SectionType::dendrite,
+              brain::neuron::SectionType::apicalDendrite})
+            key.materials.push_back(_getMaterialFromGeometryParameters(
+                index, NO_MATERIAL, sectionType, targetGIDOffsets));
+
+        if (compartmentReport)
+        {
+            key.compartmentCounts =
+                compartmentReport->getCompartmentCounts()[index];
+            const auto base =
+                _getSimulationOffsetBase(compartmentReport, index);
+            for (const auto offset : compartmentReport->getOffsets()[index])
+                key.relativeOffsets.push_back(offset - base);
+        }
+        return key;
+    }
+
+    /**
+     * @brief _importMorphologyInstances loads every morphology of a circuit
+     * once, in its own coordinates, and places one instance of it per neuron.
+     * Simulation offsets of the geometry are relative to the one of each
+     * instance.
+     * @return True if the loading was successfull, false otherwise
+     */
+    bool _importMorphologyInstances(const brain::Circuit& circuit,
+                                    const brain::GIDSet& gids,
+                                    const Matrix4fs& transformations,
+                                    const GIDOffsets& targetGIDOffsets,
+                                    CompartmentReportPtr compartmentReport)
+    {
+        const brain::URIs& uris = circuit.getMorphologyURIs(gids);
+        std::map<InstanceKey, uint64_ts> neurons;
+        for (uint64_t index = 0; index < uris.size(); ++index)
+            neurons[_getInstanceKey(uris[index], index, targetGIDOffsets,
+                                    compartmentReport)]
+                .push_back(index);
+
+        std::vector<const uint64_ts*> instances;
+        instances.reserve(neurons.size());
+        for (const auto& neuron : neurons)
+            instances.push_back(&neuron.second);
+
+        InstancedGeometries geometries(instances.size());
+        size_t loadingFailures = 0;
+        std::stringstream message;
+        message << "Loading " << instances.size() << " morphologies for "
+                << uris.size() << " neurons...";
+        std::atomic_size_t current{0};
+#pragma omp parallel for schedule(dynamic)
+        for (int64_t i = 0; i < int64_t(instances.size()); ++i)
+        {
+            ++current;
+            _parent.updateProgress(message.str(), current, instances.size());
+
+            auto geometry = std::make_shared<InstancedGeometry>();
+            Materials materials;
+            ParallelSceneContainer sceneContainer(geometry->spheres,
+                                                  geometry->cylinders,
+                                                  geometry->cones,
+                                                  geometry->trianglesMeshes,
+                                                  materials, geometry->bounds);
+
+            // The geometry of the first neuron is shared by all of them
+            const auto& indices = *instances[i];
+            const auto reference = indices.front();
+            sceneContainer.simulationOffsetBase =
+                _getSimulationOffsetBase(compartmentReport, reference);
+
+            const size_t materialId = _getMaterialFromGeometryParameters(
+                reference, NO_MATERIAL, brain::neuron::SectionType::undefined,
+                targetGIDOffsets);
+
+            if (!_importMorphology(uris[reference], reference, materialId,
+                                   Matrix4f(), compartmentReport,
+                                   targetGIDOffsets, sceneContainer))
+            {
+#pragma omp atomic
+                ++loadingFailures;
+                continue;
+            }
+
+            for (const auto index : indices)
+            {
+                geometry->transformations.push_back(transformations[index]);
+                if (compartmentReport)
+                    geometry->simulationOffsets.push_back(
+                        _getSimulationOffsetBase(compartmentReport, index));
+            }
+            geometries[i] = geometry;
+        }
+
+        for (const auto& geometry : geometries)
+            if (geometry)
+                _scene.addInstancedGeometry(geometry);
+        BRAYNS_INFO << "Placed " << uris.size() << " neurons as instances of "
+                    << instances.size() << " morphologies" << std::endl;
+
+        if (loadingFailures != 0)
+        {
+            BRAYNS_ERROR << loadingFailures << " could not be loaded"
+                         << std::endl;
+            return false;
+        }
+        return true;
+    }
+
     bool _importMorphologies(const brain::Circuit& circuit,
                              const brain::GIDSet& gids,
                              const Matrix4fs& transformations,
                              const GIDOffsets& targetGIDOffsets,
                              CompartmentReportPtr compartmentReport)
     {
+        if (_canUseInstances())
+            return _importMorphologyInstances(circuit, gids, transformations,
+                                              targetGIDOffsets,
+                                              compartmentReport);
+
         const brain::URIs& uris = circuit.getMorphologyURIs(gids);
         size_t loadingFailures = 0;
-        std::stringstream message;
-        message << "Loading " << uris.size() << " morphologies...";
         std::atomic_size_t current{0};
-#pragma omp parallel
+
+        // Every thread accumulates its morphologies in its own containers, so
+        // that no synchronization is needed until all of them are loaded
+#ifdef BRAYNS_USE_OPENMP
+        ThreadSceneGeometries threadGeometries(omp_get_max_threads());
+#else
+        ThreadSceneGeometries threadGeometries(1);
+#endif
+
+        // In progressive mode, threads publish what they loaded every
+        // batchSize morphologies, so that it is rendered while loading
+        const bool progressive = _geometryParameters.getCircuitBatchSize() != 0;
+        const size_t threadBatchSize = std::max<size_t>(
+            1, _geometryParameters.getCircuitBatchSize() /
+                   threadGeometries.size());
+
+        const auto startTime = std::chrono::high_resolution_clock::now();
+
+        // Morphologies are optionally read by dedicated I/O threads, so that
+        // the threads below never wait for the file system as long as reads
+        // keep up with them. Somas only are placed without reading any file.
+        std::unique_ptr<MorphologyPrefetcher> prefetcher;
+        if (_geometryParameters.getCircuitPrefetchThreads() != 0 &&
+            _geometryParameters.getMorphologySectionTypes() !=
+                static_cast<size_t>(MorphologySectionType::soma))
         {
-#pragma omp for nowait
-            for (uint64_t morphologyIndex = 0; morphologyIndex < uris.size();
-                 ++morphologyIndex)
-            {
-                ++current;
-                _parent.updateProgress(message.str(), current, uris.size());
-
-                SpheresMap spheres;
-                CylindersMap cylinders;
-                ConesMap cones;
-                TrianglesMeshMap triangleMeshes;
-                Materials materials;
-                Boxf bounds;
-                ParallelSceneContainer sceneContainer(spheres, cylinders, cones,
-                                                      triangleMeshes, materials,
-                                                      bounds);
-                const auto& uri = uris[morphologyIndex];
+            prefetcher.reset(new MorphologyPrefetcher(
+                uris.size(), _geometryParameters.getCircuitPrefetchThreads(),
+                _geometryParameters.getCircuitPrefetchQueueDepth(),
+                [this, &uris](const uint64_t index,
+                              MorphologyTessellation& tessellation) {
+                    _getMorphologyTessellation(uris[index], tessellation);
+                }));
+        }
 
+#pragma omp parallel
+        {
+#ifdef BRAYNS_USE_OPENMP
+            auto& threadGeometry = threadGeometries[omp_get_thread_num()];
+#else
+            auto& threadGeometry = threadGeometries[0];
+#endif
+            ParallelSceneContainer sceneContainer(
+                threadGeometry.spheres, threadGeometry.cylinders,
+                threadGeometry.cones, threadGeometry.trianglesMeshes,
+                threadGeometry.materials, threadGeometry.bounds);
+
+            // Coarse levels of detail share the materials of the thread
+            std::vector<std::unique_ptr<ParallelSceneContainer>>
+                coarseContainers;
+            if (_geometryParameters.getCircuitLevelsOfDetail())
+                for (size_t level = 0; level < NB_COARSE_LEVELS_OF_DETAIL;
+                     ++level)
+                {
+                    auto& coarse = threadGeometry.coarseGeometry[level];
+                    coarse = std::make_shared<InstancedGeometry>();
+                    coarseContainers.emplace_back(new ParallelSceneContainer(
+                        coarse->spheres, coarse->cylinders, coarse->cones,
+                        coarse->trianglesMeshes, threadGeometry.materials,
+                        coarse->bounds));
+                    sceneContainer.coarseLevels[level] =
+                        coarseContainers.back().get();
+                }
+            const auto threadStartTime =
+                std::chrono::high_resolution_clock::now();
+            size_t nbBatchMorphologies = 0;
+
+            const auto importMorphology = [&](
+                const uint64_t morphologyIndex,
+                const MorphologyTessellation* tessellation) {
+                const auto geometryStartTime =
+                    std::chrono::high_resolution_clock::now();
                 const size_t materialId = _getMaterialFromGeometryParameters(
                     morphologyIndex, NO_MATERIAL,
                     brain::neuron::SectionType::undefined, targetGIDOffsets);
 
-                if (!_importMorphology(uri, morphologyIndex, materialId,
+                if (!_importMorphology(uris[morphologyIndex], morphologyIndex,
+                                       materialId,
                                        transformations[morphologyIndex],
                                        compartmentReport, targetGIDOffsets,
-                                       sceneContainer))
+                                       sceneContainer, tessellation))
 #pragma omp atomic
                     ++loadingFailures;
 
-#pragma omp critical
-                for (size_t i = 0; i < materials.size(); ++i)
-                    _scene.setMaterial(i, materials[i]);
+                threadGeometry.geometryTime +=
+                    std::chrono::duration<double>(
+                        std::chrono::high_resolution_clock::now() -
+                        geometryStartTime)
+                        .count();
+            };
 
-#pragma omp critical
-                for (const auto& sphere : spheres)
+            const auto onMorphologyLoaded = [&]() {
+                if (progressive && ++nbBatchMorphologies == threadBatchSize)
                 {
-                    const auto id = sphere.first;
-                    _scene.getSpheres()[id].insert(
-                        _scene.getSpheres()[id].end(),
-                        sceneContainer.spheres[id].begin(),
-                        sceneContainer.spheres[id].end());
+                    const auto batch = takeBatch(threadGeometry);
+                    if (batch)
+                        _scene.addGeometryBatch(batch);
+                    nbBatchMorphologies = 0;
                 }
 
-#pragma omp critical
-                for (const auto& cylinder : cylinders)
-                {
-                    const auto id = cylinder.first;
-                    _scene.getCylinders()[id].insert(
-                        _scene.getCylinders()[id].end(),
-                        sceneContainer.cylinders[id].begin(),
-                        sceneContainer.cylinders[id].end());
-                }
+                const size_t loaded = ++current;
+                _parent.updateProgress("Loaded " + std::to_string(loaded) +
+                                           " of " +
+                                           std::to_string(uris.size()) +
+                                           " cells",
+                                       loaded, uris.size());
+            };
+
+            PrefetchedMorphology morphology;
+            const uint64_t nbMorphologies = prefetcher ? 0 : uris.size();
+            while (prefetcher && prefetcher->pop(morphology))
+            {
+                if (morphology.valid)
+                    importMorphology(morphology.index,
+                                     &morphology.tessellation);
+                else
+#pragma omp atomic
+                    ++loadingFailures;
+                onMorphologyLoaded();
+            }
 
-#pragma omp critical
-                for (const auto& cone : cones)
-                {
-                    const auto id = cone.first;
-                    _scene.getCones()[id].insert(
-                        _scene.getCones()[id].end(),
-                        sceneContainer.cones[id].begin(),
-                        sceneContainer.cones[id].end());
-                }
+#pragma omp for nowait
+            for (uint64_t morphologyIndex = 0; morphologyIndex < nbMorphologies;
+                 ++morphologyIndex)
+            {
+                importMorphology(morphologyIndex, nullptr);
+                onMorphologyLoaded();
+            }
 
-#pragma omp critical
-                _scene.getWorldBounds().merge(bounds);
+            const auto batch = takeBatch(threadGeometry);
+            if (progressive && batch)
+                _scene.addGeometryBatch(batch);
+
+            threadGeometry.loadingTime =
+                std::chrono::duration<double>(
+                    std::chrono::high_resolution_clock::now() - threadStartTime)
+                    .count();
+        }
+
+        // Batches may be rendered until the whole scene is built
+        std::lock_guard<std::mutex> lock(_scene.getLoadingMutex());
+        const auto mergeStartTime = std::chrono::high_resolution_clock::now();
+
+        size_t nbMaterials = 0;
+        double loadingTime = 0.0;
+        InstancedGeometries batches;
+        for (const auto& threadGeometry : threadGeometries)
+        {
+            nbMaterials =
+                std::max(nbMaterials, threadGeometry.materials.size());
+            loadingTime += threadGeometry.loadingTime;
+            _scene.getWorldBounds().merge(threadGeometry.bounds);
+            batches.insert(batches.end(), threadGeometry.batches.begin(),
+                           threadGeometry.batches.end());
+        }
+        // Only creates missing materials, existing ones are left untouched
+        if (nbMaterials != 0)
+            _scene.getMaterial(nbMaterials - 1);
+
+        uint64_t nbPrimitives =
+            concatenatePrimitives(batches, &InstancedGeometry::spheres,
+                                  _scene.getSpheres(), !progressive);
+        nbPrimitives +=
+            concatenatePrimitives(batches, &InstancedGeometry::cylinders,
+                                  _scene.getCylinders(), !progressive);
+        nbPrimitives +=
+            concatenatePrimitives(batches, &InstancedGeometry::cones,
+                                  _scene.getCones(), !progressive);
+        concatenateMeshes(batches, _scene.getTriangleMeshes(), !progressive);
+
+        if (_geometryParameters.getCircuitLevelsOfDetail())
+            for (size_t level = 0; level < NB_COARSE_LEVELS_OF_DETAIL; ++level)
+            {
+                InstancedGeometries coarseGeometries;
+                for (const auto& threadGeometry : threadGeometries)
+                    coarseGeometries.push_back(
+                        threadGeometry.coarseGeometry[level]);
+
+                auto& destination =
+                    _scene.getCoarseGeometry(LevelOfDetail(level));
+                concatenatePrimitives(coarseGeometries,
+                                      &InstancedGeometry::spheres,
+                                      destination.spheres, true);
+                concatenatePrimitives(coarseGeometries,
+                                      &InstancedGeometry::cylinders,
+                                      destination.cylinders, true);
+                concatenatePrimitives(coarseGeometries,
+                                      &InstancedGeometry::cones,
+                                      destination.cones, true);
             }
+
+        const auto endTime = std::chrono::high_resolution_clock::now();
+        const double elapsed =
+            std::chrono::duration<double>(mergeStartTime - startTime).count();
+        const double mergeElapsed =
+            std::chrono::duration<double>(endTime - mergeStartTime).count();
+        BRAYNS_INFO << "Loaded " << uris.size() << " morphologies in "
+                    << elapsed * 1000.0 << " ms on " << threadGeometries.size()
+                    << " threads (speedup: "
+                    << (elapsed > 0.0 ? loadingTime / elapsed : 1.0)
+                    << "), merged " << nbPrimitives << " primitives from "
+                    << batches.size() << " batches in " << mergeElapsed * 1000.0
+                    << " ms" << std::endl;
+
+        // Throughputs of both stages of the pipeline, as if their threads
+        // never waited for each other
+        if (prefetcher)
+        {
+            double geometryTime = 0.0;
+            for (const auto& threadGeometry : threadGeometries)
+                geometryTime += threadGeometry.geometryTime;
+            const double readTime = prefetcher->getReadTime();
+            const double nbMorphologies = uris.size();
+            BRAYNS_INFO << "Read morphologies at "
+                        << (readTime > 0.0 ? nbMorphologies *
+                                                 prefetcher->getNbThreads() /
+                                                 readTime
+                                           : 0.0)
+                        << " per second on " << prefetcher->getNbThreads()
+                        << " I/O threads, generated their geometry at "
+                        << (geometryTime > 0.0
+                                ? nbMorphologies * threadGeometries.size() /
+                                      geometryTime
+                                : 0.0)
+                        << " per second on " << threadGeometries.size()
+                        << " threads, which waited "
+                        << prefetcher->getWaitTime() * 1000.0
+                        << " ms for reads" << std::endl;
         }
 
         if (loadingFailures != 0)
@@ -988,6 +1568,8 @@ private:
     size_ts _electrophysiologyTypes;
     size_ts _morphologyTypes;
     size_t _materialsOffset;
+    MorphologyCache _morphologyCache;
+    RegionOfInterest _regionOfInterest;
 };
 
 MorphologyLoader::MorphologyLoader(
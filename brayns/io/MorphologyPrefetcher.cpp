@@ -0,0 +1,134 @@
+/* Copyright (c) 2015-2017, EPFL/Blue Brain Project
+ * All rights reserved. Do not distribute without permission.
+ * Responsible Author: Cyrille Favreau <cyrille.favreau@epfl.ch>
+ *
+ * This file is part of Brayns <https://github.com/BlueBrain/Brayns>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "MorphologyPrefetcher.h"
+
+#include <brayns/common/log.h>
+
+#include <algorithm>
+#include <chrono>
+
+namespace
+{
+double getElapsedTime(
+    const std::chrono::high_resolution_clock::time_point& startTime)
+{
+    return std::chrono::duration<double>(
+               std::chrono::high_resolution_clock::now() - startTime)
+        .count();
+}
+}
+
+namespace brayns
+{
+MorphologyPrefetcher::MorphologyPrefetcher(const uint64_t nbMorphologies,
+                                           const size_t nbThreads,
+                                           const size_t queueDepth,
+                                           const ReadFunction& read)
+    : _nbMorphologies(nbMorphologies)
+    , _queueDepth(std::max<size_t>(1, queueDepth))
+    , _read(read)
+{
+    const size_t nbReaders =
+        std::min<uint64_t>(std::max<size_t>(1, nbThreads), nbMorphologies);
+    for (size_t i = 0; i < nbReaders; ++i)
+        _threads.emplace_back(&MorphologyPrefetcher::_readMorphologies, this);
+}
+
+MorphologyPrefetcher::~MorphologyPrefetcher()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stopped = true;
+    }
+    _notFull.notify_all();
+    for (auto& thread : _threads)
+        thread.join();
+}
+
+bool MorphologyPrefetcher::pop(PrefetchedMorphology& morphology)
+{
+    const auto startTime = std::chrono::high_resolution_clock::now();
+    std::unique_lock<std::mutex> lock(_mutex);
+    _notEmpty.wait(lock, [this] {
+        return !_queue.empty() || _nbPopped == _nbMorphologies;
+    });
+    _waitTime += getElapsedTime(startTime);
+    if (_queue.empty())
+        return false;
+
+    morphology = std::move(_queue.front());
+    _queue.pop_front();
+
+    // Consumers still waiting have nothing left to pop
+    if (++_nbPopped == _nbMorphologies)
+        _notEmpty.notify_all();
+    lock.unlock();
+    _notFull.notify_one();
+    return true;
+}
+
+double MorphologyPrefetcher::getReadTime() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _readTime;
+}
+
+double MorphologyPrefetcher::getWaitTime() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _waitTime;
+}
+
+void MorphologyPrefetcher::_readMorphologies()
+{
+    for (;;)
+    {
+        PrefetchedMorphology morphology;
+        morphology.index = _nextIndex++;
+        if (morphology.index >= _nbMorphologies)
+            return;
+
+        // Failures are still queued, so that consumers can count them
+        const auto startTime = std::chrono::high_resolution_clock::now();
+        try
+        {
+            _read(morphology.index, morphology.tessellation);
+            morphology.valid = true;
+        }
+        catch (const std::exception& e)
+        {
+            BRAYNS_ERROR << e.what() << std::endl;
+        }
+        const double readTime = getElapsedTime(startTime);
+
+        std::unique_lock<std::mutex> lock(_mutex);
+        _readTime += readTime;
+        _notFull.wait(lock, [this] {
+            return _stopped || _queue.size() < _queueDepth;
+        });
+        if (_stopped)
+            return;
+        _queue.push_back(std::move(morphology));
+        lock.unlock();
+        _notEmpty.notify_one();
+    }
+}
+}
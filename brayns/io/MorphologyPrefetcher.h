@@ -0,0 +1,96 @@
+/* Copyright (c) 2015-2017, EPFL/Blue Brain Project
+ * All rights reserved. Do not distribute without permission.
+ * Responsible Author: Cyrille Favreau <cyrille.favreau@epfl.ch>
+ *
+ * This file is part of Brayns <https://github.com/BlueBrain/Brayns>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#pragma once
+
+#include <brayns/io/MorphologyCache.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace brayns
+{
+/** Morphology read by a MorphologyPrefetcher */
+struct PrefetchedMorphology
+{
+    uint64_t index{0};
+    // False if the morphology could not be read
+    bool valid{false};
+    MorphologyTessellation tessellation;
+};
+
+/**
+ * Reads the tessellations of morphologies on a bounded number of I/O threads,
+ * ahead of the threads that generate their geometry. Reading stops whenever
+ * queueDepth morphologies are waiting to be consumed, which bounds the memory
+ * used by the pipeline however slow the consumers are. Morphologies are
+ * consumed in the order they are read.
+ */
+class MorphologyPrefetcher
+{
+public:
+    /** Reads the tessellation of the morphology at the given index */
+    typedef std::function<void(uint64_t, MorphologyTessellation&)>
+        ReadFunction;
+
+    MorphologyPrefetcher(uint64_t nbMorphologies, size_t nbThreads,
+                         size_t queueDepth, const ReadFunction& read);
+
+    /** Stops reading and joins the I/O threads */
+    ~MorphologyPrefetcher();
+
+    /**
+     * Waits for the next morphology read by the I/O threads. Can be called
+     * concurrently by several consumers.
+     * @return false if all morphologies were already consumed
+     */
+    bool pop(PrefetchedMorphology& morphology);
+
+    size_t getNbThreads() const { return _threads.size(); }
+    /** Time spent reading morphologies, summed over all I/O threads */
+    double getReadTime() const;
+    /** Time spent by consumers waiting for a morphology to be read */
+    double getWaitTime() const;
+
+private:
+    void _readMorphologies();
+
+    const uint64_t _nbMorphologies;
+    const size_t _queueDepth;
+    const ReadFunction _read;
+
+    std::atomic<uint64_t> _nextIndex{0};
+    uint64_t _nbPopped{0};
+    std::deque<PrefetchedMorphology> _queue;
+    bool _stopped{false};
+    double _readTime{0.0};
+    double _waitTime{0.0};
+
+    mutable std::mutex _mutex;
+    std::condition_variable _notEmpty;
+    std::condition_variable _notFull;
+    std::vector<std::thread> _threads;
+};
+}
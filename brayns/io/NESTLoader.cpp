@@ -116,8 +116,8 @@ void NESTLoader::importCircuit(const std::string& filepath, Scene& scene)
     BRAYNS_INFO << "Number of materials: " << materialMapping.size()
                 << std::endl;
 
-    SpheresMap& spheres = scene.getSpheres();
-    spheres[0].reserve(_frameSize);
+    Spheres spheres;
+    spheres.reserve(_frameSize);
     _positions.reserve(_frameSize);
     const float radius = _geometryParameters.getRadiusMultiplier();
 
@@ -130,10 +130,10 @@ void NESTLoader::importCircuit(const std::string& filepath, Scene& scene)
             xColor[gid] * 65536 + yColor[gid] * 256 + zColor[gid];
         const Vector3f center(xPos[gid], yPos[gid], zPos[gid]);
         _positions.push_back(center);
-        scene.addSphere(0,
-                        {center, radius, 0.f, {materialMapping[index], 0.f}});
-        updateProgress("Loading neurons...", spheres[0].size(), _frameSize);
+        spheres.push_back({center, radius, 0.f, {materialMapping[index], 0.f}});
+        updateProgress("Loading neurons...", spheres.size(), _frameSize);
     }
+    scene.addSpheres(0, std::move(spheres));
 
     BRAYNS_INFO << "Finished loading " << _frameSize << " neurons" << std::endl;
 }
@@ -146,8 +146,27 @@ bool NESTLoader::importSpikeReport(const std::string& filename)
         return false;
     }
 
-    const uint64_t nbFrames = (_spikesEnd - _spikesStart) / NEST_TIMESTEP;
-    _spikingTimes.resize(_frameSize, -1.f);
+    const uint64_t nbFrames =
+        uint64_t((_spikesEnd - _spikesStart) / NEST_TIMESTEP) + 1;
+
+    // Only the spikes are stored, sorted by time
+    SpikeEvents spikes;
+    spikes.reserve(_nbElements);
+    for (size_t i = 0; i < _nbElements; ++i)
+    {
+        const uint32_t gid = _gids[i] - NEST_OFFSET;
+        if (_gids[i] < NEST_OFFSET || gid >= _frameSize)
+        {
+            BRAYNS_DEBUG << "Ignoring spike of unknown neuron " << _gids[i]
+                         << std::endl;
+            continue;
+        }
+        spikes.push_back({_values[i], gid});
+    }
+    std::stable_sort(spikes.begin(), spikes.end(),
+                     [](const SpikeEvent& a, const SpikeEvent& b) {
+                         return a.time < b.time;
+                     });
 
     BRAYNS_INFO << "Cache file does not exist, creating it" << std::endl;
     const std::string& cacheFile = _geometryParameters.getNESTCacheFile();
@@ -160,28 +179,22 @@ bool NESTLoader::importSpikeReport(const std::string& filename)
     }
 
     SpikeSimulationHandler simulationHandler(_geometryParameters);
-    // Write header
     simulationHandler.setNbFrames(nbFrames);
     simulationHandler.setFrameSize(_frameSize);
-    simulationHandler.writeHeader(file);
-
-    BRAYNS_INFO << "Spike report contains " << nbFrames << " frames of "
-                << _frameSize << " values each" << std::endl;
-
-    // Write body
-    for (float timestamp = _spikesStart; timestamp < _spikesEnd;
-         timestamp += NEST_TIMESTEP)
-    {
-        _load(timestamp);
-        simulationHandler.writeFrame(file, _spikingTimes);
-        if (file.bad())
-            throw std::runtime_error(
-                "Could not write cache file (disk full?), aborting");
-    }
+    simulationHandler.writeSparseCache(file, _spikesStart, NEST_TIMESTEP,
+                                       spikes);
+    if (file.bad())
+        throw std::runtime_error(
+            "Could not write cache file (disk full?), aborting");
+
+    BRAYNS_INFO << "Spike report contains " << spikes.size() << " spikes in "
+                << nbFrames << " frames of " << _frameSize << " values each"
+                << std::endl;
     file.close();
 
     BRAYNS_INFO << "----------------------------------------" << std::endl;
     BRAYNS_INFO << "Number of frames: " << nbFrames << std::endl;
+    BRAYNS_INFO << "Number of spikes: " << spikes.size() << std::endl;
     BRAYNS_INFO << "Frame size      : " << _frameSize << std::endl;
     BRAYNS_INFO << "----------------------------------------" << std::endl;
     return true;
@@ -239,41 +252,6 @@ bool NESTLoader::_loadBinarySpikes(const std::string& spikesFilename)
     return true;
 }
 
-bool NESTLoader::_load(const float timestamp)
-{
-    const float start = timestamp;
-    const float end = timestamp + NEST_TIMESTEP;
-
-    BRAYNS_DEBUG << "Loading spikes at timestamp: " << timestamp << " ("
-                 << start << " ms)" << std::endl;
-
-    size_t nbSpikes = 0;
-    for (size_t i = 0; i < _nbElements; ++i)
-    {
-        const float time = _values[i];
-        // Whith the next check, simulation only plays forward because the value
-        // that is stored
-        // is the last time the spike occured for this neuron.
-        if (time < start)
-            continue;
-
-        if (time >= end)
-            break;
-
-        const uint32_t gid = _gids[i] - NEST_OFFSET;
-
-        // We store the frame on which the spike happens, as the renderer keeps
-        // track of the current timestamp
-        assert(gid < _spikingTimes.size());
-        _spikingTimes[gid] = time;
-
-        ++nbSpikes;
-    }
-    BRAYNS_INFO << "Nb Spikes for timestamp " << timestamp << " [" << start
-                << "-" << end << "]: " << nbSpikes << std::endl;
-
-    return true;
-}
 #else
 void NESTLoader::importCircuit(const std::string&, Scene&, size_t&)
 {
@@ -292,11 +270,5 @@ bool NESTLoader::_loadBinarySpikes(const std::string&)
     return false;
 }
 
-bool NESTLoader::_load(const float)
-{
-    BRAYNS_ERROR << "Brion is required to load circuits" << std::endl;
-    return false;
-}
-
 #endif
 }
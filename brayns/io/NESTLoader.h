@@ -30,25 +30,16 @@
 
 namespace brayns
 {
-/** Loads a NEST circuit from file and stores it into a cache file containing
- * the activation
- * timestamp for every GUID of every frame. The cache file full path is
- * specified by the
- * --nest-cache-file command line parameter. If the cache file does not exist,
- * it is created and
- * populated by the import process. The format of the cache file is a array of
- * float values
- * representing the activation timestamp by GUID. GUID are ordered in the same
- * way as they are
- * read from the original NEST circuit. All frames of the simulation are stored
- * one after the other.
- * The cache file contains a header of two uint64_t. The first one is the number
- * of frame, and the
- * second one is the frame size (the number of floats per frame). The cache file
- * is handled bu the
- * SpikeSimulationHandler class.
- * Note that in the current implementation, the simulation can only be played
- * forward.
+/** Loads a NEST circuit from file and stores its spikes into a cache file. The
+ * cache file full path is specified by the --nest-cache-file command line
+ * parameter. If the cache file does not exist, it is created and populated by
+ * the import process. The cache file only contains the spikes, as a list of
+ * timestamp and GUID sorted by timestamp, and the end index of every frame in
+ * that list (see SpikeSimulationHandler::writeSparseCache). GUID are ordered
+ * in the same way as they are read from the original NEST circuit. The cache
+ * file is handled by the SpikeSimulationHandler class, that rebuilds the
+ * activation timestamp of every GUID for the requested frame, so that the
+ * simulation can be played in both directions.
  * @todo Move this loaded to Brion
  */
 class NESTLoader : public ProgressReporter
@@ -72,9 +63,8 @@ public:
      * attached to the
      * specified scene at the end of the loading. If the cache file does not
      * exists, it is created.
-     * The cache file contains the timestamp for the spike activation, for every
-     * neuron, and for
-     * every frame.
+     * The cache file contains the spikes sorted by timestamp, and the index
+     * following the last spike of every frame.
      * @param filename File containing the report
      * @return True if report was successfully imported, false otherwise
      */
@@ -82,14 +72,12 @@ public:
 
 private:
     bool _loadBinarySpikes(const std::string& spikesFilename);
-    bool _load(const float timestamp);
 
     const GeometryParameters& _geometryParameters;
     floats _values;
     uint32_ts _gids;
     uint64_t _frameSize;
     uint32_t _nbElements;
-    floats _spikingTimes;
     float _spikesStart;
     float _spikesEnd;
 
@@ -313,6 +313,24 @@ ProteinLoader::ProteinLoader(const GeometryParameters& geometryParameters)
 bool ProteinLoader::importPDBFile(const std::string& filename,
                                   const Vector3f& position,
                                   const size_t proteinIndex, Scene& scene)
+{
+    // Atoms are gathered per material and added to the scene at once
+    SpheresMap spheres;
+    if (!importPDBFile(filename, position, proteinIndex,
+                       scene.getMaterials().size(), spheres))
+        return false;
+
+    for (size_t materialId = 0; materialId < spheres.size(); ++materialId)
+        if (!spheres[materialId].empty())
+            scene.addSpheres(materialId, std::move(spheres[materialId]));
+    return true;
+}
+
+bool ProteinLoader::importPDBFile(const std::string& filename,
+                                  const Vector3f& position,
+                                  const size_t proteinIndex,
+                                  const size_t nbMaterials,
+                                  SpheresMap& spheres)
 {
     int index(0);
     std::ifstream file(filename.c_str());
@@ -401,16 +419,16 @@ bool ProteinLoader::importPDBFile(const std::string& filename,
                         switch (colorScheme)
                         {
                         case ColorScheme::protein_chains:
-                            atom.materialId = NB_SYSTEM_MATERIALS +
-                                              abs(atom.chainId) %
-                                                  (scene.getMaterials().size() -
-                                                   NB_SYSTEM_MATERIALS);
+                            atom.materialId =
+                                NB_SYSTEM_MATERIALS +
+                                abs(atom.chainId) %
+                                    (nbMaterials - NB_SYSTEM_MATERIALS);
                             break;
                         case ColorScheme::protein_residues:
-                            atom.materialId = NB_SYSTEM_MATERIALS +
-                                              abs(atom.residue) %
-                                                  (scene.getMaterials().size() -
-                                                   NB_SYSTEM_MATERIALS);
+                            atom.materialId =
+                                NB_SYSTEM_MATERIALS +
+                                abs(atom.residue) %
+                                    (nbMaterials - NB_SYSTEM_MATERIALS);
                             break;
                         default:
                             atom.materialId = static_cast<int>(i);
@@ -436,14 +454,14 @@ bool ProteinLoader::importPDBFile(const std::string& filename,
 
                 const auto materialId =
                     colorScheme == ColorScheme::protein_by_id
-                        ? proteinIndex % scene.getMaterials().size()
+                        ? proteinIndex % nbMaterials
                         : atom.materialId;
                 // Convert position from nanometers
                 const auto center = position + 0.01f * atom.position;
                 // Convert radius from angstrom
                 const auto radius = 0.0001f * atom.radius *
                                     _geometryParameters.getRadiusMultiplier();
-                scene.addSphere(materialId, {center, radius});
+                spheres[materialId].push_back({center, radius});
             }
         }
         file.close();
@@ -47,6 +47,19 @@ public:
     bool importPDBFile(const std::string& filename, const Vector3f& position,
                        const size_t proteinIndex, Scene& scene);
 
+    /** Imports atoms from a given PDB file into spheres, per material
+     *
+     * @param filename PDB file to import
+     * @param position Position of protein in space
+     * @param proteinIndex Index of the protein when more than one is loaded
+     * @param nbMaterials Number of materials of the scene
+     * @param spheres Resulting spheres
+     * @return true if PDB file was successufully loaded, false otherwize
+     */
+    bool importPDBFile(const std::string& filename, const Vector3f& position,
+                       const size_t proteinIndex, const size_t nbMaterials,
+                       SpheresMap& spheres);
+
     /** Returns the RGB composants for a given atom index, and according to the
      * JMol scheme
      *
@@ -24,6 +24,12 @@
 
 #include "XYZBLoader.h"
 
+namespace
+{
+// Number of points read at once from binary files
+const uint64_t XYZB_CHUNK_SIZE = 65536;
+}
+
 namespace brayns
 {
 XYZBLoader::XYZBLoader(const GeometryParameters& geometryParameters)
@@ -41,7 +47,6 @@ bool XYZBLoader::importFromFile(const std::string& filename, Scene& scene)
         return false;
     }
 
-    SpheresMap& spheres = scene.getSpheres();
     bool validParsing = true;
     std::string line;
 
@@ -52,6 +57,10 @@ bool XYZBLoader::importFromFile(const std::string& filename, Scene& scene)
                               std::istreambuf_iterator<char>(), '\n');
     }
 
+    Spheres spheres;
+    spheres.reserve(numlines);
+    const auto radius = _geometryParameters.getRadiusMultiplier();
+
     while (validParsing && std::getline(file, line))
     {
         std::vector<float> lineData;
@@ -66,9 +75,7 @@ bool XYZBLoader::importFromFile(const std::string& filename, Scene& scene)
         case 3:
         {
             const Vector3f position(lineData[0], lineData[1], lineData[2]);
-            scene.addSphere(0,
-                            Sphere(position,
-                                   _geometryParameters.getRadiusMultiplier()));
+            spheres.push_back({position, radius});
             break;
         }
         default:
@@ -76,10 +83,11 @@ bool XYZBLoader::importFromFile(const std::string& filename, Scene& scene)
             validParsing = false;
             break;
         }
-        updateProgress("Loading spheres...", spheres[0].size(), numlines);
+        updateProgress("Loading spheres...", spheres.size(), numlines);
     }
 
     file.close();
+    scene.addSpheres(0, std::move(spheres));
     return validParsing;
 }
 
@@ -94,27 +102,39 @@ bool XYZBLoader::importFromBinaryFile(const std::string& filename, Scene& scene)
     }
 
     file.seekg(0, std::ios_base::end);
-    uint64_t nbPoints = file.tellg() / (3 * sizeof(double));
+    const uint64_t nbPoints = file.tellg() / (3 * sizeof(double));
     file.seekg(0);
 
-    SpheresMap& spheres = scene.getSpheres();
-    while (!file.eof())
+    // Stream the points into the reserved scene container, so that only a
+    // chunk of them is held in double precision at any time
+    scene.reserveGeometry(0, nbPoints);
+    std::vector<double> points(3 * XYZB_CHUNK_SIZE);
+    Spheres spheres;
+    spheres.reserve(XYZB_CHUNK_SIZE);
+    const auto radius = _geometryParameters.getRadiusMultiplier();
+    for (uint64_t i = 0; i < nbPoints; i += XYZB_CHUNK_SIZE)
     {
-        double x, y, z;
-        file.read((char*)&x, sizeof(double));
-        file.read((char*)&y, sizeof(double));
-        file.read((char*)&z, sizeof(double));
-
-        BRAYNS_DEBUG << x << "," << y << "," << z << std::endl;
-
-        const Vector3f position(x, y, z);
-        const auto radius = _geometryParameters.getRadiusMultiplier();
-        scene.addSphere(0, {position, radius});
+        const uint64_t nbChunkPoints =
+            std::min(XYZB_CHUNK_SIZE, nbPoints - i);
+        file.read((char*)points.data(), 3 * nbChunkPoints * sizeof(double));
+        if (!file.good())
+        {
+            BRAYNS_ERROR << "Failed to read " << filename << std::endl;
+            return false;
+        }
 
-        updateProgress("Loading spheres...", spheres[0].size(), nbPoints);
+        spheres.clear();
+        for (uint64_t j = 0; j < nbChunkPoints; ++j)
+        {
+            const Vector3f position(points[3 * j], points[3 * j + 1],
+                                    points[3 * j + 2]);
+            spheres.push_back({position, radius});
+        }
+        scene.addSpheres(0, spheres);
+        updateProgress("Loading spheres...", i + nbChunkPoints, nbPoints);
     }
-
     file.close();
+
     return true;
 }
 }
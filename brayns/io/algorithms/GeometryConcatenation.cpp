@@ -0,0 +1,58 @@
+/* Copyright (c) 2015-2017, EPFL/Blue Brain Project
+ * All rights reserved. Do not distribute without permission.
+ * Responsible Author: Cyrille Favreau <cyrille.favreau@epfl.ch>
+ *
+ * This file is part of Brayns <https://github.com/BlueBrain/Brayns>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "GeometryConcatenation.h"
+
+namespace brayns
+{
+void concatenateMeshes(const InstancedGeometries& batches,
+                       TrianglesMeshMap& destination, const bool release)
+{
+    for (auto& batch : batches)
+    {
+        auto& meshes = batch->trianglesMeshes;
+        for (size_t materialId = 0; materialId < meshes.size(); ++materialId)
+        {
+            const auto& mesh = meshes[materialId];
+            if (mesh.empty())
+                continue;
+
+            auto& sceneMesh = destination[materialId];
+            const unsigned int offset = sceneMesh.vertices.size();
+            sceneMesh.vertices.insert(sceneMesh.vertices.end(),
+                                      mesh.vertices.begin(),
+                                      mesh.vertices.end());
+            sceneMesh.normals.insert(sceneMesh.normals.end(),
+                                     mesh.normals.begin(), mesh.normals.end());
+            sceneMesh.colors.insert(sceneMesh.colors.end(),
+                                    mesh.colors.begin(), mesh.colors.end());
+            sceneMesh.textureCoordinates.insert(
+                sceneMesh.textureCoordinates.end(),
+                mesh.textureCoordinates.begin(), mesh.textureCoordinates.end());
+            for (const auto& index : mesh.indices)
+                sceneMesh.indices.push_back(
+                    Vector3ui(index.x() + offset, index.y() + offset,
+                              index.z() + offset));
+        }
+        if (release)
+            meshes.clear();
+    }
+}
+}
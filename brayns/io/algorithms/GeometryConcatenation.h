@@ -0,0 +1,99 @@
+/* Copyright (c) 2015-2017, EPFL/Blue Brain Project
+ * All rights reserved. Do not distribute without permission.
+ * Responsible Author: Cyrille Favreau <cyrille.favreau@epfl.ch>
+ *
+ * This file is part of Brayns <https://github.com/BlueBrain/Brayns>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#pragma once
+
+#include <brayns/common/geometry/InstancedGeometry.h>
+#include <brayns/common/types.h>
+
+#include <algorithm>
+
+namespace brayns
+{
+/**
+ * Appends the primitives of all batches to the scene. Destination offsets are
+ * the prefix sums of the sizes of every material, so that containers are
+ * resized once and the copies run in parallel without synchronization. The
+ * result is the same as appending the batches one after the other.
+ * @param release Frees the batches once copied. Batches that were published
+ *        to the scene must be kept, since the engine may share their memory
+ * @return the number of appended primitives
+ */
+template <typename T>
+uint64_t concatenatePrimitives(
+    const InstancedGeometries& batches,
+    GeometryArena<std::vector<T>> InstancedGeometry::*member,
+    GeometryArena<std::vector<T>>& destination, const bool release)
+{
+    struct Copy
+    {
+        const std::vector<T>* source;
+        size_t materialId;
+        size_t offset;
+    };
+    std::vector<Copy> copies;
+
+    size_t nbMaterials = 0;
+    for (const auto& batch : batches)
+        nbMaterials = std::max(nbMaterials, ((*batch).*member).size());
+
+    uint64_t nbPrimitives = 0;
+    for (size_t materialId = 0; materialId < nbMaterials; ++materialId)
+    {
+        const auto existing = destination.find(materialId);
+        const size_t begin = existing ? existing->size() : 0;
+        size_t offset = begin;
+        for (const auto& batch : batches)
+        {
+            const auto source = ((*batch).*member).find(materialId);
+            if (source && !source->empty())
+            {
+                copies.push_back({source, materialId, offset});
+                offset += source->size();
+            }
+        }
+        if (offset != begin)
+        {
+            destination[materialId].resize(offset);
+            nbPrimitives += offset - begin;
+        }
+    }
+
+#pragma omp parallel for schedule(dynamic)
+    for (int64_t i = 0; i < int64_t(copies.size()); ++i)
+    {
+        const auto& copy = copies[i];
+        std::copy(copy.source->begin(), copy.source->end(),
+                  destination[copy.materialId].begin() + copy.offset);
+    }
+
+    if (release)
+        for (auto& batch : batches)
+            ((*batch).*member).clear();
+    return nbPrimitives;
+}
+
+/**
+ * Appends the meshes of all batches to the scene, shifting vertex indices
+ * @param release Frees the meshes of the batches once copied
+ */
+void concatenateMeshes(const InstancedGeometries& batches,
+                       TrianglesMeshMap& destination, const bool release);
+}
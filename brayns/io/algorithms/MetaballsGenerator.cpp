@@ -22,15 +22,24 @@
 
 #include "MetaballsGenerator.h"
 
-#include <brayns/common/geometry/Sphere.h>
 #include <brayns/common/geometry/TrianglesMesh.h>
 #include <brayns/common/log.h>
-#include <brayns/common/material/Material.h>
+
+#include <cmath>
+#include <limits>
 
 namespace brayns
 {
 const size_t NB_EDGES = 12;
 
+// Number of cells of a block of the grid, along each axis
+const size_t BLOCK_SIZE = 8;
+
+// Offsets of the vertices of a cube in the grid, in x, y and z
+const size_t CUBE_VERTICES[8][3] = {{0, 0, 0}, {0, 0, 1}, {0, 1, 1},
+                                    {0, 1, 0}, {1, 0, 0}, {1, 0, 1},
+                                    {1, 1, 1}, {1, 1, 0}};
+
 const size_t METABALLS_VERTICES[24] = {0, 1, 1, 2, 2, 3, 3, 0, 4, 5, 5, 6,
                                        6, 7, 7, 4, 0, 4, 1, 5, 2, 6, 3, 7};
 
@@ -236,7 +245,7 @@ const int8_t METABALLS_TRIANGLES[256][16] = {
     {9, 5, 4, 10, 1, 6, 1, 7, 6, 1, 3, 7, -1, -1, -1, -1},
     {1, 6, 10, 1, 7, 6, 1, 0, 7, 8, 7, 0, 9, 5, 4, -1},
     {4, 0, 10, 4, 10, 5, 0, 3, 10, 6, 10, 7, 3, 7, 10, -1},
-    {7, 6, 10, 7, 10, 58, 5, 4, 10, 4, 8, 10, -1, -1, -1, -1},
+    {7, 6, 10, 7, 10, 8, 5, 4, 10, 4, 8, 10, -1, -1, -1, -1},
     {6, 9, 5, 6, 11, 9, 11, 8, 9, -1, -1, -1, -1, -1, -1, -1},
     {3, 6, 11, 0, 6, 3, 0, 5, 6, 0, 9, 5, -1, -1, -1, -1},
     {0, 11, 8, 0, 5, 11, 0, 1, 5, 5, 6, 11, -1, -1, -1, -1},
@@ -318,282 +327,285 @@ const int8_t METABALLS_TRIANGLES[256][16] = {
     {0, 3, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
     {-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}};
 
-MetaballsGenerator::~MetaballsGenerator()
-{
-    _clear();
-}
-
-void MetaballsGenerator::_buildVerticesAndCubes(const Vector4fs& metaballs,
-                                                const size_t gridSize,
-                                                const size_t defaultMaterialId,
-                                                const float scale)
+void MetaballsGenerator::_buildGrid(const Vector4fs& metaballs,
+                                    const size_t gridSize, const float scale)
 {
     // Determine bounding box
     Boxf bounds;
     for (const auto& ball : metaballs)
         bounds.merge(Vector3f(ball.x(), ball.y(), ball.z()));
-    const Vector3f center = bounds.getCenter();
 
     // Upscale the bounding box to make sure there is no whole in the isosurface
-    Boxf rescaledBounds = Boxf(center - scale * bounds.getSize() / 2.f,
-                               center + scale * bounds.getSize() / 2.f);
-
-    const auto rescaledSize = rescaledBounds.getSize();
-    const size_t incrementedSize = gridSize + 1;
-    _vertices.resize(incrementedSize * incrementedSize * incrementedSize);
-
-    size_t x = 0;
-#pragma omp parallel for
-    for (x = 0; x < incrementedSize; ++x)
-    {
-        for (size_t y = 0; y < incrementedSize; ++y)
-        {
-            for (size_t z = 0; z < incrementedSize; ++z)
-            {
-                CubeGridVertex cgv;
-                cgv.position.x() = rescaledBounds.getMin().x() +
-                                   x * rescaledSize.x() / gridSize;
-                cgv.position.y() = rescaledBounds.getMin().y() +
-                                   y * rescaledSize.y() / gridSize;
-                cgv.position.z() = rescaledBounds.getMin().z() +
-                                   z * rescaledSize.z() / gridSize;
-
-                cgv.texCoords.x() =
-                    static_cast<float>(x) / static_cast<float>(gridSize);
-                cgv.texCoords.y() =
-                    static_cast<float>(y) / static_cast<float>(gridSize);
-                cgv.texCoords.z() = 0.f;
-
-                cgv.value = 0.f;
-                cgv.normal = {0.f, 0.f, 0.f};
-
-                cgv.materialId = defaultMaterialId;
-
-                const size_t index = x * incrementedSize * incrementedSize +
-                                     y * incrementedSize + z;
-
-                _vertices[index] = cgv;
-            }
-        }
-    }
+    const Vector3f size = scale * bounds.getSize();
+    _origin = bounds.getCenter() - size / 2.f;
+    _cellSize = size / static_cast<float>(gridSize);
+    _gridSize = gridSize;
+    _nbBlocks = (gridSize + BLOCK_SIZE - 1) / BLOCK_SIZE;
+}
 
-    _cubes.resize(gridSize * gridSize * gridSize);
-#pragma omp parallel for
-    for (x = 0; x < gridSize; ++x)
-    {
-        for (size_t y = 0; y < gridSize; ++y)
-        {
-            for (size_t z = 0; z < gridSize; ++z)
-            {
-                CubeGridCube cgc;
-                cgc.vertices[0] =
-                    &_vertices[(x * incrementedSize + y) * incrementedSize + z];
-                cgc.vertices[1] =
-                    &_vertices[(x * incrementedSize + y) * incrementedSize + z +
-                               1];
-                cgc.vertices[2] = &_vertices[(x * incrementedSize + (y + 1)) *
-                                                 incrementedSize +
-                                             z + 1];
-                cgc.vertices[3] = &_vertices[(x * incrementedSize + (y + 1)) *
-                                                 incrementedSize +
-                                             z];
-                cgc.vertices[4] = &_vertices[((x + 1) * incrementedSize + y) *
-                                                 incrementedSize +
-                                             z];
-                cgc.vertices[5] = &_vertices[((x + 1) * incrementedSize + y) *
-                                                 incrementedSize +
-                                             z + 1];
-                cgc.vertices[6] =
-                    &_vertices[((x + 1) * incrementedSize + (y + 1)) *
-                                   incrementedSize +
-                               z + 1];
-                cgc.vertices[7] =
-                    &_vertices[((x + 1) * incrementedSize + (y + 1)) *
-                                   incrementedSize +
-                               z];
-
-                const size_t index = x * gridSize * gridSize + y * gridSize + z;
-                _cubes[index] = cgc;
-            }
-        }
-    }
+Vector3ui MetaballsGenerator::_getBlockCoordinates(const size_t block) const
+{
+    return Vector3ui(block / (_nbBlocks * _nbBlocks),
+                     (block / _nbBlocks) % _nbBlocks, block % _nbBlocks);
+}
 
-    BRAYNS_DEBUG << "Nb metaballs   : " << metaballs.size() << std::endl;
-    BRAYNS_DEBUG << "Nb Vertices    : " << _vertices.size() << std::endl;
-    BRAYNS_DEBUG << "Nb Cubes       : " << _cubes.size() << std::endl;
-    BRAYNS_DEBUG << "Grid size      : " << gridSize << std::endl;
-    BRAYNS_DEBUG << "Grid dimensions: " << bounds << "/" << bounds.getSize()
-                 << std::endl;
+Vector3f MetaballsGenerator::_getVertexPosition(const Vector3ui& vertex) const
+{
+    return Vector3f(_origin.x() + vertex.x() * _cellSize.x(),
+                    _origin.y() + vertex.y() * _cellSize.y(),
+                    _origin.z() + vertex.z() * _cellSize.z());
 }
 
-void MetaballsGenerator::_buildTriangles(const Vector4fs& metaballs,
-                                         const float threshold,
-                                         Materials& materials,
-                                         const size_t defaultMaterialId,
-                                         TrianglesMeshMap& triangles)
+void MetaballsGenerator::_findSurfaceBlocks(const Vector4fs& metaballs,
+                                            const float threshold)
 {
-#pragma omp parallel
-    for (const auto metaball : metaballs)
+    const Vector3f blockSize = _cellSize * static_cast<float>(BLOCK_SIZE);
+    const auto getBlock = [this, &blockSize](const float value,
+                                             const size_t axis) {
+        const float block =
+            std::floor((value - _origin[axis]) / blockSize[axis]);
+        return static_cast<size_t>(std::max(
+            0.f, std::min(block, static_cast<float>(_nbBlocks - 1))));
+    };
+
+    // Beyond r*sqrt(n/threshold) from its center, a ball contributes less than
+    // threshold/n to the field. The isosurface is therefore within that
+    // distance of at least one of the balls, which only flag the blocks they
+    // can reach.
+    const float influence =
+        threshold > 0.f ? std::sqrt(metaballs.size() / threshold)
+                        : std::numeric_limits<float>::max();
+    std::vector<bool> candidates(_nbBlocks * _nbBlocks * _nbBlocks, false);
+    for (const auto& ball : metaballs)
     {
-        const auto radius = metaball.w();
-        const auto squaredRadius = radius * radius;
-        const auto& ballPosition =
-            Vector3f(metaball.x(), metaball.y(), metaball.z());
-
-#pragma omp parallel
-        for (auto& vertex : _vertices)
+        const float radius = ball.w() * influence;
+        size_t begin[3];
+        size_t end[3];
+        for (size_t axis = 0; axis < 3; ++axis)
         {
-            const auto ballToPoint = vertex.position - ballPosition;
-
-            // get squared distance from ball to point
-            const auto distance = ballToPoint.length();
-            auto squaredDistance = distance * distance;
-
-            if (squaredDistance == 0.f)
-                continue;
-
-            const auto normalScale = squaredRadius / squaredDistance;
-            vertex.value += normalScale;
-
-            if (distance < threshold)
-                vertex.materialId = defaultMaterialId;
-
-            vertex.normal += ballToPoint * normalScale;
+            begin[axis] = getBlock(ball[axis] - radius, axis);
+            end[axis] = getBlock(ball[axis] + radius, axis);
         }
+        for (size_t x = begin[0]; x <= end[0]; ++x)
+            for (size_t y = begin[1]; y <= end[1]; ++y)
+                for (size_t z = begin[2]; z <= end[2]; ++z)
+                    candidates[(x * _nbBlocks + y) * _nbBlocks + z] = true;
     }
 
-    for (const auto& cube : _cubes)
+    // Bounds of the field over every candidate block, the isosurface goes
+    // through the block only if they enclose the threshold
+    _surfaceBlocks.clear();
+    for (size_t block = 0; block < candidates.size(); ++block)
     {
-        unsigned char cubeIndex = 0;
-
-        if (cube.vertices[0]->value > 0.f &&
-            cube.vertices[0]->value < threshold)
-            cubeIndex |= 1;
-        if (cube.vertices[1]->value > 0.f &&
-            cube.vertices[1]->value < threshold)
-            cubeIndex |= 2;
-        if (cube.vertices[2]->value > 0.f &&
-            cube.vertices[2]->value < threshold)
-            cubeIndex |= 4;
-        if (cube.vertices[3]->value > 0.f &&
-            cube.vertices[3]->value < threshold)
-            cubeIndex |= 8;
-        if (cube.vertices[4]->value > 0.f &&
-            cube.vertices[4]->value < threshold)
-            cubeIndex |= 16;
-        if (cube.vertices[5]->value > 0.f &&
-            cube.vertices[5]->value < threshold)
-            cubeIndex |= 32;
-        if (cube.vertices[6]->value > 0.f &&
-            cube.vertices[6]->value < threshold)
-            cubeIndex |= 64;
-        if (cube.vertices[7]->value > 0.f &&
-            cube.vertices[7]->value < threshold)
-            cubeIndex |= 128;
-
-        int usedEdges = METABALLS_EDGES[cubeIndex];
-
-        if (usedEdges == 0 || usedEdges == 255)
+        if (!candidates[block])
             continue;
 
-        for (size_t currentEdge = 0; currentEdge < NB_EDGES; ++currentEdge)
+        const auto coordinates = _getBlockCoordinates(block);
+        const auto first = coordinates * BLOCK_SIZE;
+        const Vector3ui last(std::min(first.x() + BLOCK_SIZE, _gridSize),
+                             std::min(first.y() + BLOCK_SIZE, _gridSize),
+                             std::min(first.z() + BLOCK_SIZE, _gridSize));
+        const auto blockMin = _getVertexPosition(first);
+        const auto blockMax = _getVertexPosition(last);
+
+        float minValue = 0.f;
+        float maxValue = 0.f;
+        for (const auto& ball : metaballs)
         {
-            // Check usedEdges against 1,2,4,8,16,...,2048
-            if (usedEdges & (1 << currentEdge))
+            float nearest = 0.f;
+            float farthest = 0.f;
+            for (size_t axis = 0; axis < 3; ++axis)
             {
-                CubeGridVertex* v1 =
-                    cube.vertices[METABALLS_VERTICES[currentEdge * 2]];
-                CubeGridVertex* v2 =
-                    cube.vertices[METABALLS_VERTICES[currentEdge * 2 + 1]];
-
-                const float denom = (v2->value - v1->value);
-                if (fabs(denom) < 0.00001f)
-                    continue;
-
-                auto delta = (threshold - v1->value) / denom;
-
-                Vector3f position;
-                position.x() = v1->position.x() +
-                               delta * (v2->position.x() - v1->position.x());
-                position.y() = v1->position.y() +
-                               delta * (v2->position.y() - v1->position.y());
-                position.z() = v1->position.z() +
-                               delta * (v2->position.z() - v1->position.z());
-
-                Vector3f normal;
-                normal.x() =
-                    v1->normal.x() + delta * (v2->normal.x() - v1->normal.x());
-                normal.y() =
-                    v1->normal.y() + delta * (v2->normal.y() - v1->normal.y());
-                normal.z() =
-                    v1->normal.z() + delta * (v2->normal.z() - v1->normal.z());
-
-                _edgeVertices[currentEdge].position = position;
-                _edgeVertices[currentEdge].normal = normal;
-                _edgeVertices[currentEdge].materialId = v1->materialId;
+                const float toMin = blockMin[axis] - ball[axis];
+                const float toMax = ball[axis] - blockMax[axis];
+                const float outside = std::max(0.f, std::max(toMin, toMax));
+                const float across =
+                    std::max(std::abs(toMin), std::abs(toMax));
+                nearest += outside * outside;
+                farthest += across * across;
             }
-        }
 
-        auto& vertices = triangles[defaultMaterialId].vertices;
-        auto& normals = triangles[defaultMaterialId].normals;
-        auto& colors = triangles[defaultMaterialId].colors;
-        auto& indices = triangles[defaultMaterialId].indices;
+            const float squaredRadius = ball.w() * ball.w();
+            if (farthest > 0.f)
+                minValue += squaredRadius / farthest;
+            maxValue += nearest > 0.f ? squaredRadius / nearest
+                                      : std::numeric_limits<float>::max();
+        }
 
-        for (auto k = 0; METABALLS_TRIANGLES[cubeIndex][k] != -1; k += 3)
-        {
-            const auto verticesIndex = vertices.size();
+        if (minValue <= threshold && maxValue >= threshold)
+            _surfaceBlocks.push_back(block);
+    }
+}
 
-            // Create triangulated face
-            bool processFace = true;
-            for (auto f = 0; f < 3 && processFace; ++f)
+void MetaballsGenerator::_sampleBlock(const Vector4fs& metaballs,
+                                      const size_t block,
+                                      FieldSamples& samples) const
+{
+    const size_t stride = BLOCK_SIZE + 1;
+    samples.resize(stride * stride * stride);
+
+    const auto first = _getBlockCoordinates(block) * BLOCK_SIZE;
+    const size_t nbX = std::min(stride, _gridSize + 1 - first.x());
+    const size_t nbY = std::min(stride, _gridSize + 1 - first.y());
+    const size_t nbZ = std::min(stride, _gridSize + 1 - first.z());
+    for (size_t x = 0; x < nbX; ++x)
+        for (size_t y = 0; y < nbY; ++y)
+            for (size_t z = 0; z < nbZ; ++z)
             {
-                const auto index = METABALLS_TRIANGLES[cubeIndex][k + f];
-                if (size_t(index) >= _edgeVertices.size())
-                    processFace = false;
+                const auto position = _getVertexPosition(
+                    first + Vector3ui(x, y, z));
+
+                FieldSample sample;
+                for (const auto& ball : metaballs)
+                {
+                    const Vector3f ballToPoint =
+                        position - Vector3f(ball.x(), ball.y(), ball.z());
+                    const float squaredDistance = ballToPoint.squared_length();
+                    if (squaredDistance == 0.f)
+                        continue;
+
+                    const float normalScale =
+                        ball.w() * ball.w() / squaredDistance;
+                    sample.value += normalScale;
+                    sample.normal += ballToPoint * normalScale;
+                }
+                samples[(x * stride + y) * stride + z] = sample;
             }
-            if (!processFace)
-                continue;
+}
 
-            for (auto f = 0; f < 3; ++f)
+void MetaballsGenerator::_buildTriangles(const size_t block,
+                                         const FieldSamples& samples,
+                                         const float threshold,
+                                         TrianglesMesh& mesh) const
+{
+    const size_t stride = BLOCK_SIZE + 1;
+    const auto first = _getBlockCoordinates(block) * BLOCK_SIZE;
+    const size_t nbX = std::min(BLOCK_SIZE, _gridSize - first.x());
+    const size_t nbY = std::min(BLOCK_SIZE, _gridSize - first.y());
+    const size_t nbZ = std::min(BLOCK_SIZE, _gridSize - first.z());
+
+    for (size_t x = 0; x < nbX; ++x)
+        for (size_t y = 0; y < nbY; ++y)
+            for (size_t z = 0; z < nbZ; ++z)
             {
-                const auto index = METABALLS_TRIANGLES[cubeIndex][k + f];
+                const FieldSample* corners[8];
+                Vector3f positions[8];
+                unsigned char cubeIndex = 0;
+                for (size_t i = 0; i < 8; ++i)
+                {
+                    const Vector3ui vertex(x + CUBE_VERTICES[i][0],
+                                           y + CUBE_VERTICES[i][1],
+                                           z + CUBE_VERTICES[i][2]);
+                    corners[i] = &samples[(vertex.x() * stride + vertex.y()) *
+                                              stride +
+                                          vertex.z()];
+                    positions[i] = _getVertexPosition(first + vertex);
+                    if (corners[i]->value > 0.f &&
+                        corners[i]->value < threshold)
+                        cubeIndex |= 1 << i;
+                }
 
-                const auto vertex = _edgeVertices[index].position;
-                vertices.push_back(vertex);
+                const int usedEdges = METABALLS_EDGES[cubeIndex];
+                if (usedEdges == 0)
+                    continue;
 
-                const auto normal = normalize(_edgeVertices[index].normal);
-                normals.push_back(normal);
+                Vector3f edgePositions[NB_EDGES];
+                Vector3f edgeNormals[NB_EDGES];
+                bool validEdges[NB_EDGES] = {};
+                for (size_t edge = 0; edge < NB_EDGES; ++edge)
+                {
+                    // Check usedEdges against 1,2,4,8,16,...,2048
+                    if (!(usedEdges & (1 << edge)))
+                        continue;
+
+                    const size_t v1 = METABALLS_VERTICES[edge * 2];
+                    const size_t v2 = METABALLS_VERTICES[edge * 2 + 1];
+                    const float denom =
+                        corners[v2]->value - corners[v1]->value;
+                    if (fabs(denom) < 0.00001f)
+                        continue;
+
+                    const float delta =
+                        (threshold - corners[v1]->value) / denom;
+                    edgePositions[edge] =
+                        positions[v1] + (positions[v2] - positions[v1]) * delta;
+                    edgeNormals[edge] =
+                        corners[v1]->normal +
+                        (corners[v2]->normal - corners[v1]->normal) * delta;
+                    validEdges[edge] = true;
+                }
 
-                if (defaultMaterialId == NO_MATERIAL)
+                for (auto k = 0; METABALLS_TRIANGLES[cubeIndex][k] != -1;
+                     k += 3)
                 {
-                    auto& material = materials[_edgeVertices[index].materialId];
-                    colors.push_back(material.getColor());
+                    const auto* edges = &METABALLS_TRIANGLES[cubeIndex][k];
+                    if (!validEdges[edges[0]] || !validEdges[edges[1]] ||
+                        !validEdges[edges[2]])
+                        continue;
+
+                    // Create triangulated face
+                    const auto verticesIndex = mesh.vertices.size();
+                    for (auto f = 0; f < 3; ++f)
+                    {
+                        mesh.vertices.push_back(edgePositions[edges[f]]);
+                        mesh.normals.push_back(
+                            normalize(edgeNormals[edges[f]]));
+                    }
+                    mesh.indices.push_back(Vector3ui(verticesIndex,
+                                                     verticesIndex + 1,
+                                                     verticesIndex + 2));
                 }
             }
-
-            indices.push_back(
-                Vector3ui(verticesIndex, verticesIndex + 1, verticesIndex + 2));
-        }
-    }
-}
-
-void MetaballsGenerator::_clear()
-{
-    _edgeVertices.resize(NB_EDGES);
-    _vertices.clear();
-    _cubes.clear();
 }
 
 void MetaballsGenerator::generateMesh(const Vector4fs& metaballs,
                                       const size_t gridSize,
                                       const float threshold,
-                                      Materials& materials,
-                                      const size_t defaultMaterialId,
+                                      const size_t materialId,
                                       TrianglesMeshMap& triangles)
 {
-    _clear();
-    _buildVerticesAndCubes(metaballs, gridSize, defaultMaterialId);
-    _buildTriangles(metaballs, threshold, materials, defaultMaterialId,
-                    triangles);
+    if (metaballs.empty() || gridSize == 0)
+        return;
+
+    _buildGrid(metaballs, gridSize);
+
+    // A flat grid, around a single ball for instance, holds no isosurface
+    if (_cellSize.x() <= 0.f || _cellSize.y() <= 0.f || _cellSize.z() <= 0.f)
+        return;
+
+    _findSurfaceBlocks(metaballs, threshold);
+
+    // Every block is triangulated in its own mesh, meshes are then appended
+    // in block order so that the result does not depend on the scheduling
+    std::vector<TrianglesMesh> blockMeshes(_surfaceBlocks.size());
+#pragma omp parallel
+    {
+        FieldSamples samples;
+#pragma omp for schedule(dynamic)
+        for (int64_t i = 0; i < int64_t(_surfaceBlocks.size()); ++i)
+        {
+            _sampleBlock(metaballs, _surfaceBlocks[i], samples);
+            _buildTriangles(_surfaceBlocks[i], samples, threshold,
+                            blockMeshes[i]);
+        }
+    }
+
+    auto& result = triangles[materialId];
+    for (auto& mesh : blockMeshes)
+    {
+        const uint32_t offset = result.vertices.size();
+        result.vertices.insert(result.vertices.end(), mesh.vertices.begin(),
+                               mesh.vertices.end());
+        result.normals.insert(result.normals.end(), mesh.normals.begin(),
+                              mesh.normals.end());
+        for (const auto& index : mesh.indices)
+            result.indices.push_back(index + Vector3ui(offset));
+        mesh = TrianglesMesh();
+    }
+
+    BRAYNS_DEBUG << "Nb metaballs   : " << metaballs.size() << std::endl;
+    BRAYNS_DEBUG << "Grid size      : " << gridSize << std::endl;
+    BRAYNS_DEBUG << "Surface blocks : " << _surfaceBlocks.size() << "/"
+                 << _nbBlocks * _nbBlocks * _nbBlocks << std::endl;
 }
 }
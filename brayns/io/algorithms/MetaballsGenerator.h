@@ -33,74 +33,50 @@ namespace brayns
 class MetaballsGenerator
 {
 public:
-    MetaballsGenerator() {}
-    ~MetaballsGenerator();
-
     /** Generates a triangle based mesh model according to provided
-     * metaballs, grid granularity and threshold
+     * metaballs, grid granularity and threshold. Only the blocks of the grid
+     * that the isosurface goes through are sampled, on all available cores.
      *
      * @param metaballs metaballs used to generate the mesh
      * @param gridSize Size of the grid
      * @param threshold Points in 3D space that fall below the threshold
      *        (when run through the function) are ONE, while points above the
      *        threshold are ZERO
-     * @param materials
-     * @param defaultMaterialId Default material to apply to the generated mesh
+     * @param materialId Material to apply to the generated mesh
      * @param triangles Generated triangles
      */
     void generateMesh(const Vector4fs& metaballs, const size_t gridSize,
-                      const float threshold, Materials& materials,
-                      const size_t defaultMaterialId,
+                      const float threshold, const size_t materialId,
                       TrianglesMeshMap& triangles);
 
 private:
-    struct SurfaceVertex
-    {
-        SurfaceVertex()
-            : materialId(0)
-        {
-        }
-
-        Vector3f position;
-        Vector3f normal;
-        Vector3f texCoords;
-        size_t materialId;
-    };
-
-    struct CubeGridVertex : public SurfaceVertex
+    /** Value of the scalar field and its gradient at a vertex of the grid */
+    struct FieldSample
     {
-        CubeGridVertex()
-            : SurfaceVertex()
-            , value(0)
-        {
-        }
-
-        float value; // Value of the scalar field
+        float value{0.f};
+        Vector3f normal{0.f, 0.f, 0.f};
     };
+    typedef std::vector<FieldSample> FieldSamples;
 
-    struct CubeGridCube
-    {
-        CubeGridVertex* vertices[8];
-    };
+    void _buildGrid(const Vector4fs& metaballs, const size_t gridSize,
+                    const float scale = 5.f);
 
-    typedef std::vector<CubeGridVertex> Vertices;
-    typedef std::vector<CubeGridCube> Cubes;
-    typedef std::vector<SurfaceVertex> SurfaceVertices;
+    void _findSurfaceBlocks(const Vector4fs& metaballs, const float threshold);
 
-    void _clear();
+    void _sampleBlock(const Vector4fs& metaballs, const size_t block,
+                      FieldSamples& samples) const;
 
-    void _buildVerticesAndCubes(const Vector4fs& metaballs,
-                                const size_t gridSize,
-                                const size_t defaultMaterialId,
-                                const float scale = 5.f);
+    void _buildTriangles(const size_t block, const FieldSamples& samples,
+                         const float threshold, TrianglesMesh& mesh) const;
 
-    void _buildTriangles(const Vector4fs& metaballs, const float threshold,
-                         Materials& materials, const size_t defaultMaterialId,
-                         TrianglesMeshMap& triangles);
+    Vector3ui _getBlockCoordinates(const size_t block) const;
+    Vector3f _getVertexPosition(const Vector3ui& vertex) const;
 
-    SurfaceVertices _edgeVertices;
-    Vertices _vertices;
-    Cubes _cubes;
+    Vector3f _origin;
+    Vector3f _cellSize;
+    size_t _gridSize{0};
+    size_t _nbBlocks{0};
+    std::vector<size_t> _surfaceBlocks;
 };
 }
 #endif // METABALLSGENERATOR_H
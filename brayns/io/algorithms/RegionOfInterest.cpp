@@ -0,0 +1,127 @@
+/* Copyright (c) 2015-2017, EPFL/Blue Brain Project
+ * All rights reserved. Do not distribute without permission.
+ * Responsible Author: Cyrille Favreau <cyrille.favreau@epfl.ch>
+ *
+ * This file is part of Brayns <https://github.com/BlueBrain/Brayns>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "RegionOfInterest.h"
+
+#include <algorithm>
+
+namespace
+{
+float getDistance(const brayns::Vector4f& plane, const brayns::Vector3f& point)
+{
+    return plane.x() * point.x() + plane.y() * point.y() +
+           plane.z() * point.z() + plane.w();
+}
+}
+
+namespace brayns
+{
+void RegionOfInterest::addBox(const Boxf& box)
+{
+    const auto& min = box.getMin();
+    const auto& max = box.getMax();
+    _planes.push_back(Vector4f(1.f, 0.f, 0.f, -min.x()));
+    _planes.push_back(Vector4f(-1.f, 0.f, 0.f, max.x()));
+    _planes.push_back(Vector4f(0.f, 1.f, 0.f, -min.y()));
+    _planes.push_back(Vector4f(0.f, -1.f, 0.f, max.y()));
+    _planes.push_back(Vector4f(0.f, 0.f, 1.f, -min.z()));
+    _planes.push_back(Vector4f(0.f, 0.f, -1.f, max.z()));
+}
+
+void RegionOfInterest::addPlanes(const ClipPlanes& planes)
+{
+    for (const auto& plane : planes)
+    {
+        // Normalized, so that margins are distances
+        const float length = Vector3f(plane.x(), plane.y(), plane.z()).length();
+        if (length > 0.f)
+            _planes.push_back(plane / length);
+    }
+}
+
+bool RegionOfInterest::contains(const Vector3f& point, const float margin) const
+{
+    for (const auto& plane : _planes)
+        if (getDistance(plane, point) < -margin)
+            return false;
+    return true;
+}
+
+bool RegionOfInterest::clipSegment(const Vector3f& origin,
+                                   const Vector3f& target, const float margin,
+                                   float& begin, float& end) const
+{
+    begin = 0.f;
+    end = 1.f;
+    for (const auto& plane : _planes)
+    {
+        // Liang-Barsky, one plane at a time
+        const float distanceToOrigin = getDistance(plane, origin) + margin;
+        const float distanceToTarget = getDistance(plane, target) + margin;
+        if (distanceToOrigin < 0.f && distanceToTarget < 0.f)
+            return false;
+
+        if (distanceToOrigin < 0.f)
+            begin = std::max(begin, distanceToOrigin /
+                                        (distanceToOrigin - distanceToTarget));
+        else if (distanceToTarget < 0.f)
+            end = std::min(end, distanceToOrigin /
+                                    (distanceToOrigin - distanceToTarget));
+        if (begin > end)
+            return false;
+    }
+    return true;
+}
+
+bool RegionOfInterest::clipCylinder(Cylinder& cylinder) const
+{
+    if (!isDefined())
+        return true;
+
+    float begin, end;
+    if (!clipSegment(cylinder.center, cylinder.up, cylinder.radius, begin,
+                     end))
+        return false;
+
+    const Vector3f axis = cylinder.up - cylinder.center;
+    cylinder.up = cylinder.center + axis * end;
+    cylinder.center = cylinder.center + axis * begin;
+    return true;
+}
+
+bool RegionOfInterest::clipCone(Cone& cone) const
+{
+    if (!isDefined())
+        return true;
+
+    float begin, end;
+    if (!clipSegment(cone.center, cone.up,
+                     std::max(cone.centerRadius, cone.upRadius), begin, end))
+        return false;
+
+    const Vector3f axis = cone.up - cone.center;
+    const float radiusDelta = cone.upRadius - cone.centerRadius;
+    cone.up = cone.center + axis * end;
+    cone.center = cone.center + axis * begin;
+    cone.upRadius = cone.centerRadius + radiusDelta * end;
+    cone.centerRadius = cone.centerRadius + radiusDelta * begin;
+    return true;
+}
+}
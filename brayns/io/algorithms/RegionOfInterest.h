@@ -0,0 +1,86 @@
+/* Copyright (c) 2015-2017, EPFL/Blue Brain Project
+ * All rights reserved. Do not distribute without permission.
+ * Responsible Author: Cyrille Favreau <cyrille.favreau@epfl.ch>
+ *
+ * This file is part of Brayns <https://github.com/BlueBrain/Brayns>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#pragma once
+
+#include <brayns/common/geometry/Cone.h>
+#include <brayns/common/geometry/Cylinder.h>
+#include <brayns/common/types.h>
+
+namespace brayns
+{
+/**
+ * Convex region of the scene to which loaded geometry is clipped, defined by
+ * planes. A point is inside the region if nx*x+ny*y+nz*z+d is positive or null
+ * for every plane (nx, ny, nz, d). An axis-aligned box is made of 6 planes, a
+ * camera frustum of 5 or 6.
+ */
+class RegionOfInterest
+{
+public:
+    /** Creates a region that contains the whole space */
+    RegionOfInterest() = default;
+
+    /** Restricts the region to the given box */
+    void addBox(const Boxf& box);
+
+    /** Restricts the region to the positive side of the given planes */
+    void addPlanes(const ClipPlanes& planes);
+
+    /** @return true if the region does not contain the whole space */
+    bool isDefined() const { return !_planes.empty(); }
+
+    /**
+     * @return true if the point is inside the region, every plane of which is
+     *         moved outwards by margin
+     */
+    bool contains(const Vector3f& point, const float margin = 0.f) const;
+
+    /**
+     * Clips the segment from origin to target to the region, every plane of
+     * which is moved outwards by margin.
+     * @param begin Set to the parametric coordinate, in the 0..1 range, of the
+     *        beginning of the clipped segment
+     * @param end Set to the parametric coordinate of the end of the clipped
+     *        segment
+     * @return false if the segment is entirely outside of the region
+     */
+    bool clipSegment(const Vector3f& origin, const Vector3f& target,
+                     const float margin, float& begin, float& end) const;
+
+    /**
+     * Clips a cylinder to the region, every plane of which is moved outwards
+     * by the radius of the cylinder
+     * @return false if the cylinder is entirely outside of the region
+     */
+    bool clipCylinder(Cylinder& cylinder) const;
+
+    /**
+     * Clips a cone to the region, every plane of which is moved outwards by
+     * the largest radius of the cone. Radii of the clipped cone are
+     * interpolated along its axis.
+     * @return false if the cone is entirely outside of the region
+     */
+    bool clipCone(Cone& cone) const;
+
+private:
+    ClipPlanes _planes;
+};
+}
@@ -22,67 +22,257 @@
 
 #include <brayns/common/geometry/Sphere.h>
 #include <brayns/common/scene/Scene.h>
+#include <brayns/common/utils/Hash.h>
 #include <brayns/common/utils/Utils.h>
 #include <brayns/parameters/GeometryParameters.h>
 
+#include <boost/filesystem.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
 #include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 namespace
 {
 const float CALCIUM_RADIUS = 0.00194f;
+const std::string TEXT_EXTENSION = ".dat";
+const std::string BINARY_EXTENSION = ".ca";
+// "CAPOS001" in little endian
+const uint64_t BINARY_MAGIC = 0x313030534f504143ull;
+const size_t BINARY_HEADER_SIZE = 2 * sizeof(uint64_t);
 }
 
 namespace brayns
 {
 CADiffusionSimulationHandler::CADiffusionSimulationHandler(
-    const std::string& simulationFolder)
-    : _currentFrame(std::numeric_limits<size_t>::max())
-    , _spheresCreated(false)
+    const std::string& simulationFolder, const std::string& cacheFolder)
+    : _cacheFolder(cacheFolder)
+    , _currentFrame(std::numeric_limits<size_t>::max())
 {
     BRAYNS_DEBUG << "Loading Calcium simulation from " << simulationFolder
                  << std::endl;
-    const strings filters = {".dat"};
-    strings files = parseFolder(simulationFolder, filters);
-    for (size_t i = 0; i < files.size(); ++i)
+    const strings filters = {TEXT_EXTENSION, BINARY_EXTENSION};
+    const strings files = parseFolder(simulationFolder, filters);
+
+    // One frame per file name, binary files being preferred to text ones
+    std::map<std::string, std::string> frameFiles;
+    for (const auto& file : files)
+    {
+        const boost::filesystem::path path(file);
+        auto& frameFile = frameFiles[path.stem().string()];
+        if (frameFile.empty() || path.extension() == BINARY_EXTENSION)
+            frameFile = file;
+    }
+
+    size_t i = 0;
+    for (const auto& frameFile : frameFiles)
     {
-        BRAYNS_DEBUG << "CA diffusion: " << files[i] << std::endl;
-        _simulationFiles[i] = files[i];
+        BRAYNS_DEBUG << "CA diffusion: " << frameFile.second << std::endl;
+        _simulationFiles[i++] = frameFile.second;
     }
 }
 
-bool CADiffusionSimulationHandler::_loadCalciumPositions(const size_t frame)
+bool CADiffusionSimulationHandler::convertFrame(const std::string& textFile,
+                                                const std::string& binaryFile)
 {
-    if (_simulationFiles.find(frame) == _simulationFiles.end())
+    Spheres spheres;
+    return _loadTextPositions(textFile, spheres) &&
+           _saveBinaryPositions(spheres, binaryFile);
+}
+
+bool CADiffusionSimulationHandler::_saveBinaryPositions(
+    const Spheres& spheres, const std::string& binaryFile)
+{
+    // Frames may be converted concurrently by several processes, so write to
+    // a unique file that is then renamed
+    boost::system::error_code error;
+    const boost::filesystem::path parent =
+        boost::filesystem::path(binaryFile).parent_path();
+    if (!parent.empty())
+        boost::filesystem::create_directories(parent, error);
+    const auto tmpFilename =
+        boost::filesystem::unique_path(binaryFile + ".%%%%-%%%%-%%%%")
+            .string();
+
+    std::ofstream file(tmpFilename, std::ios::binary);
+    if (!file.good())
+        return false;
+
+    const uint64_t nbPositions = spheres.size();
+    file.write((const char*)&BINARY_MAGIC, sizeof(BINARY_MAGIC));
+    file.write((const char*)&nbPositions, sizeof(nbPositions));
+    for (const auto& sphere : spheres)
     {
-        BRAYNS_ERROR << "No simulation file for frame " << frame << std::endl;
+        const float values[3] = {sphere.center.x(), sphere.center.y(),
+                                 sphere.center.z()};
+        file.write((const char*)values, sizeof(values));
+    }
+    file.close();
+    if (file.fail())
+    {
+        boost::filesystem::remove(tmpFilename, error);
         return false;
     }
 
-    BRAYNS_DEBUG << "Loading Calcium positions for frame " << frame
-                 << ", filename: " << _simulationFiles[frame] << std::endl;
+    boost::filesystem::rename(tmpFilename, binaryFile, error);
+    if (error)
+    {
+        boost::filesystem::remove(tmpFilename, error);
+        return false;
+    }
+    return true;
+}
+
+std::string CADiffusionSimulationHandler::_getCacheFilename(
+    const std::string& textFile) const
+{
+    if (_cacheFolder.empty())
+        return std::string();
+
+    Hash hash;
+    hash.add(BINARY_MAGIC);
+    hash.add(boost::filesystem::absolute(textFile).string());
 
-    // Load Calcium positions
-    std::ifstream filePositions(_simulationFiles[frame], std::ios::in);
+    // Modified text files must not hit stale entries
+    boost::system::error_code error;
+    const uint64_t fileSize = boost::filesystem::file_size(textFile, error);
+    if (!error)
+        hash.add(fileSize);
+    const int64_t lastWriteTime =
+        boost::filesystem::last_write_time(textFile, error);
+    if (!error)
+        hash.add(lastWriteTime);
+
+    std::stringstream filename;
+    filename << _cacheFolder << "/" << std::hex << std::setw(16)
+             << std::setfill('0') << hash.get() << BINARY_EXTENSION;
+    return filename.str();
+}
+
+bool CADiffusionSimulationHandler::_loadTextPositions(
+    const std::string& filename, Spheres& spheres)
+{
+    std::ifstream filePositions(filename, std::ios::in);
     if (!filePositions.good())
     {
-        BRAYNS_ERROR << "Could not open file " << _simulationFiles[frame]
-                     << std::endl;
+        BRAYNS_ERROR << "Could not open file " << filename << std::endl;
+        return false;
+    }
+
+    spheres.clear();
+    size_t id;
+    Sphere sphere(Vector3f(), CALCIUM_RADIUS);
+    while (filePositions >> id >> sphere.center.x() >> sphere.center.y() >>
+           sphere.center.z())
+        spheres.push_back(sphere);
+    return true;
+}
+
+bool CADiffusionSimulationHandler::_loadBinaryPositions(
+    const std::string& filename, Spheres& spheres, uint64_t& begin,
+    uint64_t& end)
+{
+    const int descriptor = ::open(filename.c_str(), O_RDONLY);
+    if (descriptor == -1)
+    {
+        BRAYNS_ERROR << "Could not open file " << filename << std::endl;
+        return false;
+    }
+
+    struct stat sb;
+    if (::fstat(descriptor, &sb) == -1 ||
+        uint64_t(sb.st_size) < BINARY_HEADER_SIZE)
+    {
+        BRAYNS_ERROR << "Invalid file " << filename << std::endl;
+        ::close(descriptor);
+        return false;
+    }
+
+    void* data = ::mmap(0, sb.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+    ::close(descriptor);
+    if (data == MAP_FAILED)
+    {
+        BRAYNS_ERROR << "Failed to map file " << filename << std::endl;
+        return false;
+    }
+
+    uint64_t header[2];
+    memcpy(header, data, sizeof(header));
+    const uint64_t nbPositions = header[1];
+    const uint64_t maxPositions =
+        (uint64_t(sb.st_size) - BINARY_HEADER_SIZE) / (3 * sizeof(float));
+    const bool valid = header[0] == BINARY_MAGIC && nbPositions <= maxPositions;
+    if (valid)
+    {
+        const float* values =
+            (const float*)((const char*)data + BINARY_HEADER_SIZE);
+        spheres.resize(nbPositions, Sphere(Vector3f(), CALCIUM_RADIUS));
+        begin = nbPositions;
+        end = 0;
+        for (uint64_t i = 0; i < nbPositions; ++i)
+        {
+            const Vector3f position(values[i * 3], values[i * 3 + 1],
+                                    values[i * 3 + 2]);
+            if (spheres[i].center == position)
+                continue;
+            spheres[i].center = position;
+            begin = std::min(begin, i);
+            end = i + 1;
+        }
+    }
+    else
+        BRAYNS_ERROR << "Invalid file " << filename << std::endl;
+
+    ::munmap(data, sb.st_size);
+    return valid;
+}
+
+bool CADiffusionSimulationHandler::_loadCalciumPositions(const size_t frame,
+                                                         Spheres& spheres,
+                                                         uint64_t& begin,
+                                                         uint64_t& end)
+{
+    if (_simulationFiles.find(frame) == _simulationFiles.end())
+    {
+        BRAYNS_ERROR << "No simulation file for frame " << frame << std::endl;
         return false;
     }
 
-    _calciumPositions.clear();
-    std::string line;
-    while (filePositions.good() && std::getline(filePositions, line))
+    const std::string& filename = _simulationFiles[frame];
+    BRAYNS_DEBUG << "Loading Calcium positions for frame " << frame
+                 << ", filename: " << filename << std::endl;
+
+    if (boost::filesystem::path(filename).extension() == BINARY_EXTENSION)
+    {
+        if (!_loadBinaryPositions(filename, spheres, begin, end))
+            return false;
+    }
+    else
     {
-        std::stringstream lineStream(line);
-        size_t id;
-        Vector3f position;
-        lineStream >> id >> position.x() >> position.y() >> position.z();
+        // Text frames converted by a previous load are read from the cache
+        const auto cacheFile = _getCacheFilename(filename);
+        boost::system::error_code error;
+        if (cacheFile.empty() || !boost::filesystem::exists(cacheFile, error) ||
+            !_loadBinaryPositions(cacheFile, spheres, begin, end))
+        {
+            if (!_loadTextPositions(filename, spheres))
+                return false;
+            begin = 0;
+            end = spheres.size();
 
-        _calciumPositions.push_back(position);
+            if (!cacheFile.empty() && !_saveBinaryPositions(spheres, cacheFile))
+                BRAYNS_WARN << "Could not create calcium cache file "
+                            << cacheFile << std::endl;
+        }
     }
-    filePositions.close();
-    BRAYNS_DEBUG << _calciumPositions.size() << " Calcium positions loaded"
+
+    BRAYNS_DEBUG << spheres.size() << " Calcium positions loaded"
                  << std::endl;
     return true;
 }
@@ -95,26 +285,27 @@ void CADiffusionSimulationHandler::setFrame(Scene& scene, const size_t frame)
 
     _currentFrame = frame;
 
-    // Load Calcium positions
-    _loadCalciumPositions(frame);
+    // Positions are loaded straight into the spheres of the calcium material,
+    // which are created by the first frame and overwritten in place by the
+    // next ones
     const size_t materialId =
         static_cast<size_t>(MaterialType::calcium_simulation);
-    if (!_spheresCreated)
-    {
-        BRAYNS_INFO << "Creating " << _calciumPositions.size() << " CA spheres"
-                    << std::endl;
-        for (const auto position : _calciumPositions)
-            scene.addSphere(materialId, {position, CALCIUM_RADIUS});
-        _spheresCreated = true;
-    }
+    auto& spheres = scene.getMaterialSpheres(materialId);
+    const auto nbSpheres = spheres.size();
+    uint64_t begin = 0;
+    uint64_t end = 0;
+    if (!_loadCalciumPositions(frame, spheres, begin, end))
+        return;
+
+    auto& bounds = scene.getWorldBounds();
+    for (uint64_t i = begin; i < end; ++i)
+        bounds.merge(spheres[i].center);
+
+    // When the number of atoms does not change, only the range of spheres that
+    // moved is sent to the rendering engine
+    if (spheres.size() != nbSpheres)
+        scene.commitSpheres(materialId);
     else
-    {
-        uint64_t i = 0;
-        for (const auto position : _calciumPositions)
-        {
-            scene.setSphere(i, materialId, Sphere(position, CALCIUM_RADIUS));
-            ++i;
-        }
-    }
+        scene.setSpheresDirty(materialId, begin, end);
 }
 }
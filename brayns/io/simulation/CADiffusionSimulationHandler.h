@@ -28,10 +28,17 @@ namespace brayns
 {
 /**
  * @brief The CADiffusionSimulationHandler class handles simulation frames for
- *        Calcium diffusion. Frames are stored in ASCII files containing
- *        coordinates for CA atoms. Each frame is in a different file. The
- *        format of the frame is X Y Z values stored as text. For example:
- *        215.388692 996.594668 338.199478
+ *        Calcium diffusion. Frames are stored in files containing coordinates
+ *        for CA atoms. Each frame is in a different file. The format of the
+ *        frame is either text, in files with a .dat extension, with an id and
+ *        X Y Z values per line. For example:
+ *        0 215.388692 996.594668 338.199478
+ *        or binary, in files with a .ca extension, made of a header of two
+ *        uint64_t (a magic number and the number of atoms), followed by the X
+ *        Y Z float values of every atom. Binary files are memory mapped, and
+ *        preferred to text files with the same name. When a cache folder is
+ *        given, text files are converted to binary files in that folder the
+ *        first time they are loaded, the simulation folder is never written.
  */
 class CADiffusionSimulationHandler
 {
@@ -39,15 +46,23 @@ public:
     /**
      * @brief Default contructor
      * @param simulationFolder Folder containing files with the CA atom
-     *        positions. Files must have a .dat extension.
+     *        positions. Files must have a .dat or .ca extension.
+     * @param cacheFolder Folder where text files are converted to binary
+     *        files, see the --calcium-cache-folder command line parameter.
+     *        No conversion takes place if empty.
      */
-    CADiffusionSimulationHandler(const std::string& simulationFolder);
+    CADiffusionSimulationHandler(const std::string& simulationFolder,
+                                 const std::string& cacheFolder = "");
 
     /**
      * @brief setFrame Sets the frame to load
      * @param scene Scene to be populated with spheres. When setFrame is called
      *              for the first time, spheres are created. Otherwise, sphere
-     *              positions are updated with the new values
+     *              positions are updated in place with the new values. The
+     *              world bounds are extended to the new positions. Only the
+     *              spheres of the calcium material are committed, or set as
+     *              dirty for the range of them that moved when the number of
+     *              atoms does not change, see Scene::setSpheresDirty()
      * @param frame Frame to load
      */
     void setFrame(Scene& scene, const size_t frame);
@@ -56,13 +71,32 @@ public:
      * @return Returns the number of frames for the current simulation
      */
     uint64_t getNbFrames() const { return _simulationFiles.size(); }
+    /**
+     * @brief Converts a text frame file to the binary format. The binary file
+     *        is written to a temporary file that is then renamed, so that it
+     *        is never seen partially written.
+     * @param textFile File with a .dat extension
+     * @param binaryFile File to be created
+     * @return True if the frame was successfully converted, false otherwise
+     */
+    static bool convertFrame(const std::string& textFile,
+                             const std::string& binaryFile);
+
 private:
-    bool _loadCalciumPositions(const size_t frame);
+    bool _loadCalciumPositions(const size_t frame, Spheres& spheres,
+                               uint64_t& begin, uint64_t& end);
+    std::string _getCacheFilename(const std::string& textFile) const;
+    static bool _loadTextPositions(const std::string& filename,
+                                   Spheres& spheres);
+    static bool _loadBinaryPositions(const std::string& filename,
+                                     Spheres& spheres, uint64_t& begin,
+                                     uint64_t& end);
+    static bool _saveBinaryPositions(const Spheres& spheres,
+                                     const std::string& binaryFile);
 
     std::map<size_t, std::string> _simulationFiles;
-    Vector3fs _calciumPositions;
+    std::string _cacheFolder;
     size_t _currentFrame;
-    bool _spheresCreated;
 };
 }
 #endif // CADIFFUSIONSIMULATIONHANDLER_H
@@ -26,6 +26,20 @@
 
 #include <servus/types.h>
 
+#include <algorithm>
+#include <limits>
+
+namespace
+{
+double getElapsedTime(
+    const std::chrono::high_resolution_clock::time_point& startTime)
+{
+    return std::chrono::duration<double>(
+               std::chrono::high_resolution_clock::now() - startTime)
+        .count();
+}
+}
+
 namespace brayns
 {
 CircuitSimulationHandler::CircuitSimulationHandler(
@@ -36,6 +50,7 @@ CircuitSimulationHandler::CircuitSimulationHandler(
     , _applicationParameters(applicationParameters)
     , _compartmentReport(
           new brion::CompartmentReport(reportSource, brion::MODE_READ, gids))
+    , _requestedFrame(std::numeric_limits<uint32_t>::max())
 {
     // Load simulation information from compartment reports
     const auto reportStartTime = _compartmentReport->getStartTime();
@@ -64,10 +79,20 @@ CircuitSimulationHandler::CircuitSimulationHandler(
     BRAYNS_INFO << "Number of frames : " << _nbFrames << std::endl;
     BRAYNS_INFO << "-----------------------------------------------------------"
                 << std::endl;
+
+    _loadingFrames.reserve(
+        _geometryParameters.getCircuitSimulationPrefetchFrames() + 1);
 }
 
 CircuitSimulationHandler::~CircuitSimulationHandler()
 {
+    if (_frameHits + _frameMisses == 0)
+        return;
+
+    BRAYNS_INFO << "Simulation frames: " << _frameHits << " hits, "
+                << _frameMisses << " misses, average latency "
+                << getAverageFrameLatency() * 1000.0 << " ms, average wait "
+                << getAverageFrameWaitTime() * 1000.0 << " ms" << std::endl;
 }
 
 bool CircuitSimulationHandler::isReady() const
@@ -75,53 +100,148 @@ bool CircuitSimulationHandler::isReady() const
     return _ready;
 }
 
+double CircuitSimulationHandler::getAverageFrameLatency() const
+{
+    return _nbLoadedFrames == 0 ? 0.0 : _frameLatency / _nbLoadedFrames;
+}
+
+double CircuitSimulationHandler::getAverageFrameWaitTime() const
+{
+    return _nbLoadedFrames == 0 ? 0.0 : _frameWaitTime / _nbLoadedFrames;
+}
+
 void* CircuitSimulationHandler::getFrameData(uint32_t frame)
 {
     frame = _getBoundedFrame(frame);
 
-    if (!_currentFrameFuture.valid() && _currentFrame != frame)
-        _triggerLoading(frame);
-
-    _makeFrameReady(frame);
+    if (frame == _currentFrame && _frameValues)
+    {
+        // Going back to the current frame while another one is loading
+        // cancels that request, the loading frame stays in the ring
+        _requestedFrame = frame;
+        _ready = true;
+    }
+    else
+    {
+        if (frame != _requestedFrame)
+            _requestFrame(frame);
+        _makeFrameReady(frame);
+    }
 
     return _frameValues ? _frameValues.get()->data() : nullptr;
 }
 
-void CircuitSimulationHandler::_triggerLoading(const uint32_t frame)
+std::shared_ptr<const float> CircuitSimulationHandler::_shareFrameData(
+    const float* data)
 {
-    auto timestamp = _startTime + frame * _dt;
-    timestamp = std::max(_startTime, timestamp);
-    timestamp = std::min(_endTime, timestamp);
+    return std::shared_ptr<const float>(_frameValues, data);
+}
 
-    if (_currentFrameFuture.valid())
-        _currentFrameFuture.wait();
+void CircuitSimulationHandler::_requestFrame(const uint32_t frame)
+{
+    // Playback direction is the shortest way from the previous frame
+    if (_requestedFrame != std::numeric_limits<uint32_t>::max() &&
+        _nbFrames != 0)
+    {
+        const uint32_t forward =
+            (frame + _nbFrames - _requestedFrame) % _nbFrames;
+        _direction = forward <= _nbFrames - forward ? 1 : -1;
+    }
 
+    _requestedFrame = frame;
+    _requestTime = std::chrono::high_resolution_clock::now();
     _ready = false;
-    _currentFrameFuture = _compartmentReport->loadFrame(timestamp);
+
+    const auto loadingFrame = _findLoadingFrame(frame);
+    if (loadingFrame &&
+        loadingFrame->values.wait_for(std::chrono::milliseconds(0)) ==
+            std::future_status::ready)
+        ++_frameHits;
+    else
+        ++_frameMisses;
+
+    _prefetchFrames(frame);
+}
+
+void CircuitSimulationHandler::_prefetchFrames(const uint32_t frame)
+{
+    // Requested frame followed by the prefetched ones in playback direction
+    const uint32_t nbFrames = std::max<uint32_t>(1, _nbFrames);
+    const uint32_t windowSize = std::min<uint64_t>(
+        _geometryParameters.getCircuitSimulationPrefetchFrames() + 1,
+        nbFrames);
+    uint32_ts window;
+    for (uint32_t i = 0; i < windowSize; ++i)
+        window.push_back(_direction > 0 ? _getBoundedFrame(frame + i)
+                                        : _getBoundedFrame(frame + nbFrames -
+                                                           i));
+
+    // Frames out of the window are not needed anymore
+    _loadingFrames.erase(
+        std::remove_if(_loadingFrames.begin(), _loadingFrames.end(),
+                       [&window](const LoadingFrame& loadingFrame) {
+                           return std::find(window.begin(), window.end(),
+                                            loadingFrame.frame) == window.end();
+                       }),
+        _loadingFrames.end());
+
+    for (const auto windowFrame : window)
+    {
+        if ((_frameValues && windowFrame == _currentFrame) ||
+            _findLoadingFrame(windowFrame))
+            continue;
+
+        auto timestamp = _startTime + windowFrame * _dt;
+        timestamp = std::max(_startTime, timestamp);
+        timestamp = std::min(_endTime, timestamp);
+
+        LoadingFrame loadingFrame;
+        loadingFrame.frame = windowFrame;
+        loadingFrame.values = _compartmentReport->loadFrame(timestamp);
+        loadingFrame.startTime = std::chrono::high_resolution_clock::now();
+        _loadingFrames.push_back(std::move(loadingFrame));
+    }
 }
 
-bool CircuitSimulationHandler::_isFrameLoaded() const
+CircuitSimulationHandler::LoadingFrame*
+    CircuitSimulationHandler::_findLoadingFrame(const uint32_t frame)
 {
-    if (!_currentFrameFuture.valid())
-        return false;
+    for (auto& loadingFrame : _loadingFrames)
+        if (loadingFrame.frame == frame)
+            return &loadingFrame;
+    return nullptr;
+}
 
+bool CircuitSimulationHandler::_isFrameLoaded(
+    const LoadingFrame& loadingFrame) const
+{
     if (_applicationParameters.getSynchronousMode())
     {
-        _currentFrameFuture.wait();
+        loadingFrame.values.wait();
         return true;
     }
 
-    return _currentFrameFuture.wait_for(std::chrono::milliseconds(0)) ==
+    return loadingFrame.values.wait_for(std::chrono::milliseconds(0)) ==
            std::future_status::ready;
 }
 
 void CircuitSimulationHandler::_makeFrameReady(const uint32_t frame)
 {
-    if (_isFrameLoaded())
-    {
-        _frameValues = _currentFrameFuture.get();
-        _currentFrame = frame;
-        _ready = true;
-    }
+    auto loadingFrame = _findLoadingFrame(frame);
+    if (!loadingFrame || !_isFrameLoaded(*loadingFrame))
+        return;
+
+    _frameValues = loadingFrame->values.get();
+    _frameLatency += getElapsedTime(loadingFrame->startTime);
+    _frameWaitTime += getElapsedTime(_requestTime);
+    ++_nbLoadedFrames;
+    _loadingFrames.erase(_loadingFrames.begin() +
+                         (loadingFrame - _loadingFrames.data()));
+
+    _currentFrame = frame;
+    _ready = true;
+
+    // Keeps the ring full now that the current frame left it
+    _prefetchFrames(frame);
 }
 }
@@ -27,6 +27,9 @@
 #include <brayns/common/types.h>
 #include <brion/brion.h>
 
+#include <chrono>
+#include <future>
+
 namespace brayns
 {
 typedef std::shared_ptr<brion::CompartmentReport> CompartmentReportPtr;
@@ -36,6 +39,10 @@ typedef std::shared_ptr<brion::CompartmentReport> CompartmentReportPtr;
  * current circuit. Frames are stored in a memory mapped file that is accessed
  * according to a specified timestamp. The CircuitSimulationHandler class is in
  * charge of keeping the handle to the memory mapped file.
+ *
+ * Frames read from a compartment report are loaded ahead of the current one,
+ * in the playback direction, according to the
+ * --circuit-simulation-prefetch-frames command line parameter.
  */
 class CircuitSimulationHandler : public AbstractSimulationHandler
 {
@@ -57,9 +64,38 @@ public:
     CompartmentReportPtr getCompartmentReport() { return _compartmentReport; }
     bool isReady() const final;
 
+    /** @return the number of frames that were already loaded when requested */
+    uint64_t getFrameHits() const { return _frameHits; }
+    /** @return the number of frames that playback had to wait for */
+    uint64_t getFrameMisses() const { return _frameMisses; }
+    /**
+     * @return the average time in seconds between loading a frame from the
+     * report and receiving its values
+     */
+    double getAverageFrameLatency() const;
+    /**
+     * @return the average time in seconds between requesting a frame and
+     * receiving its values, 0 if all frames were prefetched in time
+     */
+    double getAverageFrameWaitTime() const;
+
+protected:
+    /** Loaded frames never change, they are shared with the histogram */
+    std::shared_ptr<const float> _shareFrameData(const float* data) final;
+
 private:
-    void _triggerLoading(uint32_t frame);
-    bool _isFrameLoaded() const;
+    /** Frame being loaded from the compartment report */
+    struct LoadingFrame
+    {
+        uint32_t frame;
+        std::future<brion::floatsPtr> values;
+        std::chrono::high_resolution_clock::time_point startTime;
+    };
+
+    void _requestFrame(uint32_t frame);
+    void _prefetchFrames(uint32_t frame);
+    LoadingFrame* _findLoadingFrame(uint32_t frame);
+    bool _isFrameLoaded(const LoadingFrame& loadingFrame) const;
     void _makeFrameReady(const uint32_t frame);
 
     const ApplicationParameters& _applicationParameters;
@@ -69,8 +105,20 @@ private:
     double _endTime;
     double _dt;
     brion::floatsPtr _frameValues;
-    std::future<brion::floatsPtr> _currentFrameFuture;
     bool _ready{false};
+
+    // Ring of the frames loaded ahead of the current one, invalidated when
+    // playback jumps or changes direction
+    std::vector<LoadingFrame> _loadingFrames;
+    uint32_t _requestedFrame;
+    int32_t _direction{1};
+    std::chrono::high_resolution_clock::time_point _requestTime;
+
+    uint64_t _frameHits{0};
+    uint64_t _frameMisses{0};
+    uint64_t _nbLoadedFrames{0};
+    double _frameLatency{0.0};
+    double _frameWaitTime{0.0};
 };
 }
 
@@ -21,6 +21,36 @@
 #include "SpikeSimulationHandler.h"
 
 #include <brayns/common/log.h>
+#include <brayns/parameters/GeometryParameters.h>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <limits>
+
+namespace
+{
+// "SPIKESCA" in little endian, too large to be the number of frames of a dense
+// cache file
+const uint64_t SPARSE_CACHE_MAGIC = 0x414353454b495053ull;
+const uint64_t SPARSE_CACHE_VERSION = 1;
+const uint64_t NO_SPIKE = std::numeric_limits<uint64_t>::max();
+
+/**
+ * Header of sparse cache files, followed by the index of the end of every
+ * frame in the list of spikes, and by the spikes sorted by time
+ */
+struct SparseCacheHeader
+{
+    uint64_t magic;
+    uint64_t version;
+    uint64_t nbFrames;
+    uint64_t frameSize;
+    uint64_t nbSpikes;
+    float startTime;
+    float timestep;
+};
+}
 
 namespace brayns
 {
@@ -35,15 +65,128 @@ void* SpikeSimulationHandler::getFrameData(const uint32_t frame)
     if (_nbFrames == 0 || _memoryMapPtr == 0)
         return nullptr;
 
-    if (!_frameData)
-        _frameData = new float[_frameSize];
+    const auto boundedFrame = _getBoundedFrame(frame);
+    if (_sparse)
+    {
+        _currentFrame = boundedFrame;
+        _applySpikes(_frameEnds[_currentFrame]);
+        return _spikingTimes.data();
+    }
+
+    // Frames are used straight from the memory mapped cache file, and the
+    // next ones are read ahead by the kernel
+    if (boundedFrame != _currentFrame)
+    {
+        _currentFrame = boundedFrame;
+        _adviseCacheFrames(
+            _currentFrame + 1,
+            std::max<size_t>(
+                1, _geometryParameters.getCircuitSimulationPrefetchFrames()));
+    }
+    return _getCacheFrame(_currentFrame);
+}
+
+void SpikeSimulationHandler::writeSparseCache(std::ofstream& stream,
+                                              const float startTime,
+                                              const float timestep,
+                                              const SpikeEvents& spikes)
+{
+    SparseCacheHeader header;
+    header.magic = SPARSE_CACHE_MAGIC;
+    header.version = SPARSE_CACHE_VERSION;
+    header.nbFrames = _nbFrames;
+    header.frameSize = _frameSize;
+    header.nbSpikes = spikes.size();
+    header.startTime = startTime;
+    header.timestep = timestep;
+    stream.write((char*)&header, sizeof(header));
+
+    uint64_ts frameEnds(_nbFrames);
+    uint64_t end = 0;
+    for (uint64_t frame = 0; frame < _nbFrames; ++frame)
+    {
+        const float frameEnd = startTime + (frame + 1) * timestep;
+        while (end < spikes.size() && spikes[end].time < frameEnd)
+            ++end;
+        frameEnds[frame] = end;
+    }
+    stream.write((char*)frameEnds.data(), frameEnds.size() * sizeof(uint64_t));
+    stream.write((char*)spikes.data(), spikes.size() * sizeof(SpikeEvent));
+}
+
+bool SpikeSimulationHandler::_readCacheHeader()
+{
+    SparseCacheHeader header;
+    if (_memoryMapSize < sizeof(header))
+        return AbstractSimulationHandler::_readCacheHeader();
+
+    memcpy(&header, _memoryMapPtr, sizeof(header));
+    if (header.magic != SPARSE_CACHE_MAGIC)
+        return AbstractSimulationHandler::_readCacheHeader();
+
+    // Sizes are checked one after the other so that corrupted counts cannot
+    // overflow
+    uint64_t available = _memoryMapSize - sizeof(header);
+    if (header.version != SPARSE_CACHE_VERSION ||
+        header.nbFrames > available / sizeof(uint64_t))
+    {
+        return false;
+    }
+    available -= header.nbFrames * sizeof(uint64_t);
+    if (header.nbSpikes > available / sizeof(SpikeEvent))
+        return false;
+
+    _headerSize = sizeof(header);
+    _nbFrames = header.nbFrames;
+    _frameSize = header.frameSize;
+    _nbSpikes = header.nbSpikes;
+    _frameEnds = (const uint64_t*)((char*)_memoryMapPtr + _headerSize);
+    _spikes = (const SpikeEvent*)(_frameEnds + _nbFrames);
+
+    // Frames end where the previous ones end, or after
+    uint64_t previousEnd = 0;
+    for (uint64_t frame = 0; frame < _nbFrames; ++frame)
+    {
+        if (_frameEnds[frame] < previousEnd || _frameEnds[frame] > _nbSpikes)
+            return false;
+        previousEnd = _frameEnds[frame];
+    }
+
+    // Index of the previous spike of the same neuron, used to restore the
+    // spiking times when playing backward
+    uint64_ts lastSpikes(_frameSize, NO_SPIKE);
+    _previousSpikes.resize(_nbSpikes);
+    for (uint64_t i = 0; i < _nbSpikes; ++i)
+    {
+        const uint32_t gid = _spikes[i].gid;
+        if (gid >= _frameSize)
+            return false;
+        _previousSpikes[i] = lastSpikes[gid];
+        lastSpikes[gid] = i;
+    }
+
+    _spikingTimes.assign(_frameSize, -1.f);
+    _nbAppliedSpikes = 0;
+    _sparse = true;
+
+    BRAYNS_INFO << "Sparse spike cache: " << _nbSpikes << " spikes from "
+                << header.startTime << " with a timestep of "
+                << header.timestep << std::endl;
+    return true;
+}
+
+void SpikeSimulationHandler::_applySpikes(const uint64_t end)
+{
+    for (uint64_t i = _nbAppliedSpikes; i < end; ++i)
+        _spikingTimes[_spikes[i].gid] = _spikes[i].time;
+
+    for (uint64_t i = _nbAppliedSpikes; i > end; --i)
+    {
+        const uint64_t previous = _previousSpikes[i - 1];
+        _spikingTimes[_spikes[i - 1].gid] =
+            previous == NO_SPIKE ? -1.f : _spikes[previous].time;
+    }
 
-    _currentFrame = _getBoundedFrame(frame);
-    const auto index = _currentFrame % _nbFrames;
-    const uint64_t frameSize = _frameSize * sizeof(float);
-    memcpy(_frameData,
-           (unsigned char*)_memoryMapPtr + _headerSize + index * frameSize,
-           frameSize);
-    return _frameData;
+    _nbAppliedSpikes = end;
 }
 }
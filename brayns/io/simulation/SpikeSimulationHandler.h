@@ -28,6 +28,14 @@
 
 namespace brayns
 {
+/** A spike of a neuron, identified by its index in the circuit */
+struct SpikeEvent
+{
+    float time;
+    uint32_t gid;
+};
+typedef std::vector<SpikeEvent> SpikeEvents;
+
 /**
  * @brief The SpikeSimulationHandler class handles simulation frames for the
  * current circuit.
@@ -36,6 +44,14 @@ namespace brayns
  *        timestamp. The SpikeSimulationHandler class is in charge of keeping
  * the handle to the
  *        memory mapped file.
+ *
+ * Cache files written by writeSparseCache() only store the spikes, sorted by
+ * time, and for every frame the end index of its spikes, that is the number of
+ * spikes that occurred up to the end of the frame. The frame returned by
+ * getFrameData() holds the last spiking time of every neuron, or -1 if the
+ * neuron has not spiked yet, and is updated incrementally with the spikes
+ * between the previous and the requested frame, in both directions. Cache
+ * files holding dense frames are still supported.
  */
 class SpikeSimulationHandler : public AbstractSimulationHandler
 {
@@ -51,6 +67,33 @@ public:
      * @return Pointer to given frame
      */
     void* getFrameData(uint32_t frame) final;
+
+    /** Dense frames are read in place from the memory mapped cache file */
+    bool hasPersistentFrameData() const final { return !_sparse; }
+
+    /**
+     * @brief Writes a sparse cache file. Frame f holds the spikes that
+     * occurred before startTime + (f + 1) * timestep. The number of frames and
+     * the frame size must be set beforehand.
+     * @param stream Stream where the cache should be written
+     * @param startTime Time of the first frame
+     * @param timestep Duration of a frame
+     * @param spikes Spikes sorted by time, with gids lower than the frame size
+     */
+    BRAYNS_API void writeSparseCache(std::ofstream& stream, float startTime,
+                                     float timestep, const SpikeEvents& spikes);
+
+private:
+    bool _readCacheHeader() final;
+    void _applySpikes(uint64_t end);
+
+    bool _sparse{false};
+    const uint64_t* _frameEnds{nullptr};
+    const SpikeEvent* _spikes{nullptr};
+    uint64_t _nbSpikes{0};
+    uint64_t _nbAppliedSpikes{0};
+    uint64_ts _previousSpikes;
+    floats _spikingTimes;
 };
 }
 
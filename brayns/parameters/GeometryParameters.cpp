@@ -41,6 +41,18 @@ const std::string PARAM_CIRCUIT_DENSITY = "circuit-density";
 const std::string PARAM_CIRCUIT_USES_SIMULATION_MODEL =
     "circuit-uses-simulation-model";
 const std::string PARAM_CIRCUIT_BOUNDING_BOX = "circuit-bounding-box";
+const std::string PARAM_CIRCUIT_REGION_OF_INTEREST =
+    "circuit-region-of-interest";
+const std::string PARAM_CIRCUIT_REGION_OF_INTEREST_PLANES =
+    "circuit-region-of-interest-planes";
+const std::string PARAM_CIRCUIT_REGION_OF_INTEREST_MARGIN =
+    "circuit-region-of-interest-margin";
+const std::string PARAM_CIRCUIT_USE_INSTANCES = "circuit-use-instances";
+const std::string PARAM_CIRCUIT_BATCH_SIZE = "circuit-batch-size";
+const std::string PARAM_CIRCUIT_LEVELS_OF_DETAIL = "circuit-levels-of-detail";
+const std::string PARAM_CIRCUIT_PREFETCH_THREADS = "circuit-prefetch-threads";
+const std::string PARAM_CIRCUIT_PREFETCH_QUEUE_DEPTH =
+    "circuit-prefetch-queue-depth";
 const std::string PARAM_CIRCUIT_MESH_FOLDER = "circuit-mesh-folder";
 const std::string PARAM_CIRCUIT_MESH_FILENAME_PATTERN =
     "circuit-mesh-filename-pattern";
@@ -57,8 +69,19 @@ const std::string PARAM_CIRCUIT_SIMULATION_RANGE =
     "circuit-simulation-values-range";
 const std::string PARAM_CIRCUIT_SIMULATION_HISTOGRAM_SIZE =
     "circuit-simulation-histogram-size";
+const std::string PARAM_CIRCUIT_SIMULATION_HISTOGRAM_WINDOW =
+    "circuit-simulation-histogram-window";
+const std::string PARAM_CIRCUIT_SIMULATION_PLAYBACK_RATE =
+    "circuit-simulation-playback-rate";
+const std::string PARAM_CIRCUIT_SIMULATION_PLAYBACK_TIME_RATE =
+    "circuit-simulation-playback-time-rate";
+const std::string PARAM_CIRCUIT_SIMULATION_PREFETCH_FRAMES =
+    "circuit-simulation-prefetch-frames";
 const std::string PARAM_LOAD_CACHE_FILE = "load-cache-file";
 const std::string PARAM_SAVE_CACHE_FILE = "save-cache-file";
+const std::string PARAM_COMPRESS_CACHE_FILE = "compress-cache-file";
+const std::string PARAM_SPATIAL_SORTING = "spatial-sorting";
+const std::string PARAM_COMPACT_GEOMETRY = "compact-geometry";
 const std::string PARAM_RADIUS_MULTIPLIER = "radius-multiplier";
 const std::string PARAM_RADIUS_CORRECTION = "radius-correction";
 const std::string PARAM_COLOR_SCHEME = "color-scheme";
@@ -67,6 +90,8 @@ const std::string PARAM_GEOMETRY_QUALITY = "geometry-quality";
 const std::string PARAM_NEST_CACHE_FILENAME = "nest-cache-file";
 const std::string PARAM_MORPHOLOGY_SECTION_TYPES = "morphology-section-types";
 const std::string PARAM_MORPHOLOGY_LAYOUT = "morphology-layout";
+const std::string PARAM_MORPHOLOGY_CACHE_FOLDER = "morphology-cache-folder";
+const std::string PARAM_CALCIUM_CACHE_FOLDER = "calcium-cache-folder";
 const std::string PARAM_SPLASH_SCENE_FOLDER = "splash-scene-folder";
 const std::string PARAM_MOLECULAR_SYSTEM_CONFIG = "molecular-system-config";
 const std::string PARAM_METABALLS_GRIDSIZE = "metaballs-grid-size";
@@ -153,6 +178,14 @@ GeometryParameters::GeometryParameters()
         "Load binary container of a scene [string]")(
         PARAM_SAVE_CACHE_FILE.c_str(), po::value<std::string>(),
         "Save binary container of a scene [string]")(
+        PARAM_COMPRESS_CACHE_FILE.c_str(), po::value<bool>(),
+        "Enable|Disable compression of the saved binary container [bool]")(
+        PARAM_SPATIAL_SORTING.c_str(), po::value<bool>(),
+        "Enable|Disable sorting of primitives along a Morton curve before "
+        "building the acceleration structures [bool]")(
+        PARAM_COMPACT_GEOMETRY.c_str(), po::value<bool>(),
+        "Enable|Disable quantized encoding of spheres, cylinders and cones "
+        "[bool]")(
         PARAM_RADIUS_MULTIPLIER.c_str(), po::value<float>(),
         "Radius multiplier for spheres, cones and cylinders [float]")(
         PARAM_RADIUS_CORRECTION.c_str(), po::value<float>(),
@@ -182,6 +215,11 @@ GeometryParameters::GeometryParameters()
                                "Morphology layout defined by number of "
                                "columns, vertical spacing, horizontal spacing "
                                "[int int int]")(
+        PARAM_MORPHOLOGY_CACHE_FOLDER.c_str(), po::value<std::string>(),
+        "Folder where tessellated morphologies are cached [string]")(
+        PARAM_CALCIUM_CACHE_FOLDER.c_str(), po::value<std::string>(),
+        "Folder where text calcium positions are cached in binary format "
+        "[string]")(
         PARAM_CIRCUIT_START_SIMULATION_TIME.c_str(), po::value<double>(),
         "Start simulation timestamp [double]")(
         PARAM_CIRCUIT_END_SIMULATION_TIME.c_str(), po::value<double>(),
@@ -193,6 +231,20 @@ GeometryParameters::GeometryParameters()
         "Minimum and maximum values for the simulation [float float]")(
         PARAM_CIRCUIT_SIMULATION_HISTOGRAM_SIZE.c_str(), po::value<size_t>(),
         "Number of values defining the simulation histogram [int]")(
+        PARAM_CIRCUIT_SIMULATION_HISTOGRAM_WINDOW.c_str(), po::value<size_t>(),
+        "Number of frames, up to the current one, covered by the simulation "
+        "histogram [int]")(
+        PARAM_CIRCUIT_SIMULATION_PLAYBACK_RATE.c_str(), po::value<float>(),
+        "Number of simulation frames played per second, frames being skipped "
+        "when loading or rendering falls behind. 0 plays one frame per "
+        "rendered frame [float]")(
+        PARAM_CIRCUIT_SIMULATION_PLAYBACK_TIME_RATE.c_str(),
+        po::value<float>(),
+        "Simulation time played per second, in the unit of the simulation "
+        "step. Overrides the playback rate [float]")(
+        PARAM_CIRCUIT_SIMULATION_PREFETCH_FRAMES.c_str(), po::value<size_t>(),
+        "Number of simulation frames loaded ahead of the current one, in the "
+        "playback direction [int]")(
         PARAM_NEST_CACHE_FILENAME.c_str(), po::value<std::string>(),
         "Cache file containing nest data [string]")(
         PARAM_SPLASH_SCENE_FOLDER.c_str(), po::value<std::string>(),
@@ -213,6 +265,36 @@ GeometryParameters::GeometryParameters()
         PARAM_CIRCUIT_BOUNDING_BOX.c_str(), po::value<floats>()->multitoken(),
         "Does not load circuit geometry outside of the specified bounding box"
         "[float float float float float float]")(
+        PARAM_CIRCUIT_REGION_OF_INTEREST.c_str(),
+        po::value<floats>()->multitoken(),
+        "Clips the geometry of a circuit to the specified box. Cells are "
+        "loaded if any part of their morphology enters the box "
+        "[float float float float float float]")(
+        PARAM_CIRCUIT_REGION_OF_INTEREST_PLANES.c_str(),
+        po::value<floats>()->multitoken(),
+        "Clips the geometry of a circuit to the convex region, a camera "
+        "frustum for instance, defined by planes. Points for which "
+        "nx*x+ny*y+nz*z+d is negative are outside of the region "
+        "[nx ny nz d ...]")(
+        PARAM_CIRCUIT_REGION_OF_INTEREST_MARGIN.c_str(), po::value<float>(),
+        "Does not load cells whose soma is further than the specified "
+        "distance from the region of interest. 0 loads every cell [float]")(
+        PARAM_CIRCUIT_USE_INSTANCES.c_str(), po::value<bool>(),
+        "Enable|Disable loading of every morphology of a circuit once, and "
+        "placing the neurons that use it as instances [bool]")(
+        PARAM_CIRCUIT_BATCH_SIZE.c_str(), po::value<size_t>(),
+        "Number of morphologies after which the loaded geometry is rendered "
+        "while the rest of the circuit is loading. 0 waits for the whole "
+        "circuit [int]")(
+        PARAM_CIRCUIT_LEVELS_OF_DETAIL.c_str(), po::value<bool>(),
+        "Enable|Disable generation of coarse levels of detail (somas only, "
+        "and one cone per section) for every morphology of a circuit, "
+        "selected with --level-of-detail [bool]")(
+        PARAM_CIRCUIT_PREFETCH_THREADS.c_str(), po::value<size_t>(),
+        "Number of I/O threads reading morphologies ahead of the threads "
+        "generating their geometry. 0 reads them on the same threads [int]")(
+        PARAM_CIRCUIT_PREFETCH_QUEUE_DEPTH.c_str(), po::value<size_t>(),
+        "Maximum number of morphologies read ahead by the I/O threads [int]")(
         PARAM_MEMORY_MODE.c_str(), po::value<std::string>(),
         "Defines what memory mode should be used between Brayns and the "
         "underlying renderer [shared|replicated]")(
@@ -260,6 +342,12 @@ bool GeometryParameters::_parse(const po::variables_map& vm)
         _loadCacheFile = vm[PARAM_LOAD_CACHE_FILE].as<std::string>();
     if (vm.count(PARAM_SAVE_CACHE_FILE))
         _saveCacheFile = vm[PARAM_SAVE_CACHE_FILE].as<std::string>();
+    if (vm.count(PARAM_COMPRESS_CACHE_FILE))
+        _compressCacheFile = vm[PARAM_COMPRESS_CACHE_FILE].as<bool>();
+    if (vm.count(PARAM_SPATIAL_SORTING))
+        _spatialSorting = vm[PARAM_SPATIAL_SORTING].as<bool>();
+    if (vm.count(PARAM_COMPACT_GEOMETRY))
+        _compactGeometry = vm[PARAM_COMPACT_GEOMETRY].as<bool>();
     if (vm.count(PARAM_COLOR_SCHEME))
     {
         _colorScheme = ColorScheme::none;
@@ -316,6 +404,9 @@ bool GeometryParameters::_parse(const po::variables_map& vm)
             _morphologyLayout.horizontalSpacing = values[2];
         }
     }
+    if (vm.count(PARAM_MORPHOLOGY_CACHE_FOLDER))
+        _morphologyCacheFolder =
+            vm[PARAM_MORPHOLOGY_CACHE_FOLDER].as<std::string>();
     if (vm.count(PARAM_CIRCUIT_START_SIMULATION_TIME))
         _circuitStartSimulationTime =
             vm[PARAM_CIRCUIT_START_SIMULATION_TIME].as<double>();
@@ -333,6 +424,18 @@ bool GeometryParameters::_parse(const po::variables_map& vm)
     if (vm.count(PARAM_CIRCUIT_SIMULATION_HISTOGRAM_SIZE))
         _circuitSimulationHistogramSize =
             vm[PARAM_CIRCUIT_SIMULATION_HISTOGRAM_SIZE].as<size_t>();
+    if (vm.count(PARAM_CIRCUIT_SIMULATION_HISTOGRAM_WINDOW))
+        _circuitSimulationHistogramWindow = std::max<size_t>(
+            1, vm[PARAM_CIRCUIT_SIMULATION_HISTOGRAM_WINDOW].as<size_t>());
+    if (vm.count(PARAM_CIRCUIT_SIMULATION_PLAYBACK_RATE))
+        _circuitSimulationPlaybackRate =
+            vm[PARAM_CIRCUIT_SIMULATION_PLAYBACK_RATE].as<float>();
+    if (vm.count(PARAM_CIRCUIT_SIMULATION_PLAYBACK_TIME_RATE))
+        _circuitSimulationPlaybackTimeRate =
+            vm[PARAM_CIRCUIT_SIMULATION_PLAYBACK_TIME_RATE].as<float>();
+    if (vm.count(PARAM_CIRCUIT_SIMULATION_PREFETCH_FRAMES))
+        _circuitSimulationPrefetchFrames =
+            vm[PARAM_CIRCUIT_SIMULATION_PREFETCH_FRAMES].as<size_t>();
     if (vm.count(PARAM_NEST_CACHE_FILENAME))
         _NESTCacheFile = vm[PARAM_NEST_CACHE_FILENAME].as<std::string>();
     if (vm.count(PARAM_SPLASH_SCENE_FOLDER))
@@ -340,6 +443,8 @@ bool GeometryParameters::_parse(const po::variables_map& vm)
     if (vm.count(PARAM_MOLECULAR_SYSTEM_CONFIG))
         _molecularSystemConfig =
             vm[PARAM_MOLECULAR_SYSTEM_CONFIG].as<std::string>();
+    if (vm.count(PARAM_CALCIUM_CACHE_FOLDER))
+        _calciumCacheFolder = vm[PARAM_CALCIUM_CACHE_FOLDER].as<std::string>();
 
     if (vm.count(PARAM_METABALLS_GRIDSIZE))
         _metaballsGridSize = vm[PARAM_METABALLS_GRIDSIZE].as<size_t>();
@@ -351,6 +456,18 @@ bool GeometryParameters::_parse(const po::variables_map& vm)
     if (vm.count(PARAM_CIRCUIT_USES_SIMULATION_MODEL))
         _circuitUseSimulationModel =
             vm[PARAM_CIRCUIT_USES_SIMULATION_MODEL].as<bool>();
+    if (vm.count(PARAM_CIRCUIT_USE_INSTANCES))
+        _circuitUseInstances = vm[PARAM_CIRCUIT_USE_INSTANCES].as<bool>();
+    if (vm.count(PARAM_CIRCUIT_BATCH_SIZE))
+        _circuitBatchSize = vm[PARAM_CIRCUIT_BATCH_SIZE].as<size_t>();
+    if (vm.count(PARAM_CIRCUIT_LEVELS_OF_DETAIL))
+        _circuitLevelsOfDetail = vm[PARAM_CIRCUIT_LEVELS_OF_DETAIL].as<bool>();
+    if (vm.count(PARAM_CIRCUIT_PREFETCH_THREADS))
+        _circuitPrefetchThreads =
+            vm[PARAM_CIRCUIT_PREFETCH_THREADS].as<size_t>();
+    if (vm.count(PARAM_CIRCUIT_PREFETCH_QUEUE_DEPTH))
+        _circuitPrefetchQueueDepth =
+            vm[PARAM_CIRCUIT_PREFETCH_QUEUE_DEPTH].as<size_t>();
     if (vm.count(PARAM_CIRCUIT_BOUNDING_BOX))
     {
         const floats values = vm[PARAM_CIRCUIT_BOUNDING_BOX].as<floats>();
@@ -367,6 +484,42 @@ bool GeometryParameters::_parse(const po::variables_map& vm)
             BRAYNS_ERROR << "Invalid number of values for "
                          << PARAM_CIRCUIT_BOUNDING_BOX << std::endl;
     }
+    if (vm.count(PARAM_CIRCUIT_REGION_OF_INTEREST))
+    {
+        const floats values =
+            vm[PARAM_CIRCUIT_REGION_OF_INTEREST].as<floats>();
+        if (values.size() == 6)
+        {
+            _circuitRegionOfInterest.reset();
+            _circuitRegionOfInterest.merge(
+                Vector3f(values[0], values[1], values[2]));
+            _circuitRegionOfInterest.merge(
+                Vector3f(values[3], values[4], values[5]));
+        }
+        else
+            BRAYNS_ERROR << "Invalid number of values for "
+                         << PARAM_CIRCUIT_REGION_OF_INTEREST << std::endl;
+    }
+    if (vm.count(PARAM_CIRCUIT_REGION_OF_INTEREST_PLANES))
+    {
+        const floats values =
+            vm[PARAM_CIRCUIT_REGION_OF_INTEREST_PLANES].as<floats>();
+        if (values.size() % 4 == 0)
+        {
+            _circuitRegionOfInterestPlanes.clear();
+            for (size_t i = 0; i < values.size(); i += 4)
+                _circuitRegionOfInterestPlanes.push_back(
+                    Vector4f(values[i], values[i + 1], values[i + 2],
+                             values[i + 3]));
+        }
+        else
+            BRAYNS_ERROR << "Invalid number of values for "
+                         << PARAM_CIRCUIT_REGION_OF_INTEREST_PLANES
+                         << std::endl;
+    }
+    if (vm.count(PARAM_CIRCUIT_REGION_OF_INTEREST_MARGIN))
+        _circuitRegionOfInterestMargin =
+            vm[PARAM_CIRCUIT_REGION_OF_INTEREST_MARGIN].as<float>();
     if (vm.count(PARAM_MEMORY_MODE))
     {
         const auto& memoryMode = vm[PARAM_MEMORY_MODE].as<std::string>();
@@ -433,6 +586,12 @@ void GeometryParameters::print()
                 << std::endl;
     BRAYNS_INFO << "Cache file to save         : " << _saveCacheFile
                 << std::endl;
+    BRAYNS_INFO << "Compress cache file        : "
+                << (_compressCacheFile ? "Yes" : "No") << std::endl;
+    BRAYNS_INFO << "Spatial sorting            : "
+                << (_spatialSorting ? "Yes" : "No") << std::endl;
+    BRAYNS_INFO << "Compact geometry           : "
+                << (_compactGeometry ? "Yes" : "No") << std::endl;
     BRAYNS_INFO << "Color scheme               : "
                 << getColorSchemeAsString(_colorScheme) << std::endl;
     BRAYNS_INFO << "Radius multiplier          : " << _radiusMultiplier
@@ -464,10 +623,32 @@ void GeometryParameters::print()
                 << _circuitSimulationValuesRange << std::endl;
     BRAYNS_INFO << " - Histogram size          : "
                 << _circuitSimulationHistogramSize << std::endl;
+    BRAYNS_INFO << " - Histogram window        : "
+                << _circuitSimulationHistogramWindow << std::endl;
+    BRAYNS_INFO << " - Playback rate           : "
+                << getCircuitSimulationPlaybackRate() << std::endl;
+    BRAYNS_INFO << " - Prefetched frames       : "
+                << _circuitSimulationPrefetchFrames << std::endl;
     BRAYNS_INFO << " - Bounding box            : " << _circuitBoundingBox
                 << std::endl;
+    BRAYNS_INFO << " - Region of interest      : " << _circuitRegionOfInterest
+                << std::endl;
+    BRAYNS_INFO << " - ROI planes              : "
+                << _circuitRegionOfInterestPlanes.size() << std::endl;
+    BRAYNS_INFO << " - ROI margin              : "
+                << _circuitRegionOfInterestMargin << std::endl;
     BRAYNS_INFO << " - Mesh transformation     : "
                 << (_circuitMeshTransformation ? "Yes" : "No") << std::endl;
+    BRAYNS_INFO << " - Use instances           : "
+                << (_circuitUseInstances ? "Yes" : "No") << std::endl;
+    BRAYNS_INFO << " - Batch size              : " << _circuitBatchSize
+                << std::endl;
+    BRAYNS_INFO << " - Levels of detail        : "
+                << (_circuitLevelsOfDetail ? "Yes" : "No") << std::endl;
+    BRAYNS_INFO << " - Prefetch threads        : " << _circuitPrefetchThreads
+                << std::endl;
+    BRAYNS_INFO << " - Prefetch queue depth    : "
+                << _circuitPrefetchQueueDepth << std::endl;
     BRAYNS_INFO << "Morphology section types   : " << _morphologySectionTypes
                 << std::endl;
     BRAYNS_INFO << "Morphology Layout          : " << std::endl;
@@ -477,10 +658,14 @@ void GeometryParameters::print()
                 << _morphologyLayout.verticalSpacing << std::endl;
     BRAYNS_INFO << " - Horizontal spacing      : "
                 << _morphologyLayout.horizontalSpacing << std::endl;
+    BRAYNS_INFO << "Morphology cache folder    : " << _morphologyCacheFolder
+                << std::endl;
     BRAYNS_INFO << "Splash scene folder        : " << _splashSceneFolder
                 << std::endl;
     BRAYNS_INFO << "Molecular system config    : " << _molecularSystemConfig
                 << std::endl;
+    BRAYNS_INFO << "Calcium cache folder       : " << _calciumCacheFolder
+                << std::endl;
     BRAYNS_INFO << "Metaballs                  : " << std::endl;
     BRAYNS_INFO << " - Grid size               : " << _metaballsGridSize
                 << std::endl;
@@ -527,6 +712,13 @@ const std::string& GeometryParameters::getGeometryQualityAsString(
     return GEOMETRY_QUALITIES[static_cast<size_t>(value)];
 }
 
+float GeometryParameters::getCircuitSimulationPlaybackRate() const
+{
+    if (_circuitSimulationPlaybackTimeRate > 0.f && _circuitSimulationStep > 0)
+        return _circuitSimulationPlaybackTimeRate / _circuitSimulationStep;
+    return std::max(0.f, _circuitSimulationPlaybackRate);
+}
+
 float GeometryParameters::getCircuitDensity() const
 {
     return std::max(0.f, std::min(100.f, _circuitDensity));
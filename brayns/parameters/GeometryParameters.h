@@ -88,6 +88,12 @@ public:
     const std::string& getLoadCacheFile() const { return _loadCacheFile; }
     /** Binary representation of a scene to save */
     const std::string& getSaveCacheFile() const { return _saveCacheFile; }
+    /** Compress geometry blocks of the saved cache file */
+    bool getCompressCacheFile() const { return _compressCacheFile; }
+    /** Sort primitives of every material along a Morton curve */
+    bool getSpatialSorting() const { return _spatialSorting; }
+    /** Quantize primitives handed over to the engine */
+    bool getCompactGeometry() const { return _compactGeometry; }
     /** Circuit targets */
     const std::string& getCircuitTargets() const { return _circuitTargets; }
     strings getCircuitTargetsAsStrings() const;
@@ -115,6 +121,31 @@ public:
         updateValue(_circuitBoundingBox, value);
     }
 
+    /**
+     * Defines a box to which the geometry of a circuit is clipped. Unlike the
+     * bounding box, cells are selected by their morphology, not their soma
+     */
+    const Boxf& getCircuitRegionOfInterest() const
+    {
+        return _circuitRegionOfInterest;
+    }
+    /**
+     * Defines planes delimiting a convex region to which the geometry of a
+     * circuit is clipped, in addition to the region of interest box
+     */
+    const ClipPlanes& getCircuitRegionOfInterestPlanes() const
+    {
+        return _circuitRegionOfInterestPlanes;
+    }
+    /**
+     * Maximum distance between the soma of a cell and the region of interest
+     * for the cell to be loaded, 0 if cells are not selected by their soma
+     */
+    float getCircuitRegionOfInterestMargin() const
+    {
+        return _circuitRegionOfInterestMargin;
+    }
+
     /**
      * Defines if a different model is used to handle the simulation geometry.
      * If set to True, the shading of the main geometry model will be done
@@ -129,6 +160,35 @@ public:
     {
         updateValue(_circuitUseSimulationModel, value);
     }
+    /**
+     * Defines if every morphology of a circuit is loaded once, and placed as
+     * many times as neurons use it
+     */
+    bool getCircuitUseInstances() const { return _circuitUseInstances; }
+    /**
+     * Number of morphologies after which the geometry loaded so far is
+     * rendered, while the rest of the circuit is loading. 0 if the circuit is
+     * only rendered once fully loaded
+     */
+    size_t getCircuitBatchSize() const { return _circuitBatchSize; }
+    /**
+     * Defines if coarse levels of detail are generated for the morphologies of
+     * a circuit, in addition to their full geometry
+     */
+    bool getCircuitLevelsOfDetail() const { return _circuitLevelsOfDetail; }
+    /**
+     * Number of I/O threads reading morphologies ahead of the threads that
+     * generate their geometry. 0 if morphologies are read by the latter
+     */
+    size_t getCircuitPrefetchThreads() const { return _circuitPrefetchThreads; }
+    /**
+     * Maximum number of morphologies read by the I/O threads and waiting for
+     * their geometry to be generated
+     */
+    size_t getCircuitPrefetchQueueDepth() const
+    {
+        return _circuitPrefetchQueueDepth;
+    }
     /**
      * Return the filename pattern use to load meshes
      */
@@ -180,6 +240,11 @@ public:
     {
         return _morphologyLayout;
     }
+    /** Folder where tessellated morphologies are cached, disabled if empty */
+    const std::string& getMorphologyCacheFolder() const
+    {
+        return _morphologyCacheFolder;
+    }
 
     /** Defines the range of frames to be loaded for the simulation */
     double getCircuitEndSimulationTime() const
@@ -202,6 +267,31 @@ public:
         return _circuitSimulationHistogramSize;
     }
 
+    /**
+     * Number of frames covered by the simulation histogram, ending with the
+     * current one
+     */
+    size_t getCircuitSimulationHistogramWindow() const
+    {
+        return _circuitSimulationHistogramWindow;
+    }
+
+    /**
+     * Number of simulation frames played per second, derived from the
+     * simulation time played per second if specified. 0 if frames are played
+     * at the rendering rate.
+     */
+    float getCircuitSimulationPlaybackRate() const;
+
+    /**
+     * Number of frames of a compartment report loaded ahead of the current
+     * one, in the playback direction
+     */
+    size_t getCircuitSimulationPrefetchFrames() const
+    {
+        return _circuitSimulationPrefetchFrames;
+    }
+
     /** Size of the simulation histogram */
     size_t getCircuitMeshTransformation() const
     {
@@ -222,6 +312,11 @@ public:
     {
         return _molecularSystemConfig;
     }
+    /** Folder where calcium positions are cached, disabled if empty */
+    const std::string& getCalciumCacheFolder() const
+    {
+        return _calciumCacheFolder;
+    }
 
     /** Metaballs grid size */
     size_t getMetaballsGridSize() const { return _metaballsGridSize; }
@@ -283,6 +378,9 @@ protected:
     std::string _circuitConfiguration;
     bool _circuitUseSimulationModel;
     Boxf _circuitBoundingBox;
+    Boxf _circuitRegionOfInterest{Vector3f(0.f), Vector3f(0.f)};
+    ClipPlanes _circuitRegionOfInterestPlanes;
+    float _circuitRegionOfInterestMargin{0.f};
     float _circuitDensity;
     std::string _circuitMeshFilenamePattern;
     std::string _circuitMeshFolder;
@@ -293,11 +391,23 @@ protected:
     double _circuitSimulationStep{0};
     Vector2f _circuitSimulationValuesRange;
     size_t _circuitSimulationHistogramSize;
+    size_t _circuitSimulationHistogramWindow{1};
+    float _circuitSimulationPlaybackRate{0.f};
+    float _circuitSimulationPlaybackTimeRate{0.f};
+    size_t _circuitSimulationPrefetchFrames{0};
     bool _circuitMeshTransformation;
+    bool _circuitUseInstances{false};
+    size_t _circuitBatchSize{0};
+    bool _circuitLevelsOfDetail{false};
+    size_t _circuitPrefetchThreads{0};
+    size_t _circuitPrefetchQueueDepth{64};
 
     // Scene
     std::string _loadCacheFile;
     std::string _saveCacheFile;
+    bool _compressCacheFile{false};
+    bool _spatialSorting{true};
+    bool _compactGeometry{false};
     SceneEnvironment _sceneEnvironment;
     std::string _splashSceneFolder;
     std::string _sceneFile;
@@ -310,8 +420,10 @@ protected:
     GeometryQuality _geometryQuality;
     size_t _morphologySectionTypes;
     MorphologyLayout _morphologyLayout;
+    std::string _morphologyCacheFolder;
     bool _generateMultipleModels;
     std::string _molecularSystemConfig;
+    std::string _calciumCacheFolder;
     size_t _metaballsGridSize;
     float _metaballsThreshold;
     size_t _metaballsSamplesFromSoma;
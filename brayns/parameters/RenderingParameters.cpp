@@ -24,6 +24,8 @@
 
 #include <boost/lexical_cast.hpp>
 
+#include <algorithm>
+
 namespace
 {
 const std::string DEFAULT_ENGINE = "ospray";
@@ -51,6 +53,8 @@ const std::string PARAM_EPSILON = "epsilon";
 const std::string PARAM_CAMERA_TYPE = "camera-type";
 const std::string PARAM_HEAD_LIGHT = "head-light";
 const std::string PARAM_VARIANCE_THRESHOLD = "variance-threshold";
+const std::string PARAM_LEVEL_OF_DETAIL = "level-of-detail";
+const std::string PARAM_LEVEL_OF_DETAIL_DISTANCES = "level-of-detail-distances";
 
 const std::string RENDERERS[7] = {"basic",
                                   "proximity",
@@ -71,6 +75,8 @@ const std::string CAMERA_TYPES[5] = {"perspective", "stereo", "orthographic",
                                      "panoramic", "clipped"};
 
 const std::string SHADING_TYPES[3] = {"none", "diffuse", "electron"};
+
+const std::string LEVELS_OF_DETAIL[3] = {"somas", "skeleton", "full"};
 }
 
 namespace brayns
@@ -135,7 +141,13 @@ RenderingParameters::RenderingParameters()
         PARAM_HEAD_LIGHT.c_str(), po::value<bool>(),
         "Enable/Disable light source attached to camera origin [bool]")(
         PARAM_VARIANCE_THRESHOLD.c_str(), po::value<float>(),
-        "Threshold for adaptive accumulation [float]");
+        "Threshold for adaptive accumulation [float]")(
+        PARAM_LEVEL_OF_DETAIL.c_str(), po::value<std::string>(),
+        "Finest level of detail of circuits [somas|skeleton|full]")(
+        PARAM_LEVEL_OF_DETAIL_DISTANCES.c_str(),
+        po::value<floats>()->multitoken(),
+        "Distances between the camera and the scene beyond which circuits are "
+        "rendered as skeletons, and as somas [float float]");
 
     // Add default renderers
     _renderers.push_back(RendererType::basic);
@@ -221,6 +233,19 @@ bool RenderingParameters::_parse(const po::variables_map& vm)
         _headLight = vm[PARAM_HEAD_LIGHT].as<bool>();
     if (vm.count(PARAM_VARIANCE_THRESHOLD))
         _varianceThreshold = vm[PARAM_VARIANCE_THRESHOLD].as<float>();
+    if (vm.count(PARAM_LEVEL_OF_DETAIL))
+    {
+        _levelOfDetail = LevelOfDetail::full;
+        const std::string& levelOfDetail =
+            vm[PARAM_LEVEL_OF_DETAIL].as<std::string>();
+        for (size_t i = 0;
+             i < sizeof(LEVELS_OF_DETAIL) / sizeof(LEVELS_OF_DETAIL[0]); ++i)
+            if (levelOfDetail == LEVELS_OF_DETAIL[i])
+                _levelOfDetail = static_cast<LevelOfDetail>(i);
+    }
+    if (vm.count(PARAM_LEVEL_OF_DETAIL_DISTANCES))
+        _levelOfDetailDistances =
+            vm[PARAM_LEVEL_OF_DETAIL_DISTANCES].as<floats>();
     return true;
 }
 
@@ -265,6 +290,8 @@ void RenderingParameters::print()
                 << getCameraTypeAsString(_cameraType) << std::endl;
     BRAYNS_INFO << "Accumulation                      : "
                 << (_accumulation ? "on" : "off") << std::endl;
+    BRAYNS_INFO << "Level of detail                   : "
+                << getLevelOfDetailAsString(_levelOfDetail) << std::endl;
 }
 
 const std::string& RenderingParameters::getRendererAsString(
@@ -285,6 +312,35 @@ const std::string& RenderingParameters::getCameraTypeAsString(
     return CAMERA_TYPES[static_cast<size_t>(value)];
 }
 
+const std::string& RenderingParameters::getLevelOfDetailAsString(
+    const LevelOfDetail value) const
+{
+    return LEVELS_OF_DETAIL[static_cast<size_t>(value)];
+}
+
+LevelOfDetail RenderingParameters::getLevelOfDetail(
+    const Boxf& worldBounds, const Vector3f& cameraPosition) const
+{
+    auto level = _levelOfDetail;
+    if (_levelOfDetailDistances.empty())
+        return level;
+
+    // Distance from the camera to the closest point of the scene
+    Vector3f closest;
+    for (size_t i = 0; i < 3; ++i)
+        closest[i] =
+            std::max(worldBounds.getMin()[i],
+                     std::min(cameraPosition[i], worldBounds.getMax()[i]));
+    const float distance = (cameraPosition - closest).length();
+
+    if (distance > _levelOfDetailDistances[0])
+        level = std::min(level, LevelOfDetail::skeleton);
+    if (_levelOfDetailDistances.size() > 1 &&
+        distance > _levelOfDetailDistances[1])
+        level = std::min(level, LevelOfDetail::somas);
+    return level;
+}
+
 const std::string& RenderingParameters::getShadingAsString(
     const ShadingType value) const
 {
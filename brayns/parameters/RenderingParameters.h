@@ -190,6 +190,34 @@ public:
     {
         updateValue(_varianceThreshold, value);
     }
+    /**
+       Finest level of detail at which circuits are rendered, if they were
+       loaded with their coarse levels of detail
+    */
+    LevelOfDetail getLevelOfDetail() const { return _levelOfDetail; }
+    void setLevelOfDetail(const LevelOfDetail value)
+    {
+        updateValue(_levelOfDetail, value);
+    }
+    const std::string& getLevelOfDetailAsString(
+        const LevelOfDetail value) const;
+    /**
+       Distances between the camera and the bounds of the scene beyond which
+       circuits are rendered as skeletons, and as somas. Empty if the level of
+       detail does not depend on the camera.
+    */
+    const floats& getLevelOfDetailDistances() const
+    {
+        return _levelOfDetailDistances;
+    }
+    /**
+       @return the level of detail requested by the parameters, lowered when
+       the camera is further from the scene than the level of detail distances
+       @param worldBounds Bounds of the scene
+       @param cameraPosition Position of the camera
+    */
+    LevelOfDetail getLevelOfDetail(const Boxf& worldBounds,
+                                   const Vector3f& cameraPosition) const;
 
 protected:
     bool _parse(const po::variables_map& vm) final;
@@ -216,6 +244,8 @@ protected:
     bool _headLight;
     bool _dynamicLoadBalancer{false};
     float _varianceThreshold{-1.f};
+    LevelOfDetail _levelOfDetail{LevelOfDetail::full};
+    floats _levelOfDetailDistances;
 };
 }
 #endif // RENDERINGPARAMETERS_H
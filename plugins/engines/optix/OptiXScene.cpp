@@ -357,10 +357,11 @@ void OptiXScene::commitLights()
 
 uint64_t OptiXScene::_serializeSpheres(const size_t materialId)
 {
-    if (_spheres.find(materialId) == _spheres.end())
+    const auto elements = _spheres.find(materialId);
+    if (!elements || elements->empty())
         return 0;
 
-    const auto& spheres = _spheres[materialId];
+    const auto& spheres = *elements;
     const auto bufferSize = spheres.size() * sizeof(Sphere);
     _context["sphere_size"]->setUint(sizeof(Sphere) / sizeof(float));
     _optixSpheres[materialId] = _context->createGeometry();
@@ -386,12 +387,41 @@ uint64_t OptiXScene::_serializeSpheres(const size_t materialId)
     return memSize;
 }
 
+void OptiXScene::commitSpheres(const size_t materialId)
+{
+    // The other materials keep their geometry, commit() then rebuilds the
+    // acceleration structure
+    const auto geometry = _optixSpheres.find(materialId);
+    if (geometry == _optixSpheres.end())
+    {
+        _serializeSpheres(materialId);
+        return;
+    }
+
+    const auto elements = _spheres.find(materialId);
+    const size_t nbSpheres = elements ? elements->size() : 0;
+    const auto bufferSize = nbSpheres * sizeof(Sphere);
+    auto& buffer = _spheresBuffers[materialId];
+    RTsize size = 0;
+    buffer->getSize(size);
+    if (size < bufferSize)
+        buffer->setSize(bufferSize);
+    if (bufferSize > 0)
+    {
+        memcpy(buffer->map(), elements->data(), bufferSize);
+        buffer->unmap();
+    }
+    geometry->second->setPrimitiveCount(nbSpheres);
+    geometry->second->markDirty();
+}
+
 uint64_t OptiXScene::_serializeCylinders(const size_t materialId)
 {
-    if (_cylinders.find(materialId) == _cylinders.end())
+    const auto elements = _cylinders.find(materialId);
+    if (!elements || elements->empty())
         return 0;
 
-    const auto& cylinders = _cylinders[materialId];
+    const auto& cylinders = *elements;
     const auto bufferSize = cylinders.size() * sizeof(Cylinder);
     _context["cylinder_size"]->setUint(sizeof(Cylinder) / sizeof(float));
     _optixCylinders[materialId] = _context->createGeometry();
@@ -420,10 +450,11 @@ uint64_t OptiXScene::_serializeCylinders(const size_t materialId)
 
 uint64_t OptiXScene::_serializeCones(const size_t materialId)
 {
-    if (_cones.find(materialId) == _cones.end())
+    const auto elements = _cones.find(materialId);
+    if (!elements || elements->empty())
         return 0;
 
-    const auto& cones = _cones[materialId];
+    const auto& cones = *elements;
     const auto bufferSize = cones.size() * sizeof(Cone);
     _context["cone_size"]->setUint(sizeof(Cone) / sizeof(float));
     _optixCones[materialId] = _context->createGeometry();
@@ -454,6 +485,10 @@ uint64_t OptiXScene::serializeGeometry()
     if (_spheresDirty)
         for (size_t i = 0; i < _materials.size(); ++i)
             size += _serializeSpheres(i);
+    else
+        // Materials modified in place upload all their spheres again
+        for (const auto& range : _dirtySpheres)
+            commitSpheres(range.first);
     if (_cylindersDirty)
         for (size_t i = 0; i < _materials.size(); ++i)
             size += _serializeCylinders(i);
@@ -464,6 +499,7 @@ uint64_t OptiXScene::serializeGeometry()
     _spheresDirty = false;
     _cylindersDirty = false;
     _conesDirty = false;
+    _dirtySpheres.clear();
     return size;
 }
 
@@ -484,13 +520,12 @@ uint64_t OptiXScene::_processMeshes()
     uint64_t nbTotalMaterials = 0;
 
     for (size_t materialId = 0; materialId < _materials.size(); ++materialId)
-        if (_trianglesMeshes.find(materialId) != _trianglesMeshes.end())
+        if (const auto mesh = _trianglesMeshes.find(materialId))
         {
-            nbTotalVertices += _trianglesMeshes[materialId].vertices.size();
-            nbTotalIndices += _trianglesMeshes[materialId].indices.size();
-            nbTotalNormals += _trianglesMeshes[materialId].normals.size();
-            nbTotalTexCoords +=
-                _trianglesMeshes[materialId].textureCoordinates.size();
+            nbTotalVertices += mesh->vertices.size();
+            nbTotalIndices += mesh->indices.size();
+            nbTotalNormals += mesh->normals.size();
+            nbTotalTexCoords += mesh->textureCoordinates.size();
         }
 
     Vector3fs vertices;
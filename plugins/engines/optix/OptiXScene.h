@@ -61,6 +61,9 @@ public:
     /** @copydoc Scene::serializeGeometry */
     uint64_t serializeGeometry() final;
 
+    /** @copydoc Scene::commitSpheres */
+    void commitSpheres(size_t materialId) final;
+
     /** @copydoc Scene::commitLights */
     void commitLights() final;
 
@@ -0,0 +1,56 @@
+/* Copyright (c) 2015-2017, EPFL/Blue Brain Project
+ * All rights reserved. Do not distribute without permission.
+ * Responsible Author: Cyrille Favreau <cyrille.favreau@epfl.ch>
+ *
+ * This file is part of Brayns <https://github.com/BlueBrain/Brayns>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "GeometryChunks.h"
+
+#include <algorithm>
+
+namespace brayns
+{
+uint64_t getChunkSize(const uint64_t nbPrimitives, const uint64_t maxPrimitives)
+{
+    const uint64_t nbChunks = std::max<uint64_t>(
+        1, (nbPrimitives + maxPrimitives - 1) / maxPrimitives);
+    const uint64_t chunkSize = (nbPrimitives + nbChunks - 1) / nbChunks;
+    const uint64_t blockSize = COMPACT_PRIMITIVES_PER_BLOCK;
+    return std::max(blockSize,
+                    (chunkSize + blockSize - 1) / blockSize * blockSize);
+}
+
+size_t getNbChunks(const uint64_t nbPrimitives, const uint64_t maxPrimitives)
+{
+    const auto chunkSize = getChunkSize(nbPrimitives, maxPrimitives);
+    return (nbPrimitives + chunkSize - 1) / chunkSize;
+}
+
+std::pair<size_t, size_t> getChunkRange(const uint64_t nbPrimitives,
+                                        const uint64_t begin,
+                                        const uint64_t end,
+                                        const uint64_t maxPrimitives)
+{
+    const auto last = std::min(end, nbPrimitives);
+    if (begin >= last)
+        return std::make_pair(0, 0);
+
+    const auto chunkSize = getChunkSize(nbPrimitives, maxPrimitives);
+    return std::make_pair(begin / chunkSize,
+                          (last + chunkSize - 1) / chunkSize);
+}
+}
@@ -0,0 +1,62 @@
+/* Copyright (c) 2015-2017, EPFL/Blue Brain Project
+ * All rights reserved. Do not distribute without permission.
+ * Responsible Author: Cyrille Favreau <cyrille.favreau@epfl.ch>
+ *
+ * This file is part of Brayns <https://github.com/BlueBrain/Brayns>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef GEOMETRYCHUNKS_H
+#define GEOMETRYCHUNKS_H
+
+#include <plugins/engines/ospray/ispc/geometry/CompactPrimitives.h>
+
+#include <cstdint>
+#include <utility>
+
+namespace brayns
+{
+/**
+ * The extended geometries cannot address 1 << 30 primitives or more, larger
+ * materials are split into several geometries. The limit is a multiple of the
+ * compact block size, so that chunks start on a block.
+ */
+const uint64_t MAX_PRIMITIVES_PER_GEOMETRY =
+    (1ull << 30) - COMPACT_PRIMITIVES_PER_BLOCK;
+
+/**
+ * @return the number of primitives of the geometries a material is split
+ *         into. Chunks are balanced, the last one holding the remaining
+ *         primitives, and their size is a multiple of the compact block size.
+ * @param nbPrimitives Number of primitives of the material
+ * @param maxPrimitives Maximum number of primitives of a geometry, a multiple
+ *        of COMPACT_PRIMITIVES_PER_BLOCK
+ */
+uint64_t getChunkSize(uint64_t nbPrimitives,
+                      uint64_t maxPrimitives = MAX_PRIMITIVES_PER_GEOMETRY);
+
+/** @return the number of geometries a material is split into */
+size_t getNbChunks(uint64_t nbPrimitives,
+                   uint64_t maxPrimitives = MAX_PRIMITIVES_PER_GEOMETRY);
+
+/**
+ * @return the range [first, last) of the geometries holding the primitives in
+ *         [begin, end). The range is empty if no primitive is given.
+ */
+std::pair<size_t, size_t> getChunkRange(
+    uint64_t nbPrimitives, uint64_t begin, uint64_t end,
+    uint64_t maxPrimitives = MAX_PRIMITIVES_PER_GEOMETRY);
+}
+#endif // GEOMETRYCHUNKS_H
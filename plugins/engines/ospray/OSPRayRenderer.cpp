@@ -66,8 +66,32 @@ void OSPRayRenderer::commit()
     SceneParameters& sp = _parametersManager.getSceneParameters();
     VolumeParameters& vp = _parametersManager.getVolumeParameters();
 
-    if (!rp.getModified() && !sp.getModified() && !vp.getModified())
+    // Simulation data is double buffered by the scene, and bound when the
+    // renderer is committed, that is only when it is active. So is the model
+    // of the selected level of detail. Committed models are bound again as
+    // well, so that the renderer updates what it derives from their geometry.
+    OSPRayScene* osprayScene = static_cast<OSPRayScene*>(_scene.get());
+    assert(osprayScene);
+    const auto simulationData = osprayScene->simulationDataImpl();
+    const auto model = osprayScene->modelImpl();
+    const auto modelVersion = osprayScene->getModelVersion();
+
+    if (!rp.getModified() && !sp.getModified() && !vp.getModified() &&
+        simulationData == _simulationData && model == _model &&
+        modelVersion == _modelVersion)
+    {
         return;
+    }
+    _model = model;
+    _modelVersion = modelVersion;
+
+    if (simulationData != _simulationData)
+    {
+        ospSetData(_renderer, "simulationData", simulationData);
+        ospSet1i(_renderer, "simulationDataSize",
+                 simulationData ? osprayScene->getSimulationDataSize() : 0);
+        _simulationData = simulationData;
+    }
 
     ShadingType mt = rp.getShading();
 
@@ -98,10 +122,9 @@ void OSPRayRenderer::commit()
              static_cast<size_t>(MaterialType::voltage_simulation));
     ospSet1i(_renderer, "volumeSamplesPerRay", vp.getSamplesPerRay());
 
-    OSPRayScene* osprayScene = static_cast<OSPRayScene*>(_scene.get());
-    assert(osprayScene);
-
-    ospSetObject(_renderer, "world", osprayScene->modelImpl());
+    // Renderers only derive data from the geometry of a new model version
+    ospSet1i(_renderer, "modelVersion", int(modelVersion));
+    ospSetObject(_renderer, "world", model);
     ospSetObject(_renderer, "simulationModel",
                  osprayScene->simulationModelImpl());
     ospCommit(_renderer);
@@ -50,6 +50,9 @@ private:
     std::string _name;
     OSPRayCamera* _camera;
     OSPRenderer _renderer;
+    OSPData _simulationData{nullptr};
+    OSPModel _model{nullptr};
+    uint64_t _modelVersion{0};
     float _prevVariance{std::numeric_limits<float>::infinity()};
 };
 }
@@ -19,6 +19,7 @@
  */
 
 #include "OSPRayScene.h"
+#include "GeometryChunks.h"
 #include "OSPRayRenderer.h"
 
 #include <brayns/common/light/DirectionalLight.h>
@@ -33,6 +34,277 @@
 
 #include <boost/algorithm/string/predicate.hpp> // ends_with
 
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <functional>
+
+#ifdef BRAYNS_USE_OPENMP
+#include <omp.h>
+#endif
+
+namespace
+{
+// Below this number of primitives, a material is sorted by a single thread
+const size_t PARALLEL_SORT_THRESHOLD = 65536;
+
+// Number of bytes of a buffer copied by a single thread
+const uint64_t PARALLEL_COPY_CHUNK_SIZE = 4 << 20;
+
+// Spreads the 21 lower bits of a value so that they occupy every third bit
+uint64_t expandBits(uint64_t value)
+{
+    value &= 0x1fffff;
+    value = (value | value << 32) & 0x1f00000000ffffull;
+    value = (value | value << 16) & 0x1f0000ff0000ffull;
+    value = (value | value << 8) & 0x100f00f00f00f00full;
+    value = (value | value << 4) & 0x10c30c30c30c30c3ull;
+    value = (value | value << 2) & 0x1249249249249249ull;
+    return value;
+}
+
+// Computes 63 bits Morton codes of positions within the given bounds
+class MortonEncoder
+{
+public:
+    MortonEncoder(const brayns::Boxf& bounds)
+        : _origin(bounds.getMin())
+    {
+        const float resolution = float((1 << 21) - 1);
+        const auto size = bounds.getSize();
+        for (size_t i = 0; i < 3; ++i)
+            _scale[i] = size[i] > 0.f ? resolution / size[i] : 0.f;
+    }
+
+    uint64_t operator()(const brayns::Vector3f& position) const
+    {
+        uint64_t code = 0;
+        for (size_t i = 0; i < 3; ++i)
+        {
+            const float value = (position[i] - _origin[i]) * _scale[i];
+            code |= expandBits(value > 0.f ? uint64_t(value) : 0) << (2 - i);
+        }
+        return code;
+    }
+
+private:
+    brayns::Vector3f _origin;
+    brayns::Vector3f _scale;
+};
+
+brayns::Vector3f getCenter(const brayns::Sphere& sphere)
+{
+    return sphere.center;
+}
+
+brayns::Vector3f getCenter(const brayns::Cylinder& cylinder)
+{
+    return (cylinder.center + cylinder.up) * 0.5f;
+}
+
+brayns::Vector3f getCenter(const brayns::Cone& cone)
+{
+    return (cone.center + cone.up) * 0.5f;
+}
+
+osp::affine3f toAffine(const brayns::Matrix4f& matrix)
+{
+    osp::affine3f affine;
+    affine.l.vx = {matrix(0, 0), matrix(1, 0), matrix(2, 0)};
+    affine.l.vy = {matrix(0, 1), matrix(1, 1), matrix(2, 1)};
+    affine.l.vz = {matrix(0, 2), matrix(1, 2), matrix(2, 2)};
+    affine.p = {matrix(0, 3), matrix(1, 3), matrix(2, 3)};
+    return affine;
+}
+
+// Commits again the geometries holding the primitives in [begin, end)
+void commitChunks(const std::vector<OSPGeometry>& geometries,
+                  const uint64_t nbPrimitives, const uint64_t begin,
+                  const uint64_t end)
+{
+    const auto chunks = brayns::getChunkRange(nbPrimitives, begin, end);
+    for (size_t i = chunks.first; i < chunks.second && i < geometries.size();
+         ++i)
+        ospCommit(geometries[i]);
+}
+
+void removeGeometries(
+    OSPModel model,
+    const std::map<size_t, std::vector<OSPGeometry>>& geometries)
+{
+    for (const auto& material : geometries)
+        for (auto geometry : material.second)
+            ospRemoveGeometry(model, geometry);
+}
+
+void releaseGeometries(std::map<size_t, std::vector<OSPGeometry>>& geometries)
+{
+    for (const auto& material : geometries)
+        for (auto geometry : material.second)
+            ospRelease(geometry);
+    geometries.clear();
+}
+
+// Preparation of the primitives of one material, weighted by its number of
+// primitives
+typedef std::pair<uint64_t, std::function<void()>> SerializationTask;
+
+template <typename T, typename C>
+void addEncodingTask(
+    std::vector<SerializationTask>& tasks,
+    std::map<size_t, brayns::CompactGeometry<C>>& compactGeometries,
+    const size_t materialId, const T* primitives, const uint64_t nbPrimitives)
+{
+    if (nbPrimitives == 0)
+        return;
+
+    // Entries are created here, tasks running concurrently only write to the
+    // geometry they were given
+    auto& compactGeometry = compactGeometries[materialId];
+    tasks.emplace_back(nbPrimitives,
+                       [primitives, nbPrimitives, &compactGeometry] {
+                           brayns::encodePrimitives(primitives, nbPrimitives,
+                                                    compactGeometry);
+                       });
+}
+
+// Runs the largest tasks first, so that the last ones to be picked are short.
+// Tasks also run their own loops in parallel, which is used instead when there
+// are fewer tasks than threads.
+void runSerializationTasks(std::vector<SerializationTask>& tasks)
+{
+    std::sort(tasks.begin(), tasks.end(),
+              [](const SerializationTask& a, const SerializationTask& b) {
+                  return a.first > b.first;
+              });
+#ifdef BRAYNS_USE_OPENMP
+    const bool parallel = int64_t(tasks.size()) >= omp_get_max_threads();
+#else
+    const bool parallel = false;
+#endif
+#pragma omp parallel for schedule(dynamic) if (parallel)
+    for (int64_t i = 0; i < int64_t(tasks.size()); ++i)
+        tasks[i].second();
+}
+
+uint64_t getElapsedMilliseconds(
+    const std::chrono::high_resolution_clock::time_point& startTime)
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::high_resolution_clock::now() - startTime)
+        .count();
+}
+
+// Copies a buffer by chunks, in parallel
+void parallelCopy(const void* source, const uint64_t size, void* destination)
+{
+    const int64_t nbChunks =
+        (size + PARALLEL_COPY_CHUNK_SIZE - 1) / PARALLEL_COPY_CHUNK_SIZE;
+#pragma omp parallel for
+    for (int64_t i = 0; i < nbChunks; ++i)
+    {
+        const uint64_t begin = i * PARALLEL_COPY_CHUNK_SIZE;
+        const uint64_t end =
+            std::min<uint64_t>(begin + PARALLEL_COPY_CHUNK_SIZE, size);
+        memcpy(static_cast<uint8_t*>(destination) + begin,
+               static_cast<const uint8_t*>(source) + begin, end - begin);
+    }
+}
+
+// Copies the primitives of a material into a buffer owned by the scene. The
+// buffer is left uninitialized before the copy, which would otherwise fill it
+// with a single thread.
+template <typename T>
+void replicatePrimitives(const T* primitives, const uint64_t nbPrimitives,
+                         std::unique_ptr<uint8_t[]>& buffer)
+{
+    const uint64_t size = nbPrimitives * sizeof(T);
+    buffer.reset(new uint8_t[size]);
+    parallelCopy(primitives, size, buffer.get());
+}
+
+template <typename T>
+void addReplicationTask(
+    std::vector<SerializationTask>& tasks,
+    std::map<size_t, std::unique_ptr<uint8_t[]>>& buffers,
+    const size_t materialId, const T* primitives, const uint64_t nbPrimitives)
+{
+    if (nbPrimitives == 0)
+        return;
+
+    auto& buffer = buffers[materialId];
+    tasks.emplace_back(nbPrimitives, [primitives, nbPrimitives, &buffer] {
+        replicatePrimitives(primitives, nbPrimitives, buffer);
+    });
+}
+
+// Sorts chunks of the keys in parallel, then merges them pairwise
+template <typename T>
+void parallelSort(std::vector<T>& keys)
+{
+#ifdef BRAYNS_USE_OPENMP
+    const int64_t nbChunks =
+        keys.size() < PARALLEL_SORT_THRESHOLD ? 1 : omp_get_max_threads();
+#else
+    const int64_t nbChunks = 1;
+#endif
+    std::vector<size_t> bounds(nbChunks + 1);
+    for (int64_t i = 0; i <= nbChunks; ++i)
+        bounds[i] = keys.size() * i / nbChunks;
+
+#pragma omp parallel for
+    for (int64_t i = 0; i < nbChunks; ++i)
+        std::sort(keys.begin() + bounds[i], keys.begin() + bounds[i + 1]);
+
+    for (int64_t width = 1; width < nbChunks; width *= 2)
+    {
+#pragma omp parallel for
+        for (int64_t i = 0; i < nbChunks - width; i += 2 * width)
+            std::inplace_merge(keys.begin() + bounds[i],
+                               keys.begin() + bounds[i + width],
+                               keys.begin() +
+                                   bounds[std::min(i + 2 * width, nbChunks)]);
+    }
+}
+
+// Reorders primitives along a Morton curve. Primitives are moved as a whole,
+// so that their timestamps and simulation values follow them.
+template <typename T>
+void sortByMortonCode(std::vector<T>& primitives, const MortonEncoder& encoder)
+{
+    const int64_t nbPrimitives = primitives.size();
+    if (nbPrimitives < 2)
+        return;
+
+    // The index breaks ties, which keeps the order deterministic
+    std::vector<std::pair<uint64_t, uint64_t>> keys(nbPrimitives);
+#pragma omp parallel for
+    for (int64_t i = 0; i < nbPrimitives; ++i)
+        keys[i] = std::make_pair(encoder(getCenter(primitives[i])), i);
+
+    parallelSort(keys);
+
+    std::vector<T> sortedPrimitives(nbPrimitives);
+#pragma omp parallel for
+    for (int64_t i = 0; i < nbPrimitives; ++i)
+        sortedPrimitives[i] = primitives[keys[i].second];
+    primitives.swap(sortedPrimitives);
+}
+
+template <typename T>
+void addSortingTask(std::vector<SerializationTask>& tasks,
+                    std::vector<T>& primitives, const MortonEncoder& encoder)
+{
+    if (primitives.size() < 2)
+        return;
+
+    tasks.emplace_back(primitives.size(), [&primitives, &encoder] {
+        sortByMortonCode(primitives, encoder);
+    });
+}
+}
+
 namespace brayns
 {
 struct TextureTypeMaterialAttribute
@@ -58,7 +330,6 @@ OSPRayScene::OSPRayScene(Renderers renderers,
     , _ospLightData(nullptr)
     , _ospMaterialData(nullptr)
     , _ospVolumeData(nullptr)
-    , _ospSimulationData(nullptr)
     , _ospTransferFunctionDiffuseData(nullptr)
     , _ospTransferFunctionEmissionData(nullptr)
 {
@@ -72,6 +343,8 @@ OSPRayScene::~OSPRayScene()
     if (_ospTransferFunctionEmissionData)
         ospRelease(_ospTransferFunctionEmissionData);
 
+    _releaseSimulationData();
+
     for (auto& light : _ospLights)
         ospRelease(light);
     _ospLights.clear();
@@ -79,6 +352,8 @@ OSPRayScene::~OSPRayScene()
 
 void OSPRayScene::unload()
 {
+    _releaseGeometryBatches();
+    _releaseCoarseModels();
     if (_model)
     {
         for (size_t materialId = 0; materialId < _materials.size();
@@ -86,13 +361,12 @@ void OSPRayScene::unload()
         {
             if (_ospMeshes[materialId])
                 ospRemoveGeometry(_model, _ospMeshes[materialId]);
-            if (_ospExtendedSpheres[materialId])
-                ospRemoveGeometry(_model, _ospExtendedSpheres[materialId]);
-            if (_ospExtendedCylinders[materialId])
-                ospRemoveGeometry(_model, _ospExtendedCylinders[materialId]);
-            if (_ospExtendedCones[materialId])
-                ospRemoveGeometry(_model, _ospExtendedCones[materialId]);
         }
+        removeGeometries(_model, _ospExtendedSpheres);
+        removeGeometries(_model, _ospExtendedCylinders);
+        removeGeometries(_model, _ospExtendedCones);
+        for (auto& instance : _ospInstances)
+            ospRemoveGeometry(_model, instance);
         ospCommit(_model);
         ospRelease(_model);
         _model = nullptr;
@@ -100,21 +374,16 @@ void OSPRayScene::unload()
 
     if (_simulationModel)
     {
-        for (size_t materialId = 0; materialId < _materials.size();
-             ++materialId)
-        {
-            ospRemoveGeometry(_simulationModel,
-                              _ospExtendedSpheres[materialId]);
-            ospRemoveGeometry(_simulationModel,
-                              _ospExtendedCylinders[materialId]);
-            ospRemoveGeometry(_simulationModel, _ospExtendedCones[materialId]);
-        }
+        removeGeometries(_simulationModel, _ospExtendedSpheres);
+        removeGeometries(_simulationModel, _ospExtendedCylinders);
+        removeGeometries(_simulationModel, _ospExtendedCones);
         ospCommit(_simulationModel);
         ospRelease(_simulationModel);
         _simulationModel = nullptr;
     }
 
     Scene::unload();
+    _geometrySorted = false;
 
     for (auto& material : _ospMaterials)
         ospRelease(material);
@@ -124,33 +393,31 @@ void OSPRayScene::unload()
         ospRelease(texture.second);
     _ospTextures.clear();
 
-    if (_ospSimulationData)
-        ospRelease(_ospSimulationData);
+    _releaseSimulationData();
 
     if (_ospVolumeData)
         ospRelease(_ospVolumeData);
 
-    for (auto& geom : _ospExtendedSpheres)
-        ospRelease(geom.second);
-    _ospExtendedSpheres.clear();
-    for (auto& geom : _ospExtendedSpheresData)
-        ospRelease(geom.second);
-    _ospExtendedSpheresData.clear();
-    for (auto& geom : _ospExtendedCylinders)
-        ospRelease(geom.second);
-    _ospExtendedCylinders.clear();
-    for (auto& geom : _ospExtendedCylindersData)
-        ospRelease(geom.second);
-    _ospExtendedCylindersData.clear();
-    for (auto& geom : _ospExtendedCones)
-        ospRelease(geom.second);
-    _ospExtendedCones.clear();
-    for (auto& geom : _ospExtendedConesData)
-        ospRelease(geom.second);
-    _ospExtendedConesData.clear();
+    releaseGeometries(_ospExtendedSpheres);
+    releaseGeometries(_ospExtendedCylinders);
+    releaseGeometries(_ospExtendedCones);
     for (auto& geom : _ospMeshes)
         ospRelease(geom.second);
     _ospMeshes.clear();
+
+    for (auto& instance : _ospInstances)
+        ospRelease(instance);
+    _ospInstances.clear();
+    for (auto& model : _ospInstancedModels)
+        ospRelease(model);
+    _ospInstancedModels.clear();
+
+    _compactSpheres.clear();
+    _compactCylinders.clear();
+    _compactCones.clear();
+    _replicatedSpheres.clear();
+    _replicatedCylinders.clear();
+    _replicatedCones.clear();
 }
 
 void OSPRayScene::commit()
@@ -163,116 +430,312 @@ void OSPRayScene::commit()
         BRAYNS_INFO << "Committing simulation model" << std::endl;
         ospCommit(_simulationModel);
     }
+    ++_modelVersion;
 }
 
-uint64_t OSPRayScene::_serializeSpheres(const size_t materialId)
+uint64_t OSPRayScene::_serializeSpheres(const size_t materialId,
+                                        const bool prepare)
 {
-    if (_spheres.find(materialId) == _spheres.end())
+    const Sphere* spheres = nullptr;
+    const auto nbSpheres = _getSpheresData(materialId, spheres);
+    if (nbSpheres == 0)
         return 0;
 
-    auto model = _getActiveModel();
-    const auto& spheres = _spheres[materialId];
-    const auto bufferSize = spheres.size() * sizeof(Sphere);
-    if (_ospExtendedSpheres.find(materialId) != _ospExtendedSpheres.end())
-        ospRemoveGeometry(model, _ospExtendedSpheres[materialId]);
-
-    _ospExtendedSpheres[materialId] = ospNewGeometry("extendedspheres");
-    _ospExtendedSpheresData[materialId] =
-        ospNewData(bufferSize / sizeof(float), OSP_FLOAT, spheres.data(),
-                   _getOSPDataFlags());
-
-    ospSetObject(_ospExtendedSpheres[materialId], "extendedspheres",
-                 _ospExtendedSpheresData[materialId]);
-
-    if (_ospMaterials[materialId])
-        ospSetMaterial(_ospExtendedSpheres[materialId],
-                       _ospMaterials[materialId]);
-
-    ospCommit(_ospExtendedSpheres[materialId]);
-
+    auto& geometries = _ospExtendedSpheres[materialId];
     const auto& geometryParameters = _parametersManager.getGeometryParameters();
-    if (geometryParameters.getCircuitUseSimulationModel())
-        ospAddGeometry(_simulationModel, _ospExtendedSpheres[materialId]);
-    else
-        ospAddGeometry(model, _ospExtendedSpheres[materialId]);
+    if (!geometryParameters.getCompactGeometry())
+    {
+        // Replicated primitives are copied by the scene, concurrently for all
+        // materials, and the copy is shared with OSPRay
+        if (!(_getOSPDataFlags() & OSP_DATA_SHARED_BUFFER))
+        {
+            auto& replicatedSpheres = _replicatedSpheres[materialId];
+            if (prepare)
+                replicatePrimitives(spheres, nbSpheres, replicatedSpheres);
+            spheres = reinterpret_cast<const Sphere*>(replicatedSpheres.get());
+        }
+        return _serializeChunks(materialId, "extendedspheres", spheres,
+                                nbSpheres, sizeof(Sphere), nullptr, nullptr,
+                                geometries);
+    }
 
+    // Compact primitives are copied by OSPRay. Sharing them would add them to
+    // the full precision spheres of the scene instead of replacing those.
+    auto& compactSpheres = _compactSpheres[materialId];
+    if (prepare)
+        encodePrimitives(spheres, nbSpheres, compactSpheres);
+    const auto bufferSize = _serializeChunks(
+        materialId, "extendedspheres", compactSpheres.primitives.data(),
+        nbSpheres, sizeof(CompactSphere), compactSpheres.blocks.data(),
+        [](OSPGeometry geometry) {
+            ospSet1i(geometry, "bytes_per_extended_sphere",
+                     sizeof(CompactSphere));
+            ospSet1i(geometry, "offset_center",
+                     offsetof(CompactSphere, center));
+            ospSet1i(geometry, "offset_radius",
+                     offsetof(CompactSphere, radius));
+            ospSet1i(geometry, "offset_timestamp",
+                     offsetof(CompactSphere, timestamp));
+            ospSet1i(geometry, "offset_value_x",
+                     offsetof(CompactSphere, values));
+            ospSet1i(geometry, "offset_value_y",
+                     offsetof(CompactSphere, values) + sizeof(float));
+        },
+        geometries);
+
+    _compactSpheres.erase(materialId);
     return bufferSize;
 }
 
-uint64_t OSPRayScene::_serializeCylinders(const size_t materialId)
+uint64_t OSPRayScene::_serializeCylinders(const size_t materialId,
+                                          const bool prepare)
 {
-    if (_cylinders.find(materialId) == _cylinders.end())
+    const Cylinder* cylinders = nullptr;
+    const auto nbCylinders = _getCylindersData(materialId, cylinders);
+    if (nbCylinders == 0)
         return 0;
 
-    auto model = _getActiveModel();
-    const auto& cylinders = _cylinders[materialId];
-    const auto bufferSize = cylinders.size() * sizeof(Cylinder);
-    if (_ospExtendedCylinders.find(materialId) != _ospExtendedCylinders.end())
-        ospRemoveGeometry(model, _ospExtendedCylinders[materialId]);
-
-    _ospExtendedCylinders[materialId] = ospNewGeometry("extendedcylinders");
-    _ospExtendedCylindersData[materialId] =
-        ospNewData(bufferSize / sizeof(float), OSP_FLOAT, cylinders.data(),
-                   _getOSPDataFlags());
-    ospSetObject(_ospExtendedCylinders[materialId], "extendedcylinders",
-                 _ospExtendedCylindersData[materialId]);
+    auto& geometries = _ospExtendedCylinders[materialId];
+    const auto& geometryParameters = _parametersManager.getGeometryParameters();
+    if (!geometryParameters.getCompactGeometry())
+    {
+        if (!(_getOSPDataFlags() & OSP_DATA_SHARED_BUFFER))
+        {
+            auto& replicatedCylinders = _replicatedCylinders[materialId];
+            if (prepare)
+                replicatePrimitives(cylinders, nbCylinders,
+                                    replicatedCylinders);
+            cylinders =
+                reinterpret_cast<const Cylinder*>(replicatedCylinders.get());
+        }
+        return _serializeChunks(materialId, "extendedcylinders", cylinders,
+                                nbCylinders, sizeof(Cylinder), nullptr,
+                                nullptr, geometries);
+    }
 
-    if (_ospMaterials[materialId])
-        ospSetMaterial(_ospExtendedCylinders[materialId],
-                       _ospMaterials[materialId]);
+    auto& compactCylinders = _compactCylinders[materialId];
+    if (prepare)
+        encodePrimitives(cylinders, nbCylinders, compactCylinders);
+    const auto bufferSize = _serializeChunks(
+        materialId, "extendedcylinders", compactCylinders.primitives.data(),
+        nbCylinders, sizeof(CompactCylinder), compactCylinders.blocks.data(),
+        [](OSPGeometry geometry) {
+            ospSet1i(geometry, "bytes_per_cylinder", sizeof(CompactCylinder));
+            ospSet1i(geometry, "offset_center",
+                     offsetof(CompactCylinder, center));
+            ospSet1i(geometry, "offset_up", offsetof(CompactCylinder, up));
+            ospSet1i(geometry, "offset_radius",
+                     offsetof(CompactCylinder, radius));
+            ospSet1i(geometry, "offset_timestamp",
+                     offsetof(CompactCylinder, timestamp));
+            ospSet1i(geometry, "offset_value_x",
+                     offsetof(CompactCylinder, values));
+            ospSet1i(geometry, "offset_value_y",
+                     offsetof(CompactCylinder, values) + sizeof(float));
+        },
+        geometries);
+
+    _compactCylinders.erase(materialId);
+    return bufferSize;
+}
 
-    ospCommit(_ospExtendedCylinders[materialId]);
+uint64_t OSPRayScene::_serializeCones(const size_t materialId,
+                                      const bool prepare)
+{
+    const Cone* cones = nullptr;
+    const auto nbCones = _getConesData(materialId, cones);
+    if (nbCones == 0)
+        return 0;
 
+    auto& geometries = _ospExtendedCones[materialId];
     const auto& geometryParameters = _parametersManager.getGeometryParameters();
-    if (geometryParameters.getCircuitUseSimulationModel())
-        ospAddGeometry(_simulationModel, _ospExtendedCylinders[materialId]);
-    else
-        ospAddGeometry(model, _ospExtendedCylinders[materialId]);
+    if (!geometryParameters.getCompactGeometry())
+    {
+        if (!(_getOSPDataFlags() & OSP_DATA_SHARED_BUFFER))
+        {
+            auto& replicatedCones = _replicatedCones[materialId];
+            if (prepare)
+                replicatePrimitives(cones, nbCones, replicatedCones);
+            cones = reinterpret_cast<const Cone*>(replicatedCones.get());
+        }
+        return _serializeChunks(materialId, "extendedcones", cones, nbCones,
+                                sizeof(Cone), nullptr, nullptr, geometries);
+    }
+
+    auto& compactCones = _compactCones[materialId];
+    if (prepare)
+        encodePrimitives(cones, nbCones, compactCones);
+    const auto bufferSize = _serializeChunks(
+        materialId, "extendedcones", compactCones.primitives.data(), nbCones,
+        sizeof(CompactCone), compactCones.blocks.data(),
+        [](OSPGeometry geometry) {
+            ospSet1i(geometry, "bytes_per_extended_cone", sizeof(CompactCone));
+            ospSet1i(geometry, "offset_center", offsetof(CompactCone, center));
+            ospSet1i(geometry, "offset_up", offsetof(CompactCone, up));
+            ospSet1i(geometry, "offset_centerRadius",
+                     offsetof(CompactCone, centerRadius));
+            ospSet1i(geometry, "offset_upRadius",
+                     offsetof(CompactCone, upRadius));
+            ospSet1i(geometry, "offset_timestamp",
+                     offsetof(CompactCone, timestamp));
+            ospSet1i(geometry, "offset_value_x", offsetof(CompactCone, values));
+            ospSet1i(geometry, "offset_value_y",
+                     offsetof(CompactCone, values) + sizeof(float));
+        },
+        geometries);
+
+    _compactCones.erase(materialId);
     return bufferSize;
 }
 
-uint64_t OSPRayScene::_serializeCones(const size_t materialId)
+uint64_t OSPRayScene::_serializeChunks(
+    const size_t materialId, const std::string& type, const void* primitives,
+    const uint64_t nbPrimitives, const size_t bytesPerPrimitive,
+    const Vector4f* blocks, const std::function<void(OSPGeometry)>& setLayout,
+    OSPGeometries& geometries)
 {
-    if (_cones.find(materialId) == _cones.end())
-        return 0;
-
     auto model = _getActiveModel();
-    const auto& cones = _cones[materialId];
-    const auto bufferSize = cones.size() * sizeof(Cone);
-    if (_ospExtendedCones.find(materialId) != _ospExtendedCones.end())
-        ospRemoveGeometry(model, _ospExtendedCones[materialId]);
-
-    _ospExtendedCones[materialId] = ospNewGeometry("extendedcones");
-    _ospExtendedConesData[materialId] =
-        ospNewData(bufferSize / sizeof(float), OSP_FLOAT, cones.data(),
-                   _getOSPDataFlags());
-    ospSetObject(_ospExtendedCones[materialId], "extendedcones",
-                 _ospExtendedConesData[materialId]);
+    for (auto geometry : geometries)
+    {
+        ospRemoveGeometry(model, geometry);
+        ospRelease(geometry);
+    }
+    geometries.clear();
+
+    const auto chunkSize = getChunkSize(nbPrimitives);
+    if (chunkSize < nbPrimitives)
+        BRAYNS_DEBUG << "Splitting " << nbPrimitives << " primitives of "
+                     << "material " << materialId << " into geometries of "
+                     << chunkSize << " " << type << std::endl;
+
+    // Compact primitives are always copied, see _serializeSpheres. Other
+    // primitives are either the ones of the scene or its replicated copies.
+    const uint32_t flags = blocks ? 0 : OSP_DATA_SHARED_BUFFER;
+    uint64_t bufferSize = 0;
+    for (uint64_t begin = 0; begin < nbPrimitives; begin += chunkSize)
+    {
+        const auto end = std::min(begin + chunkSize, nbPrimitives);
+        const auto chunkBytes = (end - begin) * bytesPerPrimitive;
+        OSPGeometry geometry = ospNewGeometry(type.c_str());
+
+        OSPData data =
+            ospNewData(chunkBytes / sizeof(float), OSP_FLOAT,
+                       static_cast<const uint8_t*>(primitives) +
+                           begin * bytesPerPrimitive,
+                       flags);
+        ospSetObject(geometry, type.c_str(), data);
+        ospRelease(data);
+        bufferSize += chunkBytes;
+
+        // Chunks start on a block boundary
+        if (setLayout)
+            setLayout(geometry);
+        if (blocks)
+            bufferSize += _setCompactBlocks(
+                geometry, blocks + begin / COMPACT_PRIMITIVES_PER_BLOCK,
+                (end - begin + COMPACT_PRIMITIVES_PER_BLOCK - 1) /
+                    COMPACT_PRIMITIVES_PER_BLOCK);
+
+        if (_ospMaterials[materialId])
+            ospSetMaterial(geometry, _ospMaterials[materialId]);
+
+        ospCommit(geometry);
+        ospAddGeometry(model, geometry);
+        geometries.push_back(geometry);
+    }
+    return bufferSize;
+}
 
-    if (_ospMaterials[materialId])
-        ospSetMaterial(_ospExtendedCones[materialId],
-                       _ospMaterials[materialId]);
+uint64_t OSPRayScene::_updateSpheres(const size_t materialId,
+                                     const DirtyRange& range)
+{
+    // Shared buffers are updated in place, only the geometries holding the
+    // modified primitives are committed again. Compact primitives are copied
+    // by OSPRay, and need to be encoded and serialized again.
+    const Sphere* spheres = nullptr;
+    const auto nbSpheres = _getSpheresData(materialId, spheres);
+    const auto geometries = _ospExtendedSpheres.find(materialId);
+    const auto& geometryParameters = _parametersManager.getGeometryParameters();
+    if (range.moved || geometries == _ospExtendedSpheres.end() ||
+        geometries->second.size() != getNbChunks(nbSpheres) ||
+        range.end > nbSpheres ||
+        !(_getOSPDataFlags() & OSP_DATA_SHARED_BUFFER) ||
+        geometryParameters.getCompactGeometry())
+    {
+        return _serializeSpheres(materialId);
+    }
+    commitChunks(geometries->second, nbSpheres, range.begin, range.end);
+    return (range.end - range.begin) * sizeof(Sphere);
+}
 
-    ospCommit(_ospExtendedCones[materialId]);
+uint64_t OSPRayScene::_updateCylinders(const size_t materialId,
+                                       const DirtyRange& range)
+{
+    const Cylinder* cylinders = nullptr;
+    const auto nbCylinders = _getCylindersData(materialId, cylinders);
+    const auto geometries = _ospExtendedCylinders.find(materialId);
+    const auto& geometryParameters = _parametersManager.getGeometryParameters();
+    if (range.moved || geometries == _ospExtendedCylinders.end() ||
+        geometries->second.size() != getNbChunks(nbCylinders) ||
+        range.end > nbCylinders ||
+        !(_getOSPDataFlags() & OSP_DATA_SHARED_BUFFER) ||
+        geometryParameters.getCompactGeometry())
+    {
+        return _serializeCylinders(materialId);
+    }
+    commitChunks(geometries->second, nbCylinders, range.begin, range.end);
+    return (range.end - range.begin) * sizeof(Cylinder);
+}
 
+uint64_t OSPRayScene::_updateCones(const size_t materialId,
+                                   const DirtyRange& range)
+{
+    const Cone* cones = nullptr;
+    const auto nbCones = _getConesData(materialId, cones);
+    const auto geometries = _ospExtendedCones.find(materialId);
     const auto& geometryParameters = _parametersManager.getGeometryParameters();
-    if (geometryParameters.getCircuitUseSimulationModel())
-        ospAddGeometry(_simulationModel, _ospExtendedCones[materialId]);
-    else
-        ospAddGeometry(model, _ospExtendedCones[materialId]);
-    return bufferSize;
+    if (range.moved || geometries == _ospExtendedCones.end() ||
+        geometries->second.size() != getNbChunks(nbCones) ||
+        range.end > nbCones ||
+        !(_getOSPDataFlags() & OSP_DATA_SHARED_BUFFER) ||
+        geometryParameters.getCompactGeometry())
+    {
+        return _serializeCones(materialId);
+    }
+    commitChunks(geometries->second, nbCones, range.begin, range.end);
+    return (range.end - range.begin) * sizeof(Cone);
+}
+
+uint64_t OSPRayScene::_setCompactBlocks(OSPGeometry geometry,
+                                        const Vector4f* blocks,
+                                        const uint64_t nbBlocks)
+{
+    OSPData data = ospNewData(nbBlocks, OSP_FLOAT4, blocks, 0);
+    ospSetObject(geometry, "blocks", data);
+    ospRelease(data);
+    ospSet1i(geometry, "primitives_per_block", COMPACT_PRIMITIVES_PER_BLOCK);
+    return nbBlocks * sizeof(Vector4f);
 }
 
 uint64_t OSPRayScene::_serializeMeshes(const size_t materialId)
 {
-    if (_trianglesMeshes.find(materialId) == _trianglesMeshes.end())
+    const auto mesh = _trianglesMeshes.find(materialId);
+    if (!mesh || mesh->empty())
         return 0;
 
     uint64_t size = 0;
-    _ospMeshes[materialId] = ospNewGeometry("trianglemesh");
-    assert(_ospMeshes[materialId]);
+    _ospMeshes[materialId] = _createMeshGeometry(*mesh, materialId, size);
+    ospAddGeometry(_model, _ospMeshes[materialId]);
+    return size;
+}
+
+OSPGeometry OSPRayScene::_createMeshGeometry(const TrianglesMesh& trianglesMesh,
+                                             const size_t materialId,
+                                             uint64_t& size)
+{
+    OSPGeometry geometry = ospNewGeometry("trianglemesh");
+    assert(geometry);
 
-    auto& trianglesMesh = _trianglesMeshes[materialId];
     size += trianglesMesh.vertices.size() * 3 * sizeof(float);
     OSPData vertices =
         ospNewData(trianglesMesh.vertices.size(), OSP_FLOAT3,
@@ -284,7 +747,7 @@ uint64_t OSPRayScene::_serializeMeshes(const size_t materialId)
         OSPData normals =
             ospNewData(trianglesMesh.normals.size(), OSP_FLOAT3,
                        trianglesMesh.normals.data(), _getOSPDataFlags());
-        ospSetObject(_ospMeshes[materialId], "vertex.normal", normals);
+        ospSetObject(geometry, "vertex.normal", normals);
     }
 
     size += trianglesMesh.indices.size() * 3 * sizeof(int);
@@ -298,7 +761,7 @@ uint64_t OSPRayScene::_serializeMeshes(const size_t materialId)
         OSPData colors =
             ospNewData(trianglesMesh.colors.size(), OSP_FLOAT3A,
                        trianglesMesh.colors.data(), _getOSPDataFlags());
-        ospSetObject(_ospMeshes[materialId], "vertex.color", colors);
+        ospSetObject(geometry, "vertex.color", colors);
         ospRelease(colors);
     }
 
@@ -309,26 +772,218 @@ uint64_t OSPRayScene::_serializeMeshes(const size_t materialId)
             ospNewData(trianglesMesh.textureCoordinates.size(), OSP_FLOAT2,
                        trianglesMesh.textureCoordinates.data(),
                        _getOSPDataFlags());
-        ospSetObject(_ospMeshes[materialId], "vertex.texcoord", texCoords);
+        ospSetObject(geometry, "vertex.texcoord", texCoords);
         ospRelease(texCoords);
     }
 
-    ospSetObject(_ospMeshes[materialId], "position", vertices);
+    ospSetObject(geometry, "position", vertices);
     ospRelease(vertices);
-    ospSetObject(_ospMeshes[materialId], "index", indices);
+    ospSetObject(geometry, "index", indices);
     ospRelease(indices);
-    ospSet1i(_ospMeshes[materialId], "alpha_type", 0);
-    ospSet1i(_ospMeshes[materialId], "alpha_component", 4);
+    ospSet1i(geometry, "alpha_type", 0);
+    ospSet1i(geometry, "alpha_component", 4);
 
     if (_ospMaterials[materialId])
-        ospSetMaterial(_ospMeshes[materialId], _ospMaterials[materialId]);
+        ospSetMaterial(geometry, _ospMaterials[materialId]);
+
+    ospCommit(geometry);
+    return geometry;
+}
 
-    ospCommit(_ospMeshes[materialId]);
+OSPModel OSPRayScene::_buildInstancedModel(
+    const InstancedGeometry& instancedGeometry, uint64_t& size)
+{
+    OSPModel model = ospNewModel();
+    const auto addPrimitives = [this, model, &size](
+        const char* type, const void* primitives, const uint64_t bufferSize,
+        const size_t materialId) {
+        OSPGeometry geometry = ospNewGeometry(type);
+        OSPData data = ospNewData(bufferSize / sizeof(float), OSP_FLOAT,
+                                  primitives, _getOSPDataFlags());
+        ospSetObject(geometry, type, data);
+        ospRelease(data);
+        if (_ospMaterials[materialId])
+            ospSetMaterial(geometry, _ospMaterials[materialId]);
+        ospCommit(geometry);
+        ospAddGeometry(model, geometry);
+        ospRelease(geometry);
+        size += bufferSize;
+    };
+
+    const auto& spheresMap = instancedGeometry.spheres;
+    for (size_t materialId = 0; materialId < spheresMap.size(); ++materialId)
+    {
+        const auto& spheres = *spheresMap.find(materialId);
+        if (!spheres.empty())
+            addPrimitives("extendedspheres", spheres.data(),
+                          spheres.size() * sizeof(Sphere), materialId);
+    }
 
-    ospAddGeometry(_model, _ospMeshes[materialId]);
+    const auto& cylindersMap = instancedGeometry.cylinders;
+    for (size_t materialId = 0; materialId < cylindersMap.size();
+         ++materialId)
+    {
+        const auto& cylinders = *cylindersMap.find(materialId);
+        if (!cylinders.empty())
+            addPrimitives("extendedcylinders", cylinders.data(),
+                          cylinders.size() * sizeof(Cylinder), materialId);
+    }
+
+    const auto& conesMap = instancedGeometry.cones;
+    for (size_t materialId = 0; materialId < conesMap.size(); ++materialId)
+    {
+        const auto& cones = *conesMap.find(materialId);
+        if (!cones.empty())
+            addPrimitives("extendedcones", cones.data(),
+                          cones.size() * sizeof(Cone), materialId);
+    }
+
+    const auto& meshesMap = instancedGeometry.trianglesMeshes;
+    for (size_t materialId = 0; materialId < meshesMap.size(); ++materialId)
+    {
+        const auto& mesh = *meshesMap.find(materialId);
+        if (mesh.empty())
+            continue;
+
+        OSPGeometry geometry = _createMeshGeometry(mesh, materialId, size);
+        ospAddGeometry(model, geometry);
+        ospRelease(geometry);
+    }
+    ospCommit(model);
+    return model;
+}
+
+uint64_t OSPRayScene::_buildInstances()
+{
+    uint64_t size = 0;
+    for (const auto& instancedGeometry : _instancedGeometries)
+    {
+        // Geometry is built once, in its own model
+        OSPModel model = _buildInstancedModel(*instancedGeometry, size);
+        _ospInstancedModels.push_back(model);
+
+        // ... and referenced by every instance
+        const auto& transformations = instancedGeometry->transformations;
+        const auto& simulationOffsets = instancedGeometry->simulationOffsets;
+        for (size_t i = 0; i < transformations.size(); ++i)
+        {
+            OSPGeometry instance =
+                ospNewInstance(model, toAffine(transformations[i]));
+            if (i < simulationOffsets.size())
+            {
+                // Looked up by the simulation renderer with the instance ID
+                // of the hit, see SimulationRenderer::commit()
+                const uint64_t offset = simulationOffsets[i];
+                ospSet1i(instance, "simulation_offset_high", offset >> 32);
+                ospSet1i(instance, "simulation_offset_low",
+                         offset & 0xFFFFFFFF);
+            }
+            ospCommit(instance);
+            ospAddGeometry(_model, instance);
+            _ospInstances.push_back(instance);
+        }
+    }
+    return size;
+}
+
+bool OSPRayScene::commitGeometryBatches()
+{
+    const auto batches = _takeGeometryBatches();
+    if (batches.empty())
+        return false;
+
+    size_t nbMaterials = 0;
+    for (const auto& batch : batches)
+    {
+        nbMaterials = std::max({nbMaterials, batch->spheres.size(),
+                                batch->cylinders.size(), batch->cones.size(),
+                                batch->trianglesMeshes.size()});
+        _bounds.merge(batch->bounds);
+    }
+    if (nbMaterials != 0)
+        _buildMissingMaterials(nbMaterials - 1);
+    if (_ospMaterials.size() < _materials.size())
+        commitMaterials(Action::create);
+
+    if (!_model)
+        _model = ospNewModel();
+
+    // Every batch is built in its own model, placed once in world coordinates
+    uint64_t size = 0;
+    for (const auto& batch : batches)
+    {
+        OSPModel model = _buildInstancedModel(*batch, size);
+        _ospBatchModels.push_back(model);
+
+        OSPGeometry instance = ospNewInstance(model, toAffine(Matrix4f()));
+        ospCommit(instance);
+        ospAddGeometry(_model, instance);
+        _ospBatchInstances.push_back(instance);
+    }
+    _modified = true;
+
+    BRAYNS_INFO << "Committed " << batches.size() << " geometry batches ("
+                << size / 1048576 << " MB)" << std::endl;
+    return true;
+}
+
+void OSPRayScene::_releaseGeometryBatches()
+{
+    for (auto& instance : _ospBatchInstances)
+    {
+        if (_model)
+            ospRemoveGeometry(_model, instance);
+        ospRelease(instance);
+    }
+    _ospBatchInstances.clear();
+    for (auto& model : _ospBatchModels)
+        ospRelease(model);
+    _ospBatchModels.clear();
+    _clearGeometryBatches();
+}
+
+uint64_t OSPRayScene::_buildCoarseModels()
+{
+    uint64_t size = 0;
+    for (size_t level = 0; level < NB_COARSE_LEVELS_OF_DETAIL; ++level)
+    {
+        const auto& coarseGeometry = _coarseGeometry[level];
+        if (coarseGeometry.spheres.empty() &&
+            coarseGeometry.cylinders.empty() && coarseGeometry.cones.empty())
+            continue;
+
+        // Coarse primitives replace the ones of the scene containers, other
+        // geometry is the same at every level
+        OSPModel model = _buildInstancedModel(coarseGeometry, size);
+        for (const auto& mesh : _ospMeshes)
+            if (mesh.second)
+                ospAddGeometry(model, mesh.second);
+        for (const auto& instance : _ospInstances)
+            ospAddGeometry(model, instance);
+        ospCommit(model);
+        _coarseModels[level] = model;
+    }
     return size;
 }
 
+void OSPRayScene::_releaseCoarseModels()
+{
+    for (auto& model : _coarseModels)
+    {
+        if (model)
+            ospRelease(model);
+        model = nullptr;
+    }
+}
+
+OSPModel OSPRayScene::modelImpl()
+{
+    const size_t level = size_t(_levelOfDetail);
+    if (level < NB_COARSE_LEVELS_OF_DETAIL && _coarseModels[level])
+        return _coarseModels[level];
+    return _model;
+}
+
 OSPModel OSPRayScene::_getActiveModel()
 {
     auto model = _model;
@@ -338,29 +993,152 @@ OSPModel OSPRayScene::_getActiveModel()
     return model;
 }
 
+void OSPRayScene::_sortGeometry()
+{
+    const auto startTime = std::chrono::high_resolution_clock::now();
+    const MortonEncoder encoder(_bounds);
+
+    // Mapped geometry is read-only. Cache files are saved after the geometry
+    // is built though, so their primitives are already sorted.
+    std::vector<SerializationTask> tasks;
+    for (auto& spheres : _spheres)
+        addSortingTask(tasks, spheres, encoder);
+    for (auto& cylinders : _cylinders)
+        addSortingTask(tasks, cylinders, encoder);
+    for (auto& cones : _cones)
+        addSortingTask(tasks, cones, encoder);
+
+    uint64_t nbPrimitives = 0;
+    for (const auto& task : tasks)
+        nbPrimitives += task.first;
+    runSerializationTasks(tasks);
+
+    _serializationTimes.sorting = getElapsedMilliseconds(startTime);
+    BRAYNS_INFO << "Sorted " << nbPrimitives << " primitives in "
+                << _serializationTimes.sorting << " ms" << std::endl;
+}
+
+void OSPRayScene::_encodeCompactGeometry()
+{
+    std::vector<SerializationTask> tasks;
+    for (size_t i = 0; i < _materials.size(); ++i)
+    {
+        if (_spheresDirty)
+        {
+            const Sphere* spheres = nullptr;
+            const auto nbSpheres = _getSpheresData(i, spheres);
+            addEncodingTask(tasks, _compactSpheres, i, spheres, nbSpheres);
+        }
+        if (_cylindersDirty)
+        {
+            const Cylinder* cylinders = nullptr;
+            const auto nbCylinders = _getCylindersData(i, cylinders);
+            addEncodingTask(tasks, _compactCylinders, i, cylinders,
+                            nbCylinders);
+        }
+        if (_conesDirty)
+        {
+            const Cone* cones = nullptr;
+            const auto nbCones = _getConesData(i, cones);
+            addEncodingTask(tasks, _compactCones, i, cones, nbCones);
+        }
+    }
+    runSerializationTasks(tasks);
+}
+
+void OSPRayScene::_replicateGeometry()
+{
+    std::vector<SerializationTask> tasks;
+    for (size_t i = 0; i < _materials.size(); ++i)
+    {
+        if (_spheresDirty)
+        {
+            const Sphere* spheres = nullptr;
+            const auto nbSpheres = _getSpheresData(i, spheres);
+            addReplicationTask(tasks, _replicatedSpheres, i, spheres,
+                               nbSpheres);
+        }
+        if (_cylindersDirty)
+        {
+            const Cylinder* cylinders = nullptr;
+            const auto nbCylinders = _getCylindersData(i, cylinders);
+            addReplicationTask(tasks, _replicatedCylinders, i, cylinders,
+                               nbCylinders);
+        }
+        if (_conesDirty)
+        {
+            const Cone* cones = nullptr;
+            const auto nbCones = _getConesData(i, cones);
+            addReplicationTask(tasks, _replicatedCones, i, cones, nbCones);
+        }
+    }
+    runSerializationTasks(tasks);
+}
+
 uint64_t OSPRayScene::serializeGeometry()
 {
+    // Sort once per scene only, primitives that are later updated in place
+    // (simulation handlers for instance) keep their indices
+    _serializationTimes = SerializationTimes();
+    const auto& geometryParameters = _parametersManager.getGeometryParameters();
+    if (!_geometrySorted && geometryParameters.getSpatialSorting())
+    {
+        _sortGeometry();
+        _geometrySorted = true;
+    }
+
+    // Compact primitives of all materials are encoded concurrently, and so are
+    // the copies of replicated primitives. OSPRay objects are then created by
+    // this thread only, the OSPRay API not being thread safe.
+    auto startTime = std::chrono::high_resolution_clock::now();
+    if (geometryParameters.getCompactGeometry())
+        _encodeCompactGeometry();
+    else if (!(_getOSPDataFlags() & OSP_DATA_SHARED_BUFFER))
+        _replicateGeometry();
+    _serializationTimes.preparation = getElapsedMilliseconds(startTime);
+
+    // Materials that were only partially modified are updated on their own
     uint64_t size = 0;
+    startTime = std::chrono::high_resolution_clock::now();
     if (_spheresDirty)
         for (size_t i = 0; i < _materials.size(); ++i)
-            size += _serializeSpheres(i);
+            size += _serializeSpheres(i, false);
+    else
+        for (const auto& range : _dirtySpheres)
+            size += _updateSpheres(range.first, range.second);
+    _serializationTimes.spheres = getElapsedMilliseconds(startTime);
 
+    startTime = std::chrono::high_resolution_clock::now();
     if (_cylindersDirty)
         for (size_t i = 0; i < _materials.size(); ++i)
-            size += _serializeCylinders(i);
+            size += _serializeCylinders(i, false);
+    else
+        for (const auto& range : _dirtyCylinders)
+            size += _updateCylinders(range.first, range.second);
+    _serializationTimes.cylinders = getElapsedMilliseconds(startTime);
 
+    startTime = std::chrono::high_resolution_clock::now();
     if (_conesDirty)
         for (size_t i = 0; i < _materials.size(); ++i)
-            size += _serializeCones(i);
+            size += _serializeCones(i, false);
+    else
+        for (const auto& range : _dirtyCones)
+            size += _updateCones(range.first, range.second);
+    _serializationTimes.cones = getElapsedMilliseconds(startTime);
 
+    startTime = std::chrono::high_resolution_clock::now();
     if (_trianglesMeshesDirty)
         for (size_t i = 0; i < _materials.size(); ++i)
             size += _serializeMeshes(i);
+    _serializationTimes.meshes = getElapsedMilliseconds(startTime);
 
     _spheresDirty = false;
     _cylindersDirty = false;
     _conesDirty = false;
     _trianglesMeshesDirty = false;
+    _dirtySpheres.clear();
+    _dirtyCylinders.clear();
+    _dirtyCones.clear();
     return size;
 }
 
@@ -372,29 +1150,44 @@ void OSPRayScene::buildGeometry()
 
     const auto& geomParams = _parametersManager.getGeometryParameters();
 
+    // Geometry rendered while the scene was loading is replaced by the
+    // geometry of the whole scene
+    _releaseGeometryBatches();
+    _releaseCoarseModels();
+    if (_model)
+        ospRelease(_model);
     _model = ospNewModel();
 
     if (geomParams.getCircuitUseSimulationModel() && !_simulationModel)
         _simulationModel = ospNewModel();
 
-    const size_t size = serializeGeometry();
-
-    size_t totalNbSpheres = 0;
-    size_t totalNbCylinders = 0;
-    size_t totalNbCones = 0;
+    size_t size = serializeGeometry();
+    auto startTime = std::chrono::high_resolution_clock::now();
+    size += _buildInstances();
+    const auto instancesTime = getElapsedMilliseconds(startTime);
+    startTime = std::chrono::high_resolution_clock::now();
+    size += _buildCoarseModels();
+    const auto coarseModelsTime = getElapsedMilliseconds(startTime);
+
+    size_t totalNbSpheres = _spheres.getNbElements();
+    size_t totalNbCylinders = _cylinders.getNbElements();
+    size_t totalNbCones = _cones.getNbElements();
     size_t totalNbVertices = 0;
     size_t totalNbIndices = 0;
-    for (const auto& spheres : _spheres)
-        totalNbSpheres += spheres.second.size();
-    for (const auto& cylinders : _cylinders)
-        totalNbCylinders += cylinders.second.size();
-    for (const auto& cones : _cones)
-        totalNbCones += cones.second.size();
-    for (const auto& trianglesMeshes : _trianglesMeshes)
+    for (const auto& mapped : _mappedGeometry)
+    {
+        totalNbSpheres += mapped.second.nbSpheres;
+        totalNbCylinders += mapped.second.nbCylinders;
+        totalNbCones += mapped.second.nbCones;
+    }
+    for (const auto& trianglesMesh : _trianglesMeshes)
     {
-        totalNbVertices += trianglesMeshes.second.vertices.size();
-        totalNbIndices += trianglesMeshes.second.indices.size();
+        totalNbVertices += trianglesMesh.vertices.size();
+        totalNbIndices += trianglesMesh.indices.size();
     }
+    size_t totalNbInstances = 0;
+    for (const auto& instancedGeometry : _instancedGeometries)
+        totalNbInstances += instancedGeometry->transformations.size();
 
     BRAYNS_INFO << "---------------------------------------------------"
                 << std::endl;
@@ -404,13 +1197,42 @@ void OSPRayScene::buildGeometry()
     BRAYNS_INFO << "Cones    : " << totalNbCones << std::endl;
     BRAYNS_INFO << "Vertices : " << totalNbVertices << std::endl;
     BRAYNS_INFO << "Indices  : " << totalNbIndices << std::endl;
+    BRAYNS_INFO << "Instances: " << totalNbInstances << " of "
+                << _instancedGeometries.size() << " geometries" << std::endl;
     BRAYNS_INFO << "Materials: " << _materials.size() << std::endl;
     BRAYNS_INFO << "Total    : " << size << " bytes (" << size / 1048576
                 << " MB)" << std::endl;
+    BRAYNS_INFO << "Sorting  : " << _serializationTimes.sorting << " ms"
+                << std::endl;
+    BRAYNS_INFO << "Prepared : " << _serializationTimes.preparation << " ms"
+                << std::endl;
+    BRAYNS_INFO << "Commits  : " << _serializationTimes.spheres
+                << " ms spheres, " << _serializationTimes.cylinders
+                << " ms cylinders, " << _serializationTimes.cones
+                << " ms cones, " << _serializationTimes.meshes << " ms meshes"
+                << std::endl;
+    BRAYNS_INFO << "Instanced: " << instancesTime << " ms" << std::endl;
+    BRAYNS_INFO << "LODs     : " << coarseModelsTime << " ms" << std::endl;
     BRAYNS_INFO << "---------------------------------------------------"
                 << std::endl;
 }
 
+void OSPRayScene::commitSpheres(const size_t materialId)
+{
+    // Spheres that are not serialized yet are built with the rest of the scene
+    if (_ospExtendedSpheres.find(materialId) == _ospExtendedSpheres.end())
+    {
+        Scene::commitSpheres(materialId);
+        return;
+    }
+
+    // In shared memory mode, the new geometry points to the spheres of the
+    // scene, and the other materials keep their OSPRay geometry
+    _serializeSpheres(materialId);
+    _dirtySpheres.erase(materialId);
+    _modified = true;
+}
+
 void OSPRayScene::commitLights()
 {
     size_t lightCount = 0;
@@ -664,26 +1486,64 @@ void OSPRayScene::commitSimulationData()
     if (!frameData)
         return;
 
-    if (_ospSimulationData)
-        ospRelease(_ospSimulationData);
-    _ospSimulationData = ospNewData(_simulationHandler->getFrameSize(),
-                                    OSP_FLOAT, frameData, _getOSPDataFlags());
-    ospCommit(_ospSimulationData);
-
-    for (const auto& renderer : _renderers)
+    const uint64_t frameSize = _simulationHandler->getFrameSize();
+    const size_t back = 1 - _frontSimulationBuffer;
+    auto& ospData = _ospSimulationData[back];
+    auto& buffer = _simulationBuffers[back];
+    auto& wrappedHandler = _wrappedSimulationHandlers[back];
+    if ((_getOSPDataFlags() & OSP_DATA_SHARED_BUFFER) &&
+        _simulationHandler->hasPersistentFrameData())
     {
-        OSPRayRenderer* osprayRenderer =
-            dynamic_cast<OSPRayRenderer*>(renderer.get());
-
-        ospSetData(osprayRenderer->impl(), "simulationData",
-                   _ospSimulationData);
-        ospSet1i(osprayRenderer->impl(), "simulationDataSize",
-                 _simulationHandler->getFrameSize());
-        ospCommit(osprayRenderer->impl());
+        // Frames of memory mapped cache files are wrapped in place, renderers
+        // switch to the new handle when they are committed
+        if (ospData)
+            ospRelease(ospData);
+        ospData = ospNewData(frameSize, OSP_FLOAT, frameData,
+                             OSP_DATA_SHARED_BUFFER);
+        ospCommit(ospData);
+        wrappedHandler = _simulationHandler;
+        buffer.clear();
+        buffer.shrink_to_fit();
+    }
+    else
+    {
+        // Other frames are copied into the back buffer, whose handle is only
+        // created when the frame size changes. OSPRay 1.x cannot update data
+        // it owns, so the buffers are shared with OSPRay whatever the memory
+        // mode, which only applies to the geometry.
+        if (!ospData || wrappedHandler || buffer.size() != frameSize)
+        {
+            if (ospData)
+                ospRelease(ospData);
+            buffer.resize(frameSize);
+            ospData = ospNewData(frameSize, OSP_FLOAT, buffer.data(),
+                                 OSP_DATA_SHARED_BUFFER);
+            ospCommit(ospData);
+            wrappedHandler.reset();
+        }
+        parallelCopy(frameData, frameSize * sizeof(float), buffer.data());
     }
+
+    // Only the active renderer binds the new buffer, when it is committed
+    _frontSimulationBuffer = back;
+    _simulationDataSize = frameSize;
     _modified = true;
 }
 
+void OSPRayScene::_releaseSimulationData()
+{
+    for (size_t i = 0; i < 2; ++i)
+    {
+        if (_ospSimulationData[i])
+            ospRelease(_ospSimulationData[i]);
+        _ospSimulationData[i] = nullptr;
+        _simulationBuffers[i].clear();
+        _simulationBuffers[i].shrink_to_fit();
+        _wrappedSimulationHandlers[i].reset();
+    }
+    _simulationDataSize = 0;
+}
+
 OSPTexture2D OSPRayScene::_createTexture2D(const std::string& textureName)
 {
     if (_ospTextures.find(textureName) != _ospTextures.end())
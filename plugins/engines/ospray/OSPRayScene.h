@@ -23,12 +23,16 @@
 
 #include <brayns/common/scene/Scene.h>
 #include <brayns/common/types.h>
+#include <plugins/engines/ospray/ispc/geometry/CompactPrimitives.h>
 
 #include <ospray_cpp/Data.h>
 #include <ospray_cpp/Light.h>
 #include <ospray_cpp/Model.h>
 #include <ospray_cpp/Texture2D.h>
 
+#include <functional>
+#include <memory>
+
 namespace brayns
 {
 /**
@@ -53,6 +57,9 @@ public:
     /** @copydoc Scene::serializeGeometry */
     uint64_t serializeGeometry() final;
 
+    /** @copydoc Scene::commitGeometryBatches */
+    bool commitGeometryBatches() final;
+
     /** @copydoc Scene::commitLights */
     void commitLights() final;
 
@@ -62,6 +69,9 @@ public:
     /** @copydoc Scene::commitSimulationData */
     void commitSimulationData() final;
 
+    /** @copydoc Scene::commitSpheres */
+    void commitSpheres(size_t materialId) final;
+
     /** @copydoc Scene::commitVolumeData */
     void commitVolumeData() final;
 
@@ -74,16 +84,89 @@ public:
     /** @copydoc Scene::isVolumeSupported */
     bool isVolumeSupported(const std::string& volumeFile) const final;
 
-    OSPModel modelImpl() { return _model; }
+    /** @copydoc Scene::supportsMappedGeometry */
+    bool supportsMappedGeometry() const final { return true; }
+
+    /** @copydoc Scene::supportsInstancing */
+    bool supportsInstancing() const final { return true; }
+
+    /** @return the model of the selected level of detail */
+    OSPModel modelImpl();
     OSPModel simulationModelImpl() { return _simulationModel; }
+    /**
+     * @return the simulation data of the current frame, bound by renderers
+     *         when they are committed, or nullptr if there is none
+     */
+    OSPData simulationDataImpl() const
+    {
+        return _ospSimulationData[_frontSimulationBuffer];
+    }
+    uint64_t getSimulationDataSize() const { return _simulationDataSize; }
+    /**
+     * @return the number of times the models were committed, renderers
+     *         commit again when it changes since they depend on the geometry
+     *         of the models (instance offsets for instance)
+     */
+    uint64_t getModelVersion() const { return _modelVersion; }
 private:
     OSPTexture2D _createTexture2D(const std::string& textureName);
     OSPModel _getActiveModel();
     uint32_t _getOSPDataFlags();
-    uint64_t _serializeSpheres(const size_t materialId);
-    uint64_t _serializeCylinders(const size_t materialId);
-    uint64_t _serializeCones(const size_t materialId);
+    // Primitives that are not prepared must already be encoded in the compact
+    // maps, or copied in the replicated ones
+    uint64_t _serializeSpheres(const size_t materialId, bool prepare = true);
+    uint64_t _serializeCylinders(const size_t materialId, bool prepare = true);
+    uint64_t _serializeCones(const size_t materialId, bool prepare = true);
     uint64_t _serializeMeshes(const size_t materialId);
+    uint64_t _updateSpheres(size_t materialId, const DirtyRange& range);
+    uint64_t _updateCylinders(size_t materialId, const DirtyRange& range);
+    uint64_t _updateCones(size_t materialId, const DirtyRange& range);
+    typedef std::vector<OSPGeometry> OSPGeometries;
+
+    /**
+     * Replaces the geometries of a material by new ones, splitting primitives
+     * into balanced chunks that the extended geometries can address. Blocks
+     * and layout are only given for compact primitives, which are always
+     * copied by OSPRay whatever the memory mode. Other primitives are shared
+     * with OSPRay, replicated ones being copies owned by the scene.
+     */
+    uint64_t _serializeChunks(const size_t materialId, const std::string& type,
+                              const void* primitives, uint64_t nbPrimitives,
+                              size_t bytesPerPrimitive, const Vector4f* blocks,
+                              const std::function<void(OSPGeometry)>& setLayout,
+                              OSPGeometries& geometries);
+    uint64_t _setCompactBlocks(OSPGeometry geometry, const Vector4f* blocks,
+                               uint64_t nbBlocks);
+    OSPGeometry _createMeshGeometry(const TrianglesMesh& trianglesMesh,
+                                    const size_t materialId, uint64_t& size);
+    OSPModel _buildInstancedModel(const InstancedGeometry& instancedGeometry,
+                                  uint64_t& size);
+    uint64_t _buildInstances();
+    void _releaseGeometryBatches();
+    uint64_t _buildCoarseModels();
+    void _releaseCoarseModels();
+    void _releaseSimulationData();
+
+    /**
+     * Sorts the spheres, cylinders and cones of every material along a Morton
+     * curve, so that primitives close in space are also close in memory. This
+     * speeds up the BVH construction and improves memory coherence during
+     * traversal.
+     */
+    void _sortGeometry();
+
+    /**
+     * Encodes the compact primitives of the materials whose spheres, cylinders
+     * or cones are dirty, one task per material and type of primitive.
+     */
+    void _encodeCompactGeometry();
+
+    /**
+     * Copies the primitives of the materials whose spheres, cylinders or cones
+     * are dirty in replicated memory mode, one task per material and type of
+     * primitive.
+     */
+    void _replicateGeometry();
 
     OSPModel _model;
     OSPModel _simulationModel;
@@ -94,17 +177,60 @@ private:
     OSPData _ospLightData;
     OSPData _ospMaterialData;
     OSPData _ospVolumeData;
-    OSPData _ospSimulationData;
+
+    // Simulation frames are copied into the back buffer while renderers read
+    // the front one. Buffers and their handles are only recreated when the
+    // frame size changes. In shared memory mode, persistent frames are wrapped
+    // without any copy instead, and their handler is kept alive as long as
+    // OSPRay references them.
+    floats _simulationBuffers[2];
+    AbstractSimulationHandlerPtr _wrappedSimulationHandlers[2];
+    OSPData _ospSimulationData[2]{nullptr, nullptr};
+    size_t _frontSimulationBuffer{0};
+    uint64_t _simulationDataSize{0};
+    uint64_t _modelVersion{0};
+
     OSPData _ospTransferFunctionDiffuseData;
     OSPData _ospTransferFunctionEmissionData;
 
-    std::map<size_t, OSPGeometry> _ospExtendedSpheres;
-    std::map<size_t, OSPData> _ospExtendedSpheresData;
-    std::map<size_t, OSPGeometry> _ospExtendedCylinders;
-    std::map<size_t, OSPData> _ospExtendedCylindersData;
-    std::map<size_t, OSPGeometry> _ospExtendedCones;
-    std::map<size_t, OSPData> _ospExtendedConesData;
+    // Large materials are split into several geometries
+    std::map<size_t, OSPGeometries> _ospExtendedSpheres;
+    std::map<size_t, OSPGeometries> _ospExtendedCylinders;
+    std::map<size_t, OSPGeometries> _ospExtendedCones;
     std::map<size_t, OSPGeometry> _ospMeshes;
+    std::vector<OSPModel> _ospInstancedModels;
+    std::vector<OSPGeometry> _ospInstances;
+    std::vector<OSPModel> _ospBatchModels;
+    std::vector<OSPGeometry> _ospBatchInstances;
+
+    // Coarse levels of detail, sharing the meshes and instances of _model
+    OSPModel _coarseModels[NB_COARSE_LEVELS_OF_DETAIL]{};
+
+    // Compact primitives encoded ahead of serialization, released as soon as
+    // OSPRay holds its own copy
+    std::map<size_t, CompactGeometry<CompactSphere>> _compactSpheres;
+    std::map<size_t, CompactGeometry<CompactCylinder>> _compactCylinders;
+    std::map<size_t, CompactGeometry<CompactCone>> _compactCones;
+
+    // Copies of the primitives in replicated memory mode, shared with OSPRay
+    // as long as the geometries of their material
+    std::map<size_t, std::unique_ptr<uint8_t[]>> _replicatedSpheres;
+    std::map<size_t, std::unique_ptr<uint8_t[]>> _replicatedCylinders;
+    std::map<size_t, std::unique_ptr<uint8_t[]>> _replicatedCones;
+
+    bool _geometrySorted{false};
+
+    // Durations of the phases of the last serialization, in milliseconds
+    struct SerializationTimes
+    {
+        uint64_t sorting{0};
+        uint64_t preparation{0};
+        uint64_t spheres{0};
+        uint64_t cylinders{0};
+        uint64_t cones{0};
+        uint64_t meshes{0};
+    };
+    SerializationTimes _serializationTimes;
 };
 }
 #endif // OSPRAYSCENE_H
@@ -0,0 +1,270 @@
+/* Copyright (c) 2015-2017, EPFL/Blue Brain Project
+ * All rights reserved. Do not distribute without permission.
+ * Responsible Author: Cyrille Favreau <cyrille.favreau@epfl.ch>
+ *
+ * This file is part of Brayns <https://github.com/BlueBrain/Brayns>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "CompactPrimitives.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace
+{
+const float QUANTIZATION_LEVELS = 65535.f;
+
+// IEEE 754 binary16, rounded to nearest. Decoded by half_to_float in ISPC.
+uint16_t floatToHalf(const float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+
+    const uint16_t sign = (bits >> 16) & 0x8000;
+    const int32_t exponent = int32_t((bits >> 23) & 0xff) - 127 + 15;
+    uint32_t mantissa = bits & 0x7fffff;
+
+    if (((bits >> 23) & 0xff) == 0xff)
+        return sign | 0x7c00 | (mantissa ? 0x200 : 0);
+    if (exponent >= 31)
+        return sign | 0x7c00;
+    if (exponent <= 0)
+    {
+        // Subnormal
+        if (exponent < -10)
+            return sign;
+        mantissa |= 0x800000;
+        const uint32_t shift = 14 - exponent;
+        uint16_t half = mantissa >> shift;
+        if ((mantissa >> (shift - 1)) & 1)
+            ++half;
+        return sign | half;
+    }
+
+    // A carry out of the mantissa correctly increments the exponent
+    uint16_t half = sign | (exponent << 10) | (mantissa >> 13);
+    if (mantissa & 0x1000)
+        ++half;
+    return half;
+}
+
+brayns::Vector4f getBlock(const brayns::Boxf& bounds)
+{
+    const auto size = bounds.getSize();
+    const float extent = std::max(size.x(), std::max(size.y(), size.z()));
+    const auto& origin = bounds.getMin();
+    return brayns::Vector4f(origin.x(), origin.y(), origin.z(),
+                            extent / QUANTIZATION_LEVELS);
+}
+
+void quantize(const brayns::Vector4f& block, const brayns::Vector3f& position,
+              uint16_t* result)
+{
+    for (size_t i = 0; i < 3; ++i)
+    {
+        const float value =
+            block.w() > 0.f ? (position[i] - block[i]) / block.w() : 0.f;
+        result[i] = uint16_t(
+            std::min(QUANTIZATION_LEVELS, std::max(0.f, std::round(value))));
+    }
+}
+
+void merge(brayns::Boxf& bounds, const brayns::Sphere& sphere)
+{
+    bounds.merge(sphere.center);
+}
+
+void merge(brayns::Boxf& bounds, const brayns::Cylinder& cylinder)
+{
+    bounds.merge(cylinder.center);
+    bounds.merge(cylinder.up);
+}
+
+void merge(brayns::Boxf& bounds, const brayns::Cone& cone)
+{
+    bounds.merge(cone.center);
+    bounds.merge(cone.up);
+}
+
+void encode(const brayns::Vector4f& block, const brayns::Sphere& sphere,
+            brayns::CompactSphere& compactSphere)
+{
+    quantize(block, sphere.center, compactSphere.center);
+    compactSphere.radius = floatToHalf(sphere.radius);
+    compactSphere.values[0] = sphere.values.x();
+    compactSphere.values[1] = sphere.values.y();
+    compactSphere.timestamp = floatToHalf(sphere.timestamp);
+    compactSphere.padding = 0;
+}
+
+void encode(const brayns::Vector4f& block, const brayns::Cylinder& cylinder,
+            brayns::CompactCylinder& compactCylinder)
+{
+    quantize(block, cylinder.center, compactCylinder.center);
+    quantize(block, cylinder.up, compactCylinder.up);
+    compactCylinder.radius = floatToHalf(cylinder.radius);
+    compactCylinder.timestamp = floatToHalf(cylinder.timestamp);
+    compactCylinder.values[0] = cylinder.values.x();
+    compactCylinder.values[1] = cylinder.values.y();
+}
+
+void encode(const brayns::Vector4f& block, const brayns::Cone& cone,
+            brayns::CompactCone& compactCone)
+{
+    quantize(block, cone.center, compactCone.center);
+    quantize(block, cone.up, compactCone.up);
+    compactCone.centerRadius = floatToHalf(cone.centerRadius);
+    compactCone.upRadius = floatToHalf(cone.upRadius);
+    compactCone.values[0] = cone.values.x();
+    compactCone.values[1] = cone.values.y();
+    compactCone.timestamp = floatToHalf(cone.timestamp);
+    compactCone.padding = 0;
+}
+
+template <typename T, typename C>
+void encodeBlocks(const T* primitives, const uint64_t nbPrimitives,
+                  const int64_t firstBlock, const int64_t endBlock,
+                  brayns::CompactGeometry<C>& compactGeometry)
+{
+#pragma omp parallel for
+    for (int64_t i = firstBlock; i < endBlock; ++i)
+    {
+        const uint64_t begin = i * brayns::COMPACT_PRIMITIVES_PER_BLOCK;
+        const uint64_t end = std::min<uint64_t>(
+            begin + brayns::COMPACT_PRIMITIVES_PER_BLOCK, nbPrimitives);
+
+        brayns::Boxf bounds;
+        for (uint64_t j = begin; j < end; ++j)
+            merge(bounds, primitives[j]);
+
+        const auto block = getBlock(bounds);
+        compactGeometry.blocks[i] = block;
+        for (uint64_t j = begin; j < end; ++j)
+            encode(block, primitives[j], compactGeometry.primitives[j]);
+    }
+}
+
+template <typename T, typename C>
+void encodeBlocks(const T* primitives, const uint64_t nbPrimitives,
+                  brayns::CompactGeometry<C>& compactGeometry)
+{
+    const int64_t nbBlocks =
+        (nbPrimitives + brayns::COMPACT_PRIMITIVES_PER_BLOCK - 1) /
+        brayns::COMPACT_PRIMITIVES_PER_BLOCK;
+    compactGeometry.primitives.resize(nbPrimitives);
+    compactGeometry.blocks.resize(nbBlocks);
+    encodeBlocks(primitives, nbPrimitives, 0, nbBlocks, compactGeometry);
+}
+
+// Inverse of floatToHalf, mirrors half_to_float in ISPC
+float halfToFloat(const uint16_t half)
+{
+    const uint32_t sign = uint32_t(half & 0x8000) << 16;
+    const uint32_t exponent = (half >> 10) & 0x1f;
+    const uint32_t mantissa = half & 0x3ff;
+
+    float value;
+    if (exponent == 0)
+        value = std::ldexp(float(mantissa), -24);
+    else if (exponent == 31)
+        value = mantissa ? std::numeric_limits<float>::quiet_NaN()
+                         : std::numeric_limits<float>::infinity();
+    else
+        value = std::ldexp(float(mantissa | 0x400), int(exponent) - 25);
+
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    bits |= sign;
+    memcpy(&value, &bits, sizeof(bits));
+    return value;
+}
+
+brayns::Vector3f dequantize(const brayns::Vector4f& block,
+                            const uint16_t* steps)
+{
+    return brayns::Vector3f(block.x() + block.w() * steps[0],
+                            block.y() + block.w() * steps[1],
+                            block.z() + block.w() * steps[2]);
+}
+
+template <typename C>
+const brayns::Vector4f& getBlock(const brayns::CompactGeometry<C>& geometry,
+                                 const uint64_t index)
+{
+    return geometry.blocks[index / brayns::COMPACT_PRIMITIVES_PER_BLOCK];
+}
+}
+
+namespace brayns
+{
+void encodePrimitives(const Sphere* spheres, const uint64_t nbSpheres,
+                      CompactGeometry<CompactSphere>& compactSpheres)
+{
+    encodeBlocks(spheres, nbSpheres, compactSpheres);
+}
+
+void encodePrimitives(const Cylinder* cylinders, const uint64_t nbCylinders,
+                      CompactGeometry<CompactCylinder>& compactCylinders)
+{
+    encodeBlocks(cylinders, nbCylinders, compactCylinders);
+}
+
+void encodePrimitives(const Cone* cones, const uint64_t nbCones,
+                      CompactGeometry<CompactCone>& compactCones)
+{
+    encodeBlocks(cones, nbCones, compactCones);
+}
+
+Sphere decodePrimitive(const CompactGeometry<CompactSphere>& compactSpheres,
+                       const uint64_t index)
+{
+    const auto& block = getBlock(compactSpheres, index);
+    const auto& compactSphere = compactSpheres.primitives[index];
+    return Sphere(dequantize(block, compactSphere.center),
+                  halfToFloat(compactSphere.radius),
+                  halfToFloat(compactSphere.timestamp),
+                  Vector2f(compactSphere.values[0], compactSphere.values[1]));
+}
+
+Cylinder decodePrimitive(
+    const CompactGeometry<CompactCylinder>& compactCylinders,
+    const uint64_t index)
+{
+    const auto& block = getBlock(compactCylinders, index);
+    const auto& compactCylinder = compactCylinders.primitives[index];
+    return Cylinder(dequantize(block, compactCylinder.center),
+                    dequantize(block, compactCylinder.up),
+                    halfToFloat(compactCylinder.radius),
+                    halfToFloat(compactCylinder.timestamp),
+                    Vector2f(compactCylinder.values[0],
+                             compactCylinder.values[1]));
+}
+
+Cone decodePrimitive(const CompactGeometry<CompactCone>& compactCones,
+                     const uint64_t index)
+{
+    const auto& block = getBlock(compactCones, index);
+    const auto& compactCone = compactCones.primitives[index];
+    return Cone(dequantize(block, compactCone.center),
+                dequantize(block, compactCone.up),
+                halfToFloat(compactCone.centerRadius),
+                halfToFloat(compactCone.upRadius),
+                halfToFloat(compactCone.timestamp),
+                Vector2f(compactCone.values[0], compactCone.values[1]));
+}
+}
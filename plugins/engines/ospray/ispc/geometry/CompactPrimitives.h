@@ -0,0 +1,101 @@
+/* Copyright (c) 2015-2017, EPFL/Blue Brain Project
+ * All rights reserved. Do not distribute without permission.
+ * Responsible Author: Cyrille Favreau <cyrille.favreau@epfl.ch>
+ *
+ * This file is part of Brayns <https://github.com/BlueBrain/Brayns>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#pragma once
+
+#include <brayns/common/geometry/Cone.h>
+#include <brayns/common/geometry/Cylinder.h>
+#include <brayns/common/geometry/Sphere.h>
+#include <brayns/common/types.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace brayns
+{
+/** Number of consecutive primitives sharing the same quantization block */
+const size_t COMPACT_PRIMITIVES_PER_BLOCK = 256;
+
+/*
+ * Compact primitives, decoded by the extended geometries of the OSPRay engine
+ * (see CompactPrimitives.ih). Positions are quantized on 16 bits relative to
+ * the block the primitive belongs to, radii and timestamps are half floats.
+ * Values are kept as floats since they encode simulation offsets.
+ */
+struct CompactSphere
+{
+    uint16_t center[3];
+    uint16_t radius;
+    float values[2];
+    uint16_t timestamp;
+    uint16_t padding;
+};
+
+struct CompactCylinder
+{
+    uint16_t center[3];
+    uint16_t up[3];
+    uint16_t radius;
+    uint16_t timestamp;
+    float values[2];
+};
+
+struct CompactCone
+{
+    uint16_t center[3];
+    uint16_t up[3];
+    uint16_t centerRadius;
+    uint16_t upRadius;
+    float values[2];
+    uint16_t timestamp;
+    uint16_t padding;
+};
+
+/**
+ * Compact encoding of the primitives of a material. Every block holds the
+ * origin of COMPACT_PRIMITIVES_PER_BLOCK consecutive primitives in xyz, and
+ * the size of the quantization step in w.
+ */
+template <typename T>
+struct CompactGeometry
+{
+    std::vector<T> primitives;
+    Vector4fs blocks;
+};
+
+/** Encodes primitives, blocks being computed on all available cores */
+void encodePrimitives(const Sphere* spheres, uint64_t nbSpheres,
+                      CompactGeometry<CompactSphere>& compactSpheres);
+void encodePrimitives(const Cylinder* cylinders, uint64_t nbCylinders,
+                      CompactGeometry<CompactCylinder>& compactCylinders);
+void encodePrimitives(const Cone* cones, uint64_t nbCones,
+                      CompactGeometry<CompactCone>& compactCones);
+
+/**
+ * Decodes the primitive at the given index the way the extended geometries
+ * do, which gives the precision actually rendered
+ */
+Sphere decodePrimitive(const CompactGeometry<CompactSphere>& compactSpheres,
+                       uint64_t index);
+Cylinder decodePrimitive(
+    const CompactGeometry<CompactCylinder>& compactCylinders, uint64_t index);
+Cone decodePrimitive(const CompactGeometry<CompactCone>& compactCones,
+                     uint64_t index);
+}
@@ -50,6 +50,8 @@ void ExtendedCones::finalize(ospray::Model *model)
     offset_value_y = getParam1i("offset_value_y", 10 * sizeof(float));
     offset_materialID = getParam1i("offset_materialID", -1);
     data = getParamData("extendedcones", nullptr);
+    blocks = getParamData("blocks", nullptr);
+    primitivesPerBlock = getParam1i("primitives_per_block", 0);
 
     if (data.ptr == nullptr || bytesPerCone == 0)
         throw std::runtime_error(
@@ -57,12 +59,13 @@ void ExtendedCones::finalize(ospray::Model *model)
             "no 'extendedcones' data specified");
     numExtendedCones = data->numBytes / bytesPerCone;
     ispc::ExtendedConesGeometry_set(getIE(), model->getIE(), data->data,
-                                    numExtendedCones, bytesPerCone, radius,
-                                    length, materialID, offset_center,
-                                    offset_up, offset_centerRadius,
-                                    offset_upRadius, offset_timestamp,
-                                    offset_value_x, offset_value_y,
-                                    offset_materialID);
+                                    blocks ? blocks->data : nullptr,
+                                    primitivesPerBlock, numExtendedCones,
+                                    bytesPerCone, radius, length, materialID,
+                                    offset_center, offset_up,
+                                    offset_centerRadius, offset_upRadius,
+                                    offset_timestamp, offset_value_x,
+                                    offset_value_y, offset_materialID);
 }
 
 OSP_REGISTER_GEOMETRY(ExtendedCones, extendedcones);
@@ -48,6 +48,10 @@ struct ExtendedCones : public ospray::Geometry
 
     ospray::Ref<ospray::Data> data;
 
+    // Quantization blocks of compact cones, see CompactPrimitives.h
+    ospray::Ref<ospray::Data> blocks;
+    int32 primitivesPerBlock;
+
     ExtendedCones();
 };
 
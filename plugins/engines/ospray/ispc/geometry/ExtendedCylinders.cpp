@@ -47,6 +47,8 @@ void ExtendedCylinders::finalize(ospray::Model *model)
     offset_value_y = getParam1i("offset_value_y", 9 * sizeof(float));
     offset_materialID = getParam1i("offset_materialID", -1);
     data = getParamData("extendedcylinders", nullptr);
+    blocks = getParamData("blocks", nullptr);
+    primitivesPerBlock = getParam1i("primitives_per_block", 0);
 
     if (data.ptr == nullptr || bytesPerCylinder == 0)
         throw std::runtime_error(
@@ -54,6 +56,8 @@ void ExtendedCylinders::finalize(ospray::Model *model)
             "no 'extendedcylinders' data specified");
     numExtendedCylinders = data->numBytes / bytesPerCylinder;
     ispc::ExtendedCylindersGeometry_set(getIE(), model->getIE(), data->data,
+                                        blocks ? blocks->data : nullptr,
+                                        primitivesPerBlock,
                                         numExtendedCylinders, bytesPerCylinder,
                                         radius, materialID, offset_center,
                                         offset_up, offset_radius,
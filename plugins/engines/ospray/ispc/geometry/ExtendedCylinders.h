@@ -44,6 +44,10 @@ struct ExtendedCylinders : public ospray::Geometry
 
     ospray::Ref<ospray::Data> data;
 
+    // Quantization blocks of compact cylinders, see CompactPrimitives.h
+    ospray::Ref<ospray::Data> blocks;
+    int32 primitivesPerBlock;
+
     ExtendedCylinders();
 };
 
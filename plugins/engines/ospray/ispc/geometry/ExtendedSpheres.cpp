@@ -48,6 +48,8 @@ void ExtendedSpheres::finalize(ospray::Model *model)
     offset_materialID = getParam1i("offset_materialID", -1);
     data = getParamData("extendedspheres", nullptr);
     materialList = getParamData("materialList", nullptr);
+    blocks = getParamData("blocks", nullptr);
+    primitivesPerBlock = getParam1i("primitives_per_block", 0);
 
     if (data.ptr == nullptr)
         throw std::runtime_error(
@@ -83,7 +85,9 @@ void ExtendedSpheres::finalize(ospray::Model *model)
         ispcMaterialList = static_cast<void *>(ispcMaterials_.data());
     }
     ispc::ExtendedSpheresGeometry_set(getIE(), model->getIE(), data->data,
-                                      ispcMaterialList, numExtendedSpheres,
+                                      ispcMaterialList,
+                                      blocks ? blocks->data : nullptr,
+                                      primitivesPerBlock, numExtendedSpheres,
                                       bytesPerExtendedSphere, radius,
                                       materialID, offset_center, offset_radius,
                                       offset_timestamp, offset_value_x,
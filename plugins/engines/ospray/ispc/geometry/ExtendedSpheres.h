@@ -46,6 +46,10 @@ struct ExtendedSpheres : public ospray::Geometry
     ospray::Ref<ospray::Data> data;
     ospray::Ref<ospray::Data> materialList;
 
+    // Quantization blocks of compact spheres, see CompactPrimitives.h
+    ospray::Ref<ospray::Data> blocks;
+    int32 primitivesPerBlock;
+
     ExtendedSpheres();
 
 private:
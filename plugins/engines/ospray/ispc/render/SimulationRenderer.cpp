@@ -25,6 +25,7 @@
 // ospray
 #include <ospray/SDK/common/Data.h>
 #include <ospray/SDK/common/Model.h>
+#include <ospray/SDK/geometry/Instance.h>
 
 // ispc exports
 #include "SimulationRenderer_ispc.h"
@@ -56,6 +57,38 @@ void SimulationRenderer::commit()
     _threshold = getParam1f("threshold", _transferFunctionMinValue);
     _detectionDistance = getParam1f("detectionDistance", 15.f);
 
+    // Simulation offsets of the instances of the model, indexed by their
+    // position in the model. Committing a model registers its geometries in
+    // Embree in that order, so the position is also the instance ID of the
+    // hits, as OSPRay itself assumes to find the geometry of a hit. Renderers
+    // are committed again whenever the model is, see OSPRayRenderer::commit,
+    // and for every simulation frame, which leaves the offsets untouched.
+    const ospray::int32 modelVersion = getParam1i("modelVersion", 0);
+    if (model != _instanceOffsetsModel ||
+        modelVersion != _instanceOffsetsModelVersion)
+    {
+        _instanceOffsetsModel = model;
+        _instanceOffsetsModelVersion = modelVersion;
+        _instanceOffsets.clear();
+        if (model)
+            for (size_t i = 0; i < model->geometry.size(); ++i)
+            {
+                const auto& geometry = model->geometry[i];
+                const ospray::uint32 high =
+                    geometry->getParam1i("simulation_offset_high", 0);
+                const ospray::uint32 low =
+                    geometry->getParam1i("simulation_offset_low", 0);
+                const ospray::uint64 offset = ospray::uint64(high) << 32 | low;
+                if (offset == 0)
+                    continue;
+                assert(dynamic_cast<ospray::Instance*>(geometry.ptr));
+                assert(static_cast<ospray::Instance*>(geometry.ptr)
+                           ->embreeGeomID == i);
+                _instanceOffsets.resize(model->geometry.size(), 0);
+                _instanceOffsets[i] = offset;
+            }
+    }
+
     ispc::SimulationRenderer_set(
         getIE(), (_simulationModel ? _simulationModel->getIE() : nullptr),
         (ispc::vec3f&)_bgColor, _shadows, _softShadows,
@@ -67,6 +100,8 @@ void SimulationRenderer::commit()
         (ispc::vec3f&)_volumeOffset, _volumeEpsilon, _volumeSamplesPerRay,
         _simulationData ? (float*)_simulationData->data : NULL,
         _simulationDataSize,
+        _instanceOffsets.empty() ? NULL : _instanceOffsets.data(),
+        _instanceOffsets.size(),
         _transferFunctionDiffuseData
             ? (ispc::vec4f*)_transferFunctionDiffuseData->data
             : NULL,
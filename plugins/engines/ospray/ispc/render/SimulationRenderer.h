@@ -44,6 +44,9 @@ private:
     ospray::Ref<ospray::Data> _volumeData;
     ospray::Ref<ospray::Data> _simulationData;
     ospray::uint64 _simulationDataSize;
+    std::vector<ospray::uint64> _instanceOffsets;
+    ospray::Model *_instanceOffsetsModel{nullptr};
+    ospray::int32 _instanceOffsetsModelVersion{0};
     ospray::Ref<ospray::Data> _transferFunctionDiffuseData;
     ospray::Ref<ospray::Data> _transferFunctionEmissionData;
     ospray::int32 _transferFunctionSize;
@@ -58,6 +58,7 @@ const std::string ENDPOINT_CLIP_PLANES = "clip-planes";
 const std::string ENDPOINT_FRAME = "frame";
 const std::string ENDPOINT_IMAGE_JPEG = "image-jpeg";
 const std::string ENDPOINT_MATERIAL_LUT = "material-lut";
+const std::string ENDPOINT_PLAYBACK_STATISTICS = "playback-statistics";
 const std::string ENDPOINT_VIEWPORT = "viewport";
 const std::string ENDPOINT_CIRCUIT_CONFIG_BUILDER = "circuit-config-builder";
 const std::string ENDPOINT_STREAM = "stream";
@@ -193,7 +194,10 @@ void RocketsPlugin::_broadcastWebsocketMessages()
     if (_engine->getModified())
         _httpServer->broadcastText(_wsOutgoing[ENDPOINT_PROGRESS]());
 
-    if (_engine->isReady() && _engine->getRenderer().hasNewImage())
+    // Geometry batches are streamed while the scene is loading
+    const bool rendering =
+        _engine->isReady() || _engine->getScene().hasGeometryBatches();
+    if (rendering && _engine->getRenderer().hasNewImage())
     {
         const auto fps =
             _parametersManager.getApplicationParameters().getImageStreamFPS();
@@ -314,6 +318,10 @@ void RocketsPlugin::_setupHTTPServer()
     _remoteSimulationHistogram.registerSerializeCallback(
         [this] { _requestSimulationHistogram(); });
 
+    _handleGET(ENDPOINT_PLAYBACK_STATISTICS, _remotePlaybackStatistics);
+    _remotePlaybackStatistics.registerSerializeCallback(
+        [this] { _requestPlaybackStatistics(); });
+
     _handleGET(ENDPOINT_VOLUME_HISTOGRAM, _remoteVolumeHistogram);
     _remoteVolumeHistogram.registerSerializeCallback(
         [this] { _requestVolumeHistogram(); });
@@ -1300,8 +1308,10 @@ void RocketsPlugin::_frameUpdated()
     {
         auto& scene = _engine->getScene();
         handler->setFrame(scene, _remoteFrame.getCurrent());
-        scene.setSpheresDirty(true);
-        scene.serializeGeometry();
+        // Engines that cannot commit the spheres of a single material mark
+        // all of them dirty instead
+        if (scene.isSpheresDirty())
+            scene.serializeGeometry();
         scene.commit();
     }
 }
@@ -1333,6 +1343,18 @@ bool RocketsPlugin::_requestSimulationHistogram()
     return true;
 }
 
+bool RocketsPlugin::_requestPlaybackStatistics()
+{
+    const auto& scheduler = _engine->getPlaybackScheduler();
+    _remotePlaybackStatistics.setPlaying(scheduler.isPlaying());
+    _remotePlaybackStatistics.setPlayedFrames(scheduler.getNbPlayedFrames());
+    _remotePlaybackStatistics.setDroppedFrames(scheduler.getNbDroppedFrames());
+    _remotePlaybackStatistics.setPlaybackTime(scheduler.getPlaybackTime());
+    _remotePlaybackStatistics.setStallTime(scheduler.getStallTime());
+    _remotePlaybackStatistics.setEffectiveRate(scheduler.getEffectiveRate());
+    return true;
+}
+
 bool RocketsPlugin::_requestVolumeHistogram()
 {
     auto volumeHandler = _engine->getScene().getVolumeHandler();
@@ -38,6 +38,7 @@
 
 #include <zerobuf/render/frameBuffers.h>
 #include <zerobuf/render/parameters.h>
+#include <zerobuf/render/playback.h>
 #include <zerobuf/render/reset.h>
 #include <zerobuf/render/scene.h>
 #include <zerobuf/render/spikes.h>
@@ -106,6 +107,8 @@ private:
 
     bool _requestSimulationHistogram();
 
+    bool _requestPlaybackStatistics();
+
     bool _requestVolumeHistogram();
 
     void _clipPlanesUpdated();
@@ -192,6 +195,7 @@ private:
     ::brayns::v1::DataSource _remoteDataSource;
     ::brayns::v1::Settings _remoteSettings;
     ::brayns::v1::Spikes _remoteSpikes;
+    ::brayns::v1::PlaybackStatistics _remotePlaybackStatistics;
     ::brayns::v1::FrameBuffers _remoteFrameBuffers;
     ::brayns::v1::Material _remoteMaterial;
     ::brayns::v1::ResetCamera _remoteResetCamera;
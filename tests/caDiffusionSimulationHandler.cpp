@@ -0,0 +1,283 @@
+/* Copyright (c) 2015-2017, EPFL/Blue Brain Project
+ * All rights reserved. Do not distribute without permission.
+ * Responsible Author: Cyrille Favreau <cyrille.favreau@epfl.ch>
+ *
+ * This file is part of Brayns <https://github.com/BlueBrain/Brayns>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <brayns/common/geometry/Sphere.h>
+#include <brayns/common/scene/Scene.h>
+#include <brayns/io/simulation/CADiffusionSimulationHandler.h>
+#include <brayns/parameters/ParametersManager.h>
+
+#define BOOST_TEST_MODULE caDiffusionSimulationHandler
+#include <boost/test/unit_test.hpp>
+
+#include <boost/filesystem.hpp>
+
+#include <fstream>
+
+namespace
+{
+const size_t CALCIUM_MATERIAL =
+    static_cast<size_t>(brayns::MaterialType::calcium_simulation);
+
+/** Scene counting the commits of the calcium spheres, and recording their
+    dirty ranges when the geometry is serialized */
+class TestScene : public brayns::Scene
+{
+public:
+    TestScene(brayns::ParametersManager& parametersManager)
+        : brayns::Scene(brayns::Renderers(), parametersManager)
+    {
+    }
+
+    void commit() final {}
+    void commitLights() final {}
+    void buildGeometry() final {}
+    uint64_t serializeGeometry() final
+    {
+        dirtySpheres = _dirtySpheres;
+        _dirtySpheres.clear();
+        _spheresDirty = false;
+        return 0;
+    }
+    void commitSimulationData() final {}
+    void commitVolumeData() final {}
+    void commitTransferFunctionData() final {}
+    void commitMaterials(const brayns::Action) final {}
+    bool isVolumeSupported(const std::string&) const final { return false; }
+    void commitSpheres(const size_t materialId) final
+    {
+        BOOST_CHECK_EQUAL(materialId, CALCIUM_MATERIAL);
+        ++nbCommits;
+    }
+
+    size_t nbCommits{0};
+    DirtyRanges dirtySpheres;
+};
+
+/** Simulation folders, removed when the test ends */
+struct SimulationFolder
+{
+    SimulationFolder()
+        : folder(boost::filesystem::temp_directory_path() /
+                 boost::filesystem::unique_path("brayns-%%%%%%%%"))
+        , text(folder / "text")
+        , binary(folder / "binary")
+        , cache(folder / "cache")
+    {
+        boost::filesystem::create_directories(text);
+        boost::filesystem::create_directories(binary);
+        writeFrame(0, {{1.f, 2.f, 3.f}, {-4.f, 5.5f, 6.f}, {7.f, 8.f, -9.f}});
+        writeFrame(1, {{0.5f, 0.25f, 0.125f}, {10.f, 20.f, 30.f}});
+        writeFrame(2, {{0.5f, 0.25f, 0.125f}, {11.f, 20.f, 30.f}});
+        writeFrame(3, {{0.5f, 0.25f, 0.125f}, {11.f, 20.f, 30.f}});
+    }
+
+    ~SimulationFolder() { boost::filesystem::remove_all(folder); }
+    void writeFrame(const size_t frame, const brayns::Vector3fs& positions)
+    {
+        const auto name = std::to_string(frame);
+        std::ofstream file((text / (name + ".dat")).string());
+        for (size_t i = 0; i < positions.size(); ++i)
+            file << i << " " << positions[i].x() << " " << positions[i].y()
+                 << " " << positions[i].z() << std::endl;
+        frames.push_back(positions);
+    }
+
+    void checkSpheres(TestScene& scene, const size_t frame) const
+    {
+        const auto& positions = frames[frame];
+        const auto& spheres = scene.getMaterialSpheres(CALCIUM_MATERIAL);
+        BOOST_REQUIRE_EQUAL(spheres.size(), positions.size());
+        for (size_t i = 0; i < spheres.size(); ++i)
+        {
+            BOOST_CHECK_EQUAL(spheres[i].center, positions[i]);
+            BOOST_CHECK_GT(spheres[i].radius, 0.f);
+            BOOST_CHECK(scene.getWorldBounds().isIn(positions[i]));
+        }
+    }
+
+    const boost::filesystem::path folder;
+    const boost::filesystem::path text;
+    const boost::filesystem::path binary;
+    const boost::filesystem::path cache;
+    std::vector<brayns::Vector3fs> frames;
+};
+
+void writeBinaryFrame(const std::string& filename, const uint64_t magic,
+                      const uint64_t nbPositions, const size_t nbValues)
+{
+    std::ofstream file(filename, std::ios::binary);
+    file.write((const char*)&magic, sizeof(magic));
+    file.write((const char*)&nbPositions, sizeof(nbPositions));
+    const std::vector<float> values(nbValues, 1.f);
+    file.write((const char*)values.data(), values.size() * sizeof(float));
+}
+
+uint64_t readMagic(const std::string& filename)
+{
+    uint64_t magic = 0;
+    std::ifstream file(filename, std::ios::binary);
+    file.read((char*)&magic, sizeof(magic));
+    return magic;
+}
+}
+
+BOOST_AUTO_TEST_CASE(converted_frames_round_trip)
+{
+    SimulationFolder simulation;
+    for (size_t frame = 0; frame < simulation.frames.size(); ++frame)
+    {
+        const auto name = std::to_string(frame);
+        BOOST_REQUIRE(brayns::CADiffusionSimulationHandler::convertFrame(
+            (simulation.text / (name + ".dat")).string(),
+            (simulation.binary / (name + ".ca")).string()));
+    }
+    BOOST_CHECK(!brayns::CADiffusionSimulationHandler::convertFrame(
+        (simulation.text / "missing.dat").string(),
+        (simulation.binary / "missing.ca").string()));
+
+    brayns::CADiffusionSimulationHandler handler(simulation.binary.string());
+    BOOST_CHECK_EQUAL(handler.getNbFrames(), simulation.frames.size());
+
+    brayns::ParametersManager parametersManager;
+    TestScene scene(parametersManager);
+    handler.setFrame(scene, 0);
+    simulation.checkSpheres(scene, 0);
+    BOOST_CHECK_EQUAL(scene.nbCommits, 1);
+
+    // Spheres are overwritten in place, the current frame is not reloaded
+    handler.setFrame(scene, 1);
+    simulation.checkSpheres(scene, 1);
+    handler.setFrame(scene, 1);
+    BOOST_CHECK_EQUAL(scene.nbCommits, 2);
+    handler.setFrame(scene, 0);
+    simulation.checkSpheres(scene, 0);
+    BOOST_CHECK_EQUAL(scene.nbCommits, 3);
+}
+
+BOOST_AUTO_TEST_CASE(moved_atoms_range)
+{
+    SimulationFolder simulation;
+    for (size_t frame = 0; frame < simulation.frames.size(); ++frame)
+    {
+        const auto name = std::to_string(frame);
+        BOOST_REQUIRE(brayns::CADiffusionSimulationHandler::convertFrame(
+            (simulation.text / (name + ".dat")).string(),
+            (simulation.binary / (name + ".ca")).string()));
+    }
+
+    brayns::CADiffusionSimulationHandler handler(simulation.binary.string());
+    brayns::ParametersManager parametersManager;
+    TestScene scene(parametersManager);
+    handler.setFrame(scene, 1);
+    BOOST_CHECK_EQUAL(scene.nbCommits, 1);
+    scene.serializeGeometry();
+    BOOST_CHECK(!scene.isSpheresDirty());
+
+    // Frames with as many atoms only set the spheres that moved as dirty
+    handler.setFrame(scene, 2);
+    simulation.checkSpheres(scene, 2);
+    BOOST_CHECK_EQUAL(scene.nbCommits, 1);
+    BOOST_CHECK(scene.isSpheresDirty());
+    scene.serializeGeometry();
+    BOOST_REQUIRE_EQUAL(scene.dirtySpheres.size(), 1);
+    const auto& range = scene.dirtySpheres[CALCIUM_MATERIAL];
+    BOOST_CHECK_EQUAL(range.begin, 1);
+    BOOST_CHECK_EQUAL(range.end, 2);
+
+    // A frame that moves no atom leaves nothing to update
+    handler.setFrame(scene, 3);
+    simulation.checkSpheres(scene, 3);
+    BOOST_CHECK(!scene.isSpheresDirty());
+
+    // Growing the number of atoms commits the whole material again
+    handler.setFrame(scene, 0);
+    simulation.checkSpheres(scene, 0);
+    BOOST_CHECK_EQUAL(scene.nbCommits, 2);
+}
+
+BOOST_AUTO_TEST_CASE(text_frames_are_cached)
+{
+    SimulationFolder simulation;
+    brayns::ParametersManager parametersManager;
+    TestScene scene(parametersManager);
+    {
+        brayns::CADiffusionSimulationHandler handler(simulation.text.string(),
+                                                     simulation.cache.string());
+        handler.setFrame(scene, 0);
+        simulation.checkSpheres(scene, 0);
+    }
+
+    // The simulation folder is left untouched
+    size_t nbTextFiles = 0;
+    for (boost::filesystem::directory_iterator i(simulation.text), end;
+         i != end; ++i)
+        ++nbTextFiles;
+    BOOST_CHECK_EQUAL(nbTextFiles, simulation.frames.size());
+
+    std::vector<std::string> cacheFiles;
+    for (boost::filesystem::directory_iterator i(simulation.cache), end;
+         i != end; ++i)
+        cacheFiles.push_back(i->path().string());
+    BOOST_REQUIRE_EQUAL(cacheFiles.size(), 1);
+
+    // Rewritten cache positions show that the next load reads the cache
+    const brayns::Vector3fs cachedPositions(3, brayns::Vector3f(1.f));
+    writeBinaryFrame(cacheFiles[0], readMagic(cacheFiles[0]),
+                     cachedPositions.size(), cachedPositions.size() * 3);
+    simulation.frames[0] = cachedPositions;
+
+    brayns::CADiffusionSimulationHandler handler(simulation.text.string(),
+                                                 simulation.cache.string());
+    handler.setFrame(scene, 0);
+    simulation.checkSpheres(scene, 0);
+}
+
+BOOST_AUTO_TEST_CASE(invalid_binary_frames)
+{
+    SimulationFolder simulation;
+    BOOST_REQUIRE(brayns::CADiffusionSimulationHandler::convertFrame(
+        (simulation.text / "0.dat").string(),
+        (simulation.binary / "0.ca").string()));
+    const auto magic = readMagic((simulation.binary / "0.ca").string());
+
+    // Truncated positions, a count whose size overflows, a wrong magic number
+    // and a missing header
+    writeBinaryFrame((simulation.binary / "1.ca").string(), magic, 3, 8);
+    writeBinaryFrame((simulation.binary / "2.ca").string(), magic,
+                     uint64_t(1) << 62, 9);
+    writeBinaryFrame((simulation.binary / "3.ca").string(), magic + 1, 3, 9);
+    std::ofstream((simulation.binary / "4.ca").string()) << "CA";
+
+    brayns::CADiffusionSimulationHandler handler(simulation.binary.string());
+    BOOST_REQUIRE_EQUAL(handler.getNbFrames(), 5);
+
+    brayns::ParametersManager parametersManager;
+    TestScene scene(parametersManager);
+    handler.setFrame(scene, 0);
+    simulation.checkSpheres(scene, 0);
+
+    // Invalid frames leave the spheres of the previous one
+    for (size_t frame = 1; frame < handler.getNbFrames(); ++frame)
+    {
+        handler.setFrame(scene, frame);
+        simulation.checkSpheres(scene, 0);
+    }
+    BOOST_CHECK_EQUAL(scene.nbCommits, 1);
+}
@@ -0,0 +1,134 @@
+/* Copyright (c) 2015-2017, EPFL/Blue Brain Project
+ * All rights reserved. Do not distribute without permission.
+ * Responsible Author: Cyrille Favreau <cyrille.favreau@epfl.ch>
+ *
+ * This file is part of Brayns <https://github.com/BlueBrain/Brayns>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+#include <tests/paths.h>
+
+#include <brayns/io/simulation/CircuitSimulationHandler.h>
+#include <brayns/parameters/ApplicationParameters.h>
+#include <brayns/parameters/GeometryParameters.h>
+
+#define BOOST_TEST_MODULE circuitSimulationHandler
+#include <boost/test/unit_test.hpp>
+
+#include <thread>
+
+namespace
+{
+const std::string REPORT_FILE(
+    BBP_TESTDATA "/local/simulations/may17_2011/Control/allCompartments.bbp");
+const brion::GIDSet GIDS = {1, 2, 3, 4, 5};
+const auto TIMEOUT = std::chrono::seconds(10);
+
+/** Handler reading the test report with the given number of prefetched
+ * frames */
+struct Fixture
+{
+    explicit Fixture(const std::string& prefetchFrames,
+                     const std::string& synchronousMode = "off")
+    {
+        applicationParameters.set("synchronous-mode", synchronousMode);
+        geometryParameters.set("circuit-simulation-prefetch-frames",
+                               prefetchFrames);
+        handler.reset(new brayns::CircuitSimulationHandler(
+            applicationParameters, geometryParameters,
+            brion::URI(REPORT_FILE), GIDS));
+        report.reset(new brion::CompartmentReport(brion::URI(REPORT_FILE),
+                                                  brion::MODE_READ, GIDS));
+    }
+
+    /** Requests the frame until it is ready, as the renderer does */
+    const float* waitForFrame(const uint32_t frame)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        for (;;)
+        {
+            const auto data = handler->getFrameData(frame);
+            if (handler->isReady())
+                return static_cast<const float*>(data);
+            if (std::chrono::steady_clock::now() - start > TIMEOUT)
+                return nullptr;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    void checkFrame(const uint32_t frame, const float* data)
+    {
+        BOOST_REQUIRE(data);
+        const auto expected =
+            report
+                ->loadFrame(report->getStartTime() +
+                            frame * report->getTimestep())
+                .get();
+        BOOST_REQUIRE(expected);
+        BOOST_CHECK_EQUAL_COLLECTIONS(data, data + expected->size(),
+                                      expected->begin(), expected->end());
+    }
+
+    brayns::ApplicationParameters applicationParameters;
+    brayns::GeometryParameters geometryParameters;
+    std::unique_ptr<brayns::CircuitSimulationHandler> handler;
+    std::unique_ptr<brion::CompartmentReport> report;
+};
+}
+
+BOOST_AUTO_TEST_CASE(seek_back_to_current_frame)
+{
+    Fixture fixture("0");
+    fixture.checkFrame(3, fixture.waitForFrame(3));
+
+    // Frame 4 starts loading, but playback goes back to frame 3 right away
+    fixture.handler->getFrameData(4);
+    fixture.checkFrame(3, fixture.waitForFrame(3));
+    fixture.checkFrame(4, fixture.waitForFrame(4));
+}
+
+BOOST_AUTO_TEST_CASE(forward_and_reverse_playback)
+{
+    Fixture fixture("2", "on");
+    for (uint32_t frame = 0; frame < 5; ++frame)
+        fixture.checkFrame(frame, fixture.waitForFrame(frame));
+    for (uint32_t frame = 5; frame-- > 0;)
+        fixture.checkFrame(frame, fixture.waitForFrame(frame));
+
+    // Every request is either a hit or a miss, frame 4 being current when
+    // playback reverses
+    BOOST_CHECK_EQUAL(fixture.handler->getFrameHits() +
+                          fixture.handler->getFrameMisses(),
+                      9);
+}
+
+BOOST_AUTO_TEST_CASE(hits_and_misses)
+{
+    Fixture fixture("1");
+    fixture.checkFrame(0, fixture.waitForFrame(0));
+    BOOST_CHECK_EQUAL(fixture.handler->getFrameHits(), 0);
+    BOOST_CHECK_EQUAL(fixture.handler->getFrameMisses(), 1);
+
+    // Leaves time to the next frame to be prefetched
+    std::this_thread::sleep_for(std::chrono::seconds(1));
+    fixture.checkFrame(1, fixture.waitForFrame(1));
+    BOOST_CHECK_EQUAL(fixture.handler->getFrameHits(), 1);
+    BOOST_CHECK_EQUAL(fixture.handler->getFrameMisses(), 1);
+
+    // Jumping ahead of the prefetched frames is a miss
+    fixture.checkFrame(4, fixture.waitForFrame(4));
+    BOOST_CHECK_EQUAL(fixture.handler->getFrameHits(), 1);
+    BOOST_CHECK_EQUAL(fixture.handler->getFrameMisses(), 2);
+    BOOST_CHECK_GT(fixture.handler->getAverageFrameLatency(), 0.0);
+}
@@ -0,0 +1,182 @@
+/* Copyright (c) 2015-2017, EPFL/Blue Brain Project
+ * All rights reserved. Do not distribute without permission.
+ * Responsible Author: Cyrille Favreau <cyrille.favreau@epfl.ch>
+ *
+ * This file is part of Brayns <https://github.com/BlueBrain/Brayns>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <plugins/engines/ospray/ispc/geometry/CompactPrimitives.h>
+
+#define BOOST_TEST_MODULE compactPrimitives
+#include <boost/test/unit_test.hpp>
+
+#include <cmath>
+#include <random>
+
+namespace
+{
+const uint64_t NB_PRIMITIVES = 1000;
+
+// Half floats have 11 significant bits
+const float HALF_RELATIVE_ERROR = 1.f / 2048.f;
+
+class RandomPrimitives
+{
+public:
+    brayns::Vector3f position()
+    {
+        return brayns::Vector3f(_position(_engine), _position(_engine),
+                                _position(_engine));
+    }
+    float radius() { return _radius(_engine); }
+    brayns::Vector2f values()
+    {
+        return brayns::Vector2f(_position(_engine), _position(_engine));
+    }
+
+private:
+    std::mt19937 _engine{42};
+    std::uniform_real_distribution<float> _position{-100.f, 100.f};
+    std::uniform_real_distribution<float> _radius{0.1f, 10.f};
+};
+
+// Positions are rounded to the nearest step of their block
+void checkPosition(const brayns::Vector3f& decoded,
+                   const brayns::Vector3f& expected,
+                   const brayns::Vector4f& block)
+{
+    for (size_t i = 0; i < 3; ++i)
+        BOOST_CHECK_LE(std::abs(decoded[i] - expected[i]),
+                       block.w() * 0.5f + std::abs(expected[i]) * 1e-6f);
+}
+
+void checkHalf(const float decoded, const float expected)
+{
+    BOOST_CHECK_LE(std::abs(decoded - expected),
+                   std::abs(expected) * HALF_RELATIVE_ERROR);
+}
+
+template <typename C>
+const brayns::Vector4f& getBlock(const brayns::CompactGeometry<C>& geometry,
+                                 const uint64_t index)
+{
+    return geometry.blocks[index / brayns::COMPACT_PRIMITIVES_PER_BLOCK];
+}
+}
+
+BOOST_AUTO_TEST_CASE(compact_primitive_sizes)
+{
+    BOOST_CHECK_EQUAL(sizeof(brayns::Sphere), 28);
+    BOOST_CHECK_EQUAL(sizeof(brayns::Cylinder), 40);
+    BOOST_CHECK_EQUAL(sizeof(brayns::Cone), 44);
+    BOOST_CHECK_EQUAL(sizeof(brayns::CompactSphere), 20);
+    BOOST_CHECK_EQUAL(sizeof(brayns::CompactCylinder), 24);
+    BOOST_CHECK_EQUAL(sizeof(brayns::CompactCone), 28);
+}
+
+BOOST_AUTO_TEST_CASE(compact_spheres_round_trip)
+{
+    RandomPrimitives random;
+    brayns::Spheres spheres;
+    for (uint64_t i = 0; i < NB_PRIMITIVES; ++i)
+        spheres.push_back(brayns::Sphere(random.position(), random.radius(),
+                                         float(i), random.values()));
+
+    brayns::CompactGeometry<brayns::CompactSphere> compactSpheres;
+    brayns::encodePrimitives(spheres.data(), spheres.size(), compactSpheres);
+    BOOST_REQUIRE_EQUAL(compactSpheres.primitives.size(), NB_PRIMITIVES);
+    BOOST_REQUIRE_EQUAL(compactSpheres.blocks.size(),
+                        (NB_PRIMITIVES + 255) / 256);
+
+    for (uint64_t i = 0; i < NB_PRIMITIVES; ++i)
+    {
+        const auto& expected = spheres[i];
+        const auto sphere = brayns::decodePrimitive(compactSpheres, i);
+        checkPosition(sphere.center, expected.center,
+                      getBlock(compactSpheres, i));
+        checkHalf(sphere.radius, expected.radius);
+        checkHalf(sphere.timestamp, expected.timestamp);
+        BOOST_CHECK_EQUAL(sphere.values, expected.values);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(compact_cylinders_round_trip)
+{
+    RandomPrimitives random;
+    brayns::Cylinders cylinders;
+    for (uint64_t i = 0; i < NB_PRIMITIVES; ++i)
+        cylinders.push_back(brayns::Cylinder(random.position(),
+                                             random.position(),
+                                             random.radius(), float(i),
+                                             random.values()));
+
+    brayns::CompactGeometry<brayns::CompactCylinder> compactCylinders;
+    brayns::encodePrimitives(cylinders.data(), cylinders.size(),
+                             compactCylinders);
+    BOOST_REQUIRE_EQUAL(compactCylinders.primitives.size(), NB_PRIMITIVES);
+
+    for (uint64_t i = 0; i < NB_PRIMITIVES; ++i)
+    {
+        const auto& expected = cylinders[i];
+        const auto cylinder = brayns::decodePrimitive(compactCylinders, i);
+        const auto& block = getBlock(compactCylinders, i);
+        checkPosition(cylinder.center, expected.center, block);
+        checkPosition(cylinder.up, expected.up, block);
+        checkHalf(cylinder.radius, expected.radius);
+        checkHalf(cylinder.timestamp, expected.timestamp);
+        BOOST_CHECK_EQUAL(cylinder.values, expected.values);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(compact_cones_round_trip)
+{
+    RandomPrimitives random;
+    brayns::Cones cones;
+    for (uint64_t i = 0; i < NB_PRIMITIVES; ++i)
+        cones.push_back(brayns::Cone(random.position(), random.position(),
+                                     random.radius(), random.radius(),
+                                     float(i), random.values()));
+
+    brayns::CompactGeometry<brayns::CompactCone> compactCones;
+    brayns::encodePrimitives(cones.data(), cones.size(), compactCones);
+    BOOST_REQUIRE_EQUAL(compactCones.primitives.size(), NB_PRIMITIVES);
+
+    for (uint64_t i = 0; i < NB_PRIMITIVES; ++i)
+    {
+        const auto& expected = cones[i];
+        const auto cone = brayns::decodePrimitive(compactCones, i);
+        const auto& block = getBlock(compactCones, i);
+        checkPosition(cone.center, expected.center, block);
+        checkPosition(cone.up, expected.up, block);
+        checkHalf(cone.centerRadius, expected.centerRadius);
+        checkHalf(cone.upRadius, expected.upRadius);
+        checkHalf(cone.timestamp, expected.timestamp);
+        BOOST_CHECK_EQUAL(cone.values, expected.values);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(compact_primitives_of_a_single_point)
+{
+    // Blocks of a single position have no extent, which must not divide by
+    // zero
+    const brayns::Sphere sphere(brayns::Vector3f(1.f, 2.f, 3.f), 1.f);
+    const brayns::Spheres spheres(10, sphere);
+    brayns::CompactGeometry<brayns::CompactSphere> compactSpheres;
+    brayns::encodePrimitives(spheres.data(), spheres.size(), compactSpheres);
+    for (uint64_t i = 0; i < spheres.size(); ++i)
+        BOOST_CHECK_EQUAL(brayns::decodePrimitive(compactSpheres, i).center,
+                          sphere.center);
+}
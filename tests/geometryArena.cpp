@@ -0,0 +1,141 @@
+/* Copyright (c) 2015-2017, EPFL/Blue Brain Project
+ * All rights reserved. Do not distribute without permission.
+ * Responsible Author: Cyrille Favreau <cyrille.favreau@epfl.ch>
+ *
+ * This file is part of Brayns <https://github.com/BlueBrain/Brayns>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <brayns/common/geometry/Sphere.h>
+#include <brayns/common/types.h>
+
+#define BOOST_TEST_MODULE geometryArena
+#include <boost/test/unit_test.hpp>
+
+namespace
+{
+brayns::Spheres createSpheres(const size_t nbSpheres)
+{
+    brayns::Spheres spheres;
+    for (size_t i = 0; i < nbSpheres; ++i)
+        spheres.push_back({brayns::Vector3f(float(i), 0.f, 0.f), 1.f});
+    return spheres;
+}
+}
+
+BOOST_AUTO_TEST_CASE(geometry_arena_slots)
+{
+    brayns::SpheresMap arena;
+    BOOST_CHECK(arena.empty());
+    BOOST_CHECK_EQUAL(arena.size(), 0);
+    BOOST_CHECK(arena.find(0) == nullptr);
+
+    // Accessing a material creates all slots up to it
+    auto& spheres = arena[2];
+    BOOST_CHECK_EQUAL(arena.size(), 3);
+    BOOST_CHECK(arena.empty());
+    BOOST_CHECK(arena.find(1) != nullptr);
+    BOOST_CHECK(arena.find(3) == nullptr);
+
+    // Adding materials does not invalidate references to existing ones
+    spheres.push_back({brayns::Vector3f(), 1.f});
+    for (size_t materialId = 3; materialId < 100; ++materialId)
+        arena[materialId].push_back({brayns::Vector3f(), 2.f});
+    BOOST_CHECK_EQUAL(&spheres, &arena[2]);
+    BOOST_CHECK_EQUAL(spheres.size(), 1);
+    BOOST_CHECK(!arena.empty());
+    BOOST_CHECK_EQUAL(arena.getNbElements(), 98);
+
+    arena.clear();
+    BOOST_CHECK_EQUAL(arena.size(), 0);
+    BOOST_CHECK_EQUAL(arena.getNbElements(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(geometry_arena_append)
+{
+    brayns::SpheresMap arena;
+    const auto spheres = createSpheres(10);
+    BOOST_CHECK_EQUAL(arena.append(1, spheres), 0);
+    BOOST_CHECK_EQUAL(arena.append(1, spheres.data(), 5), 10);
+    BOOST_CHECK_EQUAL(arena.append(1, spheres), 15);
+    BOOST_REQUIRE_EQUAL(arena[1].size(), 25);
+    BOOST_CHECK_EQUAL(arena[1][12].center, spheres[2].center);
+    BOOST_CHECK(arena[0].empty());
+
+    // Appending another arena keeps the materials
+    brayns::SpheresMap other;
+    other.append(3, spheres);
+    arena.append(other);
+    BOOST_CHECK_EQUAL(arena[1].size(), 25);
+    BOOST_CHECK_EQUAL(arena[3].size(), 10);
+    BOOST_CHECK_EQUAL(arena.getNbElements(), 35);
+}
+
+BOOST_AUTO_TEST_CASE(geometry_arena_move)
+{
+    brayns::SpheresMap arena;
+
+    // Empty materials take over the memory of the elements
+    auto spheres = createSpheres(10);
+    const auto data = spheres.data();
+    BOOST_CHECK_EQUAL(arena.append(0, std::move(spheres)), 0);
+    BOOST_CHECK_EQUAL(arena[0].data(), data);
+
+    // Others copy them
+    auto moreSpheres = createSpheres(5);
+    BOOST_CHECK_EQUAL(arena.append(0, std::move(moreSpheres)), 10);
+    BOOST_CHECK_EQUAL(arena[0].size(), 15);
+    BOOST_CHECK_EQUAL(arena[0][14].center, brayns::Vector3f(4.f, 0.f, 0.f));
+}
+
+BOOST_AUTO_TEST_CASE(geometry_arena_reserve)
+{
+    brayns::SpheresMap arena;
+    arena.append(0, createSpheres(10));
+    arena.reserve(0, 100);
+    BOOST_CHECK_GE(arena[0].capacity(), 110);
+
+    // Appending within the reservation does not reallocate
+    const auto data = arena[0].data();
+    const auto spheres = createSpheres(100);
+    arena.append(0, spheres);
+    BOOST_CHECK_EQUAL(arena[0].data(), data);
+    BOOST_CHECK_EQUAL(arena[0].size(), 110);
+}
+
+BOOST_AUTO_TEST_CASE(geometry_arena_reserve_growth)
+{
+    brayns::SpheresMap arena;
+    arena.reserve(0, 100);
+    BOOST_CHECK_GE(arena[0].capacity(), 100);
+
+    // Reserving before each small append only reallocates a logarithmic
+    // number of times
+    const auto spheres = createSpheres(10);
+    size_t nbReallocations = 0;
+    for (size_t i = 0; i < 1000; ++i)
+    {
+        const auto capacity = arena[0].capacity();
+        arena.reserve(0, spheres.size());
+        if (arena[0].capacity() != capacity)
+        {
+            BOOST_CHECK_GE(arena[0].capacity(), 2 * capacity);
+            ++nbReallocations;
+        }
+        arena.append(0, spheres);
+    }
+    BOOST_CHECK_EQUAL(arena[0].size(), 10000);
+    BOOST_CHECK_LE(nbReallocations, 7);
+}
@@ -0,0 +1,121 @@
+/* Copyright (c) 2015-2017, EPFL/Blue Brain Project
+ * All rights reserved. Do not distribute without permission.
+ * Responsible Author: Cyrille Favreau <cyrille.favreau@epfl.ch>
+ *
+ * This file is part of Brayns <https://github.com/BlueBrain/Brayns>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <brayns/common/scene/Scene.h>
+#include <brayns/parameters/ParametersManager.h>
+
+#define BOOST_TEST_MODULE geometryBatches
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <thread>
+
+namespace
+{
+const size_t NB_THREADS = 4;
+const size_t NB_BATCHES_PER_THREAD = 100;
+
+/** Scene recording the batches committed by the rendering thread */
+class TestScene : public brayns::Scene
+{
+public:
+    TestScene(brayns::ParametersManager& parametersManager)
+        : brayns::Scene(brayns::Renderers(), parametersManager)
+    {
+    }
+
+    void commit() final {}
+    void commitLights() final {}
+    void buildGeometry() final {}
+    uint64_t serializeGeometry() final { return 0; }
+    void commitSimulationData() final {}
+    void commitVolumeData() final {}
+    void commitTransferFunctionData() final {}
+    void commitMaterials(const brayns::Action) final {}
+    bool isVolumeSupported(const std::string&) const final { return false; }
+    bool commitGeometryBatches() final
+    {
+        const auto batches = _takeGeometryBatches();
+        committed.insert(committed.end(), batches.begin(), batches.end());
+        return !batches.empty();
+    }
+
+    brayns::InstancedGeometries committed;
+};
+
+/** Batch of a single sphere identifying the thread and batch */
+brayns::InstancedGeometryPtr createBatch(const size_t thread,
+                                         const size_t index)
+{
+    brayns::InstancedGeometryPtr batch(new brayns::InstancedGeometry);
+    batch->spheres[0].push_back(
+        {brayns::Vector3f(float(thread), float(index), 0.f), 1.f});
+    batch->transformations.push_back(brayns::Matrix4f());
+    return batch;
+}
+}
+
+BOOST_AUTO_TEST_CASE(geometry_batches_commit_order)
+{
+    brayns::ParametersManager parametersManager;
+    TestScene scene(parametersManager);
+    BOOST_CHECK(!scene.hasGeometryBatches());
+    BOOST_CHECK(!scene.commitGeometryBatches());
+
+    // Loading threads publish batches while the rendering thread commits them
+    std::vector<std::thread> threads;
+    for (size_t thread = 0; thread < NB_THREADS; ++thread)
+        threads.emplace_back([&scene, thread] {
+            for (size_t i = 0; i < NB_BATCHES_PER_THREAD; ++i)
+                scene.addGeometryBatch(createBatch(thread, i));
+        });
+    while (scene.committed.size() < NB_THREADS * NB_BATCHES_PER_THREAD)
+        scene.commitGeometryBatches();
+    for (auto& thread : threads)
+        thread.join();
+
+    // Every batch is committed once, those of a thread in publication order
+    BOOST_CHECK(!scene.commitGeometryBatches());
+    BOOST_CHECK_EQUAL(scene.committed.size(),
+                      NB_THREADS * NB_BATCHES_PER_THREAD);
+    std::vector<size_t> nextBatch(NB_THREADS, 0);
+    for (const auto& batch : scene.committed)
+    {
+        const auto& center = batch->spheres[0][0].center;
+        const size_t thread = center.x();
+        BOOST_REQUIRE_LT(thread, NB_THREADS);
+        BOOST_CHECK_EQUAL(size_t(center.y()), nextBatch[thread]);
+        ++nextBatch[thread];
+    }
+    BOOST_CHECK(std::all_of(nextBatch.begin(), nextBatch.end(),
+                            [](const size_t count) {
+                                return count == NB_BATCHES_PER_THREAD;
+                            }));
+
+    // Batches are kept until the scene is unloaded, and later batches are
+    // committed from the start
+    BOOST_CHECK(scene.hasGeometryBatches());
+    scene.unload();
+    BOOST_CHECK(!scene.hasGeometryBatches());
+    scene.committed.clear();
+    scene.addGeometryBatch(createBatch(0, 0));
+    BOOST_CHECK(scene.commitGeometryBatches());
+    BOOST_CHECK_EQUAL(scene.committed.size(), 1);
+}
@@ -0,0 +1,109 @@
+/* Copyright (c) 2015-2017, EPFL/Blue Brain Project
+ * All rights reserved. Do not distribute without permission.
+ * Responsible Author: Cyrille Favreau <cyrille.favreau@epfl.ch>
+ *
+ * This file is part of Brayns <https://github.com/BlueBrain/Brayns>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <plugins/engines/ospray/GeometryChunks.h>
+
+#define BOOST_TEST_MODULE geometryChunks
+#include <boost/test/unit_test.hpp>
+
+namespace
+{
+// Lowered limit, so that materials are split with a few blocks only
+const uint64_t MAX_PRIMITIVES = 4 * brayns::COMPACT_PRIMITIVES_PER_BLOCK;
+
+void checkChunkRange(const uint64_t nbPrimitives, const uint64_t begin,
+                     const uint64_t end, const size_t first, const size_t last)
+{
+    const auto chunks =
+        brayns::getChunkRange(nbPrimitives, begin, end, MAX_PRIMITIVES);
+    BOOST_CHECK_EQUAL(chunks.first, first);
+    BOOST_CHECK_EQUAL(chunks.second, last);
+}
+}
+
+BOOST_AUTO_TEST_CASE(exact_multiple_chunks)
+{
+    // Materials of whole chunks are split at the limit
+    BOOST_CHECK_EQUAL(brayns::getChunkSize(MAX_PRIMITIVES, MAX_PRIMITIVES),
+                      MAX_PRIMITIVES);
+    BOOST_CHECK_EQUAL(brayns::getNbChunks(MAX_PRIMITIVES, MAX_PRIMITIVES), 1);
+    BOOST_CHECK_EQUAL(brayns::getChunkSize(3 * MAX_PRIMITIVES, MAX_PRIMITIVES),
+                      MAX_PRIMITIVES);
+    BOOST_CHECK_EQUAL(brayns::getNbChunks(3 * MAX_PRIMITIVES, MAX_PRIMITIVES),
+                      3);
+}
+
+BOOST_AUTO_TEST_CASE(remainder_chunks)
+{
+    // Remainders are spread over balanced chunks rather than left in a small
+    // last one
+    const uint64_t blockSize = brayns::COMPACT_PRIMITIVES_PER_BLOCK;
+    BOOST_CHECK_EQUAL(brayns::getChunkSize(MAX_PRIMITIVES + 1, MAX_PRIMITIVES),
+                      3 * blockSize);
+    BOOST_CHECK_EQUAL(brayns::getNbChunks(MAX_PRIMITIVES + 1, MAX_PRIMITIVES),
+                      2);
+    BOOST_CHECK_EQUAL(
+        brayns::getChunkSize(2 * MAX_PRIMITIVES + 300, MAX_PRIMITIVES),
+        MAX_PRIMITIVES);
+    BOOST_CHECK_EQUAL(
+        brayns::getNbChunks(2 * MAX_PRIMITIVES + 300, MAX_PRIMITIVES), 3);
+}
+
+BOOST_AUTO_TEST_CASE(compact_block_aligned_chunks)
+{
+    // Chunks hold whole compact blocks, at least one, and never exceed the
+    // limit
+    const uint64_t blockSize = brayns::COMPACT_PRIMITIVES_PER_BLOCK;
+    BOOST_CHECK_EQUAL(brayns::getChunkSize(0, MAX_PRIMITIVES), blockSize);
+    BOOST_CHECK_EQUAL(brayns::getNbChunks(0, MAX_PRIMITIVES), 0);
+    BOOST_CHECK_EQUAL(brayns::getChunkSize(10, MAX_PRIMITIVES), blockSize);
+    BOOST_CHECK_EQUAL(brayns::getNbChunks(10, MAX_PRIMITIVES), 1);
+    BOOST_CHECK_EQUAL(brayns::MAX_PRIMITIVES_PER_GEOMETRY % blockSize, 0);
+
+    for (uint64_t nbPrimitives = 1; nbPrimitives <= 5 * MAX_PRIMITIVES;
+         nbPrimitives += 7)
+    {
+        const auto chunkSize =
+            brayns::getChunkSize(nbPrimitives, MAX_PRIMITIVES);
+        const auto nbChunks = brayns::getNbChunks(nbPrimitives, MAX_PRIMITIVES);
+        BOOST_CHECK_EQUAL(chunkSize % blockSize, 0);
+        BOOST_CHECK_LE(chunkSize, MAX_PRIMITIVES);
+        BOOST_CHECK_EQUAL(nbChunks, (nbPrimitives + MAX_PRIMITIVES - 1) /
+                                        MAX_PRIMITIVES);
+        // The last chunk is not empty
+        BOOST_CHECK_LT((nbChunks - 1) * chunkSize, nbPrimitives);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(modified_range_chunks)
+{
+    // Only the geometries holding modified primitives are committed again
+    const uint64_t nbPrimitives = 4 * MAX_PRIMITIVES;
+    BOOST_REQUIRE_EQUAL(brayns::getNbChunks(nbPrimitives, MAX_PRIMITIVES), 4);
+    checkChunkRange(nbPrimitives, 1500, 1501, 1, 2);
+    checkChunkRange(nbPrimitives, MAX_PRIMITIVES - 1, MAX_PRIMITIVES + 1, 0, 2);
+    checkChunkRange(nbPrimitives, MAX_PRIMITIVES, 2 * MAX_PRIMITIVES, 1, 2);
+    checkChunkRange(nbPrimitives, 0, nbPrimitives, 0, 4);
+
+    // Ranges are bounded by the primitives of the material
+    checkChunkRange(nbPrimitives, nbPrimitives - 1, nbPrimitives + 100, 3, 4);
+    checkChunkRange(nbPrimitives, nbPrimitives, nbPrimitives + 1, 0, 0);
+    checkChunkRange(nbPrimitives, 10, 10, 0, 0);
+}
@@ -0,0 +1,129 @@
+/* Copyright (c) 2015-2017, EPFL/Blue Brain Project
+ * All rights reserved. Do not distribute without permission.
+ * Responsible Author: Cyrille Favreau <cyrille.favreau@epfl.ch>
+ *
+ * This file is part of Brayns <https://github.com/BlueBrain/Brayns>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <brayns/io/algorithms/GeometryConcatenation.h>
+
+#define BOOST_TEST_MODULE geometryConcatenation
+#include <boost/test/unit_test.hpp>
+
+#include <random>
+
+namespace
+{
+const size_t NB_BATCHES = 16;
+const size_t NB_MATERIALS = 8;
+
+/** Batches of spheres of random sizes, some materials being empty */
+brayns::InstancedGeometries createBatches()
+{
+    std::mt19937 generator(42);
+    std::uniform_int_distribution<size_t> nbSpheres(0, 200);
+    brayns::InstancedGeometries batches;
+    float value = 0.f;
+    for (size_t i = 0; i < NB_BATCHES; ++i)
+    {
+        brayns::InstancedGeometryPtr batch(new brayns::InstancedGeometry);
+        for (size_t materialId = i % 3; materialId < NB_MATERIALS;
+             ++materialId)
+        {
+            auto& spheres = batch->spheres[materialId];
+            const size_t nbElements = nbSpheres(generator) % (materialId + 2);
+            for (size_t j = 0; j < nbElements; ++j)
+            {
+                spheres.push_back(
+                    {brayns::Vector3f(value, float(i), float(materialId)),
+                     1.f});
+                value += 1.f;
+            }
+        }
+        batches.push_back(batch);
+    }
+    return batches;
+}
+}
+
+BOOST_AUTO_TEST_CASE(concatenate_primitives)
+{
+    const auto batches = createBatches();
+
+    // Serial reference, appending the batches one after the other to a scene
+    // that already holds primitives
+    brayns::SpheresMap expected;
+    expected[1].push_back({brayns::Vector3f(-1.f, 0.f, 0.f), 2.f});
+    brayns::SpheresMap spheres = expected;
+    for (const auto& batch : batches)
+        expected.append(batch->spheres);
+
+    const auto nbPrimitives = brayns::concatenatePrimitives(
+        batches, &brayns::InstancedGeometry::spheres, spheres, false);
+    BOOST_CHECK_EQUAL(nbPrimitives, expected.getNbElements() - 1);
+    BOOST_REQUIRE_EQUAL(spheres.size(), expected.size());
+    for (size_t materialId = 0; materialId < expected.size(); ++materialId)
+    {
+        const auto& result = spheres[materialId];
+        const auto& reference = expected[materialId];
+        BOOST_REQUIRE_EQUAL(result.size(), reference.size());
+        for (size_t i = 0; i < result.size(); ++i)
+        {
+            BOOST_CHECK_EQUAL(result[i].center, reference[i].center);
+            BOOST_CHECK_EQUAL(result[i].radius, reference[i].radius);
+        }
+    }
+
+    // Batches are kept unless released
+    BOOST_CHECK(!batches[0]->spheres.empty());
+    brayns::SpheresMap released;
+    brayns::concatenatePrimitives(batches, &brayns::InstancedGeometry::spheres,
+                                  released, true);
+    BOOST_CHECK_EQUAL(released.getNbElements(), nbPrimitives);
+    for (const auto& batch : batches)
+        BOOST_CHECK(batch->spheres.empty());
+}
+
+BOOST_AUTO_TEST_CASE(concatenate_meshes)
+{
+    brayns::InstancedGeometries batches;
+    for (size_t i = 0; i < 3; ++i)
+    {
+        brayns::InstancedGeometryPtr batch(new brayns::InstancedGeometry);
+        auto& mesh = batch->trianglesMeshes[1];
+        for (size_t j = 0; j < 3; ++j)
+            mesh.vertices.push_back(brayns::Vector3f(float(i), float(j), 0.f));
+        mesh.indices.push_back(brayns::Vector3ui(0, 1, 2));
+        batches.push_back(batch);
+    }
+
+    brayns::TrianglesMeshMap meshes;
+    brayns::concatenateMeshes(batches, meshes, false);
+    const auto& mesh = meshes[1];
+    BOOST_REQUIRE_EQUAL(mesh.vertices.size(), 9);
+    BOOST_REQUIRE_EQUAL(mesh.indices.size(), 3);
+
+    // Indices of every batch refer to its own vertices
+    for (size_t i = 0; i < 3; ++i)
+    {
+        const auto& index = mesh.indices[i];
+        BOOST_CHECK_EQUAL(index,
+                          brayns::Vector3ui(3 * i, 3 * i + 1, 3 * i + 2));
+        BOOST_CHECK_EQUAL(mesh.vertices[index.z()],
+                          brayns::Vector3f(float(i), 2.f, 0.f));
+    }
+    BOOST_CHECK(!batches[0]->trianglesMeshes.empty());
+}
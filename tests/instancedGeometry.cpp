@@ -0,0 +1,137 @@
+/* Copyright (c) 2015-2017, EPFL/Blue Brain Project
+ * All rights reserved. Do not distribute without permission.
+ * Responsible Author: Cyrille Favreau <cyrille.favreau@epfl.ch>
+ *
+ * This file is part of Brayns <https://github.com/BlueBrain/Brayns>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <brayns/common/scene/Scene.h>
+#include <brayns/common/utils/Utils.h>
+#include <brayns/parameters/ParametersManager.h>
+
+#define BOOST_TEST_MODULE instancedGeometry
+#include <boost/test/unit_test.hpp>
+
+namespace
+{
+const size_t MATERIAL = brayns::NB_SYSTEM_MATERIALS;
+const size_t NB_SPHERES = 10;
+
+// Simulation offsets of the neurons sharing the geometry
+const uint64_t SIMULATION_OFFSETS[] = {0, 1000, 123456};
+const size_t NB_INSTANCES = 3;
+
+/** Scene without rendering engine, with or without instancing support */
+class TestScene : public brayns::Scene
+{
+public:
+    TestScene(brayns::ParametersManager& parametersManager,
+              const bool instancing)
+        : brayns::Scene(brayns::Renderers(), parametersManager)
+        , _instancing(instancing)
+    {
+    }
+
+    void commit() final {}
+    void commitLights() final {}
+    void buildGeometry() final {}
+    uint64_t serializeGeometry() final { return 0; }
+    void commitSimulationData() final {}
+    void commitVolumeData() final {}
+    void commitTransferFunctionData() final {}
+    void commitMaterials(const brayns::Action) final {}
+    bool isVolumeSupported(const std::string&) const final { return false; }
+    bool supportsInstancing() const final { return _instancing; }
+private:
+    bool _instancing;
+};
+
+/**
+ * Morphology shared by several neurons, its spheres mapped to the first
+ * compartments of the simulation data relative to the neuron
+ */
+brayns::InstancedGeometryPtr createNeurons()
+{
+    brayns::InstancedGeometryPtr geometry(new brayns::InstancedGeometry);
+    for (size_t i = 0; i < NB_SPHERES; ++i)
+        geometry->spheres[MATERIAL].push_back(
+            {brayns::Vector3f(float(i), 0.f, 0.f), 0.5f, 0.f,
+             brayns::encodeSimulationOffset(i)});
+    geometry->bounds.merge(brayns::Vector3f(-0.5f, -0.5f, -0.5f));
+    geometry->bounds.merge(brayns::Vector3f(NB_SPHERES, 0.5f, 0.5f));
+
+    const brayns::Vector3f scale(1.f, 1.f, 1.f);
+    for (size_t i = 0; i < NB_INSTANCES; ++i)
+    {
+        geometry->transformations.push_back(
+            brayns::Matrix4f(brayns::Vector3f(0.f, 10.f * i, 0.f), scale));
+        geometry->simulationOffsets.push_back(SIMULATION_OFFSETS[i]);
+    }
+    return geometry;
+}
+}
+
+BOOST_AUTO_TEST_CASE(simulation_offset_encoding)
+{
+    for (const uint64_t offset :
+         {uint64_t(0), uint64_t(1), uint64_t(123456), uint64_t(1) << 32,
+          (uint64_t(3) << 32) + 42})
+        BOOST_CHECK_EQUAL(brayns::decodeSimulationOffset(
+                              brayns::encodeSimulationOffset(offset)),
+                          offset);
+}
+
+BOOST_AUTO_TEST_CASE(instance_simulation_offsets)
+{
+    // Engines with instancing keep the geometry shared, and add the offset of
+    // every instance at render time
+    {
+        brayns::ParametersManager parametersManager;
+        TestScene scene(parametersManager, true);
+        scene.addInstancedGeometry(createNeurons());
+        BOOST_CHECK_EQUAL(scene.getSpheres().getNbElements(), 0);
+        BOOST_REQUIRE_EQUAL(scene.getInstancedGeometries().size(), 1);
+        const auto& geometry = *scene.getInstancedGeometries()[0];
+        BOOST_CHECK_EQUAL(geometry.spheres.getNbElements(), NB_SPHERES);
+        BOOST_CHECK_EQUAL_COLLECTIONS(geometry.simulationOffsets.begin(),
+                                      geometry.simulationOffsets.end(),
+                                      SIMULATION_OFFSETS,
+                                      SIMULATION_OFFSETS + NB_INSTANCES);
+        BOOST_CHECK_GE(scene.getWorldBounds().getMax().y(),
+                       10.f * (NB_INSTANCES - 1));
+    }
+
+    // Others get one copy per instance, its primitives mapped to the
+    // simulation data of the instance
+    {
+        brayns::ParametersManager parametersManager;
+        TestScene scene(parametersManager, false);
+        scene.addInstancedGeometry(createNeurons());
+        BOOST_CHECK(scene.getInstancedGeometries().empty());
+        const auto& spheres = scene.getSpheres()[MATERIAL];
+        BOOST_REQUIRE_EQUAL(spheres.size(), NB_INSTANCES * NB_SPHERES);
+        for (size_t instance = 0; instance < NB_INSTANCES; ++instance)
+            for (size_t i = 0; i < NB_SPHERES; ++i)
+            {
+                const auto& sphere = spheres[instance * NB_SPHERES + i];
+                BOOST_CHECK_EQUAL(brayns::decodeSimulationOffset(
+                                      sphere.values),
+                                  SIMULATION_OFFSETS[instance] + i);
+                BOOST_CHECK_EQUAL(sphere.center,
+                                  brayns::Vector3f(i, 10.f * instance, 0.f));
+            }
+    }
+}
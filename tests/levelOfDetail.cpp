@@ -0,0 +1,93 @@
+/* Copyright (c) 2015-2017, EPFL/Blue Brain Project
+ * All rights reserved. Do not distribute without permission.
+ * Responsible Author: Cyrille Favreau <cyrille.favreau@epfl.ch>
+ *
+ * This file is part of Brayns <https://github.com/BlueBrain/Brayns>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <brayns/parameters/RenderingParameters.h>
+
+#define BOOST_TEST_MODULE levelOfDetail
+#include <boost/test/unit_test.hpp>
+
+namespace
+{
+const brayns::Boxf WORLD_BOUNDS(brayns::Vector3f(0.f, 0.f, 0.f),
+                                brayns::Vector3f(10.f, 10.f, 10.f));
+
+brayns::LevelOfDetail getLevelOfDetail(
+    const brayns::RenderingParameters& parameters, const float distance)
+{
+    // Camera in front of the scene, along z
+    const brayns::Vector3f position(5.f, 5.f, 10.f + distance);
+    return parameters.getLevelOfDetail(WORLD_BOUNDS, position);
+}
+}
+
+BOOST_AUTO_TEST_CASE(level_of_detail_without_distances)
+{
+    brayns::RenderingParameters parameters;
+    BOOST_CHECK(getLevelOfDetail(parameters, 1e6f) ==
+                brayns::LevelOfDetail::full);
+
+    parameters.setLevelOfDetail(brayns::LevelOfDetail::skeleton);
+    BOOST_CHECK(getLevelOfDetail(parameters, 0.f) ==
+                brayns::LevelOfDetail::skeleton);
+}
+
+BOOST_AUTO_TEST_CASE(level_of_detail_by_distance)
+{
+    brayns::RenderingParameters parameters;
+    parameters.set("level-of-detail-distances", "100 1000");
+
+    BOOST_CHECK(getLevelOfDetail(parameters, 50.f) ==
+                brayns::LevelOfDetail::full);
+    BOOST_CHECK(getLevelOfDetail(parameters, 100.f) ==
+                brayns::LevelOfDetail::full);
+    BOOST_CHECK(getLevelOfDetail(parameters, 500.f) ==
+                brayns::LevelOfDetail::skeleton);
+    BOOST_CHECK(getLevelOfDetail(parameters, 5000.f) ==
+                brayns::LevelOfDetail::somas);
+
+    // The distance is measured to the closest point of the scene, which is
+    // the camera itself when inside
+    BOOST_CHECK(parameters.getLevelOfDetail(WORLD_BOUNDS,
+                                            brayns::Vector3f(5.f, 5.f, 5.f)) ==
+                brayns::LevelOfDetail::full);
+    BOOST_CHECK(parameters.getLevelOfDetail(
+                    WORLD_BOUNDS, brayns::Vector3f(-300.f, -400.f, 5.f)) ==
+                brayns::LevelOfDetail::skeleton);
+
+    // Distances never raise the requested level
+    parameters.setLevelOfDetail(brayns::LevelOfDetail::somas);
+    BOOST_CHECK(getLevelOfDetail(parameters, 0.f) ==
+                brayns::LevelOfDetail::somas);
+    parameters.setLevelOfDetail(brayns::LevelOfDetail::skeleton);
+    BOOST_CHECK(getLevelOfDetail(parameters, 500.f) ==
+                brayns::LevelOfDetail::skeleton);
+    BOOST_CHECK(getLevelOfDetail(parameters, 5000.f) ==
+                brayns::LevelOfDetail::somas);
+}
+
+BOOST_AUTO_TEST_CASE(level_of_detail_single_distance)
+{
+    brayns::RenderingParameters parameters;
+    parameters.set("level-of-detail-distances", "100");
+    BOOST_CHECK(getLevelOfDetail(parameters, 50.f) ==
+                brayns::LevelOfDetail::full);
+    BOOST_CHECK(getLevelOfDetail(parameters, 1e6f) ==
+                brayns::LevelOfDetail::skeleton);
+}
@@ -0,0 +1,271 @@
+/* Copyright (c) 2015-2017, EPFL/Blue Brain Project
+ * All rights reserved. Do not distribute without permission.
+ * Responsible Author: Cyrille Favreau <cyrille.favreau@epfl.ch>
+ *
+ * This file is part of Brayns <https://github.com/BlueBrain/Brayns>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+#include <brayns/common/geometry/TrianglesMesh.h>
+#include <brayns/io/algorithms/MetaballsGenerator.h>
+
+#define BOOST_TEST_MODULE metaballs
+#include <boost/test/unit_test.hpp>
+
+#include <cmath>
+#include <map>
+#include <set>
+#include <tuple>
+
+namespace
+{
+const size_t GRID_SIZE = 40;
+const float THRESHOLD = 1.f;
+const size_t MATERIAL = 0;
+
+// Tolerance, in cells, when locating a vertex in the grid
+const float CELL_EPSILON = 1e-3f;
+
+// A soma with the first samples of a few sections, as built by the morphology
+// loader
+brayns::Vector4fs makeMetaballs()
+{
+    return {{0.f, 0.f, 0.f, 4.f},   {6.f, 1.f, 0.f, 1.f},
+            {-5.f, 2.f, 1.f, 1.5f}, {0.5f, -7.f, 2.f, 0.8f},
+            {1.f, 3.f, -6.f, 1.2f}, {-2.f, -2.f, 5.f, 0.6f}};
+}
+
+// Same grid as the one of the generator
+struct Grid
+{
+    explicit Grid(const brayns::Vector4fs& metaballs)
+    {
+        brayns::Boxf bounds;
+        for (const auto& ball : metaballs)
+            bounds.merge(brayns::Vector3f(ball.x(), ball.y(), ball.z()));
+        const brayns::Vector3f size = 5.f * bounds.getSize();
+        origin = bounds.getCenter() - size / 2.f;
+        cellSize = size / static_cast<float>(GRID_SIZE);
+    }
+
+    brayns::Vector3f origin;
+    brayns::Vector3f cellSize;
+};
+
+size_t cellIndex(const size_t x, const size_t y, const size_t z)
+{
+    return (x * GRID_SIZE + y) * GRID_SIZE + z;
+}
+
+// Cells of the whole grid with corners on both sides of the isosurface
+std::set<size_t> findDenseSurfaceCells(const brayns::Vector4fs& metaballs)
+{
+    const Grid grid(metaballs);
+    const size_t nbVertices = GRID_SIZE + 1;
+    std::vector<bool> ones(nbVertices * nbVertices * nbVertices);
+    for (size_t x = 0; x < nbVertices; ++x)
+        for (size_t y = 0; y < nbVertices; ++y)
+            for (size_t z = 0; z < nbVertices; ++z)
+            {
+                const brayns::Vector3f position(
+                    grid.origin.x() + x * grid.cellSize.x(),
+                    grid.origin.y() + y * grid.cellSize.y(),
+                    grid.origin.z() + z * grid.cellSize.z());
+                float value = 0.f;
+                for (const auto& ball : metaballs)
+                {
+                    const float squaredDistance =
+                        (position -
+                         brayns::Vector3f(ball.x(), ball.y(), ball.z()))
+                            .squared_length();
+                    if (squaredDistance != 0.f)
+                        value += ball.w() * ball.w() / squaredDistance;
+                }
+                ones[(x * nbVertices + y) * nbVertices + z] =
+                    value > 0.f && value < THRESHOLD;
+            }
+
+    std::set<size_t> cells;
+    for (size_t x = 0; x < GRID_SIZE; ++x)
+        for (size_t y = 0; y < GRID_SIZE; ++y)
+            for (size_t z = 0; z < GRID_SIZE; ++z)
+            {
+                size_t nbOnes = 0;
+                for (size_t i = 0; i < 8; ++i)
+                    if (ones[((x + (i & 1)) * nbVertices + y + ((i >> 1) & 1)) *
+                                 nbVertices +
+                             z + ((i >> 2) & 1)])
+                        ++nbOnes;
+                if (nbOnes != 0 && nbOnes != 8)
+                    cells.insert(cellIndex(x, y, z));
+            }
+    return cells;
+}
+
+// Cells whose closed box contains the given vertex, as ranges per axis
+void locateVertex(const Grid& grid, const brayns::Vector3f& vertex,
+                  size_t first[3], size_t last[3])
+{
+    for (size_t axis = 0; axis < 3; ++axis)
+    {
+        const float t =
+            (vertex[axis] - grid.origin[axis]) / grid.cellSize[axis];
+        const float maxCell = static_cast<float>(GRID_SIZE - 1);
+        first[axis] = static_cast<size_t>(
+            std::max(0.f, std::min(maxCell, std::floor(t - CELL_EPSILON))));
+        last[axis] = static_cast<size_t>(
+            std::max(0.f, std::min(maxCell, std::floor(t + CELL_EPSILON))));
+    }
+}
+
+// Cells that contain the three vertices of the triangle
+std::vector<size_t> locateTriangle(const Grid& grid,
+                                   const brayns::TrianglesMesh& mesh,
+                                   const brayns::Vector3ui& triangle)
+{
+    size_t first[3] = {0, 0, 0};
+    size_t last[3] = {GRID_SIZE - 1, GRID_SIZE - 1, GRID_SIZE - 1};
+    for (size_t i = 0; i < 3; ++i)
+    {
+        size_t vertexFirst[3];
+        size_t vertexLast[3];
+        locateVertex(grid, mesh.vertices[triangle[i]], vertexFirst,
+                     vertexLast);
+        for (size_t axis = 0; axis < 3; ++axis)
+        {
+            first[axis] = std::max(first[axis], vertexFirst[axis]);
+            last[axis] = std::min(last[axis], vertexLast[axis]);
+        }
+    }
+
+    std::vector<size_t> cells;
+    for (size_t x = first[0]; x <= last[0]; ++x)
+        for (size_t y = first[1]; y <= last[1]; ++y)
+            for (size_t z = first[2]; z <= last[2]; ++z)
+                cells.push_back(cellIndex(x, y, z));
+    return cells;
+}
+
+// Two tiny balls set a grid of unit cells from -16 to 24, two others sit next
+// to the diagonal corners (4, 3, 3) and (4, 4, 4) of a face of the cell at
+// (3, 3, 3), which is the case 175 of the marching cubes: only those corners
+// are above the threshold
+brayns::Vector4fs makeSaddleMetaballs()
+{
+    return {{0.f, 0.f, 0.f, 0.001f},
+            {8.f, 8.f, 8.f, 0.001f},
+            {4.1f, 3.1f, 3.05f, 0.5f},
+            {4.05f, 4.1f, 4.1f, 0.5f}};
+}
+
+// Triangle edges used by a single triangle: as neighbouring cells interpolate
+// the same grid samples, a closed isosurface has none
+size_t countBorderEdges(const Grid& grid, const brayns::TrianglesMesh& mesh)
+{
+    typedef std::tuple<int64_t, int64_t, int64_t> Point;
+    const auto snap = [&grid](const brayns::Vector3f& vertex) {
+        int64_t coordinates[3];
+        for (size_t axis = 0; axis < 3; ++axis)
+            coordinates[axis] = std::llround(
+                (vertex[axis] - grid.origin[axis]) /
+                (grid.cellSize[axis] * CELL_EPSILON));
+        return Point(coordinates[0], coordinates[1], coordinates[2]);
+    };
+
+    std::map<std::pair<Point, Point>, size_t> edges;
+    for (const auto& triangle : mesh.indices)
+        for (size_t i = 0; i < 3; ++i)
+        {
+            Point first = snap(mesh.vertices[triangle[i]]);
+            Point second = snap(mesh.vertices[triangle[(i + 1) % 3]]);
+            if (second < first)
+                std::swap(first, second);
+            ++edges[std::make_pair(first, second)];
+        }
+
+    size_t nbBorderEdges = 0;
+    for (const auto& edge : edges)
+        if (edge.second == 1)
+            ++nbBorderEdges;
+    return nbBorderEdges;
+}
+
+brayns::TrianglesMesh generate(const brayns::Vector4fs& metaballs)
+{
+    brayns::TrianglesMeshMap meshes;
+    brayns::MetaballsGenerator generator;
+    generator.generateMesh(metaballs, GRID_SIZE, THRESHOLD, MATERIAL, meshes);
+    return meshes[MATERIAL];
+}
+
+void checkSparseMeshMatchesDenseGrid(const brayns::Vector4fs& metaballs)
+{
+    const auto mesh = generate(metaballs);
+    BOOST_REQUIRE(!mesh.indices.empty());
+    BOOST_CHECK_EQUAL(mesh.vertices.size(), mesh.normals.size());
+
+    const Grid grid(metaballs);
+    const auto denseCells = findDenseSurfaceCells(metaballs);
+
+    // Every triangle lies in a cell that the isosurface goes through, and
+    // every such cell of the whole grid is triangulated
+    std::set<size_t> meshCells;
+    for (const auto& triangle : mesh.indices)
+    {
+        for (size_t i = 0; i < 3; ++i)
+            BOOST_REQUIRE_LT(triangle[i], mesh.vertices.size());
+
+        bool inSurfaceCell = false;
+        for (const auto cell : locateTriangle(grid, mesh, triangle))
+        {
+            meshCells.insert(cell);
+            if (denseCells.count(cell))
+                inSurfaceCell = true;
+        }
+        BOOST_CHECK(inSurfaceCell);
+    }
+
+    size_t nbMissingCells = 0;
+    for (const auto cell : denseCells)
+        if (!meshCells.count(cell))
+            ++nbMissingCells;
+    BOOST_CHECK_EQUAL(nbMissingCells, 0);
+    BOOST_CHECK_EQUAL(countBorderEdges(grid, mesh), 0);
+}
+}
+
+BOOST_AUTO_TEST_CASE(sparse_mesh_matches_dense_grid)
+{
+    checkSparseMeshMatchesDenseGrid(makeMetaballs());
+}
+
+BOOST_AUTO_TEST_CASE(sparse_mesh_matches_dense_grid_with_saddle)
+{
+    checkSparseMeshMatchesDenseGrid(makeSaddleMetaballs());
+}
+
+BOOST_AUTO_TEST_CASE(deterministic_mesh)
+{
+    const auto metaballs = makeMetaballs();
+    const auto first = generate(metaballs);
+    for (size_t run = 0; run < 5; ++run)
+    {
+        const auto mesh = generate(metaballs);
+        BOOST_REQUIRE_EQUAL(mesh.vertices.size(), first.vertices.size());
+        BOOST_REQUIRE_EQUAL(mesh.indices.size(), first.indices.size());
+        BOOST_CHECK(mesh.vertices == first.vertices);
+        BOOST_CHECK(mesh.normals == first.normals);
+        BOOST_CHECK(mesh.indices == first.indices);
+    }
+}
@@ -0,0 +1,186 @@
+/* Copyright (c) 2015-2017, EPFL/Blue Brain Project
+ * All rights reserved. Do not distribute without permission.
+ * Responsible Author: Cyrille Favreau <cyrille.favreau@epfl.ch>
+ *
+ * This file is part of Brayns <https://github.com/BlueBrain/Brayns>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <brayns/common/scene/Scene.h>
+#include <brayns/io/MeshLoader.h>
+#include <brayns/io/MolecularSystemReader.h>
+#include <brayns/io/ProteinLoader.h>
+#include <brayns/parameters/GeometryParameters.h>
+#include <brayns/parameters/ParametersManager.h>
+
+#include <tests/paths.h>
+
+#define BOOST_TEST_MODULE molecularSystem
+#include <boost/test/unit_test.hpp>
+
+#include <boost/filesystem.hpp>
+
+#include <fstream>
+
+namespace
+{
+// Two proteins sharing the same PDB file, placed 3 and 2 times
+const size_t NB_FIRST_PROTEINS = 3;
+const size_t NB_SECOND_PROTEINS = 2;
+
+/** Scene without rendering engine, with or without instancing support */
+class TestScene : public brayns::Scene
+{
+public:
+    TestScene(brayns::ParametersManager& parametersManager,
+              const bool instancing)
+        : brayns::Scene(brayns::Renderers(), parametersManager)
+        , _instancing(instancing)
+    {
+    }
+
+    void commit() final {}
+    void commitLights() final {}
+    void buildGeometry() final {}
+    uint64_t serializeGeometry() final { return 0; }
+    void commitSimulationData() final {}
+    void commitVolumeData() final {}
+    void commitTransferFunctionData() final {}
+    void commitMaterials(const brayns::Action) final {}
+    bool isVolumeSupported(const std::string&) const final { return false; }
+    bool supportsInstancing() const final { return _instancing; }
+private:
+    bool _instancing;
+};
+
+/** Molecular system configuration, removed when the test ends */
+struct MolecularSystem
+{
+    MolecularSystem()
+        : folder(boost::filesystem::temp_directory_path() /
+                 boost::filesystem::unique_path("brayns-%%%%%%%%"))
+    {
+        boost::filesystem::create_directories(folder);
+
+        std::ofstream descriptor((folder / "descriptor.txt").string());
+        descriptor << "1bna 1 " << NB_FIRST_PROTEINS << std::endl;
+        descriptor << "1bna 2 " << NB_SECOND_PROTEINS << std::endl;
+
+        // Positions of unknown proteins are ignored
+        std::ofstream positions((folder / "positions.txt").string());
+        for (size_t i = 0; i < NB_FIRST_PROTEINS; ++i)
+            positions << "1 " << 100 * i << " 0 0" << std::endl;
+        for (size_t i = 0; i < NB_SECOND_PROTEINS; ++i)
+            positions << "2 0 " << 100 * i << " 0" << std::endl;
+        positions << "3 0 0 100" << std::endl;
+
+        std::ofstream configuration(getConfiguration());
+        configuration << "ProteinFolder " << BRAYNS_TESTDATA << std::endl;
+        configuration << "SystemDescriptor "
+                      << (folder / "descriptor.txt").string() << std::endl;
+        configuration << "ProteinPositions "
+                      << (folder / "positions.txt").string() << std::endl;
+    }
+    ~MolecularSystem() { boost::filesystem::remove_all(folder); }
+    std::string getConfiguration() const
+    {
+        return (folder / "configuration.txt").string();
+    }
+
+    const boost::filesystem::path folder;
+};
+
+size_t getNbAtoms(const brayns::GeometryParameters& geometryParameters)
+{
+    brayns::SpheresMap spheres;
+    brayns::ProteinLoader loader(geometryParameters);
+    BOOST_REQUIRE(loader.importPDBFile(BRAYNS_TESTDATA +
+                                           std::string("1bna.pdb"),
+                                       brayns::Vector3f(), 0,
+                                       brayns::NB_SYSTEM_MATERIALS, spheres));
+    return spheres.getNbElements();
+}
+
+void importMolecularSystem(brayns::ParametersManager& parametersManager,
+                           brayns::Scene& scene,
+                           const MolecularSystem& molecularSystem)
+{
+    auto& geometryParameters = parametersManager.getGeometryParameters();
+    geometryParameters.set("molecular-system-config",
+                           molecularSystem.getConfiguration());
+    scene.resetMaterials();
+    brayns::MeshLoader meshLoader(geometryParameters);
+    brayns::MolecularSystemReader reader(geometryParameters);
+    BOOST_REQUIRE(reader.import(scene, meshLoader));
+}
+}
+
+BOOST_AUTO_TEST_CASE(protein_instances)
+{
+    MolecularSystem molecularSystem;
+    brayns::ParametersManager parametersManager;
+    TestScene scene(parametersManager, true);
+    importMolecularSystem(parametersManager, scene, molecularSystem);
+
+    // Every protein is loaded once, with one transformation per position
+    const auto nbAtoms = getNbAtoms(parametersManager.getGeometryParameters());
+    BOOST_REQUIRE_GT(nbAtoms, 0);
+    const auto& geometries = scene.getInstancedGeometries();
+    BOOST_REQUIRE_EQUAL(geometries.size(), 2);
+    BOOST_CHECK_EQUAL(geometries[0]->transformations.size(),
+                      NB_FIRST_PROTEINS);
+    BOOST_CHECK_EQUAL(geometries[1]->transformations.size(),
+                      NB_SECOND_PROTEINS);
+    for (const auto& geometry : geometries)
+        BOOST_CHECK_EQUAL(geometry->spheres.getNbElements(), nbAtoms);
+    BOOST_CHECK_EQUAL(scene.getSpheres().getNbElements(), 0);
+
+    // Bounds cover all instances
+    const auto& bounds = scene.getWorldBounds();
+    BOOST_CHECK_GE(bounds.getMax().x(), 100.f * (NB_FIRST_PROTEINS - 1));
+    BOOST_CHECK_GE(bounds.getMax().y(), 100.f * (NB_SECOND_PROTEINS - 1));
+}
+
+BOOST_AUTO_TEST_CASE(protein_copies)
+{
+    MolecularSystem molecularSystem;
+    const size_t nbProteins = NB_FIRST_PROTEINS + NB_SECOND_PROTEINS;
+
+    // Engines without instancing get one copy of the protein per position
+    {
+        brayns::ParametersManager parametersManager;
+        TestScene scene(parametersManager, false);
+        importMolecularSystem(parametersManager, scene, molecularSystem);
+        const auto nbAtoms =
+            getNbAtoms(parametersManager.getGeometryParameters());
+        BOOST_CHECK(scene.getInstancedGeometries().empty());
+        BOOST_CHECK_EQUAL(scene.getSpheres().getNbElements(),
+                          nbProteins * nbAtoms);
+    }
+
+    // So do proteins colored by ID, which have one material per instance
+    {
+        brayns::ParametersManager parametersManager;
+        parametersManager.getGeometryParameters().set("color-scheme",
+                                                      "protein-by-id");
+        TestScene scene(parametersManager, true);
+        importMolecularSystem(parametersManager, scene, molecularSystem);
+        const auto nbAtoms =
+            getNbAtoms(parametersManager.getGeometryParameters());
+        BOOST_CHECK(scene.getInstancedGeometries().empty());
+        BOOST_CHECK_EQUAL(scene.getSpheres().getNbElements(),
+                          nbProteins * nbAtoms);
+    }
+}
@@ -0,0 +1,210 @@
+/* Copyright (c) 2015-2017, EPFL/Blue Brain Project
+ * All rights reserved. Do not distribute without permission.
+ * Responsible Author: Cyrille Favreau <cyrille.favreau@epfl.ch>
+ *
+ * This file is part of Brayns <https://github.com/BlueBrain/Brayns>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <brayns/io/MorphologyCache.h>
+#include <brayns/parameters/GeometryParameters.h>
+
+#define BOOST_TEST_MODULE morphologyCache
+#include <boost/test/unit_test.hpp>
+
+#include <boost/filesystem.hpp>
+
+#include <fstream>
+
+namespace fs = boost::filesystem;
+
+namespace
+{
+/** Morphology file and cache folder removed when the test ends */
+struct CacheFolder
+{
+    CacheFolder()
+        : folder(fs::temp_directory_path() /
+                 fs::unique_path("brayns-%%%%%%%%"))
+        , morphologyFile((folder / "morphology.h5").string())
+    {
+        fs::create_directories(folder);
+        writeMorphology("morphology");
+        parameters.set("morphology-cache-folder",
+                       (folder / "cache").string());
+    }
+
+    ~CacheFolder()
+    {
+        boost::system::error_code error;
+        fs::remove_all(folder, error);
+    }
+
+    void writeMorphology(const std::string& content)
+    {
+        std::ofstream file(morphologyFile, std::ios::binary);
+        file << content;
+    }
+
+    std::vector<fs::path> entries() const
+    {
+        std::vector<fs::path> paths;
+        if (!fs::exists(folder / "cache"))
+            return paths;
+        for (const auto& entry : fs::directory_iterator(folder / "cache"))
+            paths.push_back(entry.path());
+        return paths;
+    }
+
+    fs::path folder;
+    std::string morphologyFile;
+    brayns::GeometryParameters parameters;
+};
+
+brayns::MorphologyTessellation createTessellation()
+{
+    brayns::MorphologyTessellation tessellation;
+    tessellation.hasSoma = true;
+    tessellation.somaCenter = brayns::Vector3f(1.f, 2.f, 3.f);
+    tessellation.somaRadius = 4.f;
+    tessellation.somaChildren.push_back(brayns::Vector4f(5.f, 6.f, 7.f, 8.f));
+    tessellation.axonSections = {2, 3, 5};
+    for (uint32_t i = 0; i < 10; ++i)
+    {
+        brayns::MorphologySample sample;
+        sample.position = brayns::Vector3f(float(i), 0.f, 0.f);
+        sample.target = brayns::Vector3f(float(i + 1), 0.f, 0.f);
+        sample.radius = 0.5f;
+        sample.previousRadius = i == 0 ? 0.f : 0.5f;
+        sample.distanceToSoma = float(i);
+        sample.sectionID = i / 2;
+        sample.sectionType = 3;
+        sample.segment = i;
+        sample.nbSectionSamples = 2;
+        tessellation.samples.push_back(sample);
+    }
+    return tessellation;
+}
+}
+
+BOOST_AUTO_TEST_CASE(disabled_morphology_cache)
+{
+    CacheFolder cacheFolder;
+    brayns::GeometryParameters parameters;
+    brayns::MorphologyCache cache(parameters);
+    BOOST_CHECK(!cache.isEnabled());
+
+    brayns::MorphologyTessellation tessellation;
+    BOOST_CHECK(!cache.load(cacheFolder.morphologyFile, tessellation));
+}
+
+BOOST_AUTO_TEST_CASE(morphology_cache_hit_and_miss)
+{
+    CacheFolder cacheFolder;
+    brayns::MorphologyCache cache(cacheFolder.parameters);
+    BOOST_REQUIRE(cache.isEnabled());
+
+    brayns::MorphologyTessellation tessellation;
+    BOOST_CHECK(!cache.load(cacheFolder.morphologyFile, tessellation));
+
+    const auto expected = createTessellation();
+    cache.save(cacheFolder.morphologyFile, expected);
+    BOOST_REQUIRE_EQUAL(cacheFolder.entries().size(), 1);
+
+    BOOST_REQUIRE(cache.load(cacheFolder.morphologyFile, tessellation));
+    BOOST_CHECK(tessellation.hasSoma);
+    BOOST_CHECK_EQUAL(tessellation.somaCenter, expected.somaCenter);
+    BOOST_CHECK_EQUAL(tessellation.somaRadius, expected.somaRadius);
+    BOOST_CHECK_EQUAL_COLLECTIONS(tessellation.somaChildren.begin(),
+                                  tessellation.somaChildren.end(),
+                                  expected.somaChildren.begin(),
+                                  expected.somaChildren.end());
+    BOOST_CHECK_EQUAL_COLLECTIONS(tessellation.axonSections.begin(),
+                                  tessellation.axonSections.end(),
+                                  expected.axonSections.begin(),
+                                  expected.axonSections.end());
+    BOOST_REQUIRE_EQUAL(tessellation.samples.size(), expected.samples.size());
+    for (size_t i = 0; i < expected.samples.size(); ++i)
+    {
+        const auto& sample = tessellation.samples[i];
+        const auto& expectedSample = expected.samples[i];
+        BOOST_CHECK_EQUAL(sample.position, expectedSample.position);
+        BOOST_CHECK_EQUAL(sample.target, expectedSample.target);
+        BOOST_CHECK_EQUAL(sample.previousRadius,
+                          expectedSample.previousRadius);
+        BOOST_CHECK_EQUAL(sample.sectionID, expectedSample.sectionID);
+        BOOST_CHECK_EQUAL(sample.segment, expectedSample.segment);
+    }
+
+    // Other morphologies miss
+    const auto otherFile = (cacheFolder.folder / "other.h5").string();
+    BOOST_CHECK(!cache.load(otherFile, tessellation));
+}
+
+BOOST_AUTO_TEST_CASE(morphology_cache_invalidation)
+{
+    CacheFolder cacheFolder;
+    brayns::MorphologyCache cache(cacheFolder.parameters);
+    cache.save(cacheFolder.morphologyFile, createTessellation());
+
+    // Parameters affecting the tessellation use other entries
+    brayns::MorphologyTessellation tessellation;
+    cacheFolder.parameters.set("radius-multiplier", "2");
+    BOOST_CHECK(!cache.load(cacheFolder.morphologyFile, tessellation));
+    cacheFolder.parameters.set("radius-multiplier", "1");
+    BOOST_CHECK(cache.load(cacheFolder.morphologyFile, tessellation));
+
+    // So do modified morphologies
+    cacheFolder.writeMorphology("modified morphology");
+    BOOST_CHECK(!cache.load(cacheFolder.morphologyFile, tessellation));
+}
+
+BOOST_AUTO_TEST_CASE(corrupted_morphology_cache_entry)
+{
+    CacheFolder cacheFolder;
+    brayns::MorphologyCache cache(cacheFolder.parameters);
+    cache.save(cacheFolder.morphologyFile, createTessellation());
+    const auto entries = cacheFolder.entries();
+    BOOST_REQUIRE_EQUAL(entries.size(), 1);
+
+    // Huge sample count in the header, the entry is ignored without
+    // allocating the samples
+    std::vector<char> data(fs::file_size(entries[0]));
+    {
+        std::ifstream file(entries[0].string(), std::ios::binary);
+        file.read(data.data(), data.size());
+    }
+    auto truncated = data;
+    truncated.resize(data.size() - 1);
+    const size_t nbSamplesOffset = 48;
+    const uint64_t nbSamples = uint64_t(1) << 60;
+    std::copy((const char*)&nbSamples, (const char*)&nbSamples + 8,
+              data.begin() + nbSamplesOffset);
+    {
+        std::ofstream file(entries[0].string(), std::ios::binary);
+        file.write(data.data(), data.size());
+    }
+
+    brayns::MorphologyTessellation tessellation;
+    BOOST_CHECK_NO_THROW(
+        BOOST_CHECK(!cache.load(cacheFolder.morphologyFile, tessellation)));
+
+    // So is a truncated entry
+    {
+        std::ofstream file(entries[0].string(), std::ios::binary);
+        file.write(truncated.data(), truncated.size());
+    }
+    BOOST_CHECK(!cache.load(cacheFolder.morphologyFile, tessellation));
+}
@@ -0,0 +1,146 @@
+/* Copyright (c) 2015-2017, EPFL/Blue Brain Project
+ * All rights reserved. Do not distribute without permission.
+ * Responsible Author: Cyrille Favreau <cyrille.favreau@epfl.ch>
+ *
+ * This file is part of Brayns <https://github.com/BlueBrain/Brayns>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <brayns/io/MorphologyPrefetcher.h>
+
+#define BOOST_TEST_MODULE morphologyPrefetcher
+#include <boost/test/unit_test.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+
+namespace
+{
+const uint64_t NB_MORPHOLOGIES = 100;
+
+/** Reads a tessellation identified by the morphology index */
+void readMorphology(const uint64_t index,
+                    brayns::MorphologyTessellation& tessellation)
+{
+    tessellation.hasSoma = true;
+    tessellation.somaRadius = float(index);
+}
+}
+
+BOOST_AUTO_TEST_CASE(prefetch_all_morphologies)
+{
+    // Every 7th morphology cannot be read
+    const auto read = [](const uint64_t index,
+                         brayns::MorphologyTessellation& tessellation) {
+        if (index % 7 == 0)
+            throw std::runtime_error("Cannot read morphology");
+        readMorphology(index, tessellation);
+    };
+
+    for (const size_t queueDepth : {1, 4, 1000})
+    {
+        brayns::MorphologyPrefetcher prefetcher(NB_MORPHOLOGIES, 4, queueDepth,
+                                                read);
+        BOOST_CHECK_EQUAL(prefetcher.getNbThreads(), 4);
+
+        // Several consumers, every morphology being popped once. Checks are
+        // counted, since Boost.Test is not thread safe.
+        std::vector<std::atomic<size_t>> nbPops(NB_MORPHOLOGIES);
+        std::atomic<size_t> nbFailures{0};
+        std::atomic<size_t> nbWrongMorphologies{0};
+        std::vector<std::thread> consumers;
+        for (size_t i = 0; i < 3; ++i)
+            consumers.emplace_back([&] {
+                brayns::PrefetchedMorphology morphology;
+                while (prefetcher.pop(morphology))
+                {
+                    ++nbPops[morphology.index];
+                    if (!morphology.valid)
+                        ++nbFailures;
+                    else if (morphology.tessellation.somaRadius !=
+                             float(morphology.index))
+                        ++nbWrongMorphologies;
+                }
+            });
+        for (auto& consumer : consumers)
+            consumer.join();
+
+        for (const auto& count : nbPops)
+            BOOST_CHECK_EQUAL(count, 1);
+        BOOST_CHECK_EQUAL(nbFailures, (NB_MORPHOLOGIES + 6) / 7);
+        BOOST_CHECK_EQUAL(nbWrongMorphologies, 0);
+
+        brayns::PrefetchedMorphology morphology;
+        BOOST_CHECK(!prefetcher.pop(morphology));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(prefetch_bounded_queue)
+{
+    const size_t nbThreads = 2;
+    const size_t queueDepth = 1;
+    std::atomic<uint64_t> nbReads{0};
+    brayns::MorphologyPrefetcher prefetcher(
+        NB_MORPHOLOGIES, nbThreads, queueDepth,
+        [&nbReads](const uint64_t index,
+                   brayns::MorphologyTessellation& tessellation) {
+            ++nbReads;
+            readMorphology(index, tessellation);
+        });
+
+    // Without consumer, reading stops once the queue is full, with at most
+    // one read morphology waiting to be queued per thread
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    BOOST_CHECK_LE(nbReads, queueDepth + nbThreads);
+
+    // Morphologies are consumed in the order they are queued, so reading
+    // resumes one morphology at a time
+    brayns::PrefetchedMorphology morphology;
+    for (uint64_t i = 0; i < 10; ++i)
+    {
+        BOOST_REQUIRE(prefetcher.pop(morphology));
+        BOOST_CHECK(morphology.valid);
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        BOOST_CHECK_LE(nbReads, i + 1 + queueDepth + nbThreads);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(prefetch_shutdown)
+{
+    // Destroying the prefetcher stops I/O threads waiting for room in the
+    // queue, and threads that are still reading
+    std::atomic<uint64_t> nbReads{0};
+    {
+        brayns::MorphologyPrefetcher prefetcher(
+            NB_MORPHOLOGIES, 4, 1,
+            [&nbReads](const uint64_t index,
+                       brayns::MorphologyTessellation& tessellation) {
+                ++nbReads;
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                readMorphology(index, tessellation);
+            });
+        brayns::PrefetchedMorphology morphology;
+        BOOST_REQUIRE(prefetcher.pop(morphology));
+    }
+    BOOST_CHECK_LT(nbReads, NB_MORPHOLOGIES);
+
+    // No thread is started when there is nothing to read
+    brayns::MorphologyPrefetcher empty(0, 4, 1, readMorphology);
+    BOOST_CHECK_EQUAL(empty.getNbThreads(), 0);
+    brayns::PrefetchedMorphology morphology;
+    BOOST_CHECK(!empty.pop(morphology));
+}
@@ -0,0 +1,146 @@
+/* Copyright (c) 2015-2017, EPFL/Blue Brain Project
+ * All rights reserved. Do not distribute without permission.
+ * Responsible Author: Cyrille Favreau <cyrille.favreau@epfl.ch>
+ *
+ * This file is part of Brayns <https://github.com/BlueBrain/Brayns>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+#include <brayns/common/simulation/PlaybackScheduler.h>
+
+#define BOOST_TEST_MODULE playbackScheduler
+#include <boost/test/unit_test.hpp>
+
+namespace
+{
+// Frame durations are powers of two, so that positions are exact
+const float FRAMES_PER_SECOND = 8.f;
+
+brayns::PlaybackScheduler::Clock::time_point at(const double seconds)
+{
+    return brayns::PlaybackScheduler::Clock::time_point() +
+           std::chrono::duration_cast<
+               brayns::PlaybackScheduler::Clock::duration>(
+               std::chrono::duration<double>(seconds));
+}
+}
+
+BOOST_AUTO_TEST_CASE(play_at_target_rate)
+{
+    brayns::PlaybackScheduler scheduler;
+    BOOST_CHECK_EQUAL(scheduler.advance(FRAMES_PER_SECOND, 1, true, at(1.0)),
+                      1);
+
+    // Rendering faster than the target rate renders the same frame again
+    BOOST_CHECK_EQUAL(
+        scheduler.advance(FRAMES_PER_SECOND, 1, true, at(1.0625)), 0);
+    BOOST_CHECK_EQUAL(scheduler.advance(FRAMES_PER_SECOND, 1, true, at(1.125)),
+                      1);
+    BOOST_CHECK_EQUAL(scheduler.advance(FRAMES_PER_SECOND, 1, true, at(1.25)),
+                      1);
+    BOOST_CHECK(scheduler.isPlaying());
+    BOOST_CHECK_EQUAL(scheduler.getNbPlayedFrames(), 2);
+    BOOST_CHECK_EQUAL(scheduler.getPlaybackTime(), 0.25);
+    BOOST_CHECK_EQUAL(scheduler.getNbDroppedFrames(), 0);
+    BOOST_CHECK_EQUAL(scheduler.getStallTime(), 0.0);
+    BOOST_CHECK_CLOSE(scheduler.getEffectiveRate(), 2.f / 0.25f, 0.001f);
+}
+
+BOOST_AUTO_TEST_CASE(drop_frames_when_rendering_is_slow)
+{
+    brayns::PlaybackScheduler scheduler;
+    scheduler.advance(FRAMES_PER_SECOND, 1, true, at(1.0));
+
+    // Three frames elapsed during the rendering, two of them are skipped
+    BOOST_CHECK_EQUAL(scheduler.advance(FRAMES_PER_SECOND, 1, true, at(1.375)),
+                      3);
+    BOOST_CHECK_EQUAL(scheduler.getNbDroppedFrames(), 2);
+    BOOST_CHECK_EQUAL(scheduler.advance(FRAMES_PER_SECOND, 1, true, at(1.5)),
+                      1);
+    BOOST_CHECK_EQUAL(scheduler.getNbDroppedFrames(), 2);
+}
+
+BOOST_AUTO_TEST_CASE(move_by_whole_steps)
+{
+    brayns::PlaybackScheduler scheduler;
+    BOOST_CHECK_EQUAL(scheduler.advance(FRAMES_PER_SECOND, 2, true, at(1.0)),
+                      2);
+
+    // Three frames elapsed, playback moves by one step of two frames and
+    // keeps the last one for the next step
+    BOOST_CHECK_EQUAL(
+        scheduler.advance(FRAMES_PER_SECOND, 2, true, at(1.1875)), 2);
+    BOOST_CHECK_EQUAL(scheduler.getNbDroppedFrames(), 0);
+    BOOST_CHECK_EQUAL(scheduler.advance(FRAMES_PER_SECOND, 2, true, at(1.25)),
+                      2);
+    BOOST_CHECK_EQUAL(scheduler.getNbDroppedFrames(), 0);
+
+    // Two steps elapsed, one of them is skipped
+    BOOST_CHECK_EQUAL(scheduler.advance(FRAMES_PER_SECOND, 2, true, at(1.5)),
+                      4);
+    BOOST_CHECK_EQUAL(scheduler.getNbDroppedFrames(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(play_backward)
+{
+    brayns::PlaybackScheduler scheduler;
+    BOOST_CHECK_EQUAL(scheduler.advance(FRAMES_PER_SECOND, -2, true, at(1.0)),
+                      -2);
+    BOOST_CHECK_EQUAL(
+        scheduler.advance(FRAMES_PER_SECOND, -2, true, at(1.1875)), -2);
+    BOOST_CHECK_EQUAL(
+        scheduler.advance(FRAMES_PER_SECOND, -2, true, at(1.5625)), -6);
+    BOOST_CHECK_EQUAL(scheduler.getNbDroppedFrames(), 2);
+}
+
+BOOST_AUTO_TEST_CASE(stall_while_loading)
+{
+    brayns::PlaybackScheduler scheduler;
+    BOOST_CHECK_EQUAL(scheduler.advance(FRAMES_PER_SECOND, 1, false, at(1.0)),
+                      0);
+
+    // The clock keeps running while the frame is loading
+    BOOST_CHECK_EQUAL(
+        scheduler.advance(FRAMES_PER_SECOND, 1, false, at(1.25)), 0);
+    BOOST_CHECK_EQUAL(
+        scheduler.advance(FRAMES_PER_SECOND, 1, false, at(1.375)), 0);
+    BOOST_CHECK_EQUAL(scheduler.getStallTime(), 0.375);
+    BOOST_CHECK_EQUAL(scheduler.getNbDroppedFrames(), 0);
+
+    BOOST_CHECK_EQUAL(scheduler.advance(FRAMES_PER_SECOND, 1, true, at(1.5)),
+                      4);
+    BOOST_CHECK_EQUAL(scheduler.getStallTime(), 0.375);
+    BOOST_CHECK_EQUAL(scheduler.getNbDroppedFrames(), 3);
+}
+
+BOOST_AUTO_TEST_CASE(restart_after_stop)
+{
+    brayns::PlaybackScheduler scheduler;
+    scheduler.advance(FRAMES_PER_SECOND, 1, true, at(1.0));
+    scheduler.advance(FRAMES_PER_SECOND, 1, true, at(1.5));
+    BOOST_CHECK_EQUAL(scheduler.getNbDroppedFrames(), 3);
+    scheduler.stop();
+
+    // Statistics of the last playback are kept until the next one starts
+    BOOST_CHECK(!scheduler.isPlaying());
+    BOOST_CHECK_EQUAL(scheduler.getNbPlayedFrames(), 1);
+    BOOST_CHECK_EQUAL(scheduler.getNbDroppedFrames(), 3);
+
+    BOOST_CHECK_EQUAL(scheduler.advance(FRAMES_PER_SECOND, 1, true, at(5.0)),
+                      1);
+    BOOST_CHECK(scheduler.isPlaying());
+    BOOST_CHECK_EQUAL(scheduler.getNbPlayedFrames(), 0);
+    BOOST_CHECK_EQUAL(scheduler.getNbDroppedFrames(), 0);
+    BOOST_CHECK_EQUAL(scheduler.getStallTime(), 0.0);
+}
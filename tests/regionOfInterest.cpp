@@ -0,0 +1,174 @@
+/* Copyright (c) 2015-2017, EPFL/Blue Brain Project
+ * All rights reserved. Do not distribute without permission.
+ * Responsible Author: Cyrille Favreau <cyrille.favreau@epfl.ch>
+ *
+ * This file is part of Brayns <https://github.com/BlueBrain/Brayns>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <brayns/io/algorithms/RegionOfInterest.h>
+
+#define BOOST_TEST_MODULE regionOfInterest
+#include <boost/test/unit_test.hpp>
+
+namespace
+{
+// Relative tolerance of BOOST_CHECK_CLOSE, in percent
+const float TOLERANCE = 1e-3f;
+
+/** Region made of the unit box */
+brayns::RegionOfInterest createBoxRegion()
+{
+    brayns::RegionOfInterest region;
+    region.addBox(
+        brayns::Boxf(brayns::Vector3f(0.f, 0.f, 0.f), brayns::Vector3f(1.f)));
+    return region;
+}
+}
+
+BOOST_AUTO_TEST_CASE(undefined_region)
+{
+    const brayns::RegionOfInterest region;
+    BOOST_CHECK(!region.isDefined());
+    BOOST_CHECK(region.contains(brayns::Vector3f(1e6f, -1e6f, 0.f)));
+
+    float begin, end;
+    BOOST_CHECK(region.clipSegment(brayns::Vector3f(-10.f),
+                                   brayns::Vector3f(10.f), 0.f, begin, end));
+    BOOST_CHECK_EQUAL(begin, 0.f);
+    BOOST_CHECK_EQUAL(end, 1.f);
+
+    brayns::Cone cone(brayns::Vector3f(-10.f), brayns::Vector3f(10.f), 1.f,
+                      2.f);
+    BOOST_CHECK(region.clipCone(cone));
+    BOOST_CHECK_EQUAL(cone.center, brayns::Vector3f(-10.f));
+    BOOST_CHECK_EQUAL(cone.upRadius, 2.f);
+}
+
+BOOST_AUTO_TEST_CASE(box_contains)
+{
+    const auto region = createBoxRegion();
+    BOOST_CHECK(region.isDefined());
+    BOOST_CHECK(region.contains(brayns::Vector3f(0.5f, 0.5f, 0.5f)));
+    BOOST_CHECK(region.contains(brayns::Vector3f(1.f, 1.f, 1.f)));
+    BOOST_CHECK(!region.contains(brayns::Vector3f(1.5f, 0.5f, 0.5f)));
+    BOOST_CHECK(!region.contains(brayns::Vector3f(0.5f, -0.1f, 0.5f)));
+
+    // Margins move every plane outwards
+    BOOST_CHECK(region.contains(brayns::Vector3f(1.5f, 0.5f, 0.5f), 0.5f));
+    BOOST_CHECK(!region.contains(brayns::Vector3f(1.5f, 0.5f, 0.5f), 0.4f));
+    BOOST_CHECK(region.contains(brayns::Vector3f(-0.2f, -0.2f, 1.2f), 0.25f));
+}
+
+BOOST_AUTO_TEST_CASE(box_clip_segment)
+{
+    const auto region = createBoxRegion();
+    float begin, end;
+
+    // Crossing the box along x
+    BOOST_REQUIRE(region.clipSegment(brayns::Vector3f(-1.f, 0.5f, 0.5f),
+                                     brayns::Vector3f(3.f, 0.5f, 0.5f), 0.f,
+                                     begin, end));
+    BOOST_CHECK_CLOSE(begin, 0.25f, TOLERANCE);
+    BOOST_CHECK_CLOSE(end, 0.5f, TOLERANCE);
+
+    // Inside
+    BOOST_REQUIRE(region.clipSegment(brayns::Vector3f(0.1f, 0.2f, 0.3f),
+                                     brayns::Vector3f(0.9f, 0.8f, 0.7f), 0.f,
+                                     begin, end));
+    BOOST_CHECK_EQUAL(begin, 0.f);
+    BOOST_CHECK_EQUAL(end, 1.f);
+
+    // Outside, on one side or passing by a corner
+    BOOST_CHECK(!region.clipSegment(brayns::Vector3f(2.f, 0.f, 0.f),
+                                    brayns::Vector3f(3.f, 1.f, 1.f), 0.f,
+                                    begin, end));
+    BOOST_CHECK(!region.clipSegment(brayns::Vector3f(2.5f, 0.f, 0.5f),
+                                    brayns::Vector3f(0.f, 2.5f, 0.5f), 0.f,
+                                    begin, end));
+
+    // The margin brings the segment in
+    BOOST_REQUIRE(region.clipSegment(brayns::Vector3f(2.5f, 0.f, 0.5f),
+                                     brayns::Vector3f(0.f, 2.5f, 0.5f), 0.5f,
+                                     begin, end));
+    BOOST_CHECK_CLOSE(begin, 0.4f, TOLERANCE);
+    BOOST_CHECK_CLOSE(end, 0.6f, TOLERANCE);
+    BOOST_REQUIRE(region.clipSegment(brayns::Vector3f(-2.f, 0.5f, 0.5f),
+                                     brayns::Vector3f(2.f, 0.5f, 0.5f), 0.5f,
+                                     begin, end));
+    BOOST_CHECK_CLOSE(begin, 0.375f, TOLERANCE);
+    BOOST_CHECK_CLOSE(end, 0.875f, TOLERANCE);
+}
+
+BOOST_AUTO_TEST_CASE(plane_clip_segment)
+{
+    // Half space x + y >= 1, the normal of which is normalized
+    brayns::RegionOfInterest region;
+    region.addPlanes({brayns::Vector4f(2.f, 2.f, 0.f, -2.f),
+                      brayns::Vector4f(0.f, 0.f, 0.f, 1.f)});
+    BOOST_CHECK(region.contains(brayns::Vector3f(1.f, 1.f, 0.f)));
+    BOOST_CHECK(!region.contains(brayns::Vector3f(0.f, 0.f, 0.f)));
+    BOOST_CHECK(region.contains(brayns::Vector3f(0.f, 0.f, 0.f), 0.75f));
+    BOOST_CHECK(!region.contains(brayns::Vector3f(0.f, 0.f, 0.f), 0.7f));
+
+    float begin, end;
+    BOOST_REQUIRE(region.clipSegment(brayns::Vector3f(0.f, 0.f, 5.f),
+                                     brayns::Vector3f(2.f, 2.f, 5.f), 0.f,
+                                     begin, end));
+    BOOST_CHECK_CLOSE(begin, 0.25f, TOLERANCE);
+    BOOST_CHECK_EQUAL(end, 1.f);
+
+    // Clipped at the target end when going the other way
+    BOOST_REQUIRE(region.clipSegment(brayns::Vector3f(2.f, 2.f, 5.f),
+                                     brayns::Vector3f(0.f, 0.f, 5.f), 0.f,
+                                     begin, end));
+    BOOST_CHECK_EQUAL(begin, 0.f);
+    BOOST_CHECK_CLOSE(end, 0.75f, TOLERANCE);
+}
+
+BOOST_AUTO_TEST_CASE(clip_cylinder)
+{
+    const auto region = createBoxRegion();
+
+    // The radius is the margin
+    brayns::Cylinder cylinder(brayns::Vector3f(-2.f, 0.5f, 0.5f),
+                              brayns::Vector3f(2.f, 0.5f, 0.5f), 0.5f);
+    BOOST_REQUIRE(region.clipCylinder(cylinder));
+    BOOST_CHECK_CLOSE(cylinder.center.x(), -0.5f, TOLERANCE);
+    BOOST_CHECK_CLOSE(cylinder.up.x(), 1.5f, TOLERANCE);
+    BOOST_CHECK_EQUAL(cylinder.radius, 0.5f);
+
+    brayns::Cylinder outside(brayns::Vector3f(2.f, 0.f, 0.f),
+                             brayns::Vector3f(2.f, 1.f, 0.f), 0.5f);
+    BOOST_CHECK(!region.clipCylinder(outside));
+}
+
+BOOST_AUTO_TEST_CASE(clip_cone)
+{
+    const auto region = createBoxRegion();
+
+    // Radii are interpolated along the axis, the largest one being the margin
+    brayns::Cone cone(brayns::Vector3f(0.5f, 0.5f, -3.f),
+                      brayns::Vector3f(0.5f, 0.5f, 5.f), 0.1f, 0.9f);
+    BOOST_REQUIRE(region.clipCone(cone));
+    BOOST_CHECK_CLOSE(cone.center.z(), -0.9f, TOLERANCE);
+    BOOST_CHECK_CLOSE(cone.up.z(), 1.9f, TOLERANCE);
+    BOOST_CHECK_CLOSE(cone.centerRadius, 0.1f + 0.8f * 2.1f / 8.f, TOLERANCE);
+    BOOST_CHECK_CLOSE(cone.upRadius, 0.1f + 0.8f * 4.9f / 8.f, TOLERANCE);
+
+    brayns::Cone outside(brayns::Vector3f(0.5f, 0.5f, 3.f),
+                         brayns::Vector3f(0.5f, 0.5f, 5.f), 1.f, 0.5f);
+    BOOST_CHECK(!region.clipCone(outside));
+}
@@ -0,0 +1,489 @@
+/* Copyright (c) 2015-2017, EPFL/Blue Brain Project
+ * All rights reserved. Do not distribute without permission.
+ * Responsible Author: Cyrille Favreau <cyrille.favreau@epfl.ch>
+ *
+ * This file is part of Brayns <https://github.com/BlueBrain/Brayns>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <brayns/common/scene/Scene.h>
+#include <brayns/parameters/GeometryParameters.h>
+#include <brayns/parameters/ParametersManager.h>
+
+#define BOOST_TEST_MODULE sceneCache
+#include <boost/test/unit_test.hpp>
+
+#include <boost/filesystem.hpp>
+
+#include <fstream>
+#include <future>
+
+namespace
+{
+const size_t SPHERES_MATERIAL = brayns::NB_SYSTEM_MATERIALS;
+const size_t MESH_MATERIAL = brayns::NB_SYSTEM_MATERIALS + 1;
+const size_t NB_SPHERES = 1000;
+const size_t NB_CYLINDERS = 10;
+const size_t NB_CONES = 5;
+
+// Header and table of contents entries of version 9 and 10 files
+const size_t CACHE_HEADER_NB_MATERIALS = 1;
+const size_t CACHE_HEADER_NB_BLOCKS = 3;
+const size_t CACHE_HEADER_BLOCKS_OFFSET = 4;
+const size_t CACHE_BLOCK_SIZE = 5;
+const size_t CACHE_BLOCK_OFFSET = 4;
+
+/** Scene without rendering engine, exercising the cache file code only */
+class TestScene : public brayns::Scene
+{
+public:
+    TestScene(brayns::ParametersManager& parametersManager,
+              const bool mappedGeometry = false)
+        : brayns::Scene(brayns::Renderers(), parametersManager)
+        , _mappedGeometry(mappedGeometry)
+    {
+    }
+
+    void commit() final {}
+    void commitLights() final {}
+    void buildGeometry() final {}
+    uint64_t serializeGeometry() final { return 0; }
+    void commitSimulationData() final {}
+    void commitVolumeData() final {}
+    void commitTransferFunctionData() final {}
+    void commitMaterials(const brayns::Action) final {}
+    bool isVolumeSupported(const std::string&) const final { return false; }
+    bool supportsMappedGeometry() const final { return _mappedGeometry; }
+private:
+    bool _mappedGeometry;
+};
+
+/** Cache file removed when the test ends */
+struct CacheFile
+{
+    CacheFile()
+        : filename((boost::filesystem::temp_directory_path() /
+                    boost::filesystem::unique_path("brayns-%%%%%%%%.bin"))
+                       .string())
+    {
+    }
+    ~CacheFile() { boost::filesystem::remove(filename); }
+    std::vector<char> read() const
+    {
+        std::ifstream file(filename, std::ios::binary);
+        return std::vector<char>(std::istreambuf_iterator<char>(file),
+                                 std::istreambuf_iterator<char>());
+    }
+
+    void write(const std::vector<char>& data) const
+    {
+        std::ofstream file(filename, std::ios::binary);
+        file.write(data.data(), data.size());
+    }
+
+    uint64_t& at(std::vector<char>& data, const size_t index) const
+    {
+        return reinterpret_cast<uint64_t*>(data.data())[index];
+    }
+
+    const std::string filename;
+};
+
+void fillScene(brayns::Scene& scene)
+{
+    scene.resetMaterials();
+    brayns::Material material;
+    material.setColor(brayns::Vector3f(0.1f, 0.2f, 0.3f));
+    material.setOpacity(0.5f);
+    material.setCastSimulationData(true);
+    scene.setMaterial(SPHERES_MATERIAL, material);
+
+    for (size_t i = 0; i < NB_SPHERES; ++i)
+        scene.addSphere(SPHERES_MATERIAL,
+                        brayns::Sphere(brayns::Vector3f(i, 2.f * i, -1.f * i),
+                                       0.5f + i, i * 0.1f,
+                                       brayns::Vector2f(i, i + 1)));
+    for (size_t i = 0; i < NB_CYLINDERS; ++i)
+        scene.addCylinder(MESH_MATERIAL,
+                          brayns::Cylinder(brayns::Vector3f(i, 0.f, 0.f),
+                                           brayns::Vector3f(i, 1.f, 0.f),
+                                           0.25f, 1.f));
+    for (size_t i = 0; i < NB_CONES; ++i)
+        scene.addCone(MESH_MATERIAL,
+                      brayns::Cone(brayns::Vector3f(0.f, i, 0.f),
+                                   brayns::Vector3f(0.f, i, 1.f), 0.5f, 0.1f));
+
+    auto& mesh = scene.getTriangleMeshes()[MESH_MATERIAL];
+    mesh.vertices = {brayns::Vector3f(0.f, 0.f, 0.f),
+                     brayns::Vector3f(1.f, 0.f, 0.f),
+                     brayns::Vector3f(0.f, 1.f, 0.f)};
+    mesh.normals = {brayns::Vector3f(0.f, 0.f, 1.f),
+                    brayns::Vector3f(0.f, 0.f, 1.f),
+                    brayns::Vector3f(0.f, 0.f, 1.f)};
+    mesh.indices = {brayns::Vector3ui(0, 1, 2)};
+    mesh.textureCoordinates = {brayns::Vector2f(0.f, 0.f),
+                               brayns::Vector2f(1.f, 0.f),
+                               brayns::Vector2f(0.f, 1.f)};
+}
+
+void checkSameScenes(brayns::Scene& expected, brayns::Scene& scene)
+{
+    BOOST_REQUIRE_EQUAL(scene.getMaterials().size(),
+                        expected.getMaterials().size());
+    auto& material = scene.getMaterial(SPHERES_MATERIAL);
+    BOOST_CHECK_EQUAL(material.getColor(),
+                      expected.getMaterial(SPHERES_MATERIAL).getColor());
+    BOOST_CHECK_EQUAL(material.getOpacity(), 0.5f);
+    BOOST_CHECK(material.getCastSimulationData());
+
+    const auto& spheres = scene.getSpheres()[SPHERES_MATERIAL];
+    const auto& expectedSpheres = expected.getSpheres()[SPHERES_MATERIAL];
+    BOOST_REQUIRE_EQUAL(spheres.size(), expectedSpheres.size());
+    for (size_t i = 0; i < spheres.size(); ++i)
+    {
+        BOOST_CHECK_EQUAL(spheres[i].center, expectedSpheres[i].center);
+        BOOST_CHECK_EQUAL(spheres[i].radius, expectedSpheres[i].radius);
+        BOOST_CHECK_EQUAL(spheres[i].timestamp, expectedSpheres[i].timestamp);
+        BOOST_CHECK_EQUAL(spheres[i].values, expectedSpheres[i].values);
+    }
+
+    const auto& cylinders = scene.getCylinders()[MESH_MATERIAL];
+    const auto& expectedCylinders = expected.getCylinders()[MESH_MATERIAL];
+    BOOST_REQUIRE_EQUAL(cylinders.size(), expectedCylinders.size());
+    for (size_t i = 0; i < cylinders.size(); ++i)
+    {
+        BOOST_CHECK_EQUAL(cylinders[i].center, expectedCylinders[i].center);
+        BOOST_CHECK_EQUAL(cylinders[i].up, expectedCylinders[i].up);
+        BOOST_CHECK_EQUAL(cylinders[i].radius, expectedCylinders[i].radius);
+    }
+
+    const auto& cones = scene.getCones()[MESH_MATERIAL];
+    const auto& expectedCones = expected.getCones()[MESH_MATERIAL];
+    BOOST_REQUIRE_EQUAL(cones.size(), expectedCones.size());
+    for (size_t i = 0; i < cones.size(); ++i)
+    {
+        BOOST_CHECK_EQUAL(cones[i].center, expectedCones[i].center);
+        BOOST_CHECK_EQUAL(cones[i].upRadius, expectedCones[i].upRadius);
+    }
+
+    const auto& mesh = scene.getTriangleMeshes()[MESH_MATERIAL];
+    const auto& expectedMesh = expected.getTriangleMeshes()[MESH_MATERIAL];
+    BOOST_CHECK_EQUAL_COLLECTIONS(mesh.vertices.begin(), mesh.vertices.end(),
+                                  expectedMesh.vertices.begin(),
+                                  expectedMesh.vertices.end());
+    BOOST_CHECK_EQUAL_COLLECTIONS(mesh.normals.begin(), mesh.normals.end(),
+                                  expectedMesh.normals.begin(),
+                                  expectedMesh.normals.end());
+    BOOST_CHECK_EQUAL_COLLECTIONS(mesh.indices.begin(), mesh.indices.end(),
+                                  expectedMesh.indices.begin(),
+                                  expectedMesh.indices.end());
+    BOOST_CHECK_EQUAL_COLLECTIONS(mesh.textureCoordinates.begin(),
+                                  mesh.textureCoordinates.end(),
+                                  expectedMesh.textureCoordinates.begin(),
+                                  expectedMesh.textureCoordinates.end());
+
+    BOOST_CHECK_EQUAL(scene.getWorldBounds(), expected.getWorldBounds());
+}
+
+bool saveScene(brayns::ParametersManager& parametersManager,
+               const CacheFile& cacheFile)
+{
+    parametersManager.getGeometryParameters().set("save-cache-file",
+                                                  cacheFile.filename);
+    TestScene scene(parametersManager);
+    fillScene(scene);
+    return scene.saveToCacheFile();
+}
+
+void writeCount(std::ofstream& file, const size_t count)
+{
+    file.write((const char*)&count, sizeof(size_t));
+}
+
+template <typename T>
+void writeElements(std::ofstream& file, const std::vector<T>& elements)
+{
+    writeCount(file, elements.size());
+    file.write((const char*)elements.data(), elements.size() * sizeof(T));
+}
+
+void loadScene(brayns::Scene& scene, const CacheFile& cacheFile)
+{
+    scene.getParametersManager().getGeometryParameters().set(
+        "load-cache-file", cacheFile.filename);
+    scene.loadFromCacheFile();
+}
+}
+
+BOOST_AUTO_TEST_CASE(cache_file_round_trip)
+{
+    CacheFile cacheFile;
+    brayns::ParametersManager parametersManager;
+    BOOST_REQUIRE(saveScene(parametersManager, cacheFile));
+
+    TestScene expected(parametersManager);
+    fillScene(expected);
+
+    for (const bool mappedGeometry : {false, true})
+    {
+        TestScene scene(parametersManager, mappedGeometry);
+        loadScene(scene, cacheFile);
+        checkSameScenes(expected, scene);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(background_cache_file_writer)
+{
+    CacheFile cacheFile;
+    brayns::ParametersManager parametersManager;
+    parametersManager.getGeometryParameters().set("save-cache-file",
+                                                  cacheFile.filename);
+    TestScene scene(parametersManager);
+    fillScene(scene);
+
+    // The scene is modified and emptied while its snapshot is being written
+    auto writer = scene.createCacheFileWriter();
+    float progress = 0.f;
+    auto result = std::async(std::launch::async, [writer, &progress] {
+        return writer([&progress](const std::string&, const float amount) {
+            progress = amount;
+        });
+    });
+    scene.getMaterialSpheres(SPHERES_MATERIAL)[0].radius = 100.f;
+    scene.addSphere(SPHERES_MATERIAL,
+                    brayns::Sphere(brayns::Vector3f(), 1.f));
+    scene.unload();
+
+    BOOST_REQUIRE(result.get());
+    BOOST_CHECK_EQUAL(progress, 1.f);
+
+    TestScene expected(parametersManager);
+    fillScene(expected);
+    for (const bool mappedGeometry : {false, true})
+    {
+        TestScene loaded(parametersManager, mappedGeometry);
+        loadScene(loaded, cacheFile);
+        checkSameScenes(expected, loaded);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(cache_file_table_of_contents)
+{
+    CacheFile cacheFile;
+    brayns::ParametersManager parametersManager;
+    BOOST_REQUIRE(saveScene(parametersManager, cacheFile));
+
+    auto data = cacheFile.read();
+    BOOST_REQUIRE_GE(data.size(), 4096);
+    BOOST_CHECK_EQUAL(cacheFile.at(data, 0), 9);
+    BOOST_CHECK_EQUAL(cacheFile.at(data, CACHE_HEADER_NB_MATERIALS),
+                      MESH_MATERIAL + 1);
+
+    // Spheres, cylinders, cones, vertices, indices, normals and texture
+    // coordinates, each block starting on a page boundary
+    const uint64_t nbBlocks = cacheFile.at(data, CACHE_HEADER_NB_BLOCKS);
+    BOOST_REQUIRE_EQUAL(nbBlocks, 7);
+    const size_t firstBlock =
+        cacheFile.at(data, CACHE_HEADER_BLOCKS_OFFSET) / sizeof(uint64_t);
+    for (size_t i = 0; i < nbBlocks; ++i)
+    {
+        const uint64_t offset = cacheFile.at(
+            data, firstBlock + i * CACHE_BLOCK_SIZE + CACHE_BLOCK_OFFSET);
+        BOOST_CHECK_EQUAL(offset % 4096, 0);
+        BOOST_CHECK_LT(offset, data.size());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(legacy_cache_file)
+{
+    brayns::ParametersManager parametersManager;
+    TestScene expected(parametersManager);
+    fillScene(expected);
+
+    // Version 8: materials, then the element counts and elements of every
+    // material, then the scene bounds
+    CacheFile cacheFile;
+    {
+        std::ofstream file(cacheFile.filename, std::ios::binary);
+        writeCount(file, 8);
+        auto& materials = expected.getMaterials();
+        writeCount(file, materials.size());
+        for (auto& material : materials)
+        {
+            const float values[] = {material.getSpecularExponent(),
+                                    material.getReflectionIndex(),
+                                    material.getOpacity(),
+                                    material.getRefractionIndex(),
+                                    material.getEmission(),
+                                    material.getGlossiness()};
+            const bool castSimulationData = material.getCastSimulationData();
+            file.write((const char*)&material.getColor(),
+                       sizeof(brayns::Vector3f));
+            file.write((const char*)&material.getSpecularColor(),
+                       sizeof(brayns::Vector3f));
+            file.write((const char*)values, sizeof(values));
+            file.write((const char*)&castSimulationData, sizeof(bool));
+        }
+
+        for (size_t i = 0; i < materials.size(); ++i)
+        {
+            writeElements(file, expected.getSpheres()[i]);
+            writeElements(file, expected.getCylinders()[i]);
+            writeElements(file, expected.getCones()[i]);
+            const auto& mesh = expected.getTriangleMeshes()[i];
+            writeElements(file, mesh.vertices);
+            writeElements(file, mesh.indices);
+            writeElements(file, mesh.normals);
+            writeElements(file, mesh.textureCoordinates);
+        }
+        file.write((const char*)&expected.getWorldBounds(),
+                   sizeof(brayns::Boxf));
+    }
+
+    TestScene scene(parametersManager);
+    loadScene(scene, cacheFile);
+    checkSameScenes(expected, scene);
+
+    // A truncated file is rejected
+    auto data = cacheFile.read();
+    data.resize(data.size() / 2);
+    cacheFile.write(data);
+    TestScene truncatedScene(parametersManager);
+    BOOST_CHECK_NO_THROW(loadScene(truncatedScene, cacheFile));
+    BOOST_CHECK(truncatedScene.empty());
+
+    // So is a file announcing more materials than it holds
+    data.resize(3 * sizeof(uint64_t));
+    cacheFile.at(data, 1) = 1;
+    cacheFile.at(data, 2) = uint64_t(1) << 60;
+    cacheFile.write(data);
+    TestScene corruptedScene(parametersManager);
+    BOOST_CHECK_NO_THROW(loadScene(corruptedScene, cacheFile));
+    BOOST_CHECK(corruptedScene.empty());
+}
+
+BOOST_AUTO_TEST_CASE(corrupted_cache_file)
+{
+    CacheFile cacheFile;
+    brayns::ParametersManager parametersManager;
+    BOOST_REQUIRE(saveScene(parametersManager, cacheFile));
+    auto data = cacheFile.read();
+
+    const auto checkRejected = [&](const std::vector<char>& corrupted) {
+        cacheFile.write(corrupted);
+        for (const bool mappedGeometry : {false, true})
+        {
+            TestScene scene(parametersManager, mappedGeometry);
+            BOOST_CHECK_NO_THROW(loadScene(scene, cacheFile));
+            BOOST_CHECK(scene.empty());
+        }
+    };
+
+    // Unknown version
+    auto corrupted = data;
+    cacheFile.at(corrupted, 0) = 42;
+    checkRejected(corrupted);
+
+    // Truncated blocks
+    corrupted = data;
+    corrupted.resize(corrupted.size() / 2);
+    checkRejected(corrupted);
+
+    // Truncated table of contents
+    corrupted = data;
+    corrupted.resize(cacheFile.at(data, CACHE_HEADER_BLOCKS_OFFSET));
+    checkRejected(corrupted);
+
+    // Block with a wrong element size
+    corrupted = data;
+    const size_t firstBlock =
+        cacheFile.at(data, CACHE_HEADER_BLOCKS_OFFSET) / sizeof(uint64_t);
+    cacheFile.at(corrupted, firstBlock + 2) = 1;
+    checkRejected(corrupted);
+
+    // Block of an unknown material
+    corrupted = data;
+    cacheFile.at(corrupted, firstBlock) = 1000;
+    checkRejected(corrupted);
+
+    // Number of elements whose size overflows
+    corrupted = data;
+    cacheFile.at(corrupted, firstBlock + 3) =
+        uint64_t(-1) / cacheFile.at(data, firstBlock + 2) + 1;
+    checkRejected(corrupted);
+}
+
+#ifdef BRAYNS_USE_LZ4
+BOOST_AUTO_TEST_CASE(compressed_cache_file)
+{
+    CacheFile cacheFile;
+    brayns::ParametersManager parametersManager;
+    parametersManager.getGeometryParameters().set("compress-cache-file",
+                                                  "true");
+    BOOST_REQUIRE(saveScene(parametersManager, cacheFile));
+
+    auto data = cacheFile.read();
+    BOOST_CHECK_EQUAL(cacheFile.at(data, 0), 10);
+
+    TestScene expected(parametersManager);
+    fillScene(expected);
+    for (const bool mappedGeometry : {false, true})
+    {
+        TestScene scene(parametersManager, mappedGeometry);
+        loadScene(scene, cacheFile);
+        checkSameScenes(expected, scene);
+    }
+
+    // Counts larger than the chunks are rejected before anything is allocated
+    const size_t firstBlock =
+        cacheFile.at(data, CACHE_HEADER_BLOCKS_OFFSET) / sizeof(uint64_t);
+    const size_t firstChunk =
+        cacheFile.at(data, firstBlock + CACHE_BLOCK_OFFSET) / sizeof(uint64_t) +
+        1;
+    const auto checkRejected = [&](const std::vector<char>& corrupted) {
+        cacheFile.write(corrupted);
+        TestScene scene(parametersManager);
+        BOOST_CHECK_NO_THROW(loadScene(scene, cacheFile));
+        BOOST_CHECK(scene.empty());
+    };
+    for (const uint64_t nbElements :
+         {uint64_t(1) << 40, uint64_t(-1) / cacheFile.at(data, firstBlock + 2) +
+                                 1})
+    {
+        auto corrupted = data;
+        cacheFile.at(corrupted, firstBlock + 3) = nbElements;
+        checkRejected(corrupted);
+    }
+    {
+        // Chunk larger than any chunk written by the compressor
+        auto corrupted = data;
+        cacheFile.at(corrupted, firstChunk + 2) = uint64_t(1) << 40;
+        checkRejected(corrupted);
+    }
+    {
+        // Chunks whose sizes overflow
+        auto corrupted = data;
+        cacheFile.at(corrupted, firstChunk + 1) = uint64_t(-1);
+        checkRejected(corrupted);
+    }
+
+    // Truncated compressed chunks are rejected
+    data.resize(data.size() - 16);
+    cacheFile.write(data);
+    TestScene truncatedScene(parametersManager);
+    BOOST_CHECK_NO_THROW(loadScene(truncatedScene, cacheFile));
+    BOOST_CHECK(truncatedScene.empty());
+}
+#endif
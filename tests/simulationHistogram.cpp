@@ -0,0 +1,160 @@
+/* Copyright (c) 2015-2017, EPFL/Blue Brain Project
+ * All rights reserved. Do not distribute without permission.
+ * Responsible Author: Cyrille Favreau <cyrille.favreau@epfl.ch>
+ *
+ * This file is part of Brayns <https://github.com/BlueBrain/Brayns>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <brayns/common/simulation/AbstractSimulationHandler.h>
+#include <brayns/parameters/GeometryParameters.h>
+
+#define BOOST_TEST_MODULE simulationHistogram
+#include <boost/test/unit_test.hpp>
+
+#include <chrono>
+#include <limits>
+#include <thread>
+
+namespace
+{
+// Bins of exact width when the range is a power of 2
+const size_t HISTOGRAM_SIZE = 9;
+
+/** Handler playing frames held in memory */
+class TestSimulationHandler : public brayns::AbstractSimulationHandler
+{
+public:
+    TestSimulationHandler(const brayns::GeometryParameters& parameters,
+                          const std::vector<floats>& frames,
+                          const bool persistent)
+        : brayns::AbstractSimulationHandler(parameters)
+        , _frames(frames)
+        , _persistent(persistent)
+    {
+        _nbFrames = _frames.size();
+        _frameSize = _frames[0].size();
+    }
+
+    void* getFrameData(const uint32_t frame) final
+    {
+        _currentFrame = _getBoundedFrame(frame);
+        if (_persistent)
+            return _frames[_currentFrame].data();
+
+        // Buffer reused by every frame
+        _buffer = _frames[_currentFrame];
+        return _buffer.data();
+    }
+
+    bool hasPersistentFrameData() const final { return _persistent; }
+private:
+    std::vector<floats> _frames;
+    floats _buffer;
+    bool _persistent;
+};
+
+/** @return the histogram of a frame, once computed in the background */
+brayns::Histogram getHistogram(brayns::AbstractSimulationHandler& handler,
+                               const uint32_t frame)
+{
+    handler.getFrameData(frame);
+    const auto timeout =
+        std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (handler.getHistogram().frame != frame &&
+           std::chrono::steady_clock::now() < timeout)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    const auto& histogram = handler.getHistogram();
+    BOOST_REQUIRE_EQUAL(histogram.frame, frame);
+    return histogram;
+}
+
+void checkBins(const brayns::Histogram& histogram, const uint64_ts& expected)
+{
+    BOOST_CHECK_EQUAL_COLLECTIONS(histogram.values.begin(),
+                                  histogram.values.end(), expected.begin(),
+                                  expected.end());
+}
+}
+
+BOOST_AUTO_TEST_CASE(histogram_bins)
+{
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    const float infinity = std::numeric_limits<float>::infinity();
+    const float maxFloat = std::numeric_limits<float>::max();
+
+    // 0 to 64, non-finite values being ignored
+    floats ramp;
+    for (size_t i = 0; i <= 64; ++i)
+        ramp.push_back(float(i));
+    ramp.insert(ramp.end(), {nan, infinity, -infinity});
+
+    // Frames of the same size, padded with non-finite values
+    std::vector<floats> frames = {ramp, floats(50, 3.f), {},
+                                  {-maxFloat, maxFloat}};
+    for (auto& frame : frames)
+        frame.resize(ramp.size(), nan);
+
+    // Each frame on its own
+    brayns::GeometryParameters parameters;
+    parameters.set("circuit-simulation-histogram-size",
+                   std::to_string(HISTOGRAM_SIZE));
+    parameters.set("circuit-simulation-histogram-window", "1");
+    for (const bool persistent : {false, true})
+    {
+        TestSimulationHandler handler(parameters, frames, persistent);
+
+        // Bins of width 8, the maximum being alone in the last one
+        auto histogram = getHistogram(handler, 0);
+        checkBins(histogram, {8, 8, 8, 8, 8, 8, 8, 8, 1});
+        BOOST_CHECK_EQUAL(histogram.range, brayns::Vector2f(0.f, 64.f));
+
+        // A single value is in the first bin
+        histogram = getHistogram(handler, 1);
+        checkBins(histogram, {50, 0, 0, 0, 0, 0, 0, 0, 0});
+        BOOST_CHECK_EQUAL(histogram.range, brayns::Vector2f(3.f, 3.f));
+
+        // No finite value
+        histogram = getHistogram(handler, 2);
+        checkBins(histogram, uint64_ts(HISTOGRAM_SIZE, 0));
+        BOOST_CHECK_EQUAL(histogram.range, brayns::Vector2f(0.f, 0.f));
+
+        // Range wider than the largest float
+        histogram = getHistogram(handler, 3);
+        checkBins(histogram, {1, 0, 0, 0, 0, 0, 0, 0, 1});
+        BOOST_CHECK_EQUAL(histogram.range,
+                          brayns::Vector2f(-maxFloat, maxFloat));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(histogram_window)
+{
+    const std::vector<floats> frames = {{0.f, 1.f, 2.f, 3.f},
+                                        {4.f, 5.f, 6.f, 8.f},
+                                        {0.f, 0.f, 0.f, 0.f}};
+
+    brayns::GeometryParameters parameters;
+    parameters.set("circuit-simulation-histogram-size",
+                   std::to_string(HISTOGRAM_SIZE));
+    parameters.set("circuit-simulation-histogram-window", "2");
+    TestSimulationHandler handler(parameters, frames, false);
+
+    // Frames of the window share the range and bins, the copies of previous
+    // frames not being affected by the reused buffer
+    getHistogram(handler, 0);
+    const auto histogram = getHistogram(handler, 1);
+    checkBins(histogram, {1, 1, 1, 1, 1, 1, 1, 0, 1});
+    BOOST_CHECK_EQUAL(histogram.range, brayns::Vector2f(0.f, 8.f));
+}
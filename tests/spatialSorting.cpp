@@ -0,0 +1,118 @@
+/* Copyright (c) 2015-2017, EPFL/Blue Brain Project
+ * All rights reserved. Do not distribute without permission.
+ * Responsible Author: Cyrille Favreau <cyrille.favreau@epfl.ch>
+ *
+ * This file is part of Brayns <https://github.com/BlueBrain/Brayns>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <brayns/Brayns.h>
+
+#include <brayns/common/engine/Engine.h>
+#include <brayns/common/geometry/Sphere.h>
+#include <brayns/common/scene/Scene.h>
+
+#define BOOST_TEST_MODULE spatialSorting
+#include <boost/test/unit_test.hpp>
+
+#include <boost/filesystem.hpp>
+
+#include <fstream>
+
+namespace
+{
+// Corners of the unit cube, encoded as (x << 2 | y << 1 | z)
+const size_t SHUFFLED_CORNERS[] = {5, 2, 7, 0, 3, 6, 1, 4};
+const size_t NB_CORNERS = 8;
+
+brayns::Vector3f getCorner(const size_t corner)
+{
+    return brayns::Vector3f(float((corner >> 2) & 1), float((corner >> 1) & 1),
+                            float(corner & 1));
+}
+
+/** XYZB file of the shuffled corners, removed when the test ends */
+struct XYZBFile
+{
+    XYZBFile()
+        : filename((boost::filesystem::temp_directory_path() /
+                    boost::filesystem::unique_path("brayns-%%%%%%%%.xyzb"))
+                       .string())
+    {
+        std::ofstream file(filename, std::ios::binary);
+        for (const auto corner : SHUFFLED_CORNERS)
+        {
+            const auto position = getCorner(corner);
+            const double values[] = {position.x(), position.y(), position.z()};
+            file.write((const char*)values, sizeof(values));
+        }
+    }
+
+    ~XYZBFile()
+    {
+        boost::system::error_code error;
+        boost::filesystem::remove(filename, error);
+    }
+
+    std::string filename;
+};
+
+const brayns::Spheres& loadSpheres(brayns::Brayns& brayns)
+{
+    auto& scene = brayns.getEngine().getScene();
+    BOOST_REQUIRE_EQUAL(scene.getSpheres()[0].size(), NB_CORNERS);
+    return scene.getSpheres()[0];
+}
+}
+
+BOOST_AUTO_TEST_CASE(morton_ordering)
+{
+    XYZBFile xyzbFile;
+    auto& testSuite = boost::unit_test::framework::master_test_suite();
+    const char* argv[] = {testSuite.argv[0],
+                          "--synchronous-mode",
+                          "on",
+                          "--spatial-sorting",
+                          "on",
+                          "--xyzb-file",
+                          xyzbFile.filename.c_str()};
+    const int argc = sizeof(argv) / sizeof(char*);
+    brayns::Brayns brayns(argc, argv);
+
+    // Within the scene bounds, x is the most significant coordinate of the
+    // Morton codes, then y and z, which orders the corners lexicographically
+    const auto& spheres = loadSpheres(brayns);
+    for (size_t i = 0; i < NB_CORNERS; ++i)
+        BOOST_CHECK_EQUAL(spheres[i].center, getCorner(i));
+}
+
+BOOST_AUTO_TEST_CASE(no_spatial_sorting)
+{
+    XYZBFile xyzbFile;
+    auto& testSuite = boost::unit_test::framework::master_test_suite();
+    const char* argv[] = {testSuite.argv[0],
+                          "--synchronous-mode",
+                          "on",
+                          "--spatial-sorting",
+                          "off",
+                          "--xyzb-file",
+                          xyzbFile.filename.c_str()};
+    const int argc = sizeof(argv) / sizeof(char*);
+    brayns::Brayns brayns(argc, argv);
+
+    const auto& spheres = loadSpheres(brayns);
+    for (size_t i = 0; i < NB_CORNERS; ++i)
+        BOOST_CHECK_EQUAL(spheres[i].center, getCorner(SHUFFLED_CORNERS[i]));
+}
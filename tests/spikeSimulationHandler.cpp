@@ -0,0 +1,261 @@
+/* Copyright (c) 2015-2017, EPFL/Blue Brain Project
+ * All rights reserved. Do not distribute without permission.
+ * Responsible Author: Cyrille Favreau <cyrille.favreau@epfl.ch>
+ *
+ * This file is part of Brayns <https://github.com/BlueBrain/Brayns>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3.0 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+#include <brayns/io/simulation/SpikeSimulationHandler.h>
+#include <brayns/parameters/GeometryParameters.h>
+
+#define BOOST_TEST_MODULE spikeSimulationHandler
+#include <boost/test/unit_test.hpp>
+
+#include <boost/filesystem.hpp>
+
+#include <fstream>
+
+namespace fs = boost::filesystem;
+
+namespace
+{
+const uint64_t NB_FRAMES = 50;
+const uint64_t FRAME_SIZE = 20;
+const size_t NB_SPIKES = 300;
+const float START_TIME = 10.f;
+const float TIMESTEP = 0.1f;
+
+// Offsets in the header of sparse cache files
+const size_t NB_FRAMES_OFFSET = 16;
+const size_t NB_SPIKES_OFFSET = 32;
+const size_t FRAME_ENDS_OFFSET = 48;
+
+/** Spikes sorted by time, some of them between frames */
+brayns::SpikeEvents createSpikes()
+{
+    brayns::SpikeEvents spikes;
+    for (size_t i = 0; i < NB_SPIKES; ++i)
+    {
+        const float time = START_TIME + i * NB_FRAMES * TIMESTEP / NB_SPIKES;
+        spikes.push_back({time, uint32_t((i * 7) % FRAME_SIZE)});
+    }
+    return spikes;
+}
+
+/** Last spiking time of every neuron at the end of the given frame */
+floats createDenseFrame(const brayns::SpikeEvents& spikes,
+                                const uint64_t frame)
+{
+    floats values(FRAME_SIZE, -1.f);
+    const float frameEnd = START_TIME + (frame + 1) * TIMESTEP;
+    for (const auto& spike : spikes)
+        if (spike.time < frameEnd)
+            values[spike.gid] = spike.time;
+    return values;
+}
+
+/** Sparse cache file removed when the test ends */
+struct CacheFile
+{
+    CacheFile()
+        : path((fs::temp_directory_path() /
+                fs::unique_path("brayns-%%%%%%%%.spikes"))
+                   .string())
+    {
+        std::ofstream file(path, std::ios::binary);
+        brayns::SpikeSimulationHandler handler(parameters);
+        handler.setNbFrames(NB_FRAMES);
+        handler.setFrameSize(FRAME_SIZE);
+        handler.writeSparseCache(file, START_TIME, TIMESTEP, spikes);
+    }
+
+    ~CacheFile()
+    {
+        boost::system::error_code error;
+        fs::remove(path, error);
+    }
+
+    void write(const size_t offset, const uint64_t value)
+    {
+        std::fstream file(path,
+                          std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(offset);
+        file.write((const char*)&value, sizeof(value));
+    }
+
+    bool attach()
+    {
+        brayns::SpikeSimulationHandler handler(parameters);
+        return handler.attachSimulationToCacheFile(path);
+    }
+
+    brayns::GeometryParameters parameters;
+    const brayns::SpikeEvents spikes = createSpikes();
+    const std::string path;
+};
+
+void checkFrame(brayns::SpikeSimulationHandler& handler,
+                const brayns::SpikeEvents& spikes, const uint64_t frame)
+{
+    const auto data = static_cast<const float*>(handler.getFrameData(frame));
+    BOOST_REQUIRE(data);
+    const auto expected = createDenseFrame(spikes, frame);
+    BOOST_CHECK_EQUAL_COLLECTIONS(data, data + FRAME_SIZE, expected.begin(),
+                                  expected.end());
+}
+}
+
+BOOST_AUTO_TEST_CASE(scrub_sparse_cache)
+{
+    CacheFile cache;
+    brayns::SpikeSimulationHandler handler(cache.parameters);
+    BOOST_REQUIRE(handler.attachSimulationToCacheFile(cache.path));
+    BOOST_CHECK_EQUAL(handler.getNbFrames(), NB_FRAMES);
+    BOOST_CHECK_EQUAL(handler.getFrameSize(), FRAME_SIZE);
+    BOOST_CHECK(!handler.hasPersistentFrameData());
+
+    for (uint64_t frame = 0; frame < NB_FRAMES; ++frame)
+        checkFrame(handler, cache.spikes, frame);
+    for (uint64_t frame = NB_FRAMES; frame-- > 0;)
+        checkFrame(handler, cache.spikes, frame);
+
+    // Jumps in both directions
+    const uint64_t frames[] = {30, 2, 49, 0, 25, 26, 24, 49};
+    for (const auto frame : frames)
+        checkFrame(handler, cache.spikes, frame);
+}
+
+BOOST_AUTO_TEST_CASE(corrupted_sparse_cache)
+{
+    {
+        CacheFile cache;
+        BOOST_CHECK(cache.attach());
+    }
+    {
+        // Frames that end before the previous ones
+        CacheFile cache;
+        cache.write(FRAME_ENDS_OFFSET + 10 * sizeof(uint64_t), 0);
+        cache.write(FRAME_ENDS_OFFSET + 9 * sizeof(uint64_t), 100);
+        BOOST_CHECK(!cache.attach());
+    }
+    {
+        // Frames that end after the last spike
+        CacheFile cache;
+        cache.write(FRAME_ENDS_OFFSET + (NB_FRAMES - 1) * sizeof(uint64_t),
+                    NB_SPIKES + 1);
+        BOOST_CHECK(!cache.attach());
+    }
+    {
+        // Counts whose size overflows
+        CacheFile cache;
+        cache.write(NB_FRAMES_OFFSET, 1ull << 61);
+        BOOST_CHECK(!cache.attach());
+    }
+    {
+        CacheFile cache;
+        cache.write(NB_SPIKES_OFFSET, (1ull << 61) + 1);
+        BOOST_CHECK(!cache.attach());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(persistent_dense_cache)
+{
+    const auto spikes = createSpikes();
+    const std::string path =
+        (fs::temp_directory_path() / fs::unique_path("brayns-%%%%%%%%.spikes"))
+            .string();
+    brayns::GeometryParameters parameters;
+    {
+        std::ofstream file(path, std::ios::binary);
+        brayns::SpikeSimulationHandler handler(parameters);
+        handler.setNbFrames(NB_FRAMES);
+        handler.setFrameSize(FRAME_SIZE);
+        handler.writeHeader(file);
+        for (uint64_t frame = 0; frame < NB_FRAMES; ++frame)
+            handler.writeFrame(file, createDenseFrame(spikes, frame));
+    }
+
+    {
+        brayns::SpikeSimulationHandler handler(parameters);
+        BOOST_REQUIRE(handler.attachSimulationToCacheFile(path));
+        BOOST_CHECK(handler.hasPersistentFrameData());
+
+        // Frames stay valid when other frames are requested
+        const auto first = static_cast<const float*>(handler.getFrameData(3));
+        checkFrame(handler, spikes, 40);
+        const auto expected = createDenseFrame(spikes, 3);
+        BOOST_CHECK_EQUAL_COLLECTIONS(first, first + FRAME_SIZE,
+                                      expected.begin(), expected.end());
+    }
+
+    boost::system::error_code error;
+    fs::remove(path, error);
+}
+
+BOOST_AUTO_TEST_CASE(advised_dense_cache_frames)
+{
+    // Frames spanning several pages, not aligned on them
+    const uint64_t nbFrames = 20;
+    const uint64_t frameSize = 3001;
+    const std::string path =
+        (fs::temp_directory_path() / fs::unique_path("brayns-%%%%%%%%.spikes"))
+            .string();
+    brayns::GeometryParameters parameters;
+    parameters.set("circuit-simulation-prefetch-frames", "7");
+    {
+        std::ofstream file(path, std::ios::binary);
+        brayns::SpikeSimulationHandler handler(parameters);
+        handler.setNbFrames(nbFrames);
+        handler.setFrameSize(frameSize);
+        handler.writeHeader(file);
+        for (uint64_t frame = 0; frame < nbFrames; ++frame)
+        {
+            floats values(frameSize);
+            for (uint64_t i = 0; i < frameSize; ++i)
+                values[i] = frame * frameSize + i;
+            handler.writeFrame(file, values);
+        }
+    }
+
+    {
+        brayns::SpikeSimulationHandler handler(parameters);
+        BOOST_REQUIRE(handler.attachSimulationToCacheFile(path));
+
+        // Frames read in place, the following ones being advised to the
+        // kernel across the end of the simulation, match frames copied out
+        // of the file
+        std::ifstream file(path, std::ios::binary);
+        // Number of frames and frame size
+        const uint64_t headerSize = sizeof(uint32_t) + sizeof(uint64_t);
+        const uint64_t frames[] = {0, 1, 2, 15, 16, 19, 0, 25, 39, 7};
+        for (const auto frame : frames)
+        {
+            floats expected(frameSize);
+            file.seekg(headerSize +
+                       (frame % nbFrames) * frameSize * sizeof(float));
+            file.read((char*)expected.data(), frameSize * sizeof(float));
+            BOOST_REQUIRE(file.good());
+
+            const auto data =
+                static_cast<const float*>(handler.getFrameData(frame));
+            BOOST_REQUIRE(data);
+            BOOST_CHECK_EQUAL_COLLECTIONS(data, data + frameSize,
+                                          expected.begin(), expected.end());
+        }
+    }
+
+    boost::system::error_code error;
+    fs::remove(path, error);
+}